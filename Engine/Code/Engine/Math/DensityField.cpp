@@ -0,0 +1,149 @@
+#include "Engine/Math/DensityField.hpp"
+#include <emmintrin.h>
+
+//-----------------------------------------------------------------------------------
+DensityField::DensityField(const Vector3Int& size, const Vector3Int& step)
+	: m_size(size)
+	, m_step(step)
+	, m_latticeSize(CalculateLatticeDimension(size.x, step.x), CalculateLatticeDimension(size.y, step.y), CalculateLatticeDimension(size.z, step.z))
+{
+	m_lattice.resize(GetNumLatticeSamples());
+}
+
+//-----------------------------------------------------------------------------------
+void DensityField::SampleLattice(const Vector3& origin, SampleFunction sampleFunction, void* userData)
+{
+	int sampleIndex = 0;
+	for (int z = 0; z < m_latticeSize.z; ++z)
+	{
+		for (int y = 0; y < m_latticeSize.y; ++y)
+		{
+			for (int x = 0; x < m_latticeSize.x; ++x)
+			{
+				Vector3 position(origin.x + (float)(x * m_step.x), origin.y + (float)(y * m_step.y), origin.z + (float)(z * m_step.z));
+				m_lattice[sampleIndex++] = sampleFunction(position, userData);
+			}
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------------
+static inline __m128 LerpLanes(__m128 from, __m128 to, __m128 fraction)
+{
+	return _mm_add_ps(from, _mm_mul_ps(_mm_sub_ps(to, from), fraction));
+}
+
+//-----------------------------------------------------------------------------------
+//Writes m_size.x * m_size.y * m_size.z values, x-major (x fastest, then y, then z).
+//Every lattice row is lerped out to full width along x first, which is the only step that has to look up cells.
+//After that each output row is just the four full-width rows around it lerped together in y and z, a straight
+//run over contiguous floats that goes 4 lanes at a time.
+void DensityField::Interpolate(float* out_values) const
+{
+	std::vector<int> cellsX, cellsY, cellsZ;
+	std::vector<float> fractionsX, fractionsY, fractionsZ;
+	CalculateAxisWeights(m_size.x, m_step.x, m_latticeSize.x, cellsX, fractionsX);
+	CalculateAxisWeights(m_size.y, m_step.y, m_latticeSize.y, cellsY, fractionsY);
+	CalculateAxisWeights(m_size.z, m_step.z, m_latticeSize.z, cellsZ, fractionsZ);
+
+	const int numLatticeRows = m_latticeSize.y * m_latticeSize.z;
+	const int lastLatticeX = m_latticeSize.x - 1;
+	std::vector<float> expandedRows(numLatticeRows * m_size.x);
+	for (int latticeRow = 0; latticeRow < numLatticeRows; ++latticeRow)
+	{
+		const float* latticeValues = &m_lattice[latticeRow * m_latticeSize.x];
+		float* expandedRow = &expandedRows[latticeRow * m_size.x];
+		for (int x = 0; x < m_size.x; ++x)
+		{
+			const int x0 = cellsX[x];
+			const int x1 = (x0 < lastLatticeX) ? x0 + 1 : x0;
+			expandedRow[x] = latticeValues[x0] + ((latticeValues[x1] - latticeValues[x0]) * fractionsX[x]);
+		}
+	}
+
+	for (int z = 0; z < m_size.z; ++z)
+	{
+		const int z0 = cellsZ[z];
+		const int z1 = (z0 < m_latticeSize.z - 1) ? z0 + 1 : z0;
+		const float fractionZ = fractionsZ[z];
+		const __m128 fractionZLanes = _mm_set1_ps(fractionZ);
+		for (int y = 0; y < m_size.y; ++y)
+		{
+			const int y0 = cellsY[y];
+			const int y1 = (y0 < m_latticeSize.y - 1) ? y0 + 1 : y0;
+			const float fractionY = fractionsY[y];
+			const __m128 fractionYLanes = _mm_set1_ps(fractionY);
+			const float* bottomSouth = &expandedRows[((z0 * m_latticeSize.y) + y0) * m_size.x];
+			const float* bottomNorth = &expandedRows[((z0 * m_latticeSize.y) + y1) * m_size.x];
+			const float* topSouth = &expandedRows[((z1 * m_latticeSize.y) + y0) * m_size.x];
+			const float* topNorth = &expandedRows[((z1 * m_latticeSize.y) + y1) * m_size.x];
+
+			float* outRow = out_values + (((z * m_size.y) + y) * m_size.x);
+			int x = 0;
+			for (; x + 4 <= m_size.x; x += 4)
+			{
+				__m128 bottom = LerpLanes(_mm_loadu_ps(bottomSouth + x), _mm_loadu_ps(bottomNorth + x), fractionYLanes);
+				__m128 top = LerpLanes(_mm_loadu_ps(topSouth + x), _mm_loadu_ps(topNorth + x), fractionYLanes);
+				_mm_storeu_ps(outRow + x, LerpLanes(bottom, top, fractionZLanes));
+			}
+			//Same arithmetic one lane at a time for rows that aren't a multiple of 4 wide.
+			for (; x < m_size.x; ++x)
+			{
+				float bottom = bottomSouth[x] + ((bottomNorth[x] - bottomSouth[x]) * fractionY);
+				float top = topSouth[x] + ((topNorth[x] - topSouth[x]) * fractionY);
+				outRow[x] = bottom + ((top - bottom) * fractionZ);
+			}
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------------
+float DensityField::GetValueAt(int x, int y, int z) const
+{
+	const int x0 = x / m_step.x;
+	const int y0 = y / m_step.y;
+	const int z0 = z / m_step.z;
+	const int x1 = (x0 < m_latticeSize.x - 1) ? x0 + 1 : x0;
+	const int y1 = (y0 < m_latticeSize.y - 1) ? y0 + 1 : y0;
+	const int z1 = (z0 < m_latticeSize.z - 1) ? z0 + 1 : z0;
+	const float fractionX = (float)(x - (x0 * m_step.x)) / (float)m_step.x;
+	const float fractionY = (float)(y - (y0 * m_step.y)) / (float)m_step.y;
+	const float fractionZ = (float)(z - (z0 * m_step.z)) / (float)m_step.z;
+
+	float bottomSouth = GetLatticeValue(x0, y0, z0) + ((GetLatticeValue(x1, y0, z0) - GetLatticeValue(x0, y0, z0)) * fractionX);
+	float bottomNorth = GetLatticeValue(x0, y1, z0) + ((GetLatticeValue(x1, y1, z0) - GetLatticeValue(x0, y1, z0)) * fractionX);
+	float topSouth = GetLatticeValue(x0, y0, z1) + ((GetLatticeValue(x1, y0, z1) - GetLatticeValue(x0, y0, z1)) * fractionX);
+	float topNorth = GetLatticeValue(x0, y1, z1) + ((GetLatticeValue(x1, y1, z1) - GetLatticeValue(x0, y1, z1)) * fractionX);
+	float bottom = bottomSouth + ((bottomNorth - bottomSouth) * fractionY);
+	float top = topSouth + ((topNorth - topSouth) * fractionY);
+	return bottom + ((top - bottom) * fractionZ);
+}
+
+//-----------------------------------------------------------------------------------
+//A field needs a lattice point at both ends of every cell it covers.
+int DensityField::CalculateLatticeDimension(int size, int step)
+{
+	if (size <= 1)
+	{
+		return 1;
+	}
+	return ((size - 1 + step - 1) / step) + 1;
+}
+
+//-----------------------------------------------------------------------------------
+void DensityField::CalculateAxisWeights(int size, int step, int latticeDimension, std::vector<int>& out_cells, std::vector<float>& out_fractions)
+{
+	out_cells.resize(size);
+	out_fractions.resize(size);
+	const float inverseStep = 1.0f / (float)step;
+	for (int i = 0; i < size; ++i)
+	{
+		int cell = i / step;
+		if (cell > latticeDimension - 1)
+		{
+			cell = latticeDimension - 1;
+		}
+		out_cells[i] = cell;
+		out_fractions[i] = (float)(i - (cell * step)) * inverseStep;
+	}
+}
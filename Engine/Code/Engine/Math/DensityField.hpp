@@ -0,0 +1,36 @@
+#pragma once
+#include "Engine/Math/Vector3.hpp"
+#include "Engine/Math/Vector3Int.hpp"
+#include <vector>
+
+//-----------------------------------------------------------------------------------
+//A coarse lattice of density samples, trilinearly interpolated back up to full resolution.
+//Sampling every N units instead of every unit cuts the number of noise evaluations by ~N^3
+//(or ~N^2 for a field that's only one layer deep). Lattice points sit on multiples of the step
+//relative to the origin, so neighboring fields that share a grid line agree along their seam.
+class DensityField
+{
+public:
+	typedef float (*SampleFunction)(const Vector3& position, void* userData);
+
+	//CONSTRUCTORS//////////////////////////////////////////////////////////////////////////
+	DensityField(const Vector3Int& size, const Vector3Int& step);
+
+	//FUNCTIONS//////////////////////////////////////////////////////////////////////////
+	void SampleLattice(const Vector3& origin, SampleFunction sampleFunction, void* userData);
+	void Interpolate(float* out_values) const;
+	float GetValueAt(int x, int y, int z) const;
+	inline int GetNumLatticeSamples() const { return m_latticeSize.x * m_latticeSize.y * m_latticeSize.z; };
+	inline float GetLatticeValue(int x, int y, int z) const { return m_lattice[(((z * m_latticeSize.y) + y) * m_latticeSize.x) + x]; };
+
+	//MEMBER VARIABLES//////////////////////////////////////////////////////////////////////////
+	Vector3Int m_size;
+	Vector3Int m_step;
+	Vector3Int m_latticeSize;
+
+private:
+	static int CalculateLatticeDimension(int size, int step);
+	static void CalculateAxisWeights(int size, int step, int latticeDimension, std::vector<int>& out_cells, std::vector<float>& out_fractions);
+
+	std::vector<float> m_lattice;
+};
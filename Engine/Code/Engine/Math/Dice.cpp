@@ -1,6 +1,8 @@
 #include "Engine/Math/Dice.hpp"
 #include "Engine/Core/StringUtils.hpp"
 #include "Engine/Math/MathUtils.hpp"
+#include "Engine/Math/NoiseSIMD.hpp"
+#include <vector>
 
 //-----------------------------------------------------------------------------------
 Dice::Dice(int numDice, int numSides, int bonusModifier /*= 0*/)
@@ -53,6 +55,32 @@ int Dice::Roll(unsigned int numRolls) const
     return diceRollResult;
 }
 
+//-----------------------------------------------------------------------------------
+//Stateless bulk rolls: roll i for a given seed always comes out the same, so a batch can be
+//regenerated later (or split across threads) without sharing rand()'s state.
+void Dice::RollSeeded(int* out_results, unsigned int numRolls, unsigned int seed, int firstRollIndex /*= 0*/) const
+{
+    const int numDiceToRoll = (int)numRolls * m_numDice;
+    if (numDiceToRoll <= 0)
+    {
+        return;
+    }
+    std::vector<unsigned int> dieNoise(numDiceToRoll);
+    Get1dNoiseUintSequence(firstRollIndex * m_numDice, &dieNoise[0], numDiceToRoll, seed);
+
+    const unsigned int numSides = (unsigned int)m_numSides;
+    const unsigned int* currentDie = &dieNoise[0];
+    for (unsigned int i = 0; i < numRolls; ++i)
+    {
+        int diceRollResult = 0;
+        for (int die = 0; die < m_numDice; ++die)
+        {
+            diceRollResult += (int)(*currentDie++ % numSides) + 1 + m_bonusModifier;
+        }
+        out_results[i] = diceRollResult;
+    }
+}
+
 int Dice::GetMaxRoll() const
 {
     return (m_numDice * m_numSides) + m_bonusModifier;
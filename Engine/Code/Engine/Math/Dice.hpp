@@ -14,6 +14,7 @@ public:
     //FUNCTIONS//////////////////////////////////////////////////////////////////////////
     int Roll() const;
     int Roll(unsigned int numRolls) const;
+    void RollSeeded(int* out_results, unsigned int numRolls, unsigned int seed, int firstRollIndex = 0) const;
     int GetMaxRoll() const;
     std::string ToString();
 private:
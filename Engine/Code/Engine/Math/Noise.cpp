@@ -12,6 +12,9 @@
 #include "Engine/Math/Vector2Int.hpp"
 #include "Engine/Math/Vector3.hpp"
 #include "Engine/Math/Vector4.hpp"
+#include "Engine/Core/ProfilingUtils.h"
+#include "Engine/Core/StringUtils.hpp"
+#include "Engine/Input/Console.hpp"
 
 
 //-----------------------------------------------------------------------------------------------
@@ -769,6 +772,83 @@ float Compute4dPerlinNoise( float posX, float posY, float posZ, float posT, floa
 
 
 
+//-----------------------------------------------------------------------------------------------
+// noisebench: times the runtime octave loops against the unrolled templates on the same inputs,
+//	and counts any samples where the two disagree in even a single bit.
+//
+typedef float (*NoiseBenchFunction)( float posX, float posY, float posZ );
+
+static float RuntimePerlin2dX5( float x, float y, float ) { return Compute2dPerlinNoise( x, y, 100.f, 5, 0.3f, 2.f, true, 0 ); }
+static float TemplatePerlin2dX5( float x, float y, float ) { return Compute2dPerlinNoise< 5, true >( x, y, 100.f, 0.3f, 2.f, 0 ); }
+static float RuntimePerlin2dX6( float x, float y, float ) { return Compute2dPerlinNoise( x, y, 70.f, 6, 0.5f, 2.f, true, 4 ); }
+static float TemplatePerlin2dX6( float x, float y, float ) { return Compute2dPerlinNoise< 6, true >( x, y, 70.f, 0.5f, 2.f, 4 ); }
+static float RuntimePerlin3dX4( float x, float y, float z ) { return Compute3dPerlinNoise( x, y, z, 30.f, 4, 0.5f, 2.f, true, 0 ); }
+static float TemplatePerlin3dX4( float x, float y, float z ) { return Compute3dPerlinNoise< 4, true >( x, y, z, 30.f, 0.5f, 2.f, 0 ); }
+static float RuntimeFractal2dX4( float x, float y, float ) { return Compute2dFractalNoise( x, y, 30.f, 4, 0.5f, 2.f, false, 0 ); }
+static float TemplateFractal2dX4( float x, float y, float ) { return Compute2dFractalNoise< 4, false >( x, y, 30.f, 0.5f, 2.f, 0 ); }
+static float RuntimeFractal3dX3( float x, float y, float z ) { return Compute3dFractalNoise( x, y, z, 30.f, 3, 0.5f, 2.f, true, 0 ); }
+static float TemplateFractal3dX3( float x, float y, float z ) { return Compute3dFractalNoise< 3, true >( x, y, z, 30.f, 0.5f, 2.f, 0 ); }
+
+
+//-----------------------------------------------------------------------------------------------
+static double TimeNoiseFunction( NoiseBenchFunction function, int numSamples, float& out_sum )
+{
+	StartTiming();
+	for( int i = 0; i < numSamples; ++ i )
+	{
+		out_sum += function( (float) (i & 1023) * 0.37f, (float) (i >> 10) * 0.61f, (float) (i & 127) );
+	}
+	return EndTiming();
+}
+
+
+//-----------------------------------------------------------------------------------------------
+static void RunNoiseBenchCase( const char* label, NoiseBenchFunction runtimeFunction, NoiseBenchFunction templateFunction, int numSamples )
+{
+	float runtimeSum = 0.f;
+	float templateSum = 0.f;
+	double runtimeSeconds = TimeNoiseFunction( runtimeFunction, numSamples, runtimeSum );
+	double templateSeconds = TimeNoiseFunction( templateFunction, numSamples, templateSum );
+
+	int numMismatches = 0;
+	for( int i = 0; i < numSamples; ++ i )
+	{
+		float x = (float) (i & 1023) * 0.37f;
+		float y = (float) (i >> 10) * 0.61f;
+		float z = (float) (i & 127);
+		if( runtimeFunction( x, y, z ) != templateFunction( x, y, z ) )
+		{
+			++ numMismatches;
+		}
+	}
+
+	RGBA color = (numMismatches == 0 && runtimeSum == templateSum) ? RGBA::WHITE : RGBA::RED;
+	Console::instance->PrintLine( Stringf( "%s: runtime %.01f ns, template %.01f ns, %.02fx, %i mismatches", label,
+		(runtimeSeconds * 1e9) / numSamples, (templateSeconds * 1e9) / numSamples, runtimeSeconds / templateSeconds, numMismatches ), color );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+CONSOLE_COMMAND( noisebench )
+{
+	if( !args.HasArgs( 1 ) )
+	{
+		Console::instance->PrintLine( "noisebench <# of samples>", RGBA::GRAY );
+		return;
+	}
+	const int numSamples = args.GetIntArgument( 0 );
+	if( numSamples <= 0 )
+	{
+		return;
+	}
+	RunNoiseBenchCase( "2d Perlin x5", &RuntimePerlin2dX5, &TemplatePerlin2dX5, numSamples );
+	RunNoiseBenchCase( "2d Perlin x6", &RuntimePerlin2dX6, &TemplatePerlin2dX6, numSamples );
+	RunNoiseBenchCase( "3d Perlin x4", &RuntimePerlin3dX4, &TemplatePerlin3dX4, numSamples );
+	RunNoiseBenchCase( "2d Fractal x4", &RuntimeFractal2dX4, &TemplateFractal2dX4, numSamples );
+	RunNoiseBenchCase( "3d Fractal x3", &RuntimeFractal3dX3, &TemplateFractal3dX3, numSamples );
+}
+
+
 /////////////////////////////////////////////////////////////////////////////////////////////////
 //
 // OLDER STUFF BELOW
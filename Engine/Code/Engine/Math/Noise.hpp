@@ -96,6 +96,17 @@ float Compute3dPerlinNoise( float posX, float posY, float posZ, float scale=1.f,
 float Compute4dPerlinNoise( float posX, float posY, float posZ, float posT, float scale=1.f, unsigned int numOctaves=1, float octavePersistence=0.5f, float octaveScale=2.f, bool renormalize=true, unsigned int seed=0 );
 
 
+//-----------------------------------------------------------------------------------------------
+// Compile-time variants of the above for callers whose octave count and renormalization are
+//	constants, e.g. Compute2dPerlinNoise< 5, true >( x, y, 100.f, 0.3f ).  The octave loop is
+//	fully unrolled; results are bit-identical to the runtime versions with the same arguments.
+//
+template< unsigned int NUM_OCTAVES, bool RENORMALIZE > float Compute2dFractalNoise( float posX, float posY, float scale=1.f, float octavePersistence=0.5f, float octaveScale=2.f, unsigned int seed=0 );
+template< unsigned int NUM_OCTAVES, bool RENORMALIZE > float Compute3dFractalNoise( float posX, float posY, float posZ, float scale=1.f, float octavePersistence=0.5f, float octaveScale=2.f, unsigned int seed=0 );
+template< unsigned int NUM_OCTAVES, bool RENORMALIZE > float Compute2dPerlinNoise( float posX, float posY, float scale=1.f, float octavePersistence=0.5f, float octaveScale=2.f, unsigned int seed=0 );
+template< unsigned int NUM_OCTAVES, bool RENORMALIZE > float Compute3dPerlinNoise( float posX, float posY, float posZ, float scale=1.f, float octavePersistence=0.5f, float octaveScale=2.f, unsigned int seed=0 );
+
+
 //-----------------------------------------------------------------------------------------------
 // Simplex noise functions (random-access / deterministic)
 //
@@ -202,6 +213,326 @@ inline float Get4dNoiseNegOneToOne( int indexX, int indexY, int indexZ, int inde
 
 
 
+//-----------------------------------------------------------------------------------------------
+// Single-octave kernels for the unrolled templates below.  They perform the same operations in
+//	the same order as one iteration of the loops in Noise.cpp, just without rebuilding the
+//	gradient tables or calling out-of-line vector math.  Positions are already scaled.
+//
+const float NOISE_OCTAVE_OFFSET = 0.636764989593174f; // Translation/bias to add to each octave
+
+const float PERLIN_GRADIENTS_2D[ 8 ][ 2 ] = // Normalized unit vectors in 8 quarter-cardinal directions
+{
+	{ +0.923879533f, +0.382683432f }, // 22.5 degrees
+	{ +0.382683432f, +0.923879533f }, // 67.5 degrees
+	{ -0.382683432f, +0.923879533f }, // 112.5 degrees
+	{ -0.923879533f, +0.382683432f }, // 157.5 degrees
+	{ -0.923879533f, -0.382683432f }, // 202.5 degrees
+	{ -0.382683432f, -0.923879533f }, // 247.5 degrees
+	{ +0.382683432f, -0.923879533f }, // 292.5 degrees
+	{ +0.923879533f, -0.382683432f }  // 337.5 degrees
+};
+
+const float PERLIN_GRADIENTS_3D[ 8 ][ 3 ] = // Unit vectors toward cube corners
+{
+	{ +fSQRT_3_OVER_3, +fSQRT_3_OVER_3, +fSQRT_3_OVER_3 },
+	{ -fSQRT_3_OVER_3, +fSQRT_3_OVER_3, +fSQRT_3_OVER_3 },
+	{ +fSQRT_3_OVER_3, -fSQRT_3_OVER_3, +fSQRT_3_OVER_3 },
+	{ -fSQRT_3_OVER_3, -fSQRT_3_OVER_3, +fSQRT_3_OVER_3 },
+	{ +fSQRT_3_OVER_3, +fSQRT_3_OVER_3, -fSQRT_3_OVER_3 },
+	{ -fSQRT_3_OVER_3, +fSQRT_3_OVER_3, -fSQRT_3_OVER_3 },
+	{ +fSQRT_3_OVER_3, -fSQRT_3_OVER_3, -fSQRT_3_OVER_3 },
+	{ -fSQRT_3_OVER_3, -fSQRT_3_OVER_3, -fSQRT_3_OVER_3 }
+};
+
+
+//-----------------------------------------------------------------------------------------------
+inline float Compute2dFractalNoiseOctave( float posX, float posY, unsigned int seed )
+{
+	// Determine noise values at nearby integer "grid point" positions
+	float cellMinsX = FastFloor( posX );
+	float cellMinsY = FastFloor( posY );
+	int indexWestX = (int) cellMinsX;
+	int indexSouthY = (int) cellMinsY;
+	int indexEastX = indexWestX + 1;
+	int indexNorthY = indexSouthY + 1;
+	float valueSouthWest = Get2dNoiseZeroToOne( indexWestX, indexSouthY, seed );
+	float valueSouthEast = Get2dNoiseZeroToOne( indexEastX, indexSouthY, seed );
+	float valueNorthWest = Get2dNoiseZeroToOne( indexWestX, indexNorthY, seed );
+	float valueNorthEast = Get2dNoiseZeroToOne( indexEastX, indexNorthY, seed );
+
+	// Do a smoothed (nonlinear) weighted average of nearby grid point values
+	float weightEast  = SmoothStep( posX - cellMinsX );
+	float weightNorth = SmoothStep( posY - cellMinsY );
+	float weightWest  = 1.f - weightEast;
+	float weightSouth = 1.f - weightNorth;
+
+	float blendSouth = (weightEast * valueSouthEast) + (weightWest * valueSouthWest);
+	float blendNorth = (weightEast * valueNorthEast) + (weightWest * valueNorthWest);
+	float blendTotal = (weightSouth * blendSouth) + (weightNorth * blendNorth);
+	return 2.f * (blendTotal - 0.5f); // Map from [0,1] to [-1,1]
+}
+
+
+//-----------------------------------------------------------------------------------------------
+inline float Compute3dFractalNoiseOctave( float posX, float posY, float posZ, unsigned int seed )
+{
+	// Determine noise values at nearby integer "grid point" positions
+	float cellMinsX = FastFloor( posX );
+	float cellMinsY = FastFloor( posY );
+	float cellMinsZ = FastFloor( posZ );
+	int indexWestX  = (int) cellMinsX;
+	int indexSouthY = (int) cellMinsY;
+	int indexBelowZ = (int) cellMinsZ;
+	int indexEastX  = indexWestX + 1;
+	int indexNorthY = indexSouthY + 1;
+	int indexAboveZ = indexBelowZ + 1;
+
+	// Noise grid cell has 8 corners in 3D
+	float aboveSouthWest = Get3dNoiseZeroToOne( indexWestX, indexSouthY, indexAboveZ, seed );
+	float aboveSouthEast = Get3dNoiseZeroToOne( indexEastX, indexSouthY, indexAboveZ, seed );
+	float aboveNorthWest = Get3dNoiseZeroToOne( indexWestX, indexNorthY, indexAboveZ, seed );
+	float aboveNorthEast = Get3dNoiseZeroToOne( indexEastX, indexNorthY, indexAboveZ, seed );
+	float belowSouthWest = Get3dNoiseZeroToOne( indexWestX, indexSouthY, indexBelowZ, seed );
+	float belowSouthEast = Get3dNoiseZeroToOne( indexEastX, indexSouthY, indexBelowZ, seed );
+	float belowNorthWest = Get3dNoiseZeroToOne( indexWestX, indexNorthY, indexBelowZ, seed );
+	float belowNorthEast = Get3dNoiseZeroToOne( indexEastX, indexNorthY, indexBelowZ, seed );
+
+	// Do a smoothed (nonlinear) weighted average of nearby grid point values
+	float weightEast  = SmoothStep( posX - cellMinsX );
+	float weightNorth = SmoothStep( posY - cellMinsY );
+	float weightAbove = SmoothStep( posZ - cellMinsZ );
+	float weightWest  = 1.f - weightEast;
+	float weightSouth = 1.f - weightNorth;
+	float weightBelow = 1.f - weightAbove;
+
+	// 8-way blend (8 -> 4 -> 2 -> 1)
+	float blendBelowSouth = (weightEast * belowSouthEast) + (weightWest * belowSouthWest);
+	float blendBelowNorth = (weightEast * belowNorthEast) + (weightWest * belowNorthWest);
+	float blendAboveSouth = (weightEast * aboveSouthEast) + (weightWest * aboveSouthWest);
+	float blendAboveNorth = (weightEast * aboveNorthEast) + (weightWest * aboveNorthWest);
+	float blendBelow = (weightSouth * blendBelowSouth) + (weightNorth * blendBelowNorth);
+	float blendAbove = (weightSouth * blendAboveSouth) + (weightNorth * blendAboveNorth);
+	float blendTotal = (weightBelow * blendBelow) + (weightAbove * blendAbove);
+	return 2.f * (blendTotal - 0.5f); // Map from [0,1] to [-1,1]
+}
+
+
+//-----------------------------------------------------------------------------------------------
+inline float Compute2dPerlinNoiseOctave( float posX, float posY, unsigned int seed )
+{
+	// Determine random unit "gradient vectors" for surrounding corners
+	float cellMinsX = FastFloor( posX );
+	float cellMinsY = FastFloor( posY );
+	float cellMaxsX = cellMinsX + 1.f;
+	float cellMaxsY = cellMinsY + 1.f;
+	int indexWestX  = (int) cellMinsX;
+	int indexSouthY = (int) cellMinsY;
+	int indexEastX  = indexWestX  + 1;
+	int indexNorthY = indexSouthY + 1;
+
+	const float* gradientSW = PERLIN_GRADIENTS_2D[ Get2dNoiseUint( indexWestX, indexSouthY, seed ) & 0x00000007 ];
+	const float* gradientSE = PERLIN_GRADIENTS_2D[ Get2dNoiseUint( indexEastX, indexSouthY, seed ) & 0x00000007 ];
+	const float* gradientNW = PERLIN_GRADIENTS_2D[ Get2dNoiseUint( indexWestX, indexNorthY, seed ) & 0x00000007 ];
+	const float* gradientNE = PERLIN_GRADIENTS_2D[ Get2dNoiseUint( indexEastX, indexNorthY, seed ) & 0x00000007 ];
+
+	// Dot each corner's gradient with displacement from corner to position
+	float displacementWest  = posX - cellMinsX;
+	float displacementEast  = posX - cellMaxsX;
+	float displacementSouth = posY - cellMinsY;
+	float displacementNorth = posY - cellMaxsY;
+
+	float dotSouthWest = (gradientSW[0] * displacementWest) + (gradientSW[1] * displacementSouth);
+	float dotSouthEast = (gradientSE[0] * displacementEast) + (gradientSE[1] * displacementSouth);
+	float dotNorthWest = (gradientNW[0] * displacementWest) + (gradientNW[1] * displacementNorth);
+	float dotNorthEast = (gradientNE[0] * displacementEast) + (gradientNE[1] * displacementNorth);
+
+	// Do a smoothed (nonlinear) weighted average of dot results
+	float weightEast = SmoothStep5( displacementWest );
+	float weightNorth = SmoothStep5( displacementSouth );
+	float weightWest = 1.f - weightEast;
+	float weightSouth = 1.f - weightNorth;
+
+	float blendSouth = (weightEast * dotSouthEast) + (weightWest * dotSouthWest);
+	float blendNorth = (weightEast * dotNorthEast) + (weightWest * dotNorthWest);
+	float blendTotal = (weightSouth * blendSouth) + (weightNorth * blendNorth);
+	return 1.5f * blendTotal; // 2D Perlin is in ~[-.66,.66]; map to ~[-1,1]
+}
+
+
+//-----------------------------------------------------------------------------------------------
+inline float Compute3dPerlinNoiseOctave( float posX, float posY, float posZ, unsigned int seed )
+{
+	// Determine random unit "gradient vectors" for surrounding corners
+	float cellMinsX = FastFloor( posX );
+	float cellMinsY = FastFloor( posY );
+	float cellMinsZ = FastFloor( posZ );
+	float cellMaxsX = cellMinsX + 1.f;
+	float cellMaxsY = cellMinsY + 1.f;
+	float cellMaxsZ = cellMinsZ + 1.f;
+	int indexWestX  = (int) cellMinsX;
+	int indexSouthY = (int) cellMinsY;
+	int indexBelowZ = (int) cellMinsZ;
+	int indexEastX  = indexWestX  + 1;
+	int indexNorthY = indexSouthY + 1;
+	int indexAboveZ = indexBelowZ + 1;
+
+	const float* gradientBelowSW = PERLIN_GRADIENTS_3D[ Get3dNoiseUint( indexWestX, indexSouthY, indexBelowZ, seed ) & 0x00000007 ];
+	const float* gradientBelowSE = PERLIN_GRADIENTS_3D[ Get3dNoiseUint( indexEastX, indexSouthY, indexBelowZ, seed ) & 0x00000007 ];
+	const float* gradientBelowNW = PERLIN_GRADIENTS_3D[ Get3dNoiseUint( indexWestX, indexNorthY, indexBelowZ, seed ) & 0x00000007 ];
+	const float* gradientBelowNE = PERLIN_GRADIENTS_3D[ Get3dNoiseUint( indexEastX, indexNorthY, indexBelowZ, seed ) & 0x00000007 ];
+	const float* gradientAboveSW = PERLIN_GRADIENTS_3D[ Get3dNoiseUint( indexWestX, indexSouthY, indexAboveZ, seed ) & 0x00000007 ];
+	const float* gradientAboveSE = PERLIN_GRADIENTS_3D[ Get3dNoiseUint( indexEastX, indexSouthY, indexAboveZ, seed ) & 0x00000007 ];
+	const float* gradientAboveNW = PERLIN_GRADIENTS_3D[ Get3dNoiseUint( indexWestX, indexNorthY, indexAboveZ, seed ) & 0x00000007 ];
+	const float* gradientAboveNE = PERLIN_GRADIENTS_3D[ Get3dNoiseUint( indexEastX, indexNorthY, indexAboveZ, seed ) & 0x00000007 ];
+
+	// Dot each corner's gradient with displacement from corner to position
+	float displacementWest  = posX - cellMinsX;
+	float displacementEast  = posX - cellMaxsX;
+	float displacementSouth = posY - cellMinsY;
+	float displacementNorth = posY - cellMaxsY;
+	float displacementBelow = posZ - cellMinsZ;
+	float displacementAbove = posZ - cellMaxsZ;
+
+	float dotBelowSW = (gradientBelowSW[0] * displacementWest) + (gradientBelowSW[1] * displacementSouth) + (gradientBelowSW[2] * displacementBelow);
+	float dotBelowSE = (gradientBelowSE[0] * displacementEast) + (gradientBelowSE[1] * displacementSouth) + (gradientBelowSE[2] * displacementBelow);
+	float dotBelowNW = (gradientBelowNW[0] * displacementWest) + (gradientBelowNW[1] * displacementNorth) + (gradientBelowNW[2] * displacementBelow);
+	float dotBelowNE = (gradientBelowNE[0] * displacementEast) + (gradientBelowNE[1] * displacementNorth) + (gradientBelowNE[2] * displacementBelow);
+	float dotAboveSW = (gradientAboveSW[0] * displacementWest) + (gradientAboveSW[1] * displacementSouth) + (gradientAboveSW[2] * displacementAbove);
+	float dotAboveSE = (gradientAboveSE[0] * displacementEast) + (gradientAboveSE[1] * displacementSouth) + (gradientAboveSE[2] * displacementAbove);
+	float dotAboveNW = (gradientAboveNW[0] * displacementWest) + (gradientAboveNW[1] * displacementNorth) + (gradientAboveNW[2] * displacementAbove);
+	float dotAboveNE = (gradientAboveNE[0] * displacementEast) + (gradientAboveNE[1] * displacementNorth) + (gradientAboveNE[2] * displacementAbove);
+
+	// Do a smoothed (nonlinear) weighted average of dot results
+	float weightEast  = SmoothStep5( displacementWest );
+	float weightNorth = SmoothStep5( displacementSouth );
+	float weightAbove = SmoothStep5( displacementBelow );
+	float weightWest  = 1.f - weightEast;
+	float weightSouth = 1.f - weightNorth;
+	float weightBelow = 1.f - weightAbove;
+
+	// 8-way blend (8 -> 4 -> 2 -> 1)
+	float blendBelowSouth = (weightEast * dotBelowSE) + (weightWest * dotBelowSW);
+	float blendBelowNorth = (weightEast * dotBelowNE) + (weightWest * dotBelowNW);
+	float blendAboveSouth = (weightEast * dotAboveSE) + (weightWest * dotAboveSW);
+	float blendAboveNorth = (weightEast * dotAboveNE) + (weightWest * dotAboveNW);
+	float blendBelow = (weightSouth * blendBelowSouth) + (weightNorth * blendBelowNorth);
+	float blendAbove = (weightSouth * blendAboveSouth) + (weightNorth * blendAboveNorth);
+	float blendTotal = (weightBelow * blendBelow) + (weightAbove * blendAbove);
+	return 1.66666666f * blendTotal; // 3D Perlin is ~[-.6,.6]; map to ~[-1,1]
+}
+
+
+//-----------------------------------------------------------------------------------------------
+// Compile-time octave unrolling.  Each level adds one octave and recurses with the next
+//	position/amplitude/seed, in exactly the order the runtime loops use.
+//
+template< unsigned int OCTAVES_LEFT >
+struct NoiseOctaveUnroller
+{
+	template< float (*OCTAVE_FUNCTION)( float, float, unsigned int ) >
+	static inline void Accumulate2d( float posX, float posY, float currentAmplitude, float octavePersistence, float octaveScale, unsigned int seed, float& totalNoise, float& totalAmplitude )
+	{
+		totalNoise += OCTAVE_FUNCTION( posX, posY, seed ) * currentAmplitude;
+		totalAmplitude += currentAmplitude;
+		NoiseOctaveUnroller< OCTAVES_LEFT - 1 >::template Accumulate2d< OCTAVE_FUNCTION >( (posX * octaveScale) + NOISE_OCTAVE_OFFSET, (posY * octaveScale) + NOISE_OCTAVE_OFFSET,
+			currentAmplitude * octavePersistence, octavePersistence, octaveScale, seed + 1, totalNoise, totalAmplitude );
+	}
+
+	template< float (*OCTAVE_FUNCTION)( float, float, float, unsigned int ) >
+	static inline void Accumulate3d( float posX, float posY, float posZ, float currentAmplitude, float octavePersistence, float octaveScale, unsigned int seed, float& totalNoise, float& totalAmplitude )
+	{
+		totalNoise += OCTAVE_FUNCTION( posX, posY, posZ, seed ) * currentAmplitude;
+		totalAmplitude += currentAmplitude;
+		NoiseOctaveUnroller< OCTAVES_LEFT - 1 >::template Accumulate3d< OCTAVE_FUNCTION >( (posX * octaveScale) + NOISE_OCTAVE_OFFSET, (posY * octaveScale) + NOISE_OCTAVE_OFFSET, (posZ * octaveScale) + NOISE_OCTAVE_OFFSET,
+			currentAmplitude * octavePersistence, octavePersistence, octaveScale, seed + 1, totalNoise, totalAmplitude );
+	}
+};
+
+template<>
+struct NoiseOctaveUnroller< 0 >
+{
+	template< float (*OCTAVE_FUNCTION)( float, float, unsigned int ) >
+	static inline void Accumulate2d( float, float, float, float, float, unsigned int, float&, float& ) {}
+
+	template< float (*OCTAVE_FUNCTION)( float, float, float, unsigned int ) >
+	static inline void Accumulate3d( float, float, float, float, float, float, unsigned int, float&, float& ) {}
+};
+
+
+//-----------------------------------------------------------------------------------------------
+template< bool RENORMALIZE >
+struct NoiseRenormalizer
+{
+	static inline float Apply( float totalNoise, float totalAmplitude )
+	{
+		// Re-normalize total noise to within [-1,1] and fix octaves pulling us far away from limits
+		if( totalAmplitude > 0.f )
+		{
+			totalNoise /= totalAmplitude;				// Amplitude exceeds 1.0 if octaves are used
+			totalNoise = (totalNoise * 0.5f) + 0.5f;	// Map to [0,1]
+			totalNoise = SmoothStep( totalNoise );		// Push towards extents (octaves pull us away)
+			totalNoise = (totalNoise * 2.0f) - 1.f;		// Map back to [-1,1]
+		}
+		return totalNoise;
+	}
+};
+
+template<>
+struct NoiseRenormalizer< false >
+{
+	static inline float Apply( float totalNoise, float ) { return totalNoise; }
+};
+
+
+//-----------------------------------------------------------------------------------------------
+template< unsigned int NUM_OCTAVES, bool RENORMALIZE >
+float Compute2dFractalNoise( float posX, float posY, float scale, float octavePersistence, float octaveScale, unsigned int seed )
+{
+	float totalNoise = 0.f;
+	float totalAmplitude = 0.f;
+	float invScale = (1.f / scale);
+	NoiseOctaveUnroller< NUM_OCTAVES >::template Accumulate2d< &Compute2dFractalNoiseOctave >( posX * invScale, posY * invScale, 1.f, octavePersistence, octaveScale, seed, totalNoise, totalAmplitude );
+	return NoiseRenormalizer< RENORMALIZE >::Apply( totalNoise, totalAmplitude );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+template< unsigned int NUM_OCTAVES, bool RENORMALIZE >
+float Compute3dFractalNoise( float posX, float posY, float posZ, float scale, float octavePersistence, float octaveScale, unsigned int seed )
+{
+	float totalNoise = 0.f;
+	float totalAmplitude = 0.f;
+	float invScale = (1.f / scale);
+	NoiseOctaveUnroller< NUM_OCTAVES >::template Accumulate3d< &Compute3dFractalNoiseOctave >( posX * invScale, posY * invScale, posZ * invScale, 1.f, octavePersistence, octaveScale, seed, totalNoise, totalAmplitude );
+	return NoiseRenormalizer< RENORMALIZE >::Apply( totalNoise, totalAmplitude );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+template< unsigned int NUM_OCTAVES, bool RENORMALIZE >
+float Compute2dPerlinNoise( float posX, float posY, float scale, float octavePersistence, float octaveScale, unsigned int seed )
+{
+	float totalNoise = 0.f;
+	float totalAmplitude = 0.f;
+	float invScale = (1.f / scale);
+	NoiseOctaveUnroller< NUM_OCTAVES >::template Accumulate2d< &Compute2dPerlinNoiseOctave >( posX * invScale, posY * invScale, 1.f, octavePersistence, octaveScale, seed, totalNoise, totalAmplitude );
+	return NoiseRenormalizer< RENORMALIZE >::Apply( totalNoise, totalAmplitude );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+template< unsigned int NUM_OCTAVES, bool RENORMALIZE >
+float Compute3dPerlinNoise( float posX, float posY, float posZ, float scale, float octavePersistence, float octaveScale, unsigned int seed )
+{
+	float totalNoise = 0.f;
+	float totalAmplitude = 0.f;
+	float invScale = (1.f / scale);
+	NoiseOctaveUnroller< NUM_OCTAVES >::template Accumulate3d< &Compute3dPerlinNoiseOctave >( posX * invScale, posY * invScale, posZ * invScale, 1.f, octavePersistence, octaveScale, seed, totalNoise, totalAmplitude );
+	return NoiseRenormalizer< RENORMALIZE >::Apply( totalNoise, totalAmplitude );
+}
+
+
+
 /////////////////////////////////////////////////////////////////////////////////////////////////
 //
 // OLDER STUFF BELOW
@@ -0,0 +1,496 @@
+//-----------------------------------------------------------------------------------------------
+// NoiseSIMD.cpp
+// Lane-parallel versions of the SquirrelNoise hash functions in Noise.hpp
+
+//-----------------------------------------------------------------------------------------------
+#include "Engine/Math/NoiseSIMD.hpp"
+#include "Engine/Math/Noise.hpp"
+#include "Engine/Core/ProfilingUtils.h"
+#include "Engine/Core/StringUtils.hpp"
+#include "Engine/Input/Console.hpp"
+#include <immintrin.h>
+#include <atomic>
+#include <vector>
+#if defined( _MSC_VER )
+#include <intrin.h>
+#define NOISE_AVX2_FUNCTION
+#define NOISE_HAS_AVX2_PATH 1
+#elif defined( __GNUC__ ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+#include <cpuid.h>
+#define NOISE_AVX2_FUNCTION __attribute__(( target( "avx2" ) ))
+#define NOISE_HAS_AVX2_PATH 1
+#else
+#define NOISE_HAS_AVX2_PATH 0
+#endif
+
+
+//-----------------------------------------------------------------------------------------------
+// Which mapping a batch applies to the raw hash before writing it out.
+//
+enum NoiseBatchOutput
+{
+	NOISE_OUTPUT_UINT,
+	NOISE_OUTPUT_ZERO_TO_ONE,
+	NOISE_OUTPUT_NEG_ONE_TO_ONE
+};
+
+// Unused dimensions are passed as null index arrays, which contribute nothing to the combined index.
+struct NoiseBatch
+{
+	const int* m_indicesX;
+	const int* m_indicesY;
+	const int* m_indicesZ;
+	const int* m_indicesT;
+	void* m_output;
+	NoiseBatchOutput m_outputType;
+	unsigned int m_seed;
+};
+
+static const unsigned int PRIME_Y = 198491317;
+static const unsigned int PRIME_Z = 6542989;
+static const unsigned int PRIME_T = 357239;
+
+
+//-----------------------------------------------------------------------------------------------
+// Folding is done in unsigned math so the scalar tail wraps exactly like the vector lanes.
+//
+static inline int CombineNoiseIndices( const NoiseBatch& batch, int i )
+{
+	unsigned int combined = (unsigned int) batch.m_indicesX[ i ];
+	if( batch.m_indicesY )
+		combined += PRIME_Y * (unsigned int) batch.m_indicesY[ i ];
+	if( batch.m_indicesZ )
+		combined += PRIME_Z * (unsigned int) batch.m_indicesZ[ i ];
+	if( batch.m_indicesT )
+		combined += PRIME_T * (unsigned int) batch.m_indicesT[ i ];
+	return (int) combined;
+}
+
+
+//-----------------------------------------------------------------------------------------------
+static void ComputeNoiseBatchScalar( const NoiseBatch& batch, int first, int end )
+{
+	const double ONE_OVER_MAX_UINT = (1.0 / (double) 0xFFFFFFFF);
+	const double ONE_OVER_MAX_INT = (1.0 / (double) 0x7FFFFFFF);
+	for( int i = first; i < end; ++ i )
+	{
+		unsigned int noise = Get1dNoiseUint( CombineNoiseIndices( batch, i ), batch.m_seed );
+		switch( batch.m_outputType )
+		{
+		case NOISE_OUTPUT_UINT:
+			static_cast< unsigned int* >( batch.m_output )[ i ] = noise;
+			break;
+		case NOISE_OUTPUT_ZERO_TO_ONE:
+			static_cast< float* >( batch.m_output )[ i ] = (float)( ONE_OVER_MAX_UINT * (double) noise );
+			break;
+		case NOISE_OUTPUT_NEG_ONE_TO_ONE:
+			static_cast< float* >( batch.m_output )[ i ] = (float)( ONE_OVER_MAX_INT * (double) (int) noise );
+			break;
+		}
+	}
+}
+
+
+//-----------------------------------------------------------------------------------------------
+static int ComputeNoiseBatchSSE2( const NoiseBatch& batch, int first, int end )
+{
+	const __m128i PRIME1 = _mm_set1_epi32( (int) PRIME_Y );
+	const __m128i PRIME2 = _mm_set1_epi32( (int) PRIME_Z );
+	const __m128i PRIME3 = _mm_set1_epi32( (int) PRIME_T );
+	int i = first;
+	for( ; i + 4 <= end; i += 4 )
+	{
+		__m128i combined = _mm_loadu_si128( (const __m128i*) ( batch.m_indicesX + i ) );
+		if( batch.m_indicesY )
+			combined = _mm_add_epi32( combined, MultiplyLow32( PRIME1, _mm_loadu_si128( (const __m128i*) ( batch.m_indicesY + i ) ) ) );
+		if( batch.m_indicesZ )
+			combined = _mm_add_epi32( combined, MultiplyLow32( PRIME2, _mm_loadu_si128( (const __m128i*) ( batch.m_indicesZ + i ) ) ) );
+		if( batch.m_indicesT )
+			combined = _mm_add_epi32( combined, MultiplyLow32( PRIME3, _mm_loadu_si128( (const __m128i*) ( batch.m_indicesT + i ) ) ) );
+
+		__m128i noise = Get1dNoiseUint4( combined, batch.m_seed );
+		switch( batch.m_outputType )
+		{
+		case NOISE_OUTPUT_UINT:
+			_mm_storeu_si128( (__m128i*) ( static_cast< unsigned int* >( batch.m_output ) + i ), noise );
+			break;
+		case NOISE_OUTPUT_ZERO_TO_ONE:
+			_mm_storeu_ps( static_cast< float* >( batch.m_output ) + i, MapNoiseUint4ToZeroToOne( noise ) );
+			break;
+		case NOISE_OUTPUT_NEG_ONE_TO_ONE:
+			_mm_storeu_ps( static_cast< float* >( batch.m_output ) + i, MapNoiseUint4ToNegOneToOne( noise ) );
+			break;
+		}
+	}
+	return i;
+}
+
+
+#if NOISE_HAS_AVX2_PATH
+//-----------------------------------------------------------------------------------------------
+NOISE_AVX2_FUNCTION static inline __m256i Get1dNoiseUint8( __m256i indices, unsigned int seed )
+{
+	__m256i mangledBits = _mm256_mullo_epi32( indices, _mm256_set1_epi32( (int) 0xB5297A4D ) );
+	mangledBits = _mm256_add_epi32( mangledBits, _mm256_set1_epi32( (int) seed ) );
+	mangledBits = _mm256_xor_si256( mangledBits, _mm256_srli_epi32( mangledBits, 8 ) );
+	mangledBits = _mm256_add_epi32( mangledBits, _mm256_set1_epi32( (int) 0x68E31DA4 ) );
+	mangledBits = _mm256_xor_si256( mangledBits, _mm256_slli_epi32( mangledBits, 8 ) );
+	mangledBits = _mm256_mullo_epi32( mangledBits, _mm256_set1_epi32( (int) 0x1B56C4E9 ) );
+	mangledBits = _mm256_xor_si256( mangledBits, _mm256_srli_epi32( mangledBits, 8 ) );
+	return mangledBits;
+}
+
+
+//-----------------------------------------------------------------------------------------------
+// Same double-precision mapping as MapNoiseUint4ToZeroToOne(), four lanes per conversion.
+//
+NOISE_AVX2_FUNCTION static inline void StoreNoiseUint8AsFloats( __m256i noise, float* out_values, bool zeroToOne )
+{
+	__m256d scale = _mm256_set1_pd( 1.0 / (double) 0x7FFFFFFF );
+	__m256d offset = _mm256_setzero_pd();
+	if( zeroToOne )
+	{
+		noise = _mm256_xor_si256( noise, _mm256_set1_epi32( (int) 0x80000000 ) );
+		scale = _mm256_set1_pd( 1.0 / (double) 0xFFFFFFFF );
+		offset = _mm256_set1_pd( 2147483648.0 );
+	}
+	__m256d low = _mm256_add_pd( _mm256_cvtepi32_pd( _mm256_castsi256_si128( noise ) ), offset );
+	__m256d high = _mm256_add_pd( _mm256_cvtepi32_pd( _mm256_extracti128_si256( noise, 1 ) ), offset );
+	_mm_storeu_ps( out_values, _mm256_cvtpd_ps( _mm256_mul_pd( low, scale ) ) );
+	_mm_storeu_ps( out_values + 4, _mm256_cvtpd_ps( _mm256_mul_pd( high, scale ) ) );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+NOISE_AVX2_FUNCTION static int ComputeNoiseBatchAVX2( const NoiseBatch& batch, int first, int end )
+{
+	const __m256i PRIME1 = _mm256_set1_epi32( (int) PRIME_Y );
+	const __m256i PRIME2 = _mm256_set1_epi32( (int) PRIME_Z );
+	const __m256i PRIME3 = _mm256_set1_epi32( (int) PRIME_T );
+	int i = first;
+	for( ; i + 8 <= end; i += 8 )
+	{
+		__m256i combined = _mm256_loadu_si256( (const __m256i*) ( batch.m_indicesX + i ) );
+		if( batch.m_indicesY )
+			combined = _mm256_add_epi32( combined, _mm256_mullo_epi32( PRIME1, _mm256_loadu_si256( (const __m256i*) ( batch.m_indicesY + i ) ) ) );
+		if( batch.m_indicesZ )
+			combined = _mm256_add_epi32( combined, _mm256_mullo_epi32( PRIME2, _mm256_loadu_si256( (const __m256i*) ( batch.m_indicesZ + i ) ) ) );
+		if( batch.m_indicesT )
+			combined = _mm256_add_epi32( combined, _mm256_mullo_epi32( PRIME3, _mm256_loadu_si256( (const __m256i*) ( batch.m_indicesT + i ) ) ) );
+
+		__m256i noise = Get1dNoiseUint8( combined, batch.m_seed );
+		if( batch.m_outputType == NOISE_OUTPUT_UINT )
+			_mm256_storeu_si256( (__m256i*) ( static_cast< unsigned int* >( batch.m_output ) + i ), noise );
+		else
+			StoreNoiseUint8AsFloats( noise, static_cast< float* >( batch.m_output ) + i, batch.m_outputType == NOISE_OUTPUT_ZERO_TO_ONE );
+	}
+	return i;
+}
+
+
+//-----------------------------------------------------------------------------------------------
+NOISE_AVX2_FUNCTION static void Get1dNoiseUintSequenceAVX2( int firstIndex, unsigned int* out_noise, int count, unsigned int seed )
+{
+	const __m256i LANE_STEP = _mm256_set1_epi32( 8 );
+	__m256i indices = _mm256_add_epi32( _mm256_set1_epi32( firstIndex ), _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 ) );
+	int i = 0;
+	for( ; i + 8 <= count; i += 8 )
+	{
+		_mm256_storeu_si256( (__m256i*) ( out_noise + i ), Get1dNoiseUint8( indices, seed ) );
+		indices = _mm256_add_epi32( indices, LANE_STEP );
+	}
+	for( ; i < count; ++ i )
+	{
+		out_noise[ i ] = Get1dNoiseUint( (int) ( (unsigned int) firstIndex + (unsigned int) i ), seed );
+	}
+}
+#endif
+
+
+//-----------------------------------------------------------------------------------------------
+// AVX2 needs both the instructions (CPUID leaf 7) and an OS that saves the ymm registers (XCR0).
+//
+static bool DetectAVX2Support()
+{
+#if defined( _MSC_VER )
+	int cpuInfo[ 4 ];
+	__cpuid( cpuInfo, 0 );
+	if( cpuInfo[ 0 ] < 7 )
+		return false;
+	__cpuid( cpuInfo, 1 );
+	const bool osSavesYmm = ( ( cpuInfo[ 2 ] & ( 1 << 27 ) ) != 0 ) && ( ( _xgetbv( 0 ) & 0x6 ) == 0x6 );
+	__cpuidex( cpuInfo, 7, 0 );
+	return osSavesYmm && ( ( cpuInfo[ 1 ] & ( 1 << 5 ) ) != 0 );
+#elif NOISE_HAS_AVX2_PATH
+	__builtin_cpu_init();
+	return __builtin_cpu_supports( "avx2" ) != 0;
+#else
+	return false;
+#endif
+}
+
+
+//-----------------------------------------------------------------------------------------------
+static bool s_isAVX2Supported = DetectAVX2Support();
+// The bench turns AVX2 off from the main thread while the generation thread may be mid-batch.
+static std::atomic< bool > s_allowAVX2( true );
+
+bool IsNoiseAVX2Supported()
+{
+	return s_isAVX2Supported;
+}
+
+
+//-----------------------------------------------------------------------------------------------
+static void ComputeNoiseBatch( const NoiseBatch& batch, int count )
+{
+	int i = 0;
+#if NOISE_HAS_AVX2_PATH
+	if( s_isAVX2Supported && s_allowAVX2 )
+		i = ComputeNoiseBatchAVX2( batch, i, count );
+#endif
+	i = ComputeNoiseBatchSSE2( batch, i, count );
+	ComputeNoiseBatchScalar( batch, i, count );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+static void ComputeNoiseBatch( const int* indicesX, const int* indicesY, const int* indicesZ, const int* indicesT, void* out_noise, NoiseBatchOutput outputType, int count, unsigned int seed )
+{
+	NoiseBatch batch = { indicesX, indicesY, indicesZ, indicesT, out_noise, outputType, seed };
+	ComputeNoiseBatch( batch, count );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+void Get1dNoiseUints( const int* indices, unsigned int* out_noise, int count, unsigned int seed )
+{
+	ComputeNoiseBatch( indices, nullptr, nullptr, nullptr, out_noise, NOISE_OUTPUT_UINT, count, seed );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+void Get2dNoiseUints( const int* indicesX, const int* indicesY, unsigned int* out_noise, int count, unsigned int seed )
+{
+	ComputeNoiseBatch( indicesX, indicesY, nullptr, nullptr, out_noise, NOISE_OUTPUT_UINT, count, seed );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+void Get3dNoiseUints( const int* indicesX, const int* indicesY, const int* indicesZ, unsigned int* out_noise, int count, unsigned int seed )
+{
+	ComputeNoiseBatch( indicesX, indicesY, indicesZ, nullptr, out_noise, NOISE_OUTPUT_UINT, count, seed );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+void Get4dNoiseUints( const int* indicesX, const int* indicesY, const int* indicesZ, const int* indicesT, unsigned int* out_noise, int count, unsigned int seed )
+{
+	ComputeNoiseBatch( indicesX, indicesY, indicesZ, indicesT, out_noise, NOISE_OUTPUT_UINT, count, seed );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+void Get1dNoiseZeroToOnes( const int* indices, float* out_noise, int count, unsigned int seed )
+{
+	ComputeNoiseBatch( indices, nullptr, nullptr, nullptr, out_noise, NOISE_OUTPUT_ZERO_TO_ONE, count, seed );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+void Get2dNoiseZeroToOnes( const int* indicesX, const int* indicesY, float* out_noise, int count, unsigned int seed )
+{
+	ComputeNoiseBatch( indicesX, indicesY, nullptr, nullptr, out_noise, NOISE_OUTPUT_ZERO_TO_ONE, count, seed );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+void Get3dNoiseZeroToOnes( const int* indicesX, const int* indicesY, const int* indicesZ, float* out_noise, int count, unsigned int seed )
+{
+	ComputeNoiseBatch( indicesX, indicesY, indicesZ, nullptr, out_noise, NOISE_OUTPUT_ZERO_TO_ONE, count, seed );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+void Get4dNoiseZeroToOnes( const int* indicesX, const int* indicesY, const int* indicesZ, const int* indicesT, float* out_noise, int count, unsigned int seed )
+{
+	ComputeNoiseBatch( indicesX, indicesY, indicesZ, indicesT, out_noise, NOISE_OUTPUT_ZERO_TO_ONE, count, seed );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+void Get1dNoiseNegOneToOnes( const int* indices, float* out_noise, int count, unsigned int seed )
+{
+	ComputeNoiseBatch( indices, nullptr, nullptr, nullptr, out_noise, NOISE_OUTPUT_NEG_ONE_TO_ONE, count, seed );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+void Get2dNoiseNegOneToOnes( const int* indicesX, const int* indicesY, float* out_noise, int count, unsigned int seed )
+{
+	ComputeNoiseBatch( indicesX, indicesY, nullptr, nullptr, out_noise, NOISE_OUTPUT_NEG_ONE_TO_ONE, count, seed );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+void Get3dNoiseNegOneToOnes( const int* indicesX, const int* indicesY, const int* indicesZ, float* out_noise, int count, unsigned int seed )
+{
+	ComputeNoiseBatch( indicesX, indicesY, indicesZ, nullptr, out_noise, NOISE_OUTPUT_NEG_ONE_TO_ONE, count, seed );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+void Get4dNoiseNegOneToOnes( const int* indicesX, const int* indicesY, const int* indicesZ, const int* indicesT, float* out_noise, int count, unsigned int seed )
+{
+	ComputeNoiseBatch( indicesX, indicesY, indicesZ, indicesT, out_noise, NOISE_OUTPUT_NEG_ONE_TO_ONE, count, seed );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+// Generates its own indices instead of reading them, so it never touches an index array.
+//
+void Get1dNoiseUintSequence( int firstIndex, unsigned int* out_noise, int count, unsigned int seed )
+{
+#if NOISE_HAS_AVX2_PATH
+	if( s_isAVX2Supported && s_allowAVX2 )
+	{
+		Get1dNoiseUintSequenceAVX2( firstIndex, out_noise, count, seed );
+		return;
+	}
+#endif
+	const __m128i LANE_STEP = _mm_set1_epi32( 4 );
+	__m128i indices = _mm_add_epi32( _mm_set1_epi32( firstIndex ), _mm_setr_epi32( 0, 1, 2, 3 ) );
+	int i = 0;
+	for( ; i + 4 <= count; i += 4 )
+	{
+		_mm_storeu_si128( (__m128i*) ( out_noise + i ), Get1dNoiseUint4( indices, seed ) );
+		indices = _mm_add_epi32( indices, LANE_STEP );
+	}
+	for( ; i < count; ++ i )
+	{
+		out_noise[ i ] = Get1dNoiseUint( (int) ( (unsigned int) firstIndex + (unsigned int) i ), seed );
+	}
+}
+
+
+//-----------------------------------------------------------------------------------------------
+// hashbench: times scalar, SSE2 and (when available) AVX2 hashing of the same index arrays,
+//	and counts any lanes that don't match the scalar functions in Noise.hpp bit for bit.
+//
+static void RunScalarHashBench( const std::vector< int >& indicesX, const std::vector< int >& indicesY, const std::vector< int >& indicesZ, std::vector< unsigned int >& out_noise, std::vector< float >& out_floats )
+{
+	const int numHashes = (int) out_noise.size();
+	for( int i = 0; i < numHashes; ++ i )
+	{
+		out_noise[ i ] = Get3dNoiseUint( indicesX[ i ], indicesY[ i ], indicesZ[ i ], 0 );
+	}
+	for( int i = 0; i < numHashes; ++ i )
+	{
+		out_floats[ i ] = Get2dNoiseZeroToOne( indicesX[ i ], indicesY[ i ], 0 );
+	}
+}
+
+
+//-----------------------------------------------------------------------------------------------
+static void RunBatchHashBench( const std::vector< int >& indicesX, const std::vector< int >& indicesY, const std::vector< int >& indicesZ, std::vector< unsigned int >& out_noise, std::vector< float >& out_floats )
+{
+	const int numHashes = (int) out_noise.size();
+	Get3dNoiseUints( &indicesX[ 0 ], &indicesY[ 0 ], &indicesZ[ 0 ], &out_noise[ 0 ], numHashes, 0 );
+	Get2dNoiseZeroToOnes( &indicesX[ 0 ], &indicesY[ 0 ], &out_floats[ 0 ], numHashes, 0 );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+static int CountHashMismatches( const std::vector< unsigned int >& expectedNoise, const std::vector< float >& expectedFloats, const std::vector< unsigned int >& noise, const std::vector< float >& floats )
+{
+	int numMismatches = 0;
+	for( size_t i = 0; i < expectedNoise.size(); ++ i )
+	{
+		if( expectedNoise[ i ] != noise[ i ] || expectedFloats[ i ] != floats[ i ] )
+		{
+			++ numMismatches;
+		}
+	}
+	return numMismatches;
+}
+
+
+//-----------------------------------------------------------------------------------------------
+static int CountSequenceMismatches( int numHashes )
+{
+	const int FIRST_INDEX = -( numHashes / 2 );
+	std::vector< unsigned int > sequence( numHashes );
+	Get1dNoiseUintSequence( FIRST_INDEX, &sequence[ 0 ], numHashes, 11 );
+	int numMismatches = 0;
+	for( int i = 0; i < numHashes; ++ i )
+	{
+		if( sequence[ i ] != Get1dNoiseUint( FIRST_INDEX + i, 11 ) )
+		{
+			++ numMismatches;
+		}
+	}
+	return numMismatches;
+}
+
+
+//-----------------------------------------------------------------------------------------------
+CONSOLE_COMMAND( hashbench )
+{
+	if( !args.HasArgs( 1 ) )
+	{
+		Console::instance->PrintLine( "hashbench <# of hashes>", RGBA::GRAY );
+		return;
+	}
+	const int numHashes = args.GetIntArgument( 0 );
+	if( numHashes <= 0 )
+	{
+		return;
+	}
+
+	std::vector< int > indicesX( numHashes );
+	std::vector< int > indicesY( numHashes );
+	std::vector< int > indicesZ( numHashes );
+	for( int i = 0; i < numHashes; ++ i )
+	{
+		indicesX[ i ] = ( i & 1023 ) - 512;
+		indicesY[ i ] = ( i >> 10 ) - 77;
+		indicesZ[ i ] = (int) Get1dNoiseUint( i, 7 );
+	}
+	std::vector< unsigned int > scalarNoise( numHashes );
+	std::vector< float > scalarFloats( numHashes );
+	std::vector< unsigned int > batchNoise( numHashes );
+	std::vector< float > batchFloats( numHashes );
+
+	// Each pass hashes every index twice: once as a 3d uint, once as a 2d float.
+	const double numHashesPerPass = 2.0 * (double) numHashes;
+	StartTiming();
+	RunScalarHashBench( indicesX, indicesY, indicesZ, scalarNoise, scalarFloats );
+	double scalarSeconds = EndTiming();
+	Console::instance->PrintLine( Stringf( "Scalar: %.01f M hashes/sec", ( numHashesPerPass / scalarSeconds ) * 1e-6 ), RGBA::WHITE );
+
+	const bool wasAVX2Allowed = s_allowAVX2;
+	s_allowAVX2 = false;
+	StartTiming();
+	RunBatchHashBench( indicesX, indicesY, indicesZ, batchNoise, batchFloats );
+	double sse2Seconds = EndTiming();
+	int numMismatches = CountHashMismatches( scalarNoise, scalarFloats, batchNoise, batchFloats );
+	Console::instance->PrintLine( Stringf( "SSE2: %.01f M hashes/sec, %.02fx, %i mismatches", ( numHashesPerPass / sse2Seconds ) * 1e-6,
+		scalarSeconds / sse2Seconds, numMismatches ), numMismatches == 0 ? RGBA::WHITE : RGBA::RED );
+	numMismatches = CountSequenceMismatches( numHashes );
+	Console::instance->PrintLine( Stringf( "SSE2 sequence: %i mismatches", numMismatches ), numMismatches == 0 ? RGBA::WHITE : RGBA::RED );
+	s_allowAVX2 = wasAVX2Allowed;
+
+	if( !s_isAVX2Supported )
+	{
+		Console::instance->PrintLine( "AVX2: not supported on this CPU", RGBA::GRAY );
+		return;
+	}
+	StartTiming();
+	RunBatchHashBench( indicesX, indicesY, indicesZ, batchNoise, batchFloats );
+	double avx2Seconds = EndTiming();
+	numMismatches = CountHashMismatches( scalarNoise, scalarFloats, batchNoise, batchFloats );
+	Console::instance->PrintLine( Stringf( "AVX2: %.01f M hashes/sec, %.02fx, %i mismatches", ( numHashesPerPass / avx2Seconds ) * 1e-6,
+		scalarSeconds / avx2Seconds, numMismatches ), numMismatches == 0 ? RGBA::WHITE : RGBA::RED );
+	numMismatches = CountSequenceMismatches( numHashes );
+	Console::instance->PrintLine( Stringf( "AVX2 sequence: %i mismatches", numMismatches ), numMismatches == 0 ? RGBA::WHITE : RGBA::RED );
+}
@@ -0,0 +1,128 @@
+//-----------------------------------------------------------------------------------------------
+// NoiseSIMD.hpp
+// Lane-parallel versions of the SquirrelNoise hash functions in Noise.hpp
+#pragma once
+#include <emmintrin.h>
+
+//-----------------------------------------------------------------------------------------------
+// Every function here returns exactly the same bits as its scalar counterpart in Noise.hpp for
+//	the same inputs; they just evaluate 4 (SSE2) or 8 (AVX2) indices at a time.
+//
+// The inline SSE2 versions work on one register of 4 lanes and are meant for use inside other
+//	noise kernels.  The array versions process any count, using AVX2 when the CPU supports it
+//	and falling back to SSE2 (and finally scalar code for the leftover tail) when it doesn't.
+//
+__m128i Get1dNoiseUint4( __m128i indices, unsigned int seed=0 );
+__m128i Get2dNoiseUint4( __m128i indicesX, __m128i indicesY, unsigned int seed=0 );
+__m128i Get3dNoiseUint4( __m128i indicesX, __m128i indicesY, __m128i indicesZ, unsigned int seed=0 );
+__m128i Get4dNoiseUint4( __m128i indicesX, __m128i indicesY, __m128i indicesZ, __m128i indicesT, unsigned int seed=0 );
+__m128 MapNoiseUint4ToZeroToOne( __m128i noise );
+__m128 MapNoiseUint4ToNegOneToOne( __m128i noise );
+
+//-----------------------------------------------------------------------------------------------
+void Get1dNoiseUints( const int* indices, unsigned int* out_noise, int count, unsigned int seed=0 );
+void Get2dNoiseUints( const int* indicesX, const int* indicesY, unsigned int* out_noise, int count, unsigned int seed=0 );
+void Get3dNoiseUints( const int* indicesX, const int* indicesY, const int* indicesZ, unsigned int* out_noise, int count, unsigned int seed=0 );
+void Get4dNoiseUints( const int* indicesX, const int* indicesY, const int* indicesZ, const int* indicesT, unsigned int* out_noise, int count, unsigned int seed=0 );
+void Get1dNoiseZeroToOnes( const int* indices, float* out_noise, int count, unsigned int seed=0 );
+void Get2dNoiseZeroToOnes( const int* indicesX, const int* indicesY, float* out_noise, int count, unsigned int seed=0 );
+void Get3dNoiseZeroToOnes( const int* indicesX, const int* indicesY, const int* indicesZ, float* out_noise, int count, unsigned int seed=0 );
+void Get4dNoiseZeroToOnes( const int* indicesX, const int* indicesY, const int* indicesZ, const int* indicesT, float* out_noise, int count, unsigned int seed=0 );
+void Get1dNoiseNegOneToOnes( const int* indices, float* out_noise, int count, unsigned int seed=0 );
+void Get2dNoiseNegOneToOnes( const int* indicesX, const int* indicesY, float* out_noise, int count, unsigned int seed=0 );
+void Get3dNoiseNegOneToOnes( const int* indicesX, const int* indicesY, const int* indicesZ, float* out_noise, int count, unsigned int seed=0 );
+void Get4dNoiseNegOneToOnes( const int* indicesX, const int* indicesY, const int* indicesZ, const int* indicesT, float* out_noise, int count, unsigned int seed=0 );
+
+// Hashes the consecutive indices [firstIndex, firstIndex + count), which is all a stateless
+//	random number stream needs.
+void Get1dNoiseUintSequence( int firstIndex, unsigned int* out_noise, int count, unsigned int seed=0 );
+bool IsNoiseAVX2Supported();
+
+
+//-----------------------------------------------------------------------------------------------
+// SSE2 has no 32-bit low multiply (that's SSE4.1), so build one from two 32x32->64 multiplies.
+//
+inline __m128i MultiplyLow32( __m128i a, __m128i b )
+{
+	__m128i evenProducts = _mm_mul_epu32( a, b );
+	__m128i oddProducts = _mm_mul_epu32( _mm_srli_epi64( a, 32 ), _mm_srli_epi64( b, 32 ) );
+	return _mm_unpacklo_epi32( _mm_shuffle_epi32( evenProducts, _MM_SHUFFLE( 0, 0, 2, 0 ) ), _mm_shuffle_epi32( oddProducts, _MM_SHUFFLE( 0, 0, 2, 0 ) ) );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+inline __m128i Get1dNoiseUint4( __m128i indices, unsigned int seed )
+{
+	const __m128i BIT_NOISE1 = _mm_set1_epi32( (int) 0xB5297A4D );
+	const __m128i BIT_NOISE2 = _mm_set1_epi32( (int) 0x68E31DA4 );
+	const __m128i BIT_NOISE3 = _mm_set1_epi32( (int) 0x1B56C4E9 );
+
+	__m128i mangledBits = MultiplyLow32( indices, BIT_NOISE1 );
+	mangledBits = _mm_add_epi32( mangledBits, _mm_set1_epi32( (int) seed ) );
+	mangledBits = _mm_xor_si128( mangledBits, _mm_srli_epi32( mangledBits, 8 ) );
+	mangledBits = _mm_add_epi32( mangledBits, BIT_NOISE2 );
+	mangledBits = _mm_xor_si128( mangledBits, _mm_slli_epi32( mangledBits, 8 ) );
+	mangledBits = MultiplyLow32( mangledBits, BIT_NOISE3 );
+	mangledBits = _mm_xor_si128( mangledBits, _mm_srli_epi32( mangledBits, 8 ) );
+	return mangledBits;
+}
+
+
+//-----------------------------------------------------------------------------------------------
+inline __m128i Get2dNoiseUint4( __m128i indicesX, __m128i indicesY, unsigned int seed )
+{
+	const __m128i PRIME_NUMBER = _mm_set1_epi32( 198491317 );
+	return Get1dNoiseUint4( _mm_add_epi32( indicesX, MultiplyLow32( PRIME_NUMBER, indicesY ) ), seed );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+inline __m128i Get3dNoiseUint4( __m128i indicesX, __m128i indicesY, __m128i indicesZ, unsigned int seed )
+{
+	const __m128i PRIME1 = _mm_set1_epi32( 198491317 );
+	const __m128i PRIME2 = _mm_set1_epi32( 6542989 );
+	__m128i combined = _mm_add_epi32( _mm_add_epi32( indicesX, MultiplyLow32( PRIME1, indicesY ) ), MultiplyLow32( PRIME2, indicesZ ) );
+	return Get1dNoiseUint4( combined, seed );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+inline __m128i Get4dNoiseUint4( __m128i indicesX, __m128i indicesY, __m128i indicesZ, __m128i indicesT, unsigned int seed )
+{
+	const __m128i PRIME1 = _mm_set1_epi32( 198491317 );
+	const __m128i PRIME2 = _mm_set1_epi32( 6542989 );
+	const __m128i PRIME3 = _mm_set1_epi32( 357239 );
+	__m128i combined = _mm_add_epi32( _mm_add_epi32( indicesX, MultiplyLow32( PRIME1, indicesY ) ), MultiplyLow32( PRIME2, indicesZ ) );
+	combined = _mm_add_epi32( combined, MultiplyLow32( PRIME3, indicesT ) );
+	return Get1dNoiseUint4( combined, seed );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+// The scalar versions scale in double precision before rounding to float, so these do too.
+//	Unsigned lanes are converted by flipping the sign bit, converting as signed, and adding 2^31
+//	back, all of which is exact in a double.
+//
+inline __m128 MapNoiseUint4ToZeroToOne( __m128i noise )
+{
+	const __m128d ONE_OVER_MAX_UINT = _mm_set1_pd( 1.0 / (double) 0xFFFFFFFF );
+	const __m128d TWO_TO_THE_31 = _mm_set1_pd( 2147483648.0 );
+	__m128i flipped = _mm_xor_si128( noise, _mm_set1_epi32( (int) 0x80000000 ) );
+	__m128d low = _mm_add_pd( _mm_cvtepi32_pd( flipped ), TWO_TO_THE_31 );
+	__m128d high = _mm_add_pd( _mm_cvtepi32_pd( _mm_shuffle_epi32( flipped, _MM_SHUFFLE( 1, 0, 3, 2 ) ) ), TWO_TO_THE_31 );
+	__m128 lowFloats = _mm_cvtpd_ps( _mm_mul_pd( low, ONE_OVER_MAX_UINT ) );
+	__m128 highFloats = _mm_cvtpd_ps( _mm_mul_pd( high, ONE_OVER_MAX_UINT ) );
+	return _mm_movelh_ps( lowFloats, highFloats );
+}
+
+
+//-----------------------------------------------------------------------------------------------
+inline __m128 MapNoiseUint4ToNegOneToOne( __m128i noise )
+{
+	const __m128d ONE_OVER_MAX_INT = _mm_set1_pd( 1.0 / (double) 0x7FFFFFFF );
+	__m128d low = _mm_cvtepi32_pd( noise );
+	__m128d high = _mm_cvtepi32_pd( _mm_shuffle_epi32( noise, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+	__m128 lowFloats = _mm_cvtpd_ps( _mm_mul_pd( low, ONE_OVER_MAX_INT ) );
+	__m128 highFloats = _mm_cvtpd_ps( _mm_mul_pd( high, ONE_OVER_MAX_INT ) );
+	return _mm_movelh_ps( lowFloats, highFloats );
+}
@@ -71,4 +71,16 @@ void Mesh::BindToVAO(GLuint vaoID, ShaderProgram* shaderProgram)
     m_vertexBindFunctionPointer(vaoID, m_vbo, m_ibo, shaderProgram);
 }
 
+//-----------------------------------------------------------------------------------
+//Replaces what's in the index buffer, keeping the same buffer, so anything already bound to it sees the new indices.
+//Rendering leaves no VAO bound, so binding the element buffer here doesn't change any VAO's.
+void Mesh::UpdateIndices(void* indexData, unsigned int numIndices)
+{
+    m_numIndices = numIndices;
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, numIndices * sizeof(unsigned int), indexData, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, NULL);
+    GL_CHECK_ERROR();
+}
+
 
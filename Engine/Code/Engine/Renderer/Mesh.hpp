@@ -26,6 +26,7 @@ public:
 	//HELPER FUNCTIONS//////////////////////////////////////////////////////////////////////////
 	void Init(void* vertexData, unsigned int numVertices, unsigned int sizeofVertex, void* indexData, unsigned int numIndices, BindMeshToVAOForVertex* BindMeshFunction);
 	void BindToVAO(GLuint m_vaoID, ShaderProgram* m_shaderProgram);
+	void UpdateIndices(void* indexData, unsigned int numIndices);
 
 	//MEMBER VARIABLES//////////////////////////////////////////////////////////////////////////
 	GLuint m_vbo;
@@ -85,6 +85,7 @@ public:
     inline void SetNormal(const Vector3& normal) { m_stamp.normal = normal; SetMaskBit(NORMAL_BIT); };
     inline void SetUV(float u, float v) { m_stamp.uv0 = Vector2(u,v); SetMaskBit(UV0_BIT); };
     inline void SetUV(const Vector2& uv) { m_stamp.uv0 = uv; SetMaskBit(UV0_BIT); };
+    inline void SetUV1(const Vector2& uv) { m_stamp.uv1 = uv; SetMaskBit(UV1_BIT); };
     inline void SetFloatData0(const Vector4& data) { m_stamp.floatData0 = data; SetMaskBit(FLOAT_DATA0_BIT); };
 
     //-----------------------------------------------------------------------------------
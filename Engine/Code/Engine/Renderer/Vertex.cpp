@@ -174,3 +174,32 @@ void Vertex_PCTD::BindMeshToVAO(GLuint vao, GLuint vbo, GLuint ibo, ShaderProgra
     }
     glBindVertexArray(NULL);
 }
+
+//-----------------------------------------------------------------------------------
+void Vertex_PCTTD::Copy(const Vertex_Master& source, byte* destination)
+{
+    Vertex_PCTTD* pcttd = (Vertex_PCTTD*)(destination);
+    pcttd->pos = source.position;
+    pcttd->color = source.color;
+    pcttd->texCoords = source.uv0;
+    pcttd->texCoords1 = source.uv1;
+    pcttd->floatData0 = source.floatData0;
+}
+
+//-----------------------------------------------------------------------------------
+void Vertex_PCTTD::BindMeshToVAO(GLuint vao, GLuint vbo, GLuint ibo, ShaderProgram* program)
+{
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    program->ShaderProgramBindProperty("inPosition", 3, GL_FLOAT, GL_FALSE, sizeof(Vertex_PCTTD), offsetof(Vertex_PCTTD, pos));
+    program->ShaderProgramBindProperty("inColor", 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex_PCTTD), offsetof(Vertex_PCTTD, color));
+    program->ShaderProgramBindProperty("inUV0", 2, GL_FLOAT, GL_FALSE, sizeof(Vertex_PCTTD), offsetof(Vertex_PCTTD, texCoords));
+    program->ShaderProgramBindProperty("inUV1", 2, GL_FLOAT, GL_FALSE, sizeof(Vertex_PCTTD), offsetof(Vertex_PCTTD, texCoords1));
+    program->ShaderProgramBindProperty("inFloatData0", 4, GL_FLOAT, GL_FALSE, sizeof(Vertex_PCTTD), offsetof(Vertex_PCTTD, floatData0));
+    glBindBuffer(GL_ARRAY_BUFFER, NULL);
+    if (ibo != NULL)
+    {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+    }
+    glBindVertexArray(NULL);
+}
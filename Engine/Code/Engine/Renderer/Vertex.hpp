@@ -118,6 +118,25 @@ struct Vertex_PCTD
     Vector4 floatData0;
 };
 
+//-----------------------------------------------------------------------------------
+//Vertex_PCTD with a second set of texture coordinates.
+struct Vertex_PCTTD
+{
+    typedef unsigned int GLuint;
+
+    Vertex_PCTTD() {};
+    Vertex_PCTTD(const Vector3& position) : pos(position) {};
+    static void Copy(const Vertex_Master& source, byte* destination);
+    static void BindMeshToVAO(GLuint vao, GLuint vbo, GLuint ibo, ShaderProgram* program);
+
+    //MEMBER VARIABLES//////////////////////////////////////////////////////////////////////////
+    Vector3 pos;
+    RGBA color;
+    Vector2 texCoords;
+    Vector2 texCoords1;
+    Vector4 floatData0;
+};
+
 //-----------------------------------------------------------------------------------
 struct Vertex_PCUTB
 {
@@ -9,6 +9,9 @@ Block::Block(unsigned char type)
 , m_redLight(0)
 , m_greenLight(0)
 , m_blueLight(0)
+, m_skyRedLight(0)
+, m_skyGreenLight(0)
+, m_skyBlueLight(0)
 {
 }
 
@@ -19,6 +22,9 @@ Block::Block()
 , m_redLight(0)
 , m_greenLight(0)
 , m_blueLight(0)
+, m_skyRedLight(0)
+, m_skyGreenLight(0)
+, m_skyBlueLight(0)
 {
 }
 
@@ -91,7 +97,7 @@ Face Block::GetFace(const Vector3Int& bottomLeftCorner, const Vector3Int& faceNo
 }
 
 //-----------------------------------------------------------------------------------
-bool Block::IsPortal(Direction portalFace)
+bool Block::IsPortal(Direction portalFace) const
 {
     switch (portalFace)
     {
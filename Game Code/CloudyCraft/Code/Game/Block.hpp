@@ -14,22 +14,24 @@ public:
     //FUNCTIONS//////////////////////////////////////////////////////////////////////////
     void Update(float deltaTime);
     void Render() const;
-    inline bool IsSky() { return (m_lightAndFlags & SKY_BIT) != 0; }
-    inline bool IsEdgeBlock() { return(m_lightAndFlags & EDGE_BIT) != 0; }
-    inline bool IsDirty() { return (m_lightAndFlags & LIGHTING_DIRTY_BIT) != 0; }
-    inline bool HasAbovePortal() { return (m_portalFlags & PORTAL_ABOVE_BIT) != 0; }
-    inline bool HasBelowPortal() { return (m_portalFlags & PORTAL_BELOW_BIT) != 0; }
-    inline bool HasNorthPortal() { return (m_portalFlags & PORTAL_NORTH_BIT) != 0; }
-    inline bool HasSouthPortal() { return (m_portalFlags & PORTAL_SOUTH_BIT) != 0; }
-    inline bool HasEastPortal() { return (m_portalFlags & PORTAL_EAST_BIT) != 0; }
-    inline bool HasWestPortal() { return (m_portalFlags & PORTAL_WEST_BIT) != 0; }
-    bool IsPortal(Direction portalFace = NUM_DIRECTIONS);
+    inline bool IsSky() const { return (m_lightAndFlags & SKY_BIT) != 0; }
+    inline bool IsEdgeBlock() const { return(m_lightAndFlags & EDGE_BIT) != 0; }
+    inline bool HasAbovePortal() const { return (m_portalFlags & PORTAL_ABOVE_BIT) != 0; }
+    inline bool HasBelowPortal() const { return (m_portalFlags & PORTAL_BELOW_BIT) != 0; }
+    inline bool HasNorthPortal() const { return (m_portalFlags & PORTAL_NORTH_BIT) != 0; }
+    inline bool HasSouthPortal() const { return (m_portalFlags & PORTAL_SOUTH_BIT) != 0; }
+    inline bool HasEastPortal() const { return (m_portalFlags & PORTAL_EAST_BIT) != 0; }
+    inline bool HasWestPortal() const { return (m_portalFlags & PORTAL_WEST_BIT) != 0; }
+    bool IsPortal(Direction portalFace = NUM_DIRECTIONS) const;
 
     //GETTERS//////////////////////////////////////////////////////////////////////////
-    inline BlockDefinition* GetDefinition() { return BlockDefinition::GetDefinition(m_type); }
+    inline BlockDefinition* GetDefinition() const { return BlockDefinition::GetDefinition(m_type); }
     inline unsigned int GetLightValue() const;
     inline unsigned int GetDampedLightValue(uchar dampAmount) const;
     inline RGBA GetRGBALightValue() const;
+    inline PackedLight GetPackedLight() const;
+    inline PackedLight GetPackedSkyLight() const;
+    inline unsigned int GetDampedSkyLightValue(uchar dampAmount) const;
     inline uchar GetRedLightValue() const;
     inline uchar GetGreenLightValue() const;
     inline uchar GetBlueLightValue() const;
@@ -37,12 +39,13 @@ public:
 
     //SETTERS//////////////////////////////////////////////////////////////////////////
     inline void SetLightValue(const RGBA& lightColor);
+    inline void SetPackedLight(PackedLight light);
+    inline void SetPackedSkyLight(PackedLight skyLight);
     inline void SetRedLightValue(uchar lightValue0To15);
     inline void SetGreenLightValue(uchar lightValue0To15);
     inline void SetBlueLightValue(uchar lightValue0To15);
     inline void SetSky(bool isSkyBlock);
     inline void SetEdgeBlock(bool isEdgeBlock);
-    inline void SetDirty(bool isLightingDirty);
     inline void SetBelowHasPortal(bool isVisible);
     inline void SetAboveHasPortal(bool isVisible);
     inline void SetNorthHasPortal(bool isVisible);
@@ -81,6 +84,11 @@ public:
     uchar m_redLight;
     uchar m_greenLight;
     uchar m_blueLight;
+    //How much of the sky reaches this block, as if the sky were full white. The world's actual sky light is
+    //applied on top of it when rendering, so changing the sky never means relighting or rebuilding anything.
+    uchar m_skyRedLight;
+    uchar m_skyGreenLight;
+    uchar m_skyBlueLight;
     uchar m_portalFlags;
 }; 
 
@@ -3,22 +3,15 @@
 //-----------------------------------------------------------------------------------
 inline unsigned int Block::GetDampedLightValue(uchar dampAmount) const
 {
-	uchar red = m_redLight - dampAmount;
-	uchar green = m_greenLight - dampAmount;
-	uchar blue = m_blueLight - dampAmount;
-	if (red > m_redLight)
-	{
-		red = 0x00;
-	}
-	if (green > m_greenLight)
-	{
-		green = 0x00;
-	}
-	if (blue > m_blueLight)
-	{
-		blue = 0x00;
-	}
-	return (red << RGBA::SHIFT_RED) + (green << RGBA::SHIFT_GREEN) + (blue << RGBA::SHIFT_BLUE) + 0xFF;
+	PackedLight dampedLight = SubtractPackedLight(GetPackedLight(), PackLight(dampAmount, dampAmount, dampAmount));
+	return (GetPackedRed(dampedLight) << RGBA::SHIFT_RED) + (GetPackedGreen(dampedLight) << RGBA::SHIFT_GREEN) + (GetPackedBlue(dampedLight) << RGBA::SHIFT_BLUE) + 0xFF;
+}
+
+//-----------------------------------------------------------------------------------
+inline unsigned int Block::GetDampedSkyLightValue(uchar dampAmount) const
+{
+	PackedLight dampedLight = SubtractPackedLight(GetPackedSkyLight(), PackLight(dampAmount, dampAmount, dampAmount));
+	return (GetPackedRed(dampedLight) << RGBA::SHIFT_RED) + (GetPackedGreen(dampedLight) << RGBA::SHIFT_GREEN) + (GetPackedBlue(dampedLight) << RGBA::SHIFT_BLUE) + 0xFF;
 }
 
 //-----------------------------------------------------------------------------------
@@ -33,6 +26,18 @@ inline RGBA Block::GetRGBALightValue() const
 	return RGBA((m_redLight << RGBA::SHIFT_RED) + (m_greenLight << RGBA::SHIFT_GREEN) + (m_blueLight << RGBA::SHIFT_BLUE) + 0xFF);
 }
 
+//-----------------------------------------------------------------------------------
+inline PackedLight Block::GetPackedLight() const
+{
+	return PackLight(m_redLight, m_greenLight, m_blueLight);
+}
+
+//-----------------------------------------------------------------------------------
+inline PackedLight Block::GetPackedSkyLight() const
+{
+	return PackLight(m_skyRedLight, m_skyGreenLight, m_skyBlueLight);
+}
+
 //-----------------------------------------------------------------------------------
 inline uchar Block::GetRedLightValue() const
 {
@@ -77,6 +82,22 @@ inline void Block::SetLightValue(const RGBA& lightColor)
 	m_blueLight = lightColor.blue;
 }
 
+//-----------------------------------------------------------------------------------
+inline void Block::SetPackedLight(PackedLight light)
+{
+	m_redLight = GetPackedRed(light);
+	m_greenLight = GetPackedGreen(light);
+	m_blueLight = GetPackedBlue(light);
+}
+
+//-----------------------------------------------------------------------------------
+inline void Block::SetPackedSkyLight(PackedLight skyLight)
+{
+	m_skyRedLight = GetPackedRed(skyLight);
+	m_skyGreenLight = GetPackedGreen(skyLight);
+	m_skyBlueLight = GetPackedBlue(skyLight);
+}
+
 //-----------------------------------------------------------------------------------
 inline void Block::SetEdgeBlock(bool isEdgeBlock)
 {
@@ -91,13 +112,6 @@ inline void Block::SetSky(bool isSkyBlock)
 	m_lightAndFlags |= isSkyBlock ? BITMASK_BLOCK_IS_SKY : 0x00;
 }
 
-//-----------------------------------------------------------------------------------
-inline void Block::SetDirty(bool isLightingDirty)
-{
-	m_lightAndFlags &= ~BITMASK_BLOCK_LIGHT_DIRTY;
-	m_lightAndFlags |= isLightingDirty ? BITMASK_BLOCK_LIGHT_DIRTY : 0x00;
-}
-
 //-----------------------------------------------------------------------------------
 inline void Block::SetBelowHasPortal(bool hasPortal)
 {
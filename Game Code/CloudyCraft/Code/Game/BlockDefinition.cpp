@@ -1,4 +1,5 @@
 #include "BlockDefinition.h"
+#include "Game/LightingEngine.hpp"
 
 BlockDefinition BlockDefinition::s_definitionRegistry[BlockType::NUM_BLOCKS];
 SpriteSheet* BlockDefinition::m_blockSheet;
@@ -523,6 +524,45 @@ void BlockDefinition::Initialize()
     purpleGlass.m_placeSound           = AudioSystem::instance->CreateOrGetSound("Data/SFX/Minecraft/digStone.ogg");
     purpleGlass.m_brokenSound          = AudioSystem::instance->CreateOrGetSound("Data/SFX/Minecraft/digStone.ogg");
     s_definitionRegistry[PURPLE_GLASS] = purpleGlass;
+
+    BlockDefinition wood       = BlockDefinition();
+    wood.m_opacity             = RGBA(0xFFFFFF00);
+    wood.m_sideIndex           = 0x8E;
+    wood.m_topIndex            = 0x8F;
+    wood.m_bottomIndex         = 0x8F;
+    wood.m_sideCoords          = m_blockSheet->GetTexCoordsForSpriteIndex(wood.m_sideIndex);
+    wood.m_bottomCoords        = m_blockSheet->GetTexCoordsForSpriteIndex(wood.m_bottomIndex);
+    wood.m_topCoords           = m_blockSheet->GetTexCoordsForSpriteIndex(wood.m_topIndex);
+    wood.m_isSolid             = true;
+    wood.m_isOpaque            = true;
+    wood.m_illumination        = 0x00000000;
+    wood.m_toughness           = 1.0f;
+    wood.m_placeSound          = AudioSystem::instance->CreateOrGetSound("Data/SFX/Minecraft/digGrass.ogg");
+    wood.m_brokenSound         = AudioSystem::instance->CreateOrGetSound("Data/SFX/Minecraft/digGrass.ogg");
+    s_definitionRegistry[WOOD] = wood;
+
+    BlockDefinition leaves       = BlockDefinition();
+    leaves.m_opacity             = RGBA(0xFFFFFF00);
+    leaves.m_sideIndex           = 0x8B;
+    leaves.m_topIndex            = 0x8B;
+    leaves.m_bottomIndex         = 0x8B;
+    leaves.m_sideCoords          = m_blockSheet->GetTexCoordsForSpriteIndex(leaves.m_sideIndex);
+    leaves.m_bottomCoords        = m_blockSheet->GetTexCoordsForSpriteIndex(leaves.m_bottomIndex);
+    leaves.m_topCoords           = m_blockSheet->GetTexCoordsForSpriteIndex(leaves.m_topIndex);
+    leaves.m_isSolid             = true;
+    leaves.m_isOpaque            = true;
+    leaves.m_illumination        = 0x00000000;
+    leaves.m_toughness           = 0.2f;
+    leaves.m_placeSound          = AudioSystem::instance->CreateOrGetSound("Data/SFX/Minecraft/digGrass.ogg");
+    leaves.m_brokenSound         = AudioSystem::instance->CreateOrGetSound("Data/SFX/Minecraft/digGrass.ogg");
+    s_definitionRegistry[LEAVES] = leaves;
+
+    for (int type = 0; type < BlockType::NUM_BLOCKS; ++type)
+    {
+        BlockDefinition& definition = s_definitionRegistry[type];
+        definition.m_blocksSky = definition.m_opacity != RGBA(0x00000000);
+        definition.m_packedAttenuation = PackLightAttenuation(LightingEngine::LIGHT_FALLOFF + definition.m_opacity.red, LightingEngine::LIGHT_FALLOFF + definition.m_opacity.green, LightingEngine::LIGHT_FALLOFF + definition.m_opacity.blue);
+    }
 }
 
 void BlockDefinition::Uninitialize()
@@ -538,6 +578,8 @@ BlockDefinition::BlockDefinition()
 , m_bottomIndex(0x00)
 , m_isSolid(false)
 , m_isOpaque(false)
+, m_blocksSky(false)
+, m_packedAttenuation(0)
 , m_illumination(0x00000000)
 , m_toughness(1.0f)
 {
@@ -3,6 +3,7 @@
 #include <map>
 #include "GameCommon.hpp"
 #include "Engine/Renderer/SpriteSheet.hpp"
+#include "Game/PackedLight.hpp"
 class Texture;
 
 //ENUMS//////////////////////////////////////////////////////////////////////////
@@ -42,6 +43,9 @@ enum BlockType
     ORANGE_GLASS,
     PURPLE_GLASS,
     GRAY_GLASS,
+    //Features//////////
+    WOOD,
+    LEAVES,
     NUM_BLOCKS
 };
 
@@ -76,6 +80,8 @@ public:
     float m_toughness;
     bool m_isSolid;
     bool m_isOpaque;
+    bool m_blocksSky; //Any opacity at all stops the sky column; filled in from m_opacity by Initialize.
+    PackedLight m_packedAttenuation; //A falloff step plus m_opacity, what light loses coming into this block.
 
 private:
     static BlockDefinition s_definitionRegistry[BlockType::NUM_BLOCKS];
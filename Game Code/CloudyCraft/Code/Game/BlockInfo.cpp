@@ -92,12 +92,9 @@ Direction BlockInfo::GetFaceDirectionFromNormal(const Vector3Int& normal) const
 //-----------------------------------------------------------------------------------
 void BlockInfo::SetDirtyFlagAndAddToDirtyList(const BlockInfo& info)
 {
-	Block* block = info.GetBlock();
-	if (block->IsDirty())
+	if (info.m_chunk->SetLightingDirty(info.m_index))
 	{
-		return;
+		info.m_chunk->m_world->m_lightingDirtyChunks.push_back(info.m_chunk->m_chunkPosition);
 	}
-	block->SetDirty(true);
-	info.m_chunk->m_world->m_dirtyBlocks.push_back(info);
 }
 
@@ -4,9 +4,30 @@
 #include "Engine/Renderer/SpriteSheet.hpp"
 #include "Game/BlockDefinition.h"
 #include "Game/World.hpp"
+#include "Game/Camera3D.hpp"
 #include "Game/Generator.hpp"
+#include "Game/LightingEngine.hpp"
+#include "Game/ChunkNeighborhood.hpp"
+#include "Game/ChunkMeshSnapshot.hpp"
+#include "Game/ChunkMeshBuilder.hpp"
+#include "Game/ChunkMeshCache.hpp"
+#include "Game/CompactChunkVertex.hpp"
 #include "Engine/Renderer/MeshBuilder.hpp"
+#include "Engine/Input/Console.hpp"
+#include "Engine/Time/Time.hpp"
+#include <algorithm>
+#include <atomic>
 #include <map>
+#include <emmintrin.h>
+#include <intrin.h>
+
+bool Chunk::s_useSmoothLighting = true;
+bool Chunk::s_useGreedyMeshing = false;
+bool Chunk::s_usePackedMesher = true;
+bool Chunk::s_useMeshSections = true;
+bool Chunk::s_useFaceMasks = true;
+float Chunk::s_translucentSortDistance = 1.0f;
+static std::atomic<unsigned int> s_nextLightingQueueID(0); //Chunks are constructed on the generation thread too.
 
 //-----------------------------------------------------------------------------------
 Chunk::Chunk(const ChunkCoords& chunkCoords, World* world)
@@ -18,11 +39,17 @@ Chunk::Chunk(const ChunkCoords& chunkCoords, World* world)
 , m_northChunk(nullptr)
 , m_isDirty(false)
 , m_world(world)
-, m_numVerts(0)
-, m_meshRenderer(nullptr)
+, m_dirtyMeshSections(0)
+, m_lastSnapshotVersion(0)
+, m_timeDirtied(0.0)
+, m_localLightingSeconds(0.0)
+, m_numLightingDirtyBlocks(0)
+, m_lightingQueueID(GetNewLightingQueueID())
 {
     //REMINDER: THREAD-SAFE CODE ONLY!
     memset(m_blocks, 0, sizeof(m_blocks[0]) * BLOCKS_PER_CHUNK);
+    memset(m_lightingDirtyBits, 0, sizeof(m_lightingDirtyBits));
+    memset(m_meshSections, 0, sizeof(m_meshSections));
     GenerateChunk();
     SetEdgeBits();
 }
@@ -37,12 +64,45 @@ Chunk::Chunk(const ChunkCoords& chunkCoords, std::vector<unsigned char>& data, W
 , m_northChunk(nullptr)
 , m_isDirty(false)
 , m_world(world)
-, m_numVerts(0)
-, m_meshRenderer(nullptr)
+, m_dirtyMeshSections(0)
+, m_lastSnapshotVersion(0)
+, m_timeDirtied(0.0)
+, m_localLightingSeconds(0.0)
+, m_numLightingDirtyBlocks(0)
+, m_lightingQueueID(GetNewLightingQueueID())
 {
     //REMINDER: THREAD-SAFE CODE ONLY!
     memset(m_blocks, 0, sizeof(m_blocks[0]) * BLOCKS_PER_CHUNK);
+    memset(m_lightingDirtyBits, 0, sizeof(m_lightingDirtyBits));
+    memset(m_meshSections, 0, sizeof(m_meshSections));
     LoadChunkFromData(data);
+    ApplyDeferredBlockWrites();
+    SetEdgeBits();
+}
+
+//-----------------------------------------------------------------------------------
+//Generated by a generator other than the world's, for chunks that are never added to it. Nothing is timed, and
+//only that generator's deferred writes are applied.
+Chunk::Chunk(const ChunkCoords& chunkCoords, World* world, Generator& generator)
+: m_chunkPosition(chunkCoords)
+, m_bottomLeftCorner(WorldPosition(static_cast<float>((m_chunkPosition.x * BLOCKS_WIDE_X)), static_cast<float>((m_chunkPosition.y * BLOCKS_WIDE_Y)), 0.0f))
+, m_eastChunk(nullptr)
+, m_westChunk(nullptr)
+, m_southChunk(nullptr)
+, m_northChunk(nullptr)
+, m_isDirty(false)
+, m_world(world)
+, m_dirtyMeshSections(0)
+, m_lastSnapshotVersion(0)
+, m_timeDirtied(0.0)
+, m_localLightingSeconds(0.0)
+, m_numLightingDirtyBlocks(0)
+, m_lightingQueueID(GetNewLightingQueueID())
+{
+    memset(m_blocks, 0, sizeof(m_blocks[0]) * BLOCKS_PER_CHUNK);
+    memset(m_lightingDirtyBits, 0, sizeof(m_lightingDirtyBits));
+    memset(m_meshSections, 0, sizeof(m_meshSections));
+    generator.GenerateChunk(m_blocks, this);
     SetEdgeBits();
 }
 
@@ -60,14 +120,205 @@ void Chunk::Update(float deltaTime)
 }
 
 //-----------------------------------------------------------------------------------
+//Everything opaque. Translucent faces wait for RenderTranslucent, once every chunk's opaque faces are down.
 void Chunk::Render() const
 {
-    if (m_meshRenderer && m_meshRenderer->m_mesh->m_vbo != 0)
+    for (const MeshSection& meshSection : m_meshSections)
+    {
+        if (meshSection.m_meshRenderer && meshSection.m_meshRenderer->m_mesh->m_vbo != 0)
+        {
+            meshSection.m_meshRenderer->Render();
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//The translucent faces, a section at a time, starting with the section farthest above or below the camera and
+//finishing with the one it's in. Each section's faces are in whatever order they were last sorted into.
+void Chunk::RenderTranslucent(const WorldPosition& cameraPosition) const
+{
+    int cameraSection = std::min(std::max(static_cast<int>(floor(cameraPosition.z)) >> CHUNK_BITS_MESH_SECTION_Z, 0), NUM_MESH_SECTIONS - 1);
+    for (int sectionsAway = NUM_MESH_SECTIONS - 1; sectionsAway >= 0; --sectionsAway)
+    {
+        int sidesToDraw = (sectionsAway == 0) ? 1 : 2;
+        for (int side = 0; side < sidesToDraw; ++side)
+        {
+            int meshSection = (side == 0) ? cameraSection - sectionsAway : cameraSection + sectionsAway;
+            if (meshSection < 0 || meshSection >= NUM_MESH_SECTIONS)
+            {
+                continue;
+            }
+            const TranslucentFaces* translucentFaces = m_meshSections[meshSection].m_translucentFaces;
+            if (translucentFaces && translucentFaces->m_meshRenderer->m_mesh->m_vbo != 0)
+            {
+                translucentFaces->m_meshRenderer->Render();
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//Re-sorts the sections whose translucent faces are new, or were last sorted from too far from where the camera is
+//now. A chunk n chunks away waits for the camera to move n times as far, since faces that far off cover too few
+//pixels for being slightly out of order to show. The whole chunk's sorting is timed as one sample. Main thread only.
+bool Chunk::SortTranslucentFaces(const WorldPosition& cameraPosition)
+{
+    if (s_translucentSortDistance <= 0.0f)
+    {
+        return false;
+    }
+    Vector2 chunkCenter(m_bottomLeftCorner.x + (BLOCKS_WIDE_X / 2), m_bottomLeftCorner.y + (BLOCKS_WIDE_Y / 2));
+    float chunksAway = sqrt(MathUtils::CalcDistSquaredBetweenPoints(chunkCenter, Vector2(cameraPosition.x, cameraPosition.y))) / BLOCKS_WIDE_X;
+    float sortDistance = s_translucentSortDistance * std::max(chunksAway, 1.0f);
+    bool hasSorted = false;
+    for (MeshSection& meshSection : m_meshSections)
+    {
+        TranslucentFaces* translucentFaces = meshSection.m_translucentFaces;
+        if (!translucentFaces)
+        {
+            continue;
+        }
+        if (translucentFaces->m_isSorted && MathUtils::CalcDistSquaredBetweenPoints(translucentFaces->m_sortedFromPosition, cameraPosition) < sortDistance * sortDistance)
+        {
+            continue;
+        }
+        if (!hasSorted)
+        {
+            StartTiming(g_translucentSortProfiling);
+            hasSorted = true;
+        }
+        translucentFaces->SortBackToFront(cameraPosition);
+    }
+    if (hasSorted)
+    {
+        EndTiming(g_translucentSortProfiling);
+    }
+    return hasSorted;
+}
+
+//-----------------------------------------------------------------------------------
+//Every translucent face is its own four vertices and six indices, so quad n is vertices 4n through 4n + 3.
+static void CalculateQuadCenters(const std::vector<Vertex_PCTTD>& vertices, std::vector<WorldPosition>& out_quadCenters)
+{
+    out_quadCenters.resize(vertices.size() / 4);
+    for (unsigned int quad = 0; quad < out_quadCenters.size(); ++quad)
     {
-        m_meshRenderer->Render();
+        const Vertex_PCTTD* corners = &vertices[quad * 4];
+        out_quadCenters[quad] = (corners[0].pos + corners[1].pos + corners[2].pos + corners[3].pos) * 0.25f;
     }
 }
 
+//-----------------------------------------------------------------------------------
+//Uploads the builder's translucent faces and keeps what it takes to reorder them later. Main thread only.
+Chunk::TranslucentFaces::TranslucentFaces(const ChunkMeshBuilder& builder)
+    : m_meshRenderer(nullptr)
+    , m_sortedFromPosition(WorldPosition(0.0f, 0.0f, 0.0f))
+    , m_isSorted(false)
+{
+    m_builtIndices = builder.GetIndices(ChunkMeshBuilder::TRANSLUCENT_BUCKET);
+    CalculateQuadCenters(builder.GetVertices(ChunkMeshBuilder::TRANSLUCENT_BUCKET), m_quadCenters);
+    Mesh* mesh = new Mesh();
+    m_meshRenderer = new MeshRenderer(mesh, TheGame::instance->m_blockMaterial);
+    builder.CopyToMesh(mesh, ChunkMeshBuilder::TRANSLUCENT_BUCKET);
+}
+
+//-----------------------------------------------------------------------------------
+Chunk::TranslucentFaces::~TranslucentFaces()
+{
+    delete m_meshRenderer->m_mesh;
+    delete m_meshRenderer;
+}
+
+//-----------------------------------------------------------------------------------
+//Fills out_sortedQuads with the numbers of the quads centered at quadCenters, farthest from the camera first.
+//The keys are each quad's squared distance as float bits, which sort the same way the floats do since they're never
+//negative, flipped so an ascending sort puts the farthest first. Sorted a byte at a time, least significant first,
+//skipping any byte every key shares, which with distances this close together is usually the top one. Quads the
+//same distance away keep the order they came in. Main thread only.
+static void SortQuadsBackToFront(const std::vector<WorldPosition>& quadCenters, const WorldPosition& cameraPosition, std::vector<unsigned int>& out_sortedQuads)
+{
+    //Every section's sort shares the same scratch space.
+    static std::vector<unsigned int> s_keys[2];
+    static std::vector<unsigned int> s_quads[2];
+    const int RADIX_BITS = 8;
+    const int RADIX_SIZE = BIT(RADIX_BITS);
+    const int NUM_RADIX_PASSES = 32 / RADIX_BITS;
+    int numQuads = static_cast<int>(quadCenters.size());
+    out_sortedQuads.resize(numQuads);
+    if (numQuads == 0)
+    {
+        return;
+    }
+    for (int buffer = 0; buffer < 2; ++buffer)
+    {
+        s_keys[buffer].resize(numQuads);
+        s_quads[buffer].resize(numQuads);
+    }
+
+    unsigned int counts[NUM_RADIX_PASSES][RADIX_SIZE];
+    memset(counts, 0, sizeof(counts));
+    for (int quad = 0; quad < numQuads; ++quad)
+    {
+        float distanceSquared = MathUtils::CalcDistSquaredBetweenPoints(quadCenters[quad], cameraPosition);
+        unsigned int key;
+        memcpy(&key, &distanceSquared, sizeof(key));
+        key = ~key;
+        s_keys[0][quad] = key;
+        s_quads[0][quad] = quad;
+        for (int pass = 0; pass < NUM_RADIX_PASSES; ++pass)
+        {
+            ++counts[pass][(key >> (pass * RADIX_BITS)) & (RADIX_SIZE - 1)];
+        }
+    }
+
+    int source = 0;
+    for (int pass = 0; pass < NUM_RADIX_PASSES; ++pass)
+    {
+        int shift = pass * RADIX_BITS;
+        if (counts[pass][(s_keys[source][0] >> shift) & (RADIX_SIZE - 1)] == static_cast<unsigned int>(numQuads))
+        {
+            continue;
+        }
+        unsigned int offsets[RADIX_SIZE];
+        unsigned int offset = 0;
+        for (int digit = 0; digit < RADIX_SIZE; ++digit)
+        {
+            offsets[digit] = offset;
+            offset += counts[pass][digit];
+        }
+        const unsigned int* sourceKeys = s_keys[source].data();
+        const unsigned int* sourceQuads = s_quads[source].data();
+        unsigned int* destinationKeys = s_keys[1 - source].data();
+        unsigned int* destinationQuads = s_quads[1 - source].data();
+        for (int i = 0; i < numQuads; ++i)
+        {
+            unsigned int destination = offsets[(sourceKeys[i] >> shift) & (RADIX_SIZE - 1)]++;
+            destinationKeys[destination] = sourceKeys[i];
+            destinationQuads[destination] = sourceQuads[i];
+        }
+        source = 1 - source;
+    }
+    memcpy(out_sortedQuads.data(), s_quads[source].data(), numQuads * sizeof(unsigned int));
+}
+
+//-----------------------------------------------------------------------------------
+//Hands the GPU the quads' indices in back to front order from cameraPosition; the vertices stay where they are.
+void Chunk::TranslucentFaces::SortBackToFront(const WorldPosition& cameraPosition)
+{
+    //Main thread only, so every section's sort shares the same scratch space.
+    static std::vector<unsigned int> s_sortedQuads;
+    static std::vector<unsigned int> s_sortedIndices;
+    SortQuadsBackToFront(m_quadCenters, cameraPosition, s_sortedQuads);
+    s_sortedIndices.resize(m_builtIndices.size());
+    for (unsigned int i = 0; i < s_sortedQuads.size(); ++i)
+    {
+        memcpy(&s_sortedIndices[i * 6], &m_builtIndices[s_sortedQuads[i] * 6], 6 * sizeof(unsigned int));
+    }
+    m_meshRenderer->m_mesh->UpdateIndices(s_sortedIndices.data(), s_sortedIndices.size());
+    m_sortedFromPosition = cameraPosition;
+    m_isSorted = true;
+}
+
 //-----------------------------------------------------------------------------------
 void Chunk::GenerateChunk()
 {
@@ -77,81 +328,369 @@ void Chunk::GenerateChunk()
 }
 
 //-----------------------------------------------------------------------------------
-void Chunk::CalculateSkyLighting()
+//Fills out_neighborIndices with whichever of the block's six neighbors are inside this chunk.
+static int GetNeighborIndicesInsideChunk(LocalIndex index, LocalIndex* out_neighborIndices)
+{
+    int numNeighbors = 0;
+    if ((index & Chunk::LOCAL_Z_MASK) != Chunk::LOCAL_Z_MASK)
+    {
+        out_neighborIndices[numNeighbors++] = index + Chunk::BLOCKS_PER_LAYER;
+    }
+    if ((index & Chunk::LOCAL_Z_MASK) != 0)
+    {
+        out_neighborIndices[numNeighbors++] = index - Chunk::BLOCKS_PER_LAYER;
+    }
+    if ((index & Chunk::LOCAL_Y_MASK) != Chunk::LOCAL_Y_MASK)
+    {
+        out_neighborIndices[numNeighbors++] = index + Chunk::BLOCKS_WIDE_X;
+    }
+    if ((index & Chunk::LOCAL_Y_MASK) != 0)
+    {
+        out_neighborIndices[numNeighbors++] = index - Chunk::BLOCKS_WIDE_X;
+    }
+    if ((index & Chunk::LOCAL_X_MASK) != Chunk::LOCAL_X_MASK)
+    {
+        out_neighborIndices[numNeighbors++] = index + 1;
+    }
+    if ((index & Chunk::LOCAL_X_MASK) != 0)
+    {
+        out_neighborIndices[numNeighbors++] = index - 1;
+    }
+    return numNeighbors;
+}
+
+//-----------------------------------------------------------------------------------
+//Sky columns plus a flood fill from them and from glowing blocks, using only this chunk's blocks.
+//Nothing outside the chunk is touched, so this runs on the thread that generated or loaded it.
+//Light crossing into the neighbors is reconciled by the LightingEngine once the chunk is hooked up.
+//The profiling channel isn't safe off the main thread, so the time is kept on the chunk for whoever picks it up.
+void Chunk::CalculateLocalLighting()
+{
+    //REMINDER: THREAD-SAFE CODE ONLY!
+    double startSeconds = GetCurrentTimeSeconds();
+    std::vector<LocalIndex> spreadQueue;
+    spreadQueue.reserve(BLOCKS_PER_CHUNK / 4);
+    ResetLocalLighting(spreadQueue);
+    CalculateHeightMap();
+    CalculateSkyLighting(spreadQueue);
+    FloodLocalLighting(spreadQueue);
+    m_localLightingSeconds = GetCurrentTimeSeconds() - startSeconds;
+}
+
+//-----------------------------------------------------------------------------------
+//Every block goes back to its own glow and no sky, and the glowing ones are queued to spread it.
+void Chunk::ResetLocalLighting(std::vector<LocalIndex>& out_spreadQueue)
+{
+    for (int index = 0; index < BLOCKS_PER_CHUNK; ++index)
+    {
+        Block* currentBlock = &m_blocks[index];
+        BlockDefinition* definition = currentBlock->GetDefinition();
+        currentBlock->SetSky(false);
+        currentBlock->SetLightValue(RGBA(definition->m_illumination));
+        currentBlock->SetPackedSkyLight(0);
+        if (definition->IsIlluminated())
+        {
+            out_spreadQueue.push_back(index);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------------
+void Chunk::CalculateHeightMap()
+{
+    const int TOP_LAYER_INDEX = BLOCKS_PER_CHUNK - BLOCKS_PER_LAYER;
+    for (int columnIndex = 0; columnIndex < BLOCKS_PER_LAYER; ++columnIndex)
+    {
+        uchar height = 0;
+        for (int index = TOP_LAYER_INDEX + columnIndex; index >= 0; index -= BLOCKS_PER_LAYER)
+        {
+            if (m_blocks[index].GetDefinition()->m_blocksSky)
+            {
+                height = static_cast<uchar>((index >> CHUNK_BITS_XY) + 1);
+                break;
+            }
+        }
+        m_heightMap[columnIndex] = height;
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//Keeps one column of the height map right after a block in it changed type.
+void Chunk::UpdateHeightMap(LocalIndex changedIndex)
+{
+    int columnIndex = changedIndex & (LOCAL_X_MASK | LOCAL_Y_MASK);
+    int changedHeight = (changedIndex >> CHUNK_BITS_XY) + 1;
+    if (m_blocks[changedIndex].GetDefinition()->m_blocksSky)
+    {
+        if (changedHeight > m_heightMap[columnIndex])
+        {
+            m_heightMap[columnIndex] = static_cast<uchar>(changedHeight);
+        }
+        return;
+    }
+    if (changedHeight != m_heightMap[columnIndex])
+    {
+        return;
+    }
+    //The top of the column just opened up, so find whatever is under it.
+    uchar height = 0;
+    for (int index = changedIndex - BLOCKS_PER_LAYER; index >= 0; index -= BLOCKS_PER_LAYER)
+    {
+        if (m_blocks[index].GetDefinition()->m_blocksSky)
+        {
+            height = static_cast<uchar>((index >> CHUNK_BITS_XY) + 1);
+            break;
+        }
+    }
+    m_heightMap[columnIndex] = height;
+}
+
+//-----------------------------------------------------------------------------------
+//Marks every block at or above its column's height as sky and gives it full sky light, a row of 16 at a time.
+//Sky blocks next to something darker inside the chunk are queued to spread their light.
+void Chunk::CalculateSkyLighting(std::vector<LocalIndex>& out_spreadQueue)
 {
-    //Sky Pass 1
-    for (int x = 0; x < (BLOCKS_WIDE_X); x++)
+    static_assert((BLOCKS_WIDE_X * sizeof(Block)) % sizeof(__m128i) == 0, "The full-row sky kernel assumes a row of blocks fills whole SSE registers.");
+    const int BYTES_PER_ROW = BLOCKS_WIDE_X * sizeof(Block);
+    const int REGISTERS_PER_ROW = BYTES_PER_ROW / sizeof(__m128i);
+    const PackedLight fullSkyLight = PackLight(LightingEngine::FULL_SKY_LIGHT, LightingEngine::FULL_SKY_LIGHT, LightingEngine::FULL_SKY_LIGHT);
+
+    //What a full row of sky blocks looks like: keep the type, glow, other flags and portals, set the sky bit and sky light.
+    uchar keepBytes[BYTES_PER_ROW];
+    uchar skyBytes[BYTES_PER_ROW];
+    for (int blockIndex = 0; blockIndex < BLOCKS_WIDE_X; ++blockIndex)
+    {
+        Block keepMask;
+        keepMask.m_type = 0xFF;
+        keepMask.m_lightAndFlags = static_cast<uchar>(~Block::SKY_BIT);
+        keepMask.m_redLight = keepMask.m_greenLight = keepMask.m_blueLight = 0xFF;
+        keepMask.m_skyRedLight = keepMask.m_skyGreenLight = keepMask.m_skyBlueLight = 0x00;
+        keepMask.m_portalFlags = 0xFF;
+        Block skyPattern;
+        skyPattern.m_type = 0x00;
+        skyPattern.m_lightAndFlags = Block::SKY_BIT;
+        skyPattern.m_redLight = skyPattern.m_greenLight = skyPattern.m_blueLight = 0x00;
+        skyPattern.SetPackedSkyLight(fullSkyLight);
+        skyPattern.m_portalFlags = 0x00;
+        memcpy(&keepBytes[blockIndex * sizeof(Block)], &keepMask, sizeof(Block));
+        memcpy(&skyBytes[blockIndex * sizeof(Block)], &skyPattern, sizeof(Block));
+    }
+    __m128i keepRegisters[REGISTERS_PER_ROW];
+    __m128i skyRegisters[REGISTERS_PER_ROW];
+    for (int registerIndex = 0; registerIndex < REGISTERS_PER_ROW; ++registerIndex)
+    {
+        keepRegisters[registerIndex] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&keepBytes[registerIndex * sizeof(__m128i)]));
+        skyRegisters[registerIndex] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&skyBytes[registerIndex * sizeof(__m128i)]));
+    }
+
+    uchar lowestHeight = BLOCKS_TALL_Z;
+    for (int columnIndex = 0; columnIndex < BLOCKS_PER_LAYER; ++columnIndex)
+    {
+        lowestHeight = m_heightMap[columnIndex] < lowestHeight ? m_heightMap[columnIndex] : lowestHeight;
+    }
+    for (int z = lowestHeight; z < BLOCKS_TALL_Z; ++z)
     {
-        for (int y = 0; y < BLOCKS_WIDE_Y; y++)
+        const __m128i layerHeight = _mm_set1_epi8(static_cast<char>(z));
+        for (int y = 0; y < BLOCKS_WIDE_Y; ++y)
         {
-            BlockInfo info = GetBlockInfoFromLocalCoords(LocalCoords(x, y, BLOCKS_TALL_Z - 1));
-            while (info.m_index != BlockInfo::INVALID_INDEX)
+            //A column is sky on this layer if its height is at or below it; min(height, z) == height says exactly that.
+            __m128i heights = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_heightMap[y << CHUNK_BITS_X]));
+            int skyMask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(heights, layerHeight), heights));
+            if (skyMask == 0)
             {
-                Block* currentBlock = info.GetBlock();
-                if (currentBlock->GetDefinition()->m_opacity != RGBA(0x00000000))
+                continue;
+            }
+            LocalIndex rowIndex = (z << CHUNK_BITS_XY) + (y << CHUNK_BITS_X);
+            if (skyMask == 0xFFFF)
+            {
+                __m128i* rowBytes = reinterpret_cast<__m128i*>(&m_blocks[rowIndex]);
+                for (int registerIndex = 0; registerIndex < REGISTERS_PER_ROW; ++registerIndex)
                 {
-                    info = BlockInfo::INVALID_BLOCKINFO;
+                    __m128i blockBytes = _mm_loadu_si128(rowBytes + registerIndex);
+                    blockBytes = _mm_or_si128(_mm_and_si128(blockBytes, keepRegisters[registerIndex]), skyRegisters[registerIndex]);
+                    _mm_storeu_si128(rowBytes + registerIndex, blockBytes);
                 }
-                else
+                continue;
+            }
+            for (int x = 0; x < BLOCKS_WIDE_X; ++x)
+            {
+                if (skyMask & BIT(x))
                 {
+                    Block* currentBlock = &m_blocks[rowIndex + x];
                     currentBlock->SetSky(true);
-                    currentBlock->SetLightValue(m_world->m_skyLight);
-                    info = info.GetBelow();
+                    currentBlock->SetPackedSkyLight(fullSkyLight);
                 }
             }
         }
     }
-    //Sky Pass 2
-    for (int x = 0; x < (BLOCKS_WIDE_X); x++)
+
+    //A sky block can only have a darker neighbor inside the chunk where a neighboring column is taller,
+    //or right on top of its own column if the block there lets light through.
+    for (int columnIndex = 0; columnIndex < BLOCKS_PER_LAYER; ++columnIndex)
     {
-        for (int y = 0; y < BLOCKS_WIDE_Y; y++)
+        int height = m_heightMap[columnIndex];
+        int tallestNeighborHeight = height;
+        if ((columnIndex & LOCAL_X_MASK) != LOCAL_X_MASK)
+        {
+            tallestNeighborHeight = m_heightMap[columnIndex + 1] > tallestNeighborHeight ? m_heightMap[columnIndex + 1] : tallestNeighborHeight;
+        }
+        if ((columnIndex & LOCAL_X_MASK) != 0)
         {
-            BlockInfo info = GetBlockInfoFromLocalCoords(LocalCoords(x, y, BLOCKS_TALL_Z - 1));
-            while (info.m_index != BlockInfo::INVALID_INDEX)
+            tallestNeighborHeight = m_heightMap[columnIndex - 1] > tallestNeighborHeight ? m_heightMap[columnIndex - 1] : tallestNeighborHeight;
+        }
+        if ((columnIndex & LOCAL_Y_MASK) != LOCAL_Y_MASK)
+        {
+            tallestNeighborHeight = m_heightMap[columnIndex + BLOCKS_WIDE_X] > tallestNeighborHeight ? m_heightMap[columnIndex + BLOCKS_WIDE_X] : tallestNeighborHeight;
+        }
+        if ((columnIndex & LOCAL_Y_MASK) != 0)
+        {
+            tallestNeighborHeight = m_heightMap[columnIndex - BLOCKS_WIDE_X] > tallestNeighborHeight ? m_heightMap[columnIndex - BLOCKS_WIDE_X] : tallestNeighborHeight;
+        }
+        int seedTopHeight = tallestNeighborHeight;
+        if (height > 0 && height < BLOCKS_TALL_Z && height == seedTopHeight && !m_blocks[((height - 1) << CHUNK_BITS_XY) + columnIndex].GetDefinition()->m_isOpaque)
+        {
+            seedTopHeight = height + 1;
+        }
+        for (int z = height; z < seedTopHeight; ++z)
+        {
+            out_spreadQueue.push_back((z << CHUNK_BITS_XY) + columnIndex);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//The original per-block sky pass, kept to check and benchmark CalculateSkyLighting against.
+void Chunk::CalculateSkyLightingPerBlock(std::vector<LocalIndex>& out_spreadQueue)
+{
+    const int TOP_LAYER_INDEX = BLOCKS_PER_CHUNK - BLOCKS_PER_LAYER;
+    const PackedLight fullSkyLight = PackLight(LightingEngine::FULL_SKY_LIGHT, LightingEngine::FULL_SKY_LIGHT, LightingEngine::FULL_SKY_LIGHT);
+    for (int columnIndex = 0; columnIndex < BLOCKS_PER_LAYER; ++columnIndex)
+    {
+        for (int index = TOP_LAYER_INDEX + columnIndex; index >= 0; index -= BLOCKS_PER_LAYER)
+        {
+            Block* currentBlock = &m_blocks[index];
+            if (currentBlock->GetDefinition()->m_opacity != RGBA(0x00000000))
+            {
+                break;
+            }
+            currentBlock->SetSky(true);
+            currentBlock->SetPackedSkyLight(fullSkyLight);
+        }
+    }
+    LocalIndex neighborIndices[NUM_DIRECTIONS];
+    for (int columnIndex = 0; columnIndex < BLOCKS_PER_LAYER; ++columnIndex)
+    {
+        for (int index = TOP_LAYER_INDEX + columnIndex; index >= 0 && m_blocks[index].IsSky(); index -= BLOCKS_PER_LAYER)
+        {
+            int numNeighbors = GetNeighborIndicesInsideChunk(index, neighborIndices);
+            for (int i = 0; i < numNeighbors; ++i)
             {
-                Block* currentBlock = info.GetBlock();
-                uchar blockType = currentBlock->m_type;
-                if (BlockDefinition::GetDefinition(blockType)->m_isOpaque)
+                Block* neighbor = &m_blocks[neighborIndices[i]];
+                if (!neighbor->IsSky() && !neighbor->GetDefinition()->m_isOpaque)
                 {
-                    info = BlockInfo::INVALID_BLOCKINFO;
+                    out_spreadQueue.push_back(index);
+                    break;
                 }
-                else
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//Glow and sky spread side by side, with the same falloff and filtering.
+void Chunk::FloodLocalLighting(std::vector<LocalIndex>& spreadQueue)
+{
+    LocalIndex neighborIndices[NUM_DIRECTIONS];
+    for (unsigned int queueIndex = 0; queueIndex < spreadQueue.size(); ++queueIndex)
+    {
+        LocalIndex index = spreadQueue[queueIndex];
+        Block* currentBlock = &m_blocks[index];
+        if (!LightingEngine::CanSpreadLight(currentBlock))
+        {
+            continue;
+        }
+        PackedLight light = currentBlock->GetPackedLight();
+        PackedLight skyLight = currentBlock->GetPackedSkyLight();
+        int numNeighbors = GetNeighborIndicesInsideChunk(index, neighborIndices);
+        for (int i = 0; i < numNeighbors; ++i)
+        {
+            Block* neighbor = &m_blocks[neighborIndices[i]];
+            BlockDefinition* neighborDefinition = neighbor->GetDefinition();
+            if (neighborDefinition->m_isOpaque)
+            {
+                continue;
+            }
+            PackedLight spreadLight = SubtractPackedLight(light, neighborDefinition->m_packedAttenuation);
+            PackedLight spreadSkyLight = SubtractPackedLight(skyLight, neighborDefinition->m_packedAttenuation);
+            PackedLight neighborLight = neighbor->GetPackedLight();
+            PackedLight neighborSkyLight = neighbor->GetPackedSkyLight();
+            bool isBrighter = IsPackedLightBrighter(spreadLight, neighborLight);
+            bool isSkyBrighter = IsPackedLightBrighter(spreadSkyLight, neighborSkyLight);
+            if (isBrighter || isSkyBrighter)
+            {
+                if (isBrighter)
                 {
-                    BlockInfo eastBlock = info.GetEast();
-                    if (eastBlock.m_index != BlockInfo::INVALID_INDEX && !eastBlock.GetBlock()->IsSky())
-                    {
-                        BlockInfo::SetDirtyFlagAndAddToDirtyList(eastBlock);
-                    }
-                    BlockInfo westBlock = info.GetWest();
-                    if (westBlock.m_index != BlockInfo::INVALID_INDEX && !westBlock.GetBlock()->IsSky())
-                    {
-                        BlockInfo::SetDirtyFlagAndAddToDirtyList(westBlock);
-                    }
-                    BlockInfo northBlock = info.GetNorth();
-                    if (northBlock.m_index != BlockInfo::INVALID_INDEX && !northBlock.GetBlock()->IsSky())
-                    {
-                        BlockInfo::SetDirtyFlagAndAddToDirtyList(northBlock);
-                    }
-                    BlockInfo southBlock = info.GetSouth();
-                    if (southBlock.m_index != BlockInfo::INVALID_INDEX && !southBlock.GetBlock()->IsSky())
-                    {
-                        BlockInfo::SetDirtyFlagAndAddToDirtyList(southBlock);
-                    }
-                    info = info.GetBelow();
+                    neighbor->SetPackedLight(MaxPackedLight(spreadLight, neighborLight));
                 }
+                if (isSkyBrighter)
+                {
+                    neighbor->SetPackedSkyLight(MaxPackedLight(spreadSkyLight, neighborSkyLight));
+                }
+                spreadQueue.push_back(neighborIndices[i]);
             }
         }
     }
+}
+
+//-----------------------------------------------------------------------------------
+//Returns true if this is the chunk's first dirty block, meaning the world has to queue the chunk up.
+bool Chunk::SetLightingDirty(LocalIndex index)
+{
+    unsigned int& word = m_lightingDirtyBits[index / LIGHTING_DIRTY_BITS_PER_WORD];
+    unsigned int bit = BIT(index % LIGHTING_DIRTY_BITS_PER_WORD);
+    if (word & bit)
+    {
+        return false;
+    }
+    word |= bit;
+    return ++m_numLightingDirtyBlocks == 1;
+}
+
+//-----------------------------------------------------------------------------------
+void Chunk::ClearLightingDirty()
+{
+    if (m_numLightingDirtyBlocks > 0)
+    {
+        memset(m_lightingDirtyBits, 0, sizeof(m_lightingDirtyBits));
+        m_numLightingDirtyBlocks = 0;
+    }
+}
 
-    for (int i = 0; i < BLOCKS_PER_CHUNK; i++)
+//-----------------------------------------------------------------------------------
+//Hands every dirty block to the engine in index order and clears the bits. Returns how many there were.
+int Chunk::QueueLightingDirtyBlocks(LightingEngine& lightingEngine)
+{
+    int numQueuedBlocks = m_numLightingDirtyBlocks;
+    for (int wordIndex = 0; wordIndex < NUM_LIGHTING_DIRTY_WORDS && m_numLightingDirtyBlocks > 0; ++wordIndex)
     {
-        Block* currentBlock = GetBlock(i);
-        BlockDefinition* definition = BlockDefinition::GetDefinition(currentBlock->m_type);
-        if (definition->m_illumination > 0)
+        unsigned long word = m_lightingDirtyBits[wordIndex];
+        m_lightingDirtyBits[wordIndex] = 0;
+        unsigned long bitIndex;
+        while (_BitScanForward(&bitIndex, word))
         {
-            SetBlockDirtyAndAddToDirtyList(i);
+            word &= word - 1;
+            lightingEngine.QueueRelight(BlockInfo(this, static_cast<LocalIndex>(wordIndex * LIGHTING_DIRTY_BITS_PER_WORD + bitIndex)));
+            --m_numLightingDirtyBlocks;
         }
     }
+    return numQueuedBlocks;
+}
+
+//-----------------------------------------------------------------------------------
+//Never handed out twice, so a retired id can't come back on a new chunk that reuses an old one's memory.
+unsigned int Chunk::GetNewLightingQueueID()
+{
+    return s_nextLightingQueueID++;
 }
 
 //-----------------------------------------------------------------------------------
@@ -242,158 +781,628 @@ bool Chunk::IsInFrustum(const Vector3& cameraXYZ, const WorldPosition& playerPos
 }
 
 //-----------------------------------------------------------------------------------
+//The portal flag, plus how much of the sky reaches the face, which the shader scales by the world's sky light.
+static Vector4 GetFaceFloatData(float isPortal, const Block* faceBlock, uchar dampAmount)
+{
+    Vector4 skyLight = RGBA(faceBlock->GetDampedSkyLightValue(dampAmount)).ToVec4();
+    return Vector4(isPortal, skyLight.x, skyLight.y, skyLight.z);
+}
+
+//-----------------------------------------------------------------------------------
+static unsigned int GetRGBAValue(PackedLight light)
+{
+    return (GetPackedRed(light) << RGBA::SHIFT_RED) + (GetPackedGreen(light) << RGBA::SHIFT_GREEN) + (GetPackedBlue(light) << RGBA::SHIFT_BLUE) + 0xFF;
+}
+
+//-----------------------------------------------------------------------------------
+//Adds one corner of a face. With a neighborhood, the corner gets its own smoothed and occluded light, overriding
+//the face's flat color and sky light; without one (or for portals), it keeps whatever the face set.
+template <typename MeshBuilderType>
+static void AddFaceVertex(MeshBuilderType& builder, const ChunkNeighborhood* neighborhood, LocalIndex index, Direction faceDirection, uchar dampAmount, float isPortal, const WorldPosition& blockMins, const Vector3& position)
+{
+    PackedLight light = 0;
+    PackedLight skyLight = 0;
+    Vector3Int cornerOffset(position.x - blockMins.x > 0.5f ? 1 : 0, position.y - blockMins.y > 0.5f ? 1 : 0, position.z - blockMins.z > 0.5f ? 1 : 0);
+    if (neighborhood && isPortal == 0.0f && neighborhood->GetSmoothVertexLight(index, faceDirection, cornerOffset, dampAmount, light, skyLight))
+    {
+        Vector4 sky = RGBA(GetRGBAValue(skyLight)).ToVec4();
+        builder.SetColor(RGBA(GetRGBAValue(light)));
+        builder.SetFloatData0(Vector4(isPortal, sky.x, sky.y, sky.z));
+    }
+    builder.AddVertex(position);
+}
+
+//-----------------------------------------------------------------------------------
+//Switches the builder over to translucent faces and returns the index their first vertex gets. ChunkMeshBuilder
+//keeps them in a buffer of their own, numbered from 0; MeshBuilder has just the one, so they carry on from lastIndex.
+static int StartTranslucentFaces(ChunkMeshBuilder& builder, int lastIndex)
+{
+    UNUSED(lastIndex);
+    builder.SetBucket(ChunkMeshBuilder::TRANSLUCENT_BUCKET);
+    return 0;
+}
+
+//-----------------------------------------------------------------------------------
+static int StartTranslucentFaces(MeshBuilder& builder, int lastIndex)
+{
+    UNUSED(builder);
+    return lastIndex;
+}
+
+//-----------------------------------------------------------------------------------
+//One opaque block face as the greedy mesher sees it. Neighboring faces only merge if all of this matches.
+struct GreedyFace
+{
+    bool m_isVisible;
+    bool m_canMerge; //False for smooth lit faces whose corners differ; those are built one block at a time.
+    uchar m_type;
+    bool m_isPortal;
+    PackedLight m_light;
+    PackedLight m_skyLight;
+
+    inline bool CanMergeWith(const GreedyFace& other) const
+    {
+        return other.m_isVisible && other.m_canMerge && m_type == other.m_type && m_isPortal == other.m_isPortal && m_light == other.m_light && m_skyLight == other.m_skyLight;
+    }
+};
+
+//-----------------------------------------------------------------------------------
+//How each face direction lays out for the greedy mesher: the block axis (0 x, 1 y, 2 z) its slices step along, the
+//two axes its rectangles grow along, whether the face is on the high side of the block, how much it's damped,
+//and its corners in the same order as the per-face mesher (0 for the low edge, 1 for the high edge).
+//The bottom face's texture runs along y, so its tile counts swap.
+struct GreedyDirectionInfo
+{
+    int m_sliceAxis;
+    int m_firstAxis;
+    int m_secondAxis;
+    int m_faceOffset;
+    uchar m_dampAmount;
+    int m_firstCorners[4];
+    int m_secondCorners[4];
+    bool m_swapsTiles;
+};
+static const GreedyDirectionInfo GREEDY_DIRECTIONS[NUM_DIRECTIONS] =
+{
+    { 2, 0, 1, 1, 0x00, { 0, 1, 1, 0 }, { 0, 0, 1, 1 }, false }, //ABOVE
+    { 2, 0, 1, 0, 0x33, { 0, 0, 1, 1 }, { 0, 1, 1, 0 }, true }, //BELOW
+    { 1, 0, 2, 1, 0x11, { 1, 0, 0, 1 }, { 0, 0, 1, 1 }, false }, //NORTH
+    { 1, 0, 2, 0, 0x11, { 0, 1, 1, 0 }, { 0, 0, 1, 1 }, false }, //SOUTH
+    { 0, 1, 2, 1, 0x22, { 0, 1, 1, 0 }, { 0, 0, 1, 1 }, false }, //EAST
+    { 0, 1, 2, 0, 0x22, { 1, 0, 0, 1 }, { 0, 0, 1, 1 }, false }, //WEST
+};
+static const int GREEDY_AXIS_SIZES[3] = { Chunk::BLOCKS_WIDE_X, Chunk::BLOCKS_WIDE_Y, Chunk::BLOCKS_TALL_Z };
+static const int GREEDY_AXIS_SHIFTS[3] = { 0, Chunk::CHUNK_BITS_X, Chunk::CHUNK_BITS_XY };
+
+//-----------------------------------------------------------------------------------
+//Only asked about faces the opaque face masks say are drawn. Their light follows the same rules as the per-face mesher.
+static GreedyFace GetGreedyFace(const ChunkMeshSnapshot& snapshot, LocalIndex index, Direction direction)
+{
+    GreedyFace face;
+    const Block* currentBlock = snapshot.GetBlock(index);
+    const Block* neighborBlock = snapshot.GetNeighbor(index, direction);
+    const GreedyDirectionInfo& info = GREEDY_DIRECTIONS[direction];
+    PackedLight damping = PackLight(info.m_dampAmount, info.m_dampAmount, info.m_dampAmount);
+    face.m_isVisible = true;
+    face.m_canMerge = true;
+    face.m_type = currentBlock->m_type;
+    face.m_isPortal = currentBlock->IsPortal(direction);
+    face.m_light = SubtractPackedLight(neighborBlock->GetPackedLight(), damping);
+    face.m_skyLight = SubtractPackedLight(neighborBlock->GetPackedSkyLight(), damping);
+    const ChunkNeighborhood* neighborhood = snapshot.GetSmoothLightingNeighborhood();
+    if (!neighborhood || face.m_isPortal)
+    {
+        return face;
+    }
+
+    //Smooth lit faces can still merge if all four corners came out the same.
+    for (int corner = 0; corner < 4; ++corner)
+    {
+        int offsets[3];
+        offsets[info.m_sliceAxis] = info.m_faceOffset;
+        offsets[info.m_firstAxis] = info.m_firstCorners[corner];
+        offsets[info.m_secondAxis] = info.m_secondCorners[corner];
+        PackedLight light = 0;
+        PackedLight skyLight = 0;
+        if (!neighborhood->GetSmoothVertexLight(index, direction, Vector3Int(offsets[0], offsets[1], offsets[2]), info.m_dampAmount, light, skyLight))
+        {
+            return face; //Flat lit, same as the per-face mesher does for it.
+        }
+        if (corner == 0)
+        {
+            face.m_light = light;
+            face.m_skyLight = skyLight;
+        }
+        else if (light != face.m_light || skyLight != face.m_skyLight)
+        {
+            face.m_canMerge = false;
+            return face;
+        }
+    }
+    return face;
+}
+
+//-----------------------------------------------------------------------------------
+//Adds one face covering width x height blocks starting at index. uv0 is the tile's corner and uv1 counts tiles
+//across the face; the shader repeats the tile with them. Faces that can't merge are always 1x1 and get their
+//corners smooth lit like the per-face mesher would.
+template <typename MeshBuilderType>
+static void AddGreedyQuad(MeshBuilderType& builder, const ChunkMeshSnapshot& snapshot, LocalIndex index, Direction direction, const GreedyFace& face, int width, int height)
+{
+    const GreedyDirectionInfo& info = GREEDY_DIRECTIONS[direction];
+    BlockDefinition* definition = BlockDefinition::GetDefinition(face.m_type);
+    AABB2 textureCoords = (direction == ABOVE) ? definition->GetTopIndex() : ((direction == BELOW) ? definition->GetBottomIndex() : definition->GetSideIndex());
+    Vector4 sky = RGBA(GetRGBAValue(face.m_skyLight)).ToVec4();
+    float isPortal = face.m_isPortal ? 1.0f : 0.0f;
+    builder.SetColor(RGBA(GetRGBAValue(face.m_light)));
+    builder.SetFloatData0(Vector4(isPortal, sky.x, sky.y, sky.z));
+    builder.SetUV(textureCoords.mins);
+
+    WorldPosition blockMins = snapshot.GetWorldMinsForBlockIndex(index);
+    LocalCoords localCoords = Chunk::GetLocalCoordsFromBlockIndex(index);
+    const int blockCoords[3] = { localCoords.x, localCoords.y, localCoords.z };
+    const ChunkNeighborhood* cornerNeighborhood = face.m_canMerge ? nullptr : snapshot.GetSmoothLightingNeighborhood();
+    for (int corner = 0; corner < 4; ++corner)
+    {
+        float cornerCoords[3];
+        cornerCoords[info.m_sliceAxis] = (float)(blockCoords[info.m_sliceAxis] + info.m_faceOffset);
+        cornerCoords[info.m_firstAxis] = (float)(blockCoords[info.m_firstAxis] + (info.m_firstCorners[corner] * width));
+        cornerCoords[info.m_secondAxis] = (float)(blockCoords[info.m_secondAxis] + (info.m_secondCorners[corner] * height));
+        float firstTiles = (info.m_firstCorners[corner] != info.m_firstCorners[0]) ? (float)width : 0.0f;
+        float secondTiles = (info.m_secondCorners[corner] != info.m_secondCorners[0]) ? (float)height : 0.0f;
+        builder.SetUV1(info.m_swapsTiles ? Vector2(secondTiles, firstTiles) : Vector2(firstTiles, secondTiles));
+        Vector3 position(snapshot.m_chunkMins.x + cornerCoords[0], snapshot.m_chunkMins.y + cornerCoords[1], cornerCoords[2]);
+        AddFaceVertex(builder, cornerNeighborhood, index, direction, info.m_dampAmount, isPortal, blockMins, position);
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//Builds the opaque faces in layers firstZ up to endZ one slice at a time for each direction. Each visible face not
+//yet covered grows as wide as it can, then as tall as whole rows of matching faces allow, and everything it covers
+//is drawn as one quad. Returns the new lastIndex.
+template <typename MeshBuilderType>
+static int AddGreedyOpaqueFaces(MeshBuilderType& builder, const ChunkMeshSnapshot& snapshot, const uchar* opaqueFaces, int lastIndex, int firstZ, int endZ)
+{
+    //Big enough for the largest slice. One per thread, since mesh workers build side by side.
+    static thread_local GreedyFace s_faces[Chunk::BLOCKS_WIDE_X * Chunk::BLOCKS_TALL_Z];
+    for (int directionIndex = 0; directionIndex < NUM_DIRECTIONS; ++directionIndex)
+    {
+        Direction direction = static_cast<Direction>(directionIndex);
+        const GreedyDirectionInfo& info = GREEDY_DIRECTIONS[direction];
+        //z is always the slice axis or the second one, and only runs over the layers being built.
+        const int axisStarts[3] = { 0, 0, firstZ };
+        const int axisEnds[3] = { GREEDY_AXIS_SIZES[0], GREEDY_AXIS_SIZES[1], endZ };
+        int firstSize = GREEDY_AXIS_SIZES[info.m_firstAxis];
+        int secondStart = axisStarts[info.m_secondAxis];
+        int secondSize = axisEnds[info.m_secondAxis] - secondStart;
+        for (int slice = axisStarts[info.m_sliceAxis]; slice < axisEnds[info.m_sliceAxis]; ++slice)
+        {
+            int sliceStart = (slice << GREEDY_AXIS_SHIFTS[info.m_sliceAxis]) + (secondStart << GREEDY_AXIS_SHIFTS[info.m_secondAxis]);
+            for (int second = 0; second < secondSize; ++second)
+            {
+                for (int first = 0; first < firstSize; ++first)
+                {
+                    LocalIndex index = static_cast<LocalIndex>(sliceStart + (first << GREEDY_AXIS_SHIFTS[info.m_firstAxis]) + (second << GREEDY_AXIS_SHIFTS[info.m_secondAxis]));
+                    GreedyFace& face = s_faces[(second * firstSize) + first];
+                    if ((opaqueFaces[index] & BIT(direction)) != 0)
+                    {
+                        face = GetGreedyFace(snapshot, index, direction);
+                    }
+                    else
+                    {
+                        face.m_isVisible = false;
+                    }
+                }
+            }
+
+            for (int second = 0; second < secondSize; ++second)
+            {
+                for (int first = 0; first < firstSize; ++first)
+                {
+                    GreedyFace face = s_faces[(second * firstSize) + first];
+                    if (!face.m_isVisible)
+                    {
+                        continue;
+                    }
+                    int width = 1;
+                    int height = 1;
+                    if (face.m_canMerge)
+                    {
+                        while (first + width < firstSize && face.CanMergeWith(s_faces[(second * firstSize) + first + width]))
+                        {
+                            ++width;
+                        }
+                        bool canGrow = true;
+                        while (canGrow && second + height < secondSize)
+                        {
+                            for (int step = 0; step < width && canGrow; ++step)
+                            {
+                                canGrow = face.CanMergeWith(s_faces[((second + height) * firstSize) + first + step]);
+                            }
+                            if (canGrow)
+                            {
+                                ++height;
+                            }
+                        }
+                    }
+                    for (int row = second; row < second + height; ++row)
+                    {
+                        for (int column = first; column < first + width; ++column)
+                        {
+                            s_faces[(row * firstSize) + column].m_isVisible = false;
+                        }
+                    }
+
+                    LocalIndex index = static_cast<LocalIndex>(sliceStart + (first << GREEDY_AXIS_SHIFTS[info.m_firstAxis]) + (second << GREEDY_AXIS_SHIFTS[info.m_secondAxis]));
+                    AddGreedyQuad(builder, snapshot, index, direction, face, width, height);
+                    builder.AddQuadIndicesClockwise(lastIndex + 3, lastIndex + 2, lastIndex + 0, lastIndex + 1);
+                    lastIndex += 4;
+                }
+            }
+        }
+    }
+    //Everything after this is drawn one face at a time.
+    builder.SetUV1(Vector2::ZERO);
+    return lastIndex;
+}
+
+//-----------------------------------------------------------------------------------
+//Which faces of one opaque block get drawn, BIT(direction) each, looking at its neighbors one at a time: the ones
+//facing a loaded block that isn't opaque, or with a portal on either side.
+static uchar GetOpaqueFacesFromNeighbors(const ChunkMeshSnapshot& snapshot, LocalIndex index)
+{
+    const Block* currentBlock = snapshot.GetBlock(index);
+    if (!currentBlock->GetDefinition()->m_isOpaque)
+    {
+        return 0x00;
+    }
+    uchar faces = 0x00;
+    for (int directionIndex = 0; directionIndex < NUM_DIRECTIONS; ++directionIndex)
+    {
+        Direction direction = static_cast<Direction>(directionIndex);
+        Direction oppositeDirection = static_cast<Direction>(direction ^ 1); //The enum pairs each direction with its opposite.
+        const Block* neighborBlock = snapshot.GetNeighbor(index, direction);
+        if (neighborBlock && (!neighborBlock->GetDefinition()->m_isOpaque || currentBlock->IsPortal(direction) || neighborBlock->IsPortal(oppositeDirection)))
+        {
+            faces |= BIT(direction);
+        }
+    }
+    return faces;
+}
+
+//-----------------------------------------------------------------------------------
+//Fills in the opaque faces of every block in layers firstZ up to endZ, a row at a time from the snapshot's bitfields
+//or block by block, whichever the snapshot was taken for.
+static void CalculateOpaqueFaces(const ChunkMeshSnapshot& snapshot, int firstZ, int endZ, uchar* out_faceMasks)
+{
+    if (snapshot.m_useFaceMasks)
+    {
+        snapshot.CalculateOpaqueFaces(firstZ, endZ, out_faceMasks);
+        return;
+    }
+    for (int index = firstZ * Chunk::BLOCKS_PER_LAYER; index < endZ * Chunk::BLOCKS_PER_LAYER; ++index)
+    {
+        out_faceMasks[index] = GetOpaqueFacesFromNeighbors(snapshot, static_cast<LocalIndex>(index));
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//Builds on the main thread read from this. Main thread only, so one copy is shared by every chunk's build.
+static ChunkMeshSnapshot* GetMainThreadSnapshot()
+{
+    static ChunkMeshSnapshot s_snapshot;
+    return &s_snapshot;
+}
+
+//-----------------------------------------------------------------------------------
+//Copies what the mesher needs to rebuild the dirty sections, in the current modes, stamped with the next version of
+//the chunk. A chunk snapshotted while clean is being rebuilt on purpose, so all of it is. The chunk counts as clean
+//from here on; anything that changes it after this dirties it again and gets picked up by a later version.
+void Chunk::TakeMeshSnapshot(ChunkMeshSnapshot& out_snapshot)
+{
+    out_snapshot.CopyFromChunk(this, (m_dirtyMeshSections != 0) ? m_dirtyMeshSections : ALL_MESH_SECTIONS);
+    out_snapshot.m_version = ++m_lastSnapshotVersion;
+    m_dirtyMeshSections = 0;
+    m_isDirty = false;
+}
+
+//-----------------------------------------------------------------------------------
+//Swaps in one section's mesh built from the given version of the chunk. Builds can finish out of order, so one from
+//an older version than the section already showing is dropped. Main thread only.
+bool Chunk::UploadMesh(const ChunkMeshBuilder& builder, int meshSection, unsigned int snapshotVersion)
+{
+    MeshSection& section = m_meshSections[meshSection];
+    if (snapshotVersion < section.m_uploadedSnapshotVersion)
+    {
+        return false;
+    }
+    if (section.m_meshRenderer)
+    {
+        delete section.m_meshRenderer->m_mesh;
+        delete section.m_meshRenderer;
+        section.m_meshRenderer = nullptr;
+    }
+    delete section.m_translucentFaces;
+    section.m_translucentFaces = nullptr;
+    section.m_numVerts = builder.GetNumVerts();
+    section.m_numIndices = builder.GetNumIndices();
+    section.m_uploadedSnapshotVersion = snapshotVersion;
+    //Empty sections (all air, or all buried) are most of them, and don't need anything on the GPU.
+    if (!builder.GetIndices(ChunkMeshBuilder::OPAQUE_BUCKET).empty())
+    {
+        Mesh* mesh = new Mesh();
+        section.m_meshRenderer = new MeshRenderer(mesh, TheGame::instance->m_blockMaterial);
+        builder.CopyToMesh(mesh, ChunkMeshBuilder::OPAQUE_BUCKET);
+    }
+    if (!builder.GetIndices(ChunkMeshBuilder::TRANSLUCENT_BUCKET).empty())
+    {
+        section.m_translucentFaces = new TranslucentFaces(builder);
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//Snapshots, builds and uploads the dirty sections right away on the main thread.
 void Chunk::GenerateVertexArray()
 {
     DebuggerPrintf("[%i] World [%i]: Building Chunk %i,%i VA\n", g_frameNumber, m_world->m_worldID, m_chunkPosition.x, m_chunkPosition.y);
     StartTiming(g_vaBuildingProfiling);
-    AttemptCleanUpRenderData();
-    MeshBuilder builder = MeshBuilder();
+    ChunkMeshSnapshot* snapshot = GetMainThreadSnapshot();
+    TakeMeshSnapshot(*snapshot);
+    for (int meshSection = 0; meshSection < NUM_MESH_SECTIONS; ++meshSection)
+    {
+        if ((snapshot->m_meshSections & BIT(meshSection)) == 0)
+        {
+            continue;
+        }
+        if (s_usePackedMesher)
+        {
+            //Main thread only, so one builder's buffers are reused by every chunk's build.
+            static ChunkMeshBuilder s_builder;
+            TheGame::instance->m_meshCache->BuildSection(s_builder, *snapshot, meshSection);
+            UploadMesh(s_builder, meshSection, snapshot->m_version);
+        }
+        else
+        {
+            //MeshBuilder only has the one buffer, so translucent faces go in with the opaque ones, unsorted.
+            MeshSection& section = m_meshSections[meshSection];
+            if (section.m_meshRenderer)
+            {
+                delete section.m_meshRenderer->m_mesh;
+                delete section.m_meshRenderer;
+            }
+            delete section.m_translucentFaces;
+            section.m_translucentFaces = nullptr;
+            Mesh* mesh = new Mesh();
+            section.m_meshRenderer = new MeshRenderer(mesh, TheGame::instance->m_blockMaterial);
+            MeshBuilder builder = MeshBuilder();
+            builder.Begin();
+            int firstZ = meshSection << CHUNK_BITS_MESH_SECTION_Z;
+            AddFacesToMesh(builder, *snapshot, firstZ, firstZ + BLOCKS_TALL_MESH_SECTION_Z);
+            builder.End();
+            builder.CopyToMesh(mesh, &Vertex_PCTTD::Copy, sizeof(Vertex_PCTTD), &Vertex_PCTTD::BindMeshToVAO);
+            section.m_numVerts = builder.m_vertices.size();
+            section.m_numIndices = builder.m_indices.size();
+            section.m_uploadedSnapshotVersion = snapshot->m_version;
+        }
+    }
+    EndTiming(g_vaBuildingProfiling);
+}
+
+//-----------------------------------------------------------------------------------
+//Builds the chunk's whole mesh in the current modes without touching the chunk's own mesh. Main thread only.
+void Chunk::BuildPackedMesh(ChunkMeshBuilder& builder)
+{
+    ChunkMeshSnapshot* snapshot = GetMainThreadSnapshot();
+    snapshot->CopyFromChunk(this, ALL_MESH_SECTIONS);
+    BuildPackedMesh(builder, *snapshot);
+}
+
+//-----------------------------------------------------------------------------------
+//Builds a mesh from a snapshot alone, so it's safe on any thread as long as each thread has its own builder. This
+//one is every section in one mesh, so the snapshot has to have all of them.
+void Chunk::BuildPackedMesh(ChunkMeshBuilder& builder, const ChunkMeshSnapshot& snapshot)
+{
     builder.Begin();
+    AddFacesToMesh(builder, snapshot, 0, BLOCKS_TALL_Z);
+}
+
+//-----------------------------------------------------------------------------------
+//Just one section's mesh, which has to be one of the snapshot's sections.
+void Chunk::BuildPackedMesh(ChunkMeshBuilder& builder, const ChunkMeshSnapshot& snapshot, int meshSection)
+{
+    builder.Begin();
+    int firstZ = meshSection << CHUNK_BITS_MESH_SECTION_Z;
+    AddFacesToMesh(builder, snapshot, firstZ, firstZ + BLOCKS_TALL_MESH_SECTION_Z);
+}
+
+//-----------------------------------------------------------------------------------
+int Chunk::GetNumVerts() const
+{
+    int numVerts = 0;
+    for (const MeshSection& meshSection : m_meshSections)
+    {
+        numVerts += meshSection.m_numVerts;
+    }
+    return numVerts;
+}
+
+//-----------------------------------------------------------------------------------
+int Chunk::GetNumIndices() const
+{
+    int numIndices = 0;
+    for (const MeshSection& meshSection : m_meshSections)
+    {
+        numIndices += meshSection.m_numIndices;
+    }
+    return numIndices;
+}
+
+//-----------------------------------------------------------------------------------
+//Everything in layers firstZ up to endZ that gets drawn, opaque faces first, then transparent ones and portals, which
+//ChunkMeshBuilder keeps in a buffer of their own.
+//Works with either MeshBuilder or ChunkMeshBuilder, and reads nothing but the snapshot.
+template <typename MeshBuilderType>
+void Chunk::AddFacesToMesh(MeshBuilderType& builder, const ChunkMeshSnapshot& snapshot, int firstZ, int endZ)
+{
     const float blockSize = 1.0f;
+    const ChunkNeighborhood* neighborhood = snapshot.GetSmoothLightingNeighborhood();
     int lastIndex = 0;
-    for (int i = 0; i < BLOCKS_PER_CHUNK; i++)
+    //Which opaque faces show is settled for the whole range before either mesher starts. One per thread, since mesh
+    //workers build side by side.
+    static thread_local uchar s_opaqueFaces[BLOCKS_PER_CHUNK];
+    CalculateOpaqueFaces(snapshot, firstZ, endZ, s_opaqueFaces);
+    if (snapshot.m_useGreedyMeshing)
+    {
+        lastIndex = AddGreedyOpaqueFaces(builder, snapshot, s_opaqueFaces, lastIndex, firstZ, endZ);
+    }
+    else
     {
-        Block currentBlock = m_blocks[i];
-        if (!currentBlock.GetDefinition()->m_isOpaque)
+        for (int i = firstZ * BLOCKS_PER_LAYER; i < endZ * BLOCKS_PER_LAYER; i++)
         {
-            continue;
-        }
+            uchar faces = s_opaqueFaces[i];
+            if (faces == 0x00)
+            {
+                continue;
+            }
+            Block currentBlock = *snapshot.GetBlock(i);
 
-        WorldPosition coords = GetWorldMinsForBlockIndex(i);
-        Vertex_PCT vertex;
-        vertex.color = RGBA(0x000000FF);
-        BlockDefinition* currentDefinition = BlockDefinition::GetDefinition(currentBlock.m_type);
-        AABB2 topTex = currentDefinition->GetTopIndex();
-        AABB2 sideTex = currentDefinition->GetSideIndex();
-        AABB2 bottomTex = currentDefinition->GetBottomIndex();
-        AABB2 portalTex = TheGame::instance->m_blockSheet->GetTexCoordsForSpriteIndex(0x50);
-        static const float uvStepSize = bottomTex.maxs.x - bottomTex.mins.x;
-
-        Block* belowBlock = GetBelow(i);
-        if (belowBlock && (!BlockDefinition::GetDefinition(belowBlock->m_type)->m_isOpaque || currentBlock.HasBelowPortal() || belowBlock->HasAbovePortal()))
-        {
-            float isPortal = currentBlock.HasBelowPortal() ? 1.0f : 0.0f;
-            AABB2& textureCoords = bottomTex;
-            builder.SetColor(RGBA(belowBlock->GetDampedLightValue(0x33)));
-            builder.SetFloatData0(Vector4(isPortal, 0.0f, 0.0f, 0.0f));
-            builder.SetUV(textureCoords.mins);
-            builder.AddVertex(Vector3(coords.x, coords.y, coords.z));
-            builder.SetUV(Vector2(textureCoords.maxs.x, textureCoords.mins.y));
-            builder.AddVertex(Vector3(coords.x, coords.y + blockSize, coords.z));
-            builder.SetUV(textureCoords.maxs);
-            builder.AddVertex(Vector3(coords.x + blockSize, coords.y + blockSize, coords.z));
-            builder.SetUV(Vector2(textureCoords.mins.x, textureCoords.maxs.y));
-            builder.AddVertex(Vector3(coords.x + blockSize, coords.y, coords.z));
-            builder.AddQuadIndicesClockwise(lastIndex + 3, lastIndex + 2, lastIndex + 0, lastIndex + 1);
-            lastIndex += 4;
-        }
-
-        Block* aboveBlock = GetAbove(i);
-        if (aboveBlock && (!BlockDefinition::GetDefinition(aboveBlock->m_type)->m_isOpaque || currentBlock.HasAbovePortal() || aboveBlock->HasBelowPortal()))
-        {
-            float isPortal = currentBlock.HasAbovePortal() ? 1.0f : 0.0f;
-            AABB2& textureCoords = topTex;
-            builder.SetColor(RGBA(aboveBlock->GetDampedLightValue(0x00)));
-            builder.SetFloatData0(Vector4(isPortal, 0.0f, 0.0f, 0.0f));
-            builder.SetUV(Vector2(textureCoords.mins.x, textureCoords.mins.y));
-            builder.AddVertex(Vector3(coords.x, coords.y, coords.z + blockSize));
-            builder.SetUV(Vector2(textureCoords.maxs.x, textureCoords.mins.y));
-            builder.AddVertex(Vector3(coords.x + blockSize, coords.y, coords.z + blockSize));
-            builder.SetUV(Vector2(textureCoords.maxs.x, textureCoords.maxs.y));
-            builder.AddVertex(Vector3(coords.x + blockSize, coords.y + blockSize, coords.z + blockSize));
-            builder.SetUV(Vector2(textureCoords.mins.x, textureCoords.maxs.y));
-            builder.AddVertex(Vector3(coords.x, coords.y + blockSize, coords.z + blockSize));
-            builder.AddQuadIndicesClockwise(lastIndex + 3, lastIndex + 2, lastIndex + 0, lastIndex + 1);
-            lastIndex += 4;
-        }
-
-        Block* westBlock = GetWest(i);
-        if (westBlock && (!BlockDefinition::GetDefinition(westBlock->m_type)->m_isOpaque || currentBlock.HasWestPortal() || westBlock->HasEastPortal()))
-        {
-            float isPortal = currentBlock.HasWestPortal() ? 1.0f : 0.0f;
-            AABB2& textureCoords = sideTex;
-            builder.SetColor(RGBA(westBlock->GetDampedLightValue(0x22)));
-            builder.SetFloatData0(Vector4(isPortal, 0.0f, 0.0f, 0.0f));
-            builder.SetUV(Vector2(textureCoords.mins.x, textureCoords.mins.y));
-            builder.AddVertex(Vector3(coords.x, coords.y + blockSize, coords.z));
-            builder.SetUV(Vector2(textureCoords.maxs.x, textureCoords.mins.y));
-            builder.AddVertex(Vector3(coords.x, coords.y, coords.z));
-            builder.SetUV(Vector2(textureCoords.maxs.x, textureCoords.maxs.y));
-            builder.AddVertex(Vector3(coords.x, coords.y, coords.z + blockSize));
-            builder.SetUV(Vector2(textureCoords.mins.x, textureCoords.maxs.y));
-            builder.AddVertex(Vector3(coords.x, coords.y + blockSize, coords.z + blockSize));
-            builder.AddQuadIndicesClockwise(lastIndex + 3, lastIndex + 2, lastIndex + 0, lastIndex + 1);
-            lastIndex += 4;
-        }
-
-        Block* eastBlock = GetEast(i);
-        if (eastBlock && (!BlockDefinition::GetDefinition(eastBlock->m_type)->m_isOpaque || currentBlock.HasEastPortal() || eastBlock->HasWestPortal()))
-        {
-            float isPortal = currentBlock.HasEastPortal() ? 1.0f : 0.0f;
-            AABB2& textureCoords = sideTex;
-            builder.SetColor(RGBA(eastBlock->GetDampedLightValue(0x22)));
-            builder.SetFloatData0(Vector4(isPortal, 0.0f, 0.0f, 0.0f));
-            builder.SetUV(Vector2(textureCoords.mins.x, textureCoords.mins.y));
-            builder.AddVertex(Vector3(coords.x + blockSize, coords.y, coords.z));
-            builder.SetUV(Vector2(textureCoords.maxs.x, textureCoords.mins.y));
-            builder.AddVertex(Vector3(coords.x + blockSize, coords.y + blockSize, coords.z));
-            builder.SetUV(Vector2(textureCoords.maxs.x, textureCoords.maxs.y));
-            builder.AddVertex(Vector3(coords.x + blockSize, coords.y + blockSize, coords.z + blockSize));
-            builder.SetUV(Vector2(textureCoords.mins.x, textureCoords.maxs.y));
-            builder.AddVertex(Vector3(coords.x + blockSize, coords.y, coords.z + blockSize));
-            builder.AddQuadIndicesClockwise(lastIndex + 3, lastIndex + 2, lastIndex + 0, lastIndex + 1);
-            lastIndex += 4;
-        }
-
-        Block* southBlock = GetSouth(i);
-        if (southBlock && (!BlockDefinition::GetDefinition(southBlock->m_type)->m_isOpaque || currentBlock.HasSouthPortal() || southBlock->HasNorthPortal()))
-        {
-            float isPortal = currentBlock.HasSouthPortal() ? 1.0f : 0.0f;
-            AABB2& textureCoords = sideTex;
-            builder.SetColor(RGBA(southBlock->GetDampedLightValue(0x11)));
-            builder.SetFloatData0(Vector4(isPortal, 0.0f, 0.0f, 0.0f));
-            builder.SetUV(Vector2(textureCoords.mins.x, textureCoords.mins.y));
-            builder.AddVertex(Vector3(coords.x, coords.y, coords.z));
-            builder.SetUV(Vector2(textureCoords.maxs.x, textureCoords.mins.y));
-            builder.AddVertex(Vector3(coords.x + blockSize, coords.y, coords.z));
-            builder.SetUV(Vector2(textureCoords.maxs.x, textureCoords.maxs.y));
-            builder.AddVertex(Vector3(coords.x + blockSize, coords.y, coords.z + blockSize));
-            builder.SetUV(Vector2(textureCoords.mins.x, textureCoords.maxs.y));
-            builder.AddVertex(Vector3(coords.x, coords.y, coords.z + blockSize));
-            builder.AddQuadIndicesClockwise(lastIndex + 3, lastIndex + 2, lastIndex + 0, lastIndex + 1);
-            lastIndex += 4;
-        }
-
-        Block* northBlock = GetNorth(i);
-        if (northBlock && (!BlockDefinition::GetDefinition(northBlock->m_type)->m_isOpaque || currentBlock.HasNorthPortal() || northBlock->HasSouthPortal()))
-        {
-            float isPortal = currentBlock.HasNorthPortal() ? 1.0f : 0.0f;
-            AABB2& textureCoords = sideTex;
-            builder.SetColor(RGBA(northBlock->GetDampedLightValue(0x11)));
-            builder.SetFloatData0(Vector4(isPortal, 0.0f, 0.0f, 0.0f));
-            builder.SetUV(Vector2(textureCoords.mins.x, textureCoords.mins.y));
-            builder.AddVertex(Vector3(coords.x + blockSize, coords.y + blockSize, coords.z));
-            builder.SetUV(Vector2(textureCoords.maxs.x, textureCoords.mins.y));
-            builder.AddVertex(Vector3(coords.x, coords.y + blockSize, coords.z));
-            builder.SetUV(Vector2(textureCoords.maxs.x, textureCoords.maxs.y));
-            builder.AddVertex(Vector3(coords.x, coords.y + blockSize, coords.z + blockSize));
-            builder.SetUV(Vector2(textureCoords.mins.x, textureCoords.maxs.y));
-            builder.AddVertex(Vector3(coords.x + blockSize, coords.y + blockSize, coords.z + blockSize));
-            builder.AddQuadIndicesClockwise(lastIndex + 3, lastIndex + 2, lastIndex + 0, lastIndex + 1);
-            lastIndex += 4;
+            WorldPosition coords = snapshot.GetWorldMinsForBlockIndex(i);
+            Vertex_PCT vertex;
+            vertex.color = RGBA(0x000000FF);
+            BlockDefinition* currentDefinition = BlockDefinition::GetDefinition(currentBlock.m_type);
+            AABB2 topTex = currentDefinition->GetTopIndex();
+            AABB2 sideTex = currentDefinition->GetSideIndex();
+            AABB2 bottomTex = currentDefinition->GetBottomIndex();
+            static const float uvStepSize = bottomTex.maxs.x - bottomTex.mins.x;
+
+            const Block* belowBlock = snapshot.GetNeighbor(i, BELOW);
+            if ((faces & BIT(BELOW)) != 0)
+            {
+                float isPortal = currentBlock.HasBelowPortal() ? 1.0f : 0.0f;
+                AABB2& textureCoords = bottomTex;
+                builder.SetColor(RGBA(belowBlock->GetDampedLightValue(0x33)));
+                builder.SetFloatData0(GetFaceFloatData(isPortal, belowBlock, 0x33));
+                builder.SetUV(textureCoords.mins);
+                AddFaceVertex(builder, neighborhood, i, BELOW, 0x33, isPortal, coords, Vector3(coords.x, coords.y, coords.z));
+                builder.SetUV(Vector2(textureCoords.maxs.x, textureCoords.mins.y));
+                AddFaceVertex(builder, neighborhood, i, BELOW, 0x33, isPortal, coords, Vector3(coords.x, coords.y + blockSize, coords.z));
+                builder.SetUV(textureCoords.maxs);
+                AddFaceVertex(builder, neighborhood, i, BELOW, 0x33, isPortal, coords, Vector3(coords.x + blockSize, coords.y + blockSize, coords.z));
+                builder.SetUV(Vector2(textureCoords.mins.x, textureCoords.maxs.y));
+                AddFaceVertex(builder, neighborhood, i, BELOW, 0x33, isPortal, coords, Vector3(coords.x + blockSize, coords.y, coords.z));
+                builder.AddQuadIndicesClockwise(lastIndex + 3, lastIndex + 2, lastIndex + 0, lastIndex + 1);
+                lastIndex += 4;
+            }
+
+            const Block* aboveBlock = snapshot.GetNeighbor(i, ABOVE);
+            if ((faces & BIT(ABOVE)) != 0)
+            {
+                float isPortal = currentBlock.HasAbovePortal() ? 1.0f : 0.0f;
+                AABB2& textureCoords = topTex;
+                builder.SetColor(RGBA(aboveBlock->GetDampedLightValue(0x00)));
+                builder.SetFloatData0(GetFaceFloatData(isPortal, aboveBlock, 0x00));
+                builder.SetUV(Vector2(textureCoords.mins.x, textureCoords.mins.y));
+                AddFaceVertex(builder, neighborhood, i, ABOVE, 0x00, isPortal, coords, Vector3(coords.x, coords.y, coords.z + blockSize));
+                builder.SetUV(Vector2(textureCoords.maxs.x, textureCoords.mins.y));
+                AddFaceVertex(builder, neighborhood, i, ABOVE, 0x00, isPortal, coords, Vector3(coords.x + blockSize, coords.y, coords.z + blockSize));
+                builder.SetUV(Vector2(textureCoords.maxs.x, textureCoords.maxs.y));
+                AddFaceVertex(builder, neighborhood, i, ABOVE, 0x00, isPortal, coords, Vector3(coords.x + blockSize, coords.y + blockSize, coords.z + blockSize));
+                builder.SetUV(Vector2(textureCoords.mins.x, textureCoords.maxs.y));
+                AddFaceVertex(builder, neighborhood, i, ABOVE, 0x00, isPortal, coords, Vector3(coords.x, coords.y + blockSize, coords.z + blockSize));
+                builder.AddQuadIndicesClockwise(lastIndex + 3, lastIndex + 2, lastIndex + 0, lastIndex + 1);
+                lastIndex += 4;
+            }
+
+            const Block* westBlock = snapshot.GetNeighbor(i, WEST);
+            if ((faces & BIT(WEST)) != 0)
+            {
+                float isPortal = currentBlock.HasWestPortal() ? 1.0f : 0.0f;
+                AABB2& textureCoords = sideTex;
+                builder.SetColor(RGBA(westBlock->GetDampedLightValue(0x22)));
+                builder.SetFloatData0(GetFaceFloatData(isPortal, westBlock, 0x22));
+                builder.SetUV(Vector2(textureCoords.mins.x, textureCoords.mins.y));
+                AddFaceVertex(builder, neighborhood, i, WEST, 0x22, isPortal, coords, Vector3(coords.x, coords.y + blockSize, coords.z));
+                builder.SetUV(Vector2(textureCoords.maxs.x, textureCoords.mins.y));
+                AddFaceVertex(builder, neighborhood, i, WEST, 0x22, isPortal, coords, Vector3(coords.x, coords.y, coords.z));
+                builder.SetUV(Vector2(textureCoords.maxs.x, textureCoords.maxs.y));
+                AddFaceVertex(builder, neighborhood, i, WEST, 0x22, isPortal, coords, Vector3(coords.x, coords.y, coords.z + blockSize));
+                builder.SetUV(Vector2(textureCoords.mins.x, textureCoords.maxs.y));
+                AddFaceVertex(builder, neighborhood, i, WEST, 0x22, isPortal, coords, Vector3(coords.x, coords.y + blockSize, coords.z + blockSize));
+                builder.AddQuadIndicesClockwise(lastIndex + 3, lastIndex + 2, lastIndex + 0, lastIndex + 1);
+                lastIndex += 4;
+            }
+
+            const Block* eastBlock = snapshot.GetNeighbor(i, EAST);
+            if ((faces & BIT(EAST)) != 0)
+            {
+                float isPortal = currentBlock.HasEastPortal() ? 1.0f : 0.0f;
+                AABB2& textureCoords = sideTex;
+                builder.SetColor(RGBA(eastBlock->GetDampedLightValue(0x22)));
+                builder.SetFloatData0(GetFaceFloatData(isPortal, eastBlock, 0x22));
+                builder.SetUV(Vector2(textureCoords.mins.x, textureCoords.mins.y));
+                AddFaceVertex(builder, neighborhood, i, EAST, 0x22, isPortal, coords, Vector3(coords.x + blockSize, coords.y, coords.z));
+                builder.SetUV(Vector2(textureCoords.maxs.x, textureCoords.mins.y));
+                AddFaceVertex(builder, neighborhood, i, EAST, 0x22, isPortal, coords, Vector3(coords.x + blockSize, coords.y + blockSize, coords.z));
+                builder.SetUV(Vector2(textureCoords.maxs.x, textureCoords.maxs.y));
+                AddFaceVertex(builder, neighborhood, i, EAST, 0x22, isPortal, coords, Vector3(coords.x + blockSize, coords.y + blockSize, coords.z + blockSize));
+                builder.SetUV(Vector2(textureCoords.mins.x, textureCoords.maxs.y));
+                AddFaceVertex(builder, neighborhood, i, EAST, 0x22, isPortal, coords, Vector3(coords.x + blockSize, coords.y, coords.z + blockSize));
+                builder.AddQuadIndicesClockwise(lastIndex + 3, lastIndex + 2, lastIndex + 0, lastIndex + 1);
+                lastIndex += 4;
+            }
+
+            const Block* southBlock = snapshot.GetNeighbor(i, SOUTH);
+            if ((faces & BIT(SOUTH)) != 0)
+            {
+                float isPortal = currentBlock.HasSouthPortal() ? 1.0f : 0.0f;
+                AABB2& textureCoords = sideTex;
+                builder.SetColor(RGBA(southBlock->GetDampedLightValue(0x11)));
+                builder.SetFloatData0(GetFaceFloatData(isPortal, southBlock, 0x11));
+                builder.SetUV(Vector2(textureCoords.mins.x, textureCoords.mins.y));
+                AddFaceVertex(builder, neighborhood, i, SOUTH, 0x11, isPortal, coords, Vector3(coords.x, coords.y, coords.z));
+                builder.SetUV(Vector2(textureCoords.maxs.x, textureCoords.mins.y));
+                AddFaceVertex(builder, neighborhood, i, SOUTH, 0x11, isPortal, coords, Vector3(coords.x + blockSize, coords.y, coords.z));
+                builder.SetUV(Vector2(textureCoords.maxs.x, textureCoords.maxs.y));
+                AddFaceVertex(builder, neighborhood, i, SOUTH, 0x11, isPortal, coords, Vector3(coords.x + blockSize, coords.y, coords.z + blockSize));
+                builder.SetUV(Vector2(textureCoords.mins.x, textureCoords.maxs.y));
+                AddFaceVertex(builder, neighborhood, i, SOUTH, 0x11, isPortal, coords, Vector3(coords.x, coords.y, coords.z + blockSize));
+                builder.AddQuadIndicesClockwise(lastIndex + 3, lastIndex + 2, lastIndex + 0, lastIndex + 1);
+                lastIndex += 4;
+            }
+
+            const Block* northBlock = snapshot.GetNeighbor(i, NORTH);
+            if ((faces & BIT(NORTH)) != 0)
+            {
+                float isPortal = currentBlock.HasNorthPortal() ? 1.0f : 0.0f;
+                AABB2& textureCoords = sideTex;
+                builder.SetColor(RGBA(northBlock->GetDampedLightValue(0x11)));
+                builder.SetFloatData0(GetFaceFloatData(isPortal, northBlock, 0x11));
+                builder.SetUV(Vector2(textureCoords.mins.x, textureCoords.mins.y));
+                AddFaceVertex(builder, neighborhood, i, NORTH, 0x11, isPortal, coords, Vector3(coords.x + blockSize, coords.y + blockSize, coords.z));
+                builder.SetUV(Vector2(textureCoords.maxs.x, textureCoords.mins.y));
+                AddFaceVertex(builder, neighborhood, i, NORTH, 0x11, isPortal, coords, Vector3(coords.x, coords.y + blockSize, coords.z));
+                builder.SetUV(Vector2(textureCoords.maxs.x, textureCoords.maxs.y));
+                AddFaceVertex(builder, neighborhood, i, NORTH, 0x11, isPortal, coords, Vector3(coords.x, coords.y + blockSize, coords.z + blockSize));
+                builder.SetUV(Vector2(textureCoords.mins.x, textureCoords.maxs.y));
+                AddFaceVertex(builder, neighborhood, i, NORTH, 0x11, isPortal, coords, Vector3(coords.x + blockSize, coords.y + blockSize, coords.z + blockSize));
+                builder.AddQuadIndicesClockwise(lastIndex + 3, lastIndex + 2, lastIndex + 0, lastIndex + 1);
+                lastIndex += 4;
+            }
         }
     }
 
     //Transparent drawing
-    for (int i = 0; i < BLOCKS_PER_CHUNK; i++)
+    lastIndex = StartTranslucentFaces(builder, lastIndex);
+    for (int i = firstZ * BLOCKS_PER_LAYER; i < endZ * BLOCKS_PER_LAYER; i++)
     {
-        Block currentBlock = m_blocks[i];
+        Block currentBlock = *snapshot.GetBlock(i);
         if (!currentBlock.IsPortal(NUM_DIRECTIONS) && (currentBlock.GetDefinition()->m_isOpaque || currentBlock.m_type == BlockType::AIR))
         {
             continue;
         }
 
-        WorldPosition coords = GetWorldMinsForBlockIndex(i);
+        WorldPosition coords = snapshot.GetWorldMinsForBlockIndex(i);
         Vertex_PCT vertex;
         vertex.color = RGBA(0x000000FF);
         BlockDefinition* currentDefinition = currentBlock.GetDefinition();
@@ -401,152 +1410,138 @@ void Chunk::GenerateVertexArray()
         AABB2 sideTex = currentDefinition->GetSideIndex();
         AABB2 bottomTex = currentDefinition->GetBottomIndex();
 
-        BlockInfo info = GetBlockInfoFromLocalCoords(GetLocalCoordsFromBlockIndex(i));
-
-        BlockInfo belowInfo = info.GetBelow();
-        if (belowInfo.IsValid())
+        const Block* belowBlock = snapshot.GetNeighborThroughPortals(i, BELOW);
+        if (belowBlock)
         {
-            Block* belowBlock = belowInfo.GetBlock();
             BlockDefinition* belowType = belowBlock->GetDefinition();
             if (belowBlock && ((!belowType->m_isOpaque && belowBlock->m_type != currentBlock.m_type) || currentBlock.HasBelowPortal()))
             {
                 float isPortal = currentBlock.HasBelowPortal() ? 1.0f : 0.0f;
-                builder.SetFloatData0(Vector4(isPortal, 0.0f, 0.0f, 0.0f));
+                builder.SetFloatData0(GetFaceFloatData(isPortal, belowBlock, 0x33));
                 builder.SetColor(RGBA(belowBlock->GetDampedLightValue(0x33)));
                 builder.SetUV(bottomTex.mins);
-                builder.AddVertex(Vector3(coords.x, coords.y, coords.z));
+                AddFaceVertex(builder, neighborhood, i, BELOW, 0x33, isPortal, coords, Vector3(coords.x, coords.y, coords.z));
                 builder.SetUV(Vector2(bottomTex.maxs.x, bottomTex.mins.y));
-                builder.AddVertex(Vector3(coords.x, coords.y + blockSize, coords.z));
+                AddFaceVertex(builder, neighborhood, i, BELOW, 0x33, isPortal, coords, Vector3(coords.x, coords.y + blockSize, coords.z));
                 builder.SetUV(bottomTex.maxs);
-                builder.AddVertex(Vector3(coords.x + blockSize, coords.y + blockSize, coords.z));
+                AddFaceVertex(builder, neighborhood, i, BELOW, 0x33, isPortal, coords, Vector3(coords.x + blockSize, coords.y + blockSize, coords.z));
                 builder.SetUV(Vector2(bottomTex.mins.x, bottomTex.maxs.y));
-                builder.AddVertex(Vector3(coords.x + blockSize, coords.y, coords.z));
+                AddFaceVertex(builder, neighborhood, i, BELOW, 0x33, isPortal, coords, Vector3(coords.x + blockSize, coords.y, coords.z));
                 builder.AddQuadIndicesClockwise(lastIndex + 3, lastIndex + 2, lastIndex + 0, lastIndex + 1);
                 lastIndex += 4;
             }
         }
 
-        BlockInfo aboveInfo = info.GetAbove();
-        if (aboveInfo.IsValid())
+        const Block* aboveBlock = snapshot.GetNeighborThroughPortals(i, ABOVE);
+        if (aboveBlock)
         {
-            Block* aboveBlock = aboveInfo.GetBlock();
             BlockDefinition* aboveType = aboveBlock->GetDefinition();
             if (aboveBlock && ((!aboveType->m_isOpaque && aboveBlock->m_type != currentBlock.m_type) || currentBlock.HasAbovePortal()))
             {
                 float isPortal = currentBlock.HasAbovePortal() ? 1.0f : 0.0f;
-                builder.SetFloatData0(Vector4(isPortal, 0.0f, 0.0f, 0.0f));
+                builder.SetFloatData0(GetFaceFloatData(isPortal, aboveBlock, 0x00));
                 builder.SetColor(RGBA(aboveBlock->GetDampedLightValue(0x00)));
                 builder.SetUV(Vector2(topTex.mins.x, topTex.mins.y));
-                builder.AddVertex(Vector3(coords.x, coords.y, coords.z + blockSize));
+                AddFaceVertex(builder, neighborhood, i, ABOVE, 0x00, isPortal, coords, Vector3(coords.x, coords.y, coords.z + blockSize));
                 builder.SetUV(Vector2(topTex.maxs.x, topTex.mins.y));
-                builder.AddVertex(Vector3(coords.x + blockSize, coords.y, coords.z + blockSize));
+                AddFaceVertex(builder, neighborhood, i, ABOVE, 0x00, isPortal, coords, Vector3(coords.x + blockSize, coords.y, coords.z + blockSize));
                 builder.SetUV(Vector2(topTex.maxs.x, topTex.maxs.y));
-                builder.AddVertex(Vector3(coords.x + blockSize, coords.y + blockSize, coords.z + blockSize));
+                AddFaceVertex(builder, neighborhood, i, ABOVE, 0x00, isPortal, coords, Vector3(coords.x + blockSize, coords.y + blockSize, coords.z + blockSize));
                 builder.SetUV(Vector2(topTex.mins.x, topTex.maxs.y));
-                builder.AddVertex(Vector3(coords.x, coords.y + blockSize, coords.z + blockSize));
+                AddFaceVertex(builder, neighborhood, i, ABOVE, 0x00, isPortal, coords, Vector3(coords.x, coords.y + blockSize, coords.z + blockSize));
                 builder.AddQuadIndicesClockwise(lastIndex + 3, lastIndex + 2, lastIndex + 0, lastIndex + 1);
                 lastIndex += 4;
             }
         }
 
-        BlockInfo westInfo = info.GetWest();
-        if (westInfo.IsValid())
+        const Block* westBlock = snapshot.GetNeighborThroughPortals(i, WEST);
+        if (westBlock)
         {
-            Block* westBlock = westInfo.GetBlock();
             BlockDefinition* westType = westBlock->GetDefinition();
             if (westBlock && ((!westType->m_isOpaque && westBlock->m_type != currentBlock.m_type) || currentBlock.HasWestPortal()))
             {
                 float isPortal = currentBlock.HasWestPortal() ? 1.0f : 0.0f;
-                builder.SetFloatData0(Vector4(isPortal, 0.0f, 0.0f, 0.0f));
+                builder.SetFloatData0(GetFaceFloatData(isPortal, westBlock, 0x22));
                 builder.SetColor(RGBA(westBlock->GetDampedLightValue(0x22)));
                 builder.SetUV(Vector2(sideTex.mins.x, sideTex.mins.y));
-                builder.AddVertex(Vector3(coords.x, coords.y + blockSize, coords.z));
+                AddFaceVertex(builder, neighborhood, i, WEST, 0x22, isPortal, coords, Vector3(coords.x, coords.y + blockSize, coords.z));
                 builder.SetUV(Vector2(sideTex.maxs.x, sideTex.mins.y));
-                builder.AddVertex(Vector3(coords.x, coords.y, coords.z));
+                AddFaceVertex(builder, neighborhood, i, WEST, 0x22, isPortal, coords, Vector3(coords.x, coords.y, coords.z));
                 builder.SetUV(Vector2(sideTex.maxs.x, sideTex.maxs.y));
-                builder.AddVertex(Vector3(coords.x, coords.y, coords.z + blockSize));
+                AddFaceVertex(builder, neighborhood, i, WEST, 0x22, isPortal, coords, Vector3(coords.x, coords.y, coords.z + blockSize));
                 builder.SetUV(Vector2(sideTex.mins.x, sideTex.maxs.y));
-                builder.AddVertex(Vector3(coords.x, coords.y + blockSize, coords.z + blockSize));
+                AddFaceVertex(builder, neighborhood, i, WEST, 0x22, isPortal, coords, Vector3(coords.x, coords.y + blockSize, coords.z + blockSize));
                 builder.AddQuadIndicesClockwise(lastIndex + 3, lastIndex + 2, lastIndex + 0, lastIndex + 1);
                 lastIndex += 4;
             }
         }
 
-        BlockInfo eastInfo = info.GetEast();
-        if (eastInfo.IsValid())
+        const Block* eastBlock = snapshot.GetNeighborThroughPortals(i, EAST);
+        if (eastBlock)
         {
-            Block* eastBlock = eastInfo.GetBlock();
             BlockDefinition* eastType = eastBlock->GetDefinition();
             if (eastBlock && ((!eastType->m_isOpaque && eastBlock->m_type != currentBlock.m_type) || currentBlock.HasEastPortal()))
             {
                 float isPortal = currentBlock.HasEastPortal() ? 1.0f : 0.0f;
-                builder.SetFloatData0(Vector4(isPortal, 0.0f, 0.0f, 0.0f));
+                builder.SetFloatData0(GetFaceFloatData(isPortal, eastBlock, 0x22));
                 builder.SetColor(RGBA(eastBlock->GetDampedLightValue(0x22)));
                 builder.SetUV(Vector2(sideTex.mins.x, sideTex.mins.y));
-                builder.AddVertex(Vector3(coords.x + blockSize, coords.y, coords.z));
+                AddFaceVertex(builder, neighborhood, i, EAST, 0x22, isPortal, coords, Vector3(coords.x + blockSize, coords.y, coords.z));
                 builder.SetUV(Vector2(sideTex.maxs.x, sideTex.mins.y));
-                builder.AddVertex(Vector3(coords.x + blockSize, coords.y + blockSize, coords.z));
+                AddFaceVertex(builder, neighborhood, i, EAST, 0x22, isPortal, coords, Vector3(coords.x + blockSize, coords.y + blockSize, coords.z));
                 builder.SetUV(Vector2(sideTex.maxs.x, sideTex.maxs.y));
-                builder.AddVertex(Vector3(coords.x + blockSize, coords.y + blockSize, coords.z + blockSize));
+                AddFaceVertex(builder, neighborhood, i, EAST, 0x22, isPortal, coords, Vector3(coords.x + blockSize, coords.y + blockSize, coords.z + blockSize));
                 builder.SetUV(Vector2(sideTex.mins.x, sideTex.maxs.y));
-                builder.AddVertex(Vector3(coords.x + blockSize, coords.y, coords.z + blockSize));
+                AddFaceVertex(builder, neighborhood, i, EAST, 0x22, isPortal, coords, Vector3(coords.x + blockSize, coords.y, coords.z + blockSize));
                 builder.AddQuadIndicesClockwise(lastIndex + 3, lastIndex + 2, lastIndex + 0, lastIndex + 1);
                 lastIndex += 4;
             }
         }
 
-        BlockInfo southInfo = info.GetSouth();
-        if (southInfo.IsValid())
+        const Block* southBlock = snapshot.GetNeighborThroughPortals(i, SOUTH);
+        if (southBlock)
         {
-            Block* southBlock = southInfo.GetBlock();
             BlockDefinition* southType = southBlock->GetDefinition();
             if (southBlock && ((!southType->m_isOpaque && southBlock->m_type != currentBlock.m_type) || currentBlock.HasSouthPortal()))
             {
                 float isPortal = currentBlock.HasSouthPortal() ? 1.0f : 0.0f;
-                builder.SetFloatData0(Vector4(isPortal, 0.0f, 0.0f, 0.0f));
+                builder.SetFloatData0(GetFaceFloatData(isPortal, southBlock, 0x11));
                 builder.SetColor(RGBA(southBlock->GetDampedLightValue(0x11)));
                 builder.SetUV(Vector2(sideTex.mins.x, sideTex.mins.y));
-                builder.AddVertex(Vector3(coords.x, coords.y, coords.z));
+                AddFaceVertex(builder, neighborhood, i, SOUTH, 0x11, isPortal, coords, Vector3(coords.x, coords.y, coords.z));
                 builder.SetUV(Vector2(sideTex.maxs.x, sideTex.mins.y));
-                builder.AddVertex(Vector3(coords.x + blockSize, coords.y, coords.z));
+                AddFaceVertex(builder, neighborhood, i, SOUTH, 0x11, isPortal, coords, Vector3(coords.x + blockSize, coords.y, coords.z));
                 builder.SetUV(Vector2(sideTex.maxs.x, sideTex.maxs.y));
-                builder.AddVertex(Vector3(coords.x + blockSize, coords.y, coords.z + blockSize));
+                AddFaceVertex(builder, neighborhood, i, SOUTH, 0x11, isPortal, coords, Vector3(coords.x + blockSize, coords.y, coords.z + blockSize));
                 builder.SetUV(Vector2(sideTex.mins.x, sideTex.maxs.y));
-                builder.AddVertex(Vector3(coords.x, coords.y, coords.z + blockSize));
+                AddFaceVertex(builder, neighborhood, i, SOUTH, 0x11, isPortal, coords, Vector3(coords.x, coords.y, coords.z + blockSize));
                 builder.AddQuadIndicesClockwise(lastIndex + 3, lastIndex + 2, lastIndex + 0, lastIndex + 1);
                 lastIndex += 4;
             }
         }
 
-        BlockInfo northInfo = info.GetNorth();
-        if (northInfo.IsValid())
+        const Block* northBlock = snapshot.GetNeighborThroughPortals(i, NORTH);
+        if (northBlock)
         {
-            Block* northBlock = northInfo.GetBlock();
             BlockDefinition* northType = northBlock->GetDefinition();
             if (northBlock && ((!northType->m_isOpaque && northBlock->m_type != currentBlock.m_type) || currentBlock.HasNorthPortal()))
             {
                 float isPortal = currentBlock.HasNorthPortal() ? 1.0f : 0.0f;
-                builder.SetFloatData0(Vector4(isPortal, 0.0f, 0.0f, 0.0f));
+                builder.SetFloatData0(GetFaceFloatData(isPortal, northBlock, 0x11));
                 builder.SetColor(RGBA(northBlock->GetDampedLightValue(0x11)));
                 builder.SetUV(Vector2(sideTex.mins.x, sideTex.mins.y));
-                builder.AddVertex(Vector3(coords.x + blockSize, coords.y + blockSize, coords.z));
+                AddFaceVertex(builder, neighborhood, i, NORTH, 0x11, isPortal, coords, Vector3(coords.x + blockSize, coords.y + blockSize, coords.z));
                 builder.SetUV(Vector2(sideTex.maxs.x, sideTex.mins.y));
-                builder.AddVertex(Vector3(coords.x, coords.y + blockSize, coords.z));
+                AddFaceVertex(builder, neighborhood, i, NORTH, 0x11, isPortal, coords, Vector3(coords.x, coords.y + blockSize, coords.z));
                 builder.SetUV(Vector2(sideTex.maxs.x, sideTex.maxs.y));
-                builder.AddVertex(Vector3(coords.x, coords.y + blockSize, coords.z + blockSize));
+                AddFaceVertex(builder, neighborhood, i, NORTH, 0x11, isPortal, coords, Vector3(coords.x, coords.y + blockSize, coords.z + blockSize));
                 builder.SetUV(Vector2(sideTex.mins.x, sideTex.maxs.y));
-                builder.AddVertex(Vector3(coords.x + blockSize, coords.y + blockSize, coords.z + blockSize));
+                AddFaceVertex(builder, neighborhood, i, NORTH, 0x11, isPortal, coords, Vector3(coords.x + blockSize, coords.y + blockSize, coords.z + blockSize));
                 builder.AddQuadIndicesClockwise(lastIndex + 3, lastIndex + 2, lastIndex + 0, lastIndex + 1);
                 lastIndex += 4;
             }
         }
     }
-    builder.End();
-    Mesh* mesh = new Mesh();
-    m_meshRenderer = new MeshRenderer(mesh, TheGame::instance->m_blockMaterial);
-    builder.CopyToMesh(m_meshRenderer->m_mesh, &Vertex_PCTD::Copy, sizeof(Vertex_PCTD), &Vertex_PCTD::BindMeshToVAO);
-    m_isDirty = false;
-    EndTiming(g_vaBuildingProfiling);
 }
 
 //-----------------------------------------------------------------------------------
@@ -590,39 +1585,55 @@ void Chunk::LoadChunkFromData(std::vector<unsigned char>& data)
 //-----------------------------------------------------------------------------------
 void Chunk::AttemptCleanUpRenderData()
 {
-    if (m_meshRenderer)
+    for (MeshSection& meshSection : m_meshSections)
     {
-        delete m_meshRenderer->m_mesh;
-        delete m_meshRenderer;
-        m_meshRenderer = nullptr;
+        if (meshSection.m_meshRenderer)
+        {
+            delete meshSection.m_meshRenderer->m_mesh;
+            delete meshSection.m_meshRenderer;
+            meshSection.m_meshRenderer = nullptr;
+        }
+        delete meshSection.m_translucentFaces;
+        meshSection.m_translucentFaces = nullptr;
     }
 }
 
 //-----------------------------------------------------------------------------------
-void Chunk::SetBlockDirtyAndAddToDirtyList(LocalIndex blockToDirtyIndex)
+//Picks up any feature edits neighboring chunks left for us since we were generated or saved.
+int Chunk::ApplyDeferredBlockWrites(std::vector<LocalIndex>* out_changedIndices)
 {
-    Block* blockToDirty = GetBlock(blockToDirtyIndex);
-    blockToDirty->SetDirty(true);
-    m_world->m_dirtyBlocks.emplace_back(BlockInfo(this, blockToDirtyIndex));
+    DeferredBlockWriteList pendingWrites;
+    if (!m_world->m_generator->GetDeferredBlockWrites().Take(m_chunkPosition, pendingWrites))
+    {
+        return 0;
+    }
+    return DeferredBlockWriteQueue::ApplyWrites(m_blocks, pendingWrites, out_changedIndices);
 }
 
 //-----------------------------------------------------------------------------------
-void Chunk::DirtyAndAddToDirtyList()
+void Chunk::DirtyAndAddToDirtyList(uchar meshSections)
 {
-    //Don't do anything if we're already in the list.
+    m_dirtyMeshSections |= s_useMeshSections ? meshSections : ALL_MESH_SECTIONS;
+    //Don't do anything else if we're already in the list.
     if (m_isDirty == true)
     {
         return;
     }
     m_isDirty = true;
-    m_world->m_dirtyChunks.emplace(this, m_world->DistanceSquaredFromPlayerToChunk(this->m_chunkPosition));
+    m_timeDirtied = GetCurrentTimeSeconds();
+    m_world->m_dirtyChunks.Push(this, m_chunkPosition);
 }
 
 //-----------------------------------------------------------------------------------
-void Chunk::SetHighPriorityChunkDirtyAndAddToDirtyList()
+void Chunk::SetHighPriorityChunkDirtyAndAddToDirtyList(uchar meshSections)
 {
+    m_dirtyMeshSections |= s_useMeshSections ? meshSections : ALL_MESH_SECTIONS;
+    if (!m_isDirty)
+    {
+        m_timeDirtied = GetCurrentTimeSeconds();
+    }
     m_isDirty = true;
-    m_world->m_dirtyChunks.emplace(this, 0.0f);
+    m_world->m_dirtyChunks.Push(this, m_chunkPosition, true);
 }
 
 //-----------------------------------------------------------------------------------
@@ -664,68 +1675,628 @@ void Chunk::SetEdgeBits()
 }
 
 //-----------------------------------------------------------------------------------
-void Chunk::FlagEdgesAsDirtyLighting(Direction dir)
+//The first block of this chunk's face on the given side, and the step between blocks along one layer of it.
+static bool GetEdgeFace(Direction dir, LocalIndex& out_firstIndex, int& out_stepAlongEdge)
 {
-    //Directions are relative to the top layer of the chunk, viewed from above.
-    const int TOP_LEFT_INDEX = BLOCKS_PER_CHUNK - BLOCKS_WIDE_X;
-    const int TOP_RIGHT_INDEX = BLOCKS_PER_CHUNK - 1;
-    const int BOTTOM_RIGHT_INDEX_MINUS_1 = BLOCKS_PER_CHUNK - BLOCKS_PER_LAYER + (BLOCKS_WIDE_X - 2);
-    const int TOP_RIGHT_INDEX_MINUS_1 = BLOCKS_PER_CHUNK - 2;
+    out_firstIndex = 0;
+    out_stepAlongEdge = 1;
     switch (dir)
     {
     case NORTH:
-        //North Side
-        for (int index = BLOCKS_PER_LAYER - BLOCKS_WIDE_X + 1; index < TOP_RIGHT_INDEX_MINUS_1; index += BLOCKS_PER_LAYER)
+        out_firstIndex = Chunk::LOCAL_Y_MASK;
+        return true;
+    case SOUTH:
+        return true;
+    case EAST:
+        out_firstIndex = Chunk::LOCAL_X_MASK;
+        out_stepAlongEdge = Chunk::BLOCKS_WIDE_X;
+        return true;
+    case WEST:
+        out_stepAlongEdge = Chunk::BLOCKS_WIDE_X;
+        return true;
+    default:
+        return false;
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//The original hookup seeding: every block on our edge that has any light to give, whether or not the
+//neighbor needs it. Kept to benchmark QueueSeamLightSpread against. Returns the number of blocks queued.
+int Chunk::QueueEdgeLightSpread(Direction dir, LightingEngine& lightingEngine)
+{
+    //Each face is walked as BLOCKS_TALL_Z rows of 16 blocks, one row per layer.
+    LocalIndex firstIndex = 0;
+    int stepAlongEdge = 1;
+    if (!GetEdgeFace(dir, firstIndex, stepAlongEdge))
+    {
+        return 0;
+    }
+    int numQueuedBlocks = 0;
+    for (int layerIndex = firstIndex; layerIndex < BLOCKS_PER_CHUNK; layerIndex += BLOCKS_PER_LAYER)
+    {
+        for (int i = 0; i < BLOCKS_WIDE_X; ++i)
         {
-            const int BLOCKS_PER_ITERATION = BLOCKS_WIDE_X - 2;
-            for (int j = 0; j < BLOCKS_PER_ITERATION; j++)
+            LocalIndex index = layerIndex + (i * stepAlongEdge);
+            if (LightingEngine::CanSpreadLight(GetBlock(index)))
             {
-                Block* block = GetBlock(index + j);
-                if (block->IsSky() || BlockDefinition::GetDefinition(block->m_type)->IsIlluminated())
-                {
-                    SetBlockDirtyAndAddToDirtyList(index + j);
-                }
+                lightingEngine.QueueSpread(BlockInfo(this, index));
+                ++numQueuedBlocks;
             }
         }
+    }
+    return numQueuedBlocks;
+}
+
+//-----------------------------------------------------------------------------------
+//A neighbor just hooked up on this side. Both chunks are already lit on their own, so the only light still to
+//move is across the seam: compare the two faces block by block and queue only the blocks that would brighten
+//the block facing them, on either side. Returns the number of blocks queued.
+int Chunk::QueueSeamLightSpread(Direction dir, LightingEngine& lightingEngine)
+{
+    LocalIndex firstIndex = 0;
+    int stepAlongEdge = 1;
+    if (!GetEdgeFace(dir, firstIndex, stepAlongEdge))
+    {
+        return 0;
+    }
+    Chunk* neighborChunk = nullptr;
+    int neighborOffset = 0;
+    switch (dir)
+    {
+    case NORTH:
+        neighborChunk = m_northChunk;
+        neighborOffset = -LOCAL_Y_MASK;
         break;
     case SOUTH:
-        //South Side
-        for (int index = 1; index < BOTTOM_RIGHT_INDEX_MINUS_1; index += BLOCKS_PER_LAYER)
+        neighborChunk = m_southChunk;
+        neighborOffset = LOCAL_Y_MASK;
+        break;
+    case EAST:
+        neighborChunk = m_eastChunk;
+        neighborOffset = -LOCAL_X_MASK;
+        break;
+    case WEST:
+        neighborChunk = m_westChunk;
+        neighborOffset = LOCAL_X_MASK;
+        break;
+    default:
+        break;
+    }
+    if (!neighborChunk)
+    {
+        return 0;
+    }
+    int numQueuedBlocks = 0;
+    for (int layerIndex = firstIndex; layerIndex < BLOCKS_PER_CHUNK; layerIndex += BLOCKS_PER_LAYER)
+    {
+        for (int i = 0; i < BLOCKS_WIDE_X; ++i)
         {
-            const int BLOCKS_PER_ITERATION = BLOCKS_WIDE_X - 2;
-            for (int j = 0; j < BLOCKS_PER_ITERATION; j++)
+            LocalIndex index = layerIndex + (i * stepAlongEdge);
+            LocalIndex neighborIndex = index + neighborOffset;
+            Block* block = &m_blocks[index];
+            Block* neighborBlock = neighborChunk->GetBlock(neighborIndex);
+            BlockDefinition* definition = block->GetDefinition();
+            BlockDefinition* neighborDefinition = neighborBlock->GetDefinition();
+            //Light never enters an opaque block, so a seam between two of them has nothing to carry.
+            if (definition->m_isOpaque && neighborDefinition->m_isOpaque)
             {
-                Block* block = GetBlock(index + j);
-                if (block->IsSky() || BlockDefinition::GetDefinition(block->m_type)->IsIlluminated())
-                {
-                    SetBlockDirtyAndAddToDirtyList(index + j);
-                }
+                continue;
+            }
+            PackedLight light = block->GetPackedLight();
+            PackedLight skyLight = block->GetPackedSkyLight();
+            PackedLight neighborLight = neighborBlock->GetPackedLight();
+            PackedLight neighborSkyLight = neighborBlock->GetPackedSkyLight();
+            if (!neighborDefinition->m_isOpaque
+                && (IsPackedLightBrighter(SubtractPackedLight(light, neighborDefinition->m_packedAttenuation), neighborLight)
+                || IsPackedLightBrighter(SubtractPackedLight(skyLight, neighborDefinition->m_packedAttenuation), neighborSkyLight)))
+            {
+                lightingEngine.QueueSpread(BlockInfo(this, index));
+                ++numQueuedBlocks;
+            }
+            if (!definition->m_isOpaque
+                && (IsPackedLightBrighter(SubtractPackedLight(neighborLight, definition->m_packedAttenuation), light)
+                || IsPackedLightBrighter(SubtractPackedLight(neighborSkyLight, definition->m_packedAttenuation), skyLight)))
+            {
+                lightingEngine.QueueSpread(BlockInfo(neighborChunk, neighborIndex));
+                ++numQueuedBlocks;
             }
         }
-        break;
-    case EAST:
-        //East Side
-        for (int index = BLOCKS_WIDE_X - 1; index < TOP_RIGHT_INDEX; index += BLOCKS_WIDE_Y)
+    }
+    return numQueuedBlocks;
+}
+
+//-----------------------------------------------------------------------------------
+static void DirtyAllActiveChunks()
+{
+    for (World* world : TheGame::instance->m_worlds)
+    {
+        const std::map<ChunkCoords, Chunk*>& activeChunks = world->GetActiveChunks();
+        for (auto chunkPair : activeChunks)
+        {
+            chunkPair.second->DirtyAndAddToDirtyList();
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------------
+CONSOLE_COMMAND(smoothlighting)
+{
+    if (!args.HasArgs(1))
+    {
+        Console::instance->PrintLine(Stringf("smoothlighting <0|1> (currently %i)", Chunk::s_useSmoothLighting ? 1 : 0), RGBA::GRAY);
+        return;
+    }
+    Chunk::s_useSmoothLighting = args.GetIntArgument(0) != 0;
+    DirtyAllActiveChunks();
+}
+
+//-----------------------------------------------------------------------------------
+CONSOLE_COMMAND(greedymeshing)
+{
+    if (!args.HasArgs(1))
+    {
+        Console::instance->PrintLine(Stringf("greedymeshing <0|1> (currently %i)", Chunk::s_useGreedyMeshing ? 1 : 0), RGBA::GRAY);
+        return;
+    }
+    Chunk::s_useGreedyMeshing = args.GetIntArgument(0) != 0;
+    DirtyAllActiveChunks();
+}
+
+//-----------------------------------------------------------------------------------
+//The meshes look the same either way, so nothing needs rebuilding; only later edits rebuild more or less.
+CONSOLE_COMMAND(meshsections)
+{
+    if (!args.HasArgs(1))
+    {
+        Console::instance->PrintLine(Stringf("meshsections <0|1> (currently %i)", Chunk::s_useMeshSections ? 1 : 0), RGBA::GRAY);
+        return;
+    }
+    Chunk::s_useMeshSections = args.GetIntArgument(0) != 0;
+}
+
+//-----------------------------------------------------------------------------------
+//Both ways find the same faces, so this only changes how long rebuilds take.
+CONSOLE_COMMAND(facemasks)
+{
+    if (!args.HasArgs(1))
+    {
+        Console::instance->PrintLine(Stringf("facemasks <0|1> (currently %i)", Chunk::s_useFaceMasks ? 1 : 0), RGBA::GRAY);
+        return;
+    }
+    Chunk::s_useFaceMasks = args.GetIntArgument(0) != 0;
+}
+
+//-----------------------------------------------------------------------------------
+CONSOLE_COMMAND(translucentsort)
+{
+    if (!args.HasArgs(1))
+    {
+        Console::instance->PrintLine(Stringf("translucentsort <blocks the camera moves before resorting, 0 for never> (currently %.02f)", Chunk::s_translucentSortDistance), RGBA::GRAY);
+        return;
+    }
+    Chunk::s_translucentSortDistance = args.GetFloatArgument(0);
+}
+
+//-----------------------------------------------------------------------------------
+//Quad numbers farthest first, the way SortQuadsBackToFront orders them.
+struct FartherQuadFirst
+{
+    const float* m_distancesSquared;
+
+    inline bool operator()(unsigned int first, unsigned int second) const { return m_distancesSquared[first] > m_distancesSquared[second]; }
+};
+
+//-----------------------------------------------------------------------------------
+//Sorts the translucent quads of up to # chunks of the current world, built on the side, from where the camera is now,
+//with the radix sort the renderer uses and with std::stable_sort, and checks both come out in the same order.
+CONSOLE_COMMAND(translucentbench)
+{
+    int maxChunks = args.HasArgs(1) ? args.GetIntArgument(0) : 64;
+    if (maxChunks <= 0)
+    {
+        Console::instance->PrintLine("translucentbench <# chunks>", RGBA::GRAY);
+        return;
+    }
+    const int NUM_REPEATS = 16;
+    World* world = TheGame::instance->m_worlds[TheGame::instance->m_currentlyRenderedWorldID];
+    const WorldPosition cameraPosition = TheGame::instance->m_playerCamera->m_position;
+    ChunkMeshBuilder* builder = new ChunkMeshBuilder();
+    std::vector<WorldPosition> quadCenters;
+    std::vector<unsigned int> radixOrder;
+    std::vector<unsigned int> comparisonOrder;
+    std::vector<float> distancesSquared;
+    double radixSeconds = 0.0;
+    double comparisonSeconds = 0.0;
+    double maxChunkRadixSeconds = 0.0;
+    int numChunks = 0;
+    int numChunksWithQuads = 0;
+    int numQuads = 0;
+    int numMismatchedChunks = 0;
+    const std::map<ChunkCoords, Chunk*>& activeChunks = world->GetActiveChunks();
+    for (auto chunkPair : activeChunks)
+    {
+        if (numChunks >= maxChunks)
+        {
+            break;
+        }
+        ++numChunks;
+        chunkPair.second->BuildPackedMesh(*builder);
+        CalculateQuadCenters(builder->GetVertices(ChunkMeshBuilder::TRANSLUCENT_BUCKET), quadCenters);
+        if (quadCenters.empty())
+        {
+            continue;
+        }
+        ++numChunksWithQuads;
+        numQuads += quadCenters.size();
+
+        double startSeconds = GetCurrentTimeSeconds();
+        for (int repeat = 0; repeat < NUM_REPEATS; ++repeat)
+        {
+            SortQuadsBackToFront(quadCenters, cameraPosition, radixOrder);
+        }
+        double chunkRadixSeconds = (GetCurrentTimeSeconds() - startSeconds) / NUM_REPEATS;
+        radixSeconds += chunkRadixSeconds;
+        maxChunkRadixSeconds = std::max(maxChunkRadixSeconds, chunkRadixSeconds);
+
+        startSeconds = GetCurrentTimeSeconds();
+        for (int repeat = 0; repeat < NUM_REPEATS; ++repeat)
         {
-            Block* block = GetBlock(index);
-            if (block->IsSky() || BlockDefinition::GetDefinition(block->m_type)->IsIlluminated())
+            distancesSquared.resize(quadCenters.size());
+            comparisonOrder.resize(quadCenters.size());
+            for (unsigned int quad = 0; quad < quadCenters.size(); ++quad)
             {
-                SetBlockDirtyAndAddToDirtyList(index);
+                distancesSquared[quad] = MathUtils::CalcDistSquaredBetweenPoints(quadCenters[quad], cameraPosition);
+                comparisonOrder[quad] = quad;
             }
+            FartherQuadFirst fartherQuadFirst;
+            fartherQuadFirst.m_distancesSquared = distancesSquared.data();
+            std::stable_sort(comparisonOrder.begin(), comparisonOrder.end(), fartherQuadFirst);
         }
-        break;
-    case WEST:
-        //West Side
-        for (int index = 0; index < TOP_LEFT_INDEX; index += BLOCKS_WIDE_Y)
+        comparisonSeconds += (GetCurrentTimeSeconds() - startSeconds) / NUM_REPEATS;
+        numMismatchedChunks += (radixOrder != comparisonOrder) ? 1 : 0;
+    }
+    delete builder;
+    if (numChunksWithQuads == 0)
+    {
+        Console::instance->PrintLine(Stringf("None of %i chunks have translucent faces", numChunks), RGBA::RED);
+        return;
+    }
+
+    Console::instance->PrintLine(Stringf("%i of %i chunks have translucent faces, %.01f quads each", numChunksWithQuads, numChunks, (double)numQuads / numChunksWithQuads), RGBA::GRAY);
+    Console::instance->PrintLine(Stringf("%-24s %6.02f ns/quad, %.03f ms avg, %.03f ms max per chunk", "Radix sort", radixSeconds * 1.0e9 / numQuads, radixSeconds * 1000.0 / numChunksWithQuads, maxChunkRadixSeconds * 1000.0), RGBA::WHITE);
+    Console::instance->PrintLine(Stringf("%-24s %6.02f ns/quad, %.03f ms avg per chunk", "std::stable_sort", comparisonSeconds * 1.0e9 / numQuads, comparisonSeconds * 1000.0 / numChunksWithQuads), RGBA::WHITE);
+    if (numMismatchedChunks == 0)
+    {
+        Console::instance->PrintLine("PASS: both sorts put every chunk's quads in the same order", RGBA::GREEN);
+    }
+    else
+    {
+        Console::instance->PrintLine(Stringf("FAIL: %i chunks came out in a different order", numMismatchedChunks), RGBA::RED);
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//Smooth lighting has to fit in the time the mesh rebuild already gets each frame; it may cost at most this much
+//more than the flat build.
+static const double SMOOTH_MESH_BUILD_BUDGET = 1.5;
+
+//-----------------------------------------------------------------------------------
+//What meshbench measures for one mesh build mode, summed over all the chunks.
+struct MeshBenchResult
+{
+    double m_seconds;
+    int m_numVerts;
+    int m_numIndices;
+};
+
+//-----------------------------------------------------------------------------------
+//Rebuilds the chunks with the mode off and with it on, the opposite of its current setting first so the meshes and
+//the mode are left as they were. out_results[0] is with the mode off.
+static void CompareMeshBuildModes(const std::vector<Chunk*>& chunks, bool& mode, MeshBenchResult out_results[2])
+{
+    bool wasModeOn = mode;
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        mode = (pass == 0) ? !wasModeOn : wasModeOn;
+        MeshBenchResult& result = out_results[mode ? 1 : 0];
+        StartTiming();
+        for (Chunk* chunk : chunks)
+        {
+            chunk->GenerateVertexArray();
+        }
+        result.m_seconds = EndTiming();
+        result.m_numVerts = 0;
+        result.m_numIndices = 0;
+        for (Chunk* chunk : chunks)
+        {
+            result.m_numVerts += chunk->GetNumVerts();
+            result.m_numIndices += chunk->GetNumIndices();
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//Rebuilds the meshes of up to # active chunks in the current world to compare:
+//Flat against smooth lighting, with the neighborhood copy timed on its own.
+//The per-face against the greedy mesher, by build time, vertices, indices and vertex plus index memory.
+//Building through MeshBuilder against building straight into packed vertices, by build time and bytes written and
+//read on the CPU on the way to the upload.
+//Each comparison runs in the current modes of the others. Chunks already waiting for a rebuild are skipped.
+CONSOLE_COMMAND(meshbench)
+{
+    int maxChunks = args.HasArgs(1) ? args.GetIntArgument(0) : 64;
+    if (maxChunks <= 0)
+    {
+        Console::instance->PrintLine("meshbench <# chunks>", RGBA::GRAY);
+        return;
+    }
+    World* world = TheGame::instance->m_worlds[TheGame::instance->m_currentlyRenderedWorldID];
+    std::vector<Chunk*> chunks;
+    const std::map<ChunkCoords, Chunk*>& activeChunks = world->GetActiveChunks();
+    for (auto chunkPair : activeChunks)
+    {
+        if ((int)chunks.size() >= maxChunks)
+        {
+            break;
+        }
+        if (!chunkPair.second->m_isDirty)
+        {
+            chunks.push_back(chunkPair.second);
+        }
+    }
+    if (chunks.empty())
+    {
+        Console::instance->PrintLine("No built chunks to rebuild", RGBA::RED);
+        return;
+    }
+    int numChunks = chunks.size();
+    Console::instance->PrintLine(Stringf("%i chunks", numChunks), RGBA::GRAY);
+
+    MeshBenchResult lightingResults[2];
+    CompareMeshBuildModes(chunks, Chunk::s_useSmoothLighting, lightingResults);
+    ChunkNeighborhood* neighborhood = new ChunkNeighborhood();
+    StartTiming();
+    for (Chunk* chunk : chunks)
+    {
+        neighborhood->CopyFromChunk(chunk);
+    }
+    double copySeconds = EndTiming();
+    delete neighborhood;
+    double flatSeconds = lightingResults[0].m_seconds;
+    double smoothSeconds = lightingResults[1].m_seconds;
+    double ratio = smoothSeconds / (flatSeconds > 0.0 ? flatSeconds : 1.0);
+    Console::instance->PrintLine(Stringf("%-24s %.03f ms (%.03f ms/chunk)", "Flat lighting", flatSeconds * 1000.0, flatSeconds * 1000.0 / numChunks), RGBA::WHITE);
+    Console::instance->PrintLine(Stringf("%-24s %.03f ms (%.03f ms/chunk)", "Smooth lighting", smoothSeconds * 1000.0, smoothSeconds * 1000.0 / numChunks), RGBA::WHITE);
+    Console::instance->PrintLine(Stringf("%-24s %.03f ms (%.03f ms/chunk)", "  of which copying", copySeconds * 1000.0, copySeconds * 1000.0 / numChunks), RGBA::WHITE);
+    Console::instance->PrintLine(Stringf("Smooth is %.02fx flat, budget is %.02fx", ratio, SMOOTH_MESH_BUILD_BUDGET), ratio <= SMOOTH_MESH_BUILD_BUDGET ? RGBA::WHITE : RGBA::RED);
+
+    MeshBenchResult mesherResults[2];
+    CompareMeshBuildModes(chunks, Chunk::s_useGreedyMeshing, mesherResults);
+    const char* MESHER_NAMES[2] = { "Per-face mesher", "Greedy mesher" };
+    for (int mesher = 0; mesher < 2; ++mesher)
+    {
+        const MeshBenchResult& result = mesherResults[mesher];
+        double kilobytes = ((result.m_numVerts * sizeof(Vertex_PCTTD)) + (result.m_numIndices * sizeof(unsigned int))) / 1024.0;
+        Console::instance->PrintLine(Stringf("%-24s %.03f ms/chunk, %i verts, %i indices, %.01f KB per chunk", MESHER_NAMES[mesher], result.m_seconds * 1000.0 / numChunks,
+            result.m_numVerts / numChunks, result.m_numIndices / numChunks, kilobytes / numChunks), RGBA::WHITE);
+    }
+    double vertRatio = (double)mesherResults[1].m_numVerts / (mesherResults[0].m_numVerts > 0 ? (double)mesherResults[0].m_numVerts : 1.0);
+    double mesherRatio = mesherResults[1].m_seconds / (mesherResults[0].m_seconds > 0.0 ? mesherResults[0].m_seconds : 1.0);
+    Console::instance->PrintLine(Stringf("Greedy keeps %.01f%% of the vertices and takes %.02fx as long", vertRatio * 100.0, mesherRatio), RGBA::WHITE);
+
+    //MeshBuilder writes each Vertex_Master, reads it back to repack it and writes the packed copy. The packed
+    //mesher only writes the packed vertex. Both write the indices once, and upload the same buffers.
+    MeshBenchResult packingResults[2];
+    CompareMeshBuildModes(chunks, Chunk::s_usePackedMesher, packingResults);
+    const char* PACKING_NAMES[2] = { "Through MeshBuilder", "Packed vertices" };
+    const size_t BYTES_PER_VERT[2] = { (2 * sizeof(Vertex_Master)) + sizeof(Vertex_PCTTD), sizeof(Vertex_PCTTD) };
+    for (int packing = 0; packing < 2; ++packing)
+    {
+        const MeshBenchResult& result = packingResults[packing];
+        double kilobytes = ((result.m_numVerts * BYTES_PER_VERT[packing]) + (result.m_numIndices * sizeof(unsigned int))) / 1024.0;
+        Console::instance->PrintLine(Stringf("%-24s %.03f ms/chunk, %.01f KB touched per chunk", PACKING_NAMES[packing], result.m_seconds * 1000.0 / numChunks, kilobytes / numChunks), RGBA::WHITE);
+    }
+    double packingRatio = packingResults[1].m_seconds / (packingResults[0].m_seconds > 0.0 ? packingResults[0].m_seconds : 1.0);
+    Console::instance->PrintLine(Stringf("Packed takes %.02fx as long as MeshBuilder", packingRatio), RGBA::WHITE);
+}
+
+//-----------------------------------------------------------------------------------
+//Snapshots up to # active chunks in the current world, then times working out their opaque faces block by block
+//against the row bitfields, checks both come up with the same faces, and times whole packed mesh builds fed by
+//each. All in ns per block. The chunks' own meshes are left alone.
+CONSOLE_COMMAND(facebench)
+{
+    int maxChunks = args.HasArgs(1) ? args.GetIntArgument(0) : 64;
+    if (maxChunks <= 0)
+    {
+        Console::instance->PrintLine("facebench <# chunks>", RGBA::GRAY);
+        return;
+    }
+    World* world = TheGame::instance->m_worlds[TheGame::instance->m_currentlyRenderedWorldID];
+    ChunkMeshSnapshot* snapshot = new ChunkMeshSnapshot();
+    ChunkMeshBuilder* builder = new ChunkMeshBuilder();
+    std::vector<uchar> lookupFaces(Chunk::BLOCKS_PER_CHUNK);
+    std::vector<uchar> bitfieldFaces(Chunk::BLOCKS_PER_CHUNK);
+    double passSeconds[2] = { 0.0, 0.0 };
+    double buildSeconds[2] = { 0.0, 0.0 };
+    int numChunks = 0;
+    int numMismatchedBlocks = 0;
+    int numFaces = 0;
+    const std::map<ChunkCoords, Chunk*>& activeChunks = world->GetActiveChunks();
+    for (auto chunkPair : activeChunks)
+    {
+        if (numChunks >= maxChunks)
+        {
+            break;
+        }
+        ++numChunks;
+        snapshot->CopyFromChunk(chunkPair.second, Chunk::ALL_MESH_SECTIONS);
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            snapshot->m_useFaceMasks = (pass == 1);
+            uchar* faces = (pass == 1) ? &bitfieldFaces[0] : &lookupFaces[0];
+            double startSeconds = GetCurrentTimeSeconds();
+            CalculateOpaqueFaces(*snapshot, 0, Chunk::BLOCKS_TALL_Z, faces);
+            passSeconds[pass] += GetCurrentTimeSeconds() - startSeconds;
+            startSeconds = GetCurrentTimeSeconds();
+            Chunk::BuildPackedMesh(*builder, *snapshot);
+            buildSeconds[pass] += GetCurrentTimeSeconds() - startSeconds;
+        }
+        for (int index = 0; index < Chunk::BLOCKS_PER_CHUNK; ++index)
         {
-            Block* block = GetBlock(index);
-            if (block->IsSky() || BlockDefinition::GetDefinition(block->m_type)->IsIlluminated())
+            numMismatchedBlocks += (lookupFaces[index] != bitfieldFaces[index]) ? 1 : 0;
+            for (uchar faces = lookupFaces[index]; faces != 0x00; faces &= faces - 1)
             {
-                SetBlockDirtyAndAddToDirtyList(index);
+                ++numFaces;
+            }
+        }
+    }
+    delete builder;
+    delete snapshot;
+    if (numChunks == 0)
+    {
+        Console::instance->PrintLine("No chunks to mesh", RGBA::RED);
+        return;
+    }
+
+    double numBlocks = (double)numChunks * Chunk::BLOCKS_PER_CHUNK;
+    const char* PASS_NAMES[2] = { "Block by block", "Row bitfields" };
+    Console::instance->PrintLine(Stringf("%i chunks, %.02f opaque faces drawn per block", numChunks, numFaces / numBlocks), RGBA::GRAY);
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        Console::instance->PrintLine(Stringf("%-24s %6.02f ns/block finding faces, %6.02f ns/block whole build", PASS_NAMES[pass], passSeconds[pass] * 1.0e9 / numBlocks, buildSeconds[pass] * 1.0e9 / numBlocks), RGBA::WHITE);
+    }
+    double passRatio = passSeconds[0] / (passSeconds[1] > 0.0 ? passSeconds[1] : 1.0);
+    double buildRatio = buildSeconds[0] / (buildSeconds[1] > 0.0 ? buildSeconds[1] : 1.0);
+    Console::instance->PrintLine(Stringf("Bitfields find faces %.02fx as fast and build %.02fx as fast", passRatio, buildRatio), RGBA::WHITE);
+    if (numMismatchedBlocks == 0)
+    {
+        Console::instance->PrintLine("PASS: both find the same faces", RGBA::GREEN);
+    }
+    else
+    {
+        Console::instance->PrintLine(Stringf("FAIL: %i blocks have different faces", numMismatchedBlocks), RGBA::RED);
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//Reports what every built chunk mesh in every world takes now and would take in CompactChunkVertex form, then
+//rebuilds up to # chunks of the current world on the side and checks every quad packs and decodes back to what the
+//mesher made. The chunks' own meshes are left alone.
+CONSOLE_COMMAND(compactverts)
+{
+    int maxChunksToCheck = args.HasArgs(1) ? args.GetIntArgument(0) : 16;
+    int numChunks = 0;
+    int numVerts = 0;
+    int numIndices = 0;
+    for (World* world : TheGame::instance->m_worlds)
+    {
+        const std::map<ChunkCoords, Chunk*>& activeChunks = world->GetActiveChunks();
+        for (auto chunkPair : activeChunks)
+        {
+            if (!chunkPair.second->m_isDirty)
+            {
+                ++numChunks;
+                numVerts += chunkPair.second->GetNumVerts();
+                numIndices += chunkPair.second->GetNumIndices();
             }
         }
-        break;
-    default:
-        break;
     }
-}
\ No newline at end of file
+    double indexKilobytes = (numIndices * sizeof(unsigned int)) / 1024.0;
+    double currentKilobytes = (numVerts * sizeof(Vertex_PCTTD)) / 1024.0;
+    double compactKilobytes = (numVerts * sizeof(CompactChunkVertex)) / 1024.0;
+    Console::instance->PrintLine(Stringf("%i built chunks, %i verts, %i indices (%.01f KB of indices either way)", numChunks, numVerts, numIndices, indexKilobytes), RGBA::GRAY);
+    Console::instance->PrintLine(Stringf("%-24s %2i bytes/vert, %.01f KB", "Vertex_PCTTD", (int)sizeof(Vertex_PCTTD), currentKilobytes), RGBA::WHITE);
+    Console::instance->PrintLine(Stringf("%-24s %2i bytes/vert, %.01f KB", "CompactChunkVertex", (int)sizeof(CompactChunkVertex), compactKilobytes), RGBA::WHITE);
+
+    World* world = TheGame::instance->m_worlds[TheGame::instance->m_currentlyRenderedWorldID];
+    ChunkMeshBuilder* builder = new ChunkMeshBuilder();
+    int numChunksChecked = 0;
+    int numQuadsChecked = 0;
+    int numBadQuads = 0;
+    const std::map<ChunkCoords, Chunk*>& activeChunks = world->GetActiveChunks();
+    for (auto chunkPair : activeChunks)
+    {
+        if (numChunksChecked >= maxChunksToCheck)
+        {
+            break;
+        }
+        Chunk* chunk = chunkPair.second;
+        if (chunk->m_isDirty)
+        {
+            continue;
+        }
+        chunk->BuildPackedMesh(*builder);
+        for (int bucket = 0; bucket < ChunkMeshBuilder::NUM_BUCKETS; ++bucket)
+        {
+            const std::vector<Vertex_PCTTD>& vertices = builder->GetVertices(static_cast<ChunkMeshBuilder::Bucket>(bucket));
+            for (unsigned int firstVertex = 0; firstVertex + 3 < vertices.size(); firstVertex += 4)
+            {
+                if (!CompactChunkVertex::DoesQuadSurviveRoundTrip(&vertices[firstVertex], chunk->m_bottomLeftCorner))
+                {
+                    ++numBadQuads;
+                }
+                ++numQuadsChecked;
+            }
+        }
+        ++numChunksChecked;
+    }
+    delete builder;
+    Console::instance->PrintLine(Stringf("%s: %i of %i quads in %i chunks changed going through the compact format", numBadQuads == 0 ? "PASS" : "FAIL", numBadQuads, numQuadsChecked, numChunksChecked), numBadQuads == 0 ? RGBA::WHITE : RGBA::RED);
+}
+
+//-----------------------------------------------------------------------------------
+//Sky pass cost per chunk, the old per-block column walk against the height map pass, on chunks generated far away.
+//Both are flooded afterwards and compared, so a mismatch means the height map pass lights the chunk differently.
+CONSOLE_COMMAND(skybench)
+{
+    int numChunks = args.HasArgs(1) ? args.GetIntArgument(0) : 16;
+    if (numChunks <= 0)
+    {
+        Console::instance->PrintLine("skybench <# of chunks>", RGBA::GRAY);
+        return;
+    }
+    World* world = TheGame::instance->m_worlds[TheGame::instance->m_currentlyRenderedWorldID];
+    DetachedChunkFactory detachedChunks(world);
+    std::vector<LocalIndex> spreadQueue;
+    std::vector<Block> perBlockResult(Chunk::BLOCKS_PER_CHUNK);
+    double perBlockSeconds = 0.0;
+    double heightMapSeconds = 0.0;
+    int numMismatches = 0;
+    for (int chunkNumber = 0; chunkNumber < numChunks; ++chunkNumber)
+    {
+        Chunk* chunk = detachedChunks.CreateChunk(chunkNumber, 0);
+
+        spreadQueue.clear();
+        chunk->ResetLocalLighting(spreadQueue);
+        StartTiming();
+        chunk->CalculateSkyLightingPerBlock(spreadQueue);
+        perBlockSeconds += EndTiming();
+        chunk->FloodLocalLighting(spreadQueue);
+        for (int index = 0; index < Chunk::BLOCKS_PER_CHUNK; ++index)
+        {
+            perBlockResult[index] = *chunk->GetBlock(index);
+        }
+
+        spreadQueue.clear();
+        chunk->ResetLocalLighting(spreadQueue);
+        StartTiming();
+        chunk->CalculateHeightMap();
+        chunk->CalculateSkyLighting(spreadQueue);
+        heightMapSeconds += EndTiming();
+        chunk->FloodLocalLighting(spreadQueue);
+        for (int index = 0; index < Chunk::BLOCKS_PER_CHUNK; ++index)
+        {
+            Block* block = chunk->GetBlock(index);
+            Block& expected = perBlockResult[index];
+            if (block->IsSky() != expected.IsSky() || block->GetPackedLight() != expected.GetPackedLight() || block->GetPackedSkyLight() != expected.GetPackedSkyLight())
+            {
+                ++numMismatches;
+            }
+        }
+        delete chunk;
+    }
+    Console::instance->PrintLine(Stringf("%-24s %.03f ms/chunk", "Per-block sky pass", perBlockSeconds * 1000.0 / numChunks), RGBA::WHITE);
+    Console::instance->PrintLine(Stringf("%-24s %.03f ms/chunk", "Height map sky pass", heightMapSeconds * 1000.0 / numChunks), RGBA::WHITE);
+    Console::instance->PrintLine(Stringf("%i blocks lit differently over %i chunks", numMismatches, numChunks), numMismatches == 0 ? RGBA::WHITE : RGBA::RED);
+}
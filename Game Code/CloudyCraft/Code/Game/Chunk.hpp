@@ -6,6 +6,11 @@
 #include <vector>
 class Vector2Int;
 class BlockInfo;
+class LightingEngine;
+class ChunkNeighborhood;
+class ChunkMeshBuilder;
+class ChunkMeshSnapshot;
+class Generator;
 struct Vertex_PCT;
 
 class Chunk
@@ -14,27 +19,54 @@ public:
 	//CONSTRUCTORS//////////////////////////////////////////////////////////////////////////
 	Chunk(const ChunkCoords& chunkCoords, World* world);
 	Chunk(const ChunkCoords& chunkCoords, std::vector<unsigned char>& data, World* world);
+	Chunk(const ChunkCoords& chunkCoords, World* world, Generator& generator);
 	~Chunk();
 
 	//FUNCTIONS//////////////////////////////////////////////////////////////////////////
 	void Update(float deltaTime);
 	void Render() const;
+	void RenderTranslucent(const WorldPosition& cameraPosition) const;
+	bool SortTranslucentFaces(const WorldPosition& cameraPosition);
 	void GenerateChunk();
 	bool IsInFrustum(const Vector3& cameraXYZ, const WorldPosition& playerPosition) const;
 	void GenerateSaveData(std::vector<unsigned char>& data);
 	void LoadChunkFromData(std::vector<unsigned char>& data);
+	int ApplyDeferredBlockWrites(std::vector<LocalIndex>* out_changedIndices = nullptr);
 	void AttemptCleanUpRenderData();
 
 	//LIGHTING//////////////////////////////////////////////////////////////////////////
-	void SetBlockDirtyAndAddToDirtyList(LocalIndex blockToDirtyIndex);
-	void CalculateSkyLighting();
-	void FlagEdgesAsDirtyLighting(Direction dir);
+	void CalculateLocalLighting();
+	void ResetLocalLighting(std::vector<LocalIndex>& out_spreadQueue);
+	void CalculateHeightMap();
+	void UpdateHeightMap(LocalIndex changedIndex);
+	void CalculateSkyLighting(std::vector<LocalIndex>& out_spreadQueue);
+	void CalculateSkyLightingPerBlock(std::vector<LocalIndex>& out_spreadQueue);
+	void FloodLocalLighting(std::vector<LocalIndex>& spreadQueue);
+	inline uchar GetHeight(LocalIndex columnIndex) const { return m_heightMap[columnIndex]; };
+	int QueueEdgeLightSpread(Direction dir, LightingEngine& lightingEngine);
+	int QueueSeamLightSpread(Direction dir, LightingEngine& lightingEngine);
+	bool SetLightingDirty(LocalIndex index);
+	void ClearLightingDirty();
+	int QueueLightingDirtyBlocks(LightingEngine& lightingEngine);
+	inline int GetNumLightingDirtyBlocks() const { return m_numLightingDirtyBlocks; };
+	inline double GetLocalLightingSeconds() const { return m_localLightingSeconds; };
+	static unsigned int GetNewLightingQueueID();
 
 	//FACE VISIBILITY//////////////////////////////////////////////////////////////////////////
 	void SetEdgeBits();
-	void DirtyAndAddToDirtyList();
-	void SetHighPriorityChunkDirtyAndAddToDirtyList();
+	void DirtyAndAddToDirtyList(uchar meshSections = ALL_MESH_SECTIONS);
+	void SetHighPriorityChunkDirtyAndAddToDirtyList(uchar meshSections = ALL_MESH_SECTIONS);
 	void GenerateVertexArray();
+	void BuildPackedMesh(ChunkMeshBuilder& builder);
+	static void BuildPackedMesh(ChunkMeshBuilder& builder, const ChunkMeshSnapshot& snapshot);
+	static void BuildPackedMesh(ChunkMeshBuilder& builder, const ChunkMeshSnapshot& snapshot, int meshSection);
+	void TakeMeshSnapshot(ChunkMeshSnapshot& out_snapshot);
+	bool UploadMesh(const ChunkMeshBuilder& builder, int meshSection, unsigned int snapshotVersion);
+	static inline uchar GetMeshSectionsShowingBlock(LocalIndex index);
+	inline bool HasDirtyMeshSections() const { return m_dirtyMeshSections != 0; };
+	inline double GetTimeDirtied() const { return m_timeDirtied; };
+	int GetNumVerts() const;
+	int GetNumIndices() const;
 
 	//ACCESSORS AND CONVERSIONS//////////////////////////////////////////////////////////////////////////
 	inline Block* GetBlock(LocalIndex index);
@@ -44,7 +76,7 @@ public:
 	inline Block* GetSouth(LocalIndex index);
 	inline Block* GetEast(LocalIndex index);
 	inline Block* GetWest(LocalIndex index);
-	inline LocalCoords GetLocalCoordsFromBlockIndex(LocalIndex index) const;
+	static inline LocalCoords GetLocalCoordsFromBlockIndex(LocalIndex index);
 	inline WorldPosition GetWorldMinsForBlockIndex(LocalIndex index) const;
 	inline LocalIndex GetBlockIndexFromLocalCoords(const LocalCoords& coords) const;
 	inline BlockInfo GetBlockInfoFromLocalCoords(const LocalCoords& coords);
@@ -67,6 +99,18 @@ public:
 	static const int LOCAL_X_MASK = BLOCKS_WIDE_X - 1;
 	static const int LOCAL_Y_MASK = (BLOCKS_WIDE_Y - 1) << CHUNK_BITS_X;
 	static const int LOCAL_Z_MASK = (BLOCKS_TALL_Z - 1) << CHUNK_BITS_XY;
+	static const int LIGHTING_DIRTY_BITS_PER_WORD = 32;
+	static const int NUM_LIGHTING_DIRTY_WORDS = BLOCKS_PER_CHUNK / LIGHTING_DIRTY_BITS_PER_WORD;
+	static const int CHUNK_BITS_MESH_SECTION_Z = 4;
+	static const int BLOCKS_TALL_MESH_SECTION_Z = BIT(CHUNK_BITS_MESH_SECTION_Z);
+	static const int NUM_MESH_SECTIONS = BLOCKS_TALL_Z / BLOCKS_TALL_MESH_SECTION_Z;
+	static const uchar ALL_MESH_SECTIONS = static_cast<uchar>(BIT(NUM_MESH_SECTIONS) - 1);
+	static bool s_useSmoothLighting; //Per-corner smoothed light and ambient occlusion instead of one flat light per face.
+	static bool s_useGreedyMeshing; //Merge matching opaque faces into larger quads instead of one quad per face.
+	static bool s_usePackedMesher; //Build straight into packed vertices instead of going through MeshBuilder.
+	static bool s_useMeshSections; //Rebuild only the sections an edit touches instead of the whole chunk.
+	static bool s_useFaceMasks; //Work out which opaque faces show a row at a time from bitfields instead of block by block.
+	static float s_translucentSortDistance; //How far the camera moves before translucent faces are put back in order, 0 for never.
 
 	//MEMBER VARIABLES//////////////////////////////////////////////////////////////////////////
 	ChunkCoords m_chunkPosition;
@@ -77,11 +121,50 @@ public:
 	Chunk* m_southChunk;
 	World* m_world;
 	bool m_isDirty;
+	unsigned int m_lightingQueueID; //Stamped on everything the LightingEngine queues for this chunk, and replaced when it's purged.
 
 private:
+	//FUNCTIONS//////////////////////////////////////////////////////////////////////////
+	template <typename MeshBuilderType> static void AddFacesToMesh(MeshBuilderType& builder, const ChunkMeshSnapshot& snapshot, int firstZ, int endZ);
+
+	//-----------------------------------------------------------------------------------
+	//A section's translucent faces: water, glass, portals. Drawn after every chunk's opaque faces, farthest first, so
+	//the indices are kept here too and reordered whenever the camera has moved far enough from where they were last
+	//sorted.
+	struct TranslucentFaces
+	{
+		TranslucentFaces(const ChunkMeshBuilder& builder);
+		~TranslucentFaces();
+		void SortBackToFront(const WorldPosition& cameraPosition);
+
+		MeshRenderer* m_meshRenderer;
+		std::vector<WorldPosition> m_quadCenters;
+		std::vector<unsigned int> m_builtIndices; //Six per quad, in the order the mesher made them.
+		WorldPosition m_sortedFromPosition;
+		bool m_isSorted;
+	};
+
+	//-----------------------------------------------------------------------------------
+	//One horizontal slice of the chunk's mesh, BLOCKS_TALL_MESH_SECTION_Z blocks tall, built and uploaded on its own.
+	struct MeshSection
+	{
+		MeshRenderer* m_meshRenderer; //Just the opaque faces when the packed mesher built it.
+		TranslucentFaces* m_translucentFaces; //Null if there aren't any, which is most sections.
+		int m_numVerts;
+		int m_numIndices;
+		unsigned int m_uploadedSnapshotVersion; //Which snapshot of the chunk the section showing now was built from.
+	};
+
+	//MEMBER VARIABLES//////////////////////////////////////////////////////////////////////////
 	Block m_blocks[BLOCKS_PER_CHUNK];
-	MeshRenderer* m_meshRenderer;
-	int m_numVerts;
+	uchar m_heightMap[BLOCKS_PER_LAYER]; //Lowest z in each column that can see the sky, 0 through BLOCKS_TALL_Z.
+	unsigned int m_lightingDirtyBits[NUM_LIGHTING_DIRTY_WORDS]; //One bit per block waiting to be handed to the LightingEngine.
+	int m_numLightingDirtyBlocks;
+	MeshSection m_meshSections[NUM_MESH_SECTIONS];
+	uchar m_dirtyMeshSections; //One bit per section waiting to be rebuilt, bottom section first.
+	unsigned int m_lastSnapshotVersion; //Counts up with every snapshot taken of the chunk for meshing.
+	double m_timeDirtied; //When the chunk last went from clean to dirty, for measuring mesh latency.
+	double m_localLightingSeconds; //How long CalculateLocalLighting last took, on whichever thread ran it.
 };
 
 #include "Game/Chunk.inl"
\ No newline at end of file
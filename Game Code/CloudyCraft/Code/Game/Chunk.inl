@@ -9,11 +9,26 @@ inline WorldPosition Chunk::GetWorldMinsForBlockIndex(LocalIndex index) const
 }
 
 //-----------------------------------------------------------------------------------
-inline LocalCoords Chunk::GetLocalCoordsFromBlockIndex(LocalIndex index) const
+inline LocalCoords Chunk::GetLocalCoordsFromBlockIndex(LocalIndex index)
 {
 	return LocalCoords(index & LOCAL_X_MASK, (index & LOCAL_Y_MASK) >> CHUNK_BITS_X, index >> CHUNK_BITS_XY);
 }
 
+//-----------------------------------------------------------------------------------
+//The block's own section, and the one above or below if it sits on the boundary, since a face and its smoothed
+//corners change with any block within one of it.
+inline uchar Chunk::GetMeshSectionsShowingBlock(LocalIndex index)
+{
+	if (!s_useMeshSections)
+	{
+		return ALL_MESH_SECTIONS;
+	}
+	int z = index >> CHUNK_BITS_XY;
+	int lowestSection = ((z > 0) ? z - 1 : z) >> CHUNK_BITS_MESH_SECTION_Z;
+	int highestSection = ((z < BLOCKS_TALL_Z - 1) ? z + 1 : z) >> CHUNK_BITS_MESH_SECTION_Z;
+	return static_cast<uchar>(BIT(highestSection + 1) - BIT(lowestSection));
+}
+
 //-----------------------------------------------------------------------------------
 inline LocalIndex Chunk::GetBlockIndexFromLocalCoords(const LocalCoords& coords) const
 {
@@ -0,0 +1,37 @@
+#include "Game/ChunkMeshBuilder.hpp"
+#include "Engine/Renderer/Mesh.hpp"
+
+//-----------------------------------------------------------------------------------
+ChunkMeshBuilder::ChunkMeshBuilder()
+{
+    Begin();
+}
+
+//-----------------------------------------------------------------------------------
+void ChunkMeshBuilder::Begin()
+{
+    for (int bucket = 0; bucket < NUM_BUCKETS; ++bucket)
+    {
+        m_vertices[bucket].clear();
+        m_indices[bucket].clear();
+    }
+    m_bucket = OPAQUE_BUCKET;
+    m_stamp.pos = Vector3::ZERO;
+    m_stamp.color = RGBA::WHITE;
+    m_stamp.texCoords = Vector2::ZERO;
+    m_stamp.texCoords1 = Vector2::ZERO;
+    m_stamp.floatData0 = Vector4(0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+//-----------------------------------------------------------------------------------
+void ChunkMeshBuilder::CopyToMesh(Mesh* mesh, Bucket bucket) const
+{
+    const std::vector<Vertex_PCTTD>& vertices = m_vertices[bucket];
+    const std::vector<unsigned int>& indices = m_indices[bucket];
+    if (vertices.empty())
+    {
+        return;
+    }
+    mesh->Init((void*)vertices.data(), vertices.size(), sizeof(Vertex_PCTTD), (void*)indices.data(), indices.size(), &Vertex_PCTTD::BindMeshToVAO);
+    mesh->m_drawMode = Renderer::DrawMode::TRIANGLES;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "Engine/Renderer/Vertex.hpp"
+#include "Engine/Renderer/RGBA.hpp"
+#include "Engine/Math/Vector2.hpp"
+#include "Engine/Math/Vector3.hpp"
+#include "Engine/Math/Vector4.hpp"
+#include <vector>
+
+class Mesh;
+
+//-----------------------------------------------------------------------------------
+//Stands in for MeshBuilder when building chunk meshes. It takes the same calls the mesher already makes, but stamps
+//out Vertex_PCTTDs directly, so nothing goes through a Vertex_Master or gets repacked by a copy callback before upload.
+//Begin() empties the buffers without freeing them, so one builder kept around reuses the same memory every build.
+//Opaque and translucent faces go into separate buffers, each with indices counting from its own first vertex, so the
+//translucent ones can be drawn after everything opaque and put in order without touching the rest.
+class ChunkMeshBuilder
+{
+public:
+    //ENUMS//////////////////////////////////////////////////////////////////////////
+    enum Bucket
+    {
+        OPAQUE_BUCKET,
+        TRANSLUCENT_BUCKET,
+        NUM_BUCKETS
+    };
+
+    //CONSTRUCTORS//////////////////////////////////////////////////////////////////////////
+    ChunkMeshBuilder();
+    ~ChunkMeshBuilder() {};
+
+    //FUNCTIONS//////////////////////////////////////////////////////////////////////////
+    void Begin();
+    void CopyToMesh(Mesh* mesh, Bucket bucket) const;
+    inline void SetBucket(Bucket bucket) { m_bucket = bucket; };
+    inline void SetColor(const RGBA& color) { m_stamp.color = color; };
+    inline void SetUV(const Vector2& uv) { m_stamp.texCoords = uv; };
+    inline void SetUV1(const Vector2& uv) { m_stamp.texCoords1 = uv; };
+    inline void SetFloatData0(const Vector4& data) { m_stamp.floatData0 = data; };
+    inline void AddVertex(const Vector3& position) { m_stamp.pos = position; m_vertices[m_bucket].push_back(m_stamp); };
+    inline void AddQuadIndicesClockwise(unsigned int tlIndex, unsigned int trIndex, unsigned int blIndex, unsigned int brIndex);
+
+    //QUERIES//////////////////////////////////////////////////////////////////////////
+    inline unsigned int GetNumVerts() const { return m_vertices[OPAQUE_BUCKET].size() + m_vertices[TRANSLUCENT_BUCKET].size(); };
+    inline unsigned int GetNumIndices() const { return m_indices[OPAQUE_BUCKET].size() + m_indices[TRANSLUCENT_BUCKET].size(); };
+    inline const std::vector<Vertex_PCTTD>& GetVertices(Bucket bucket) const { return m_vertices[bucket]; };
+    inline const std::vector<unsigned int>& GetIndices(Bucket bucket) const { return m_indices[bucket]; };
+
+private:
+    //MEMBER VARIABLES//////////////////////////////////////////////////////////////////////////
+    Vertex_PCTTD m_stamp;
+    Bucket m_bucket;
+    std::vector<Vertex_PCTTD> m_vertices[NUM_BUCKETS];
+    std::vector<unsigned int> m_indices[NUM_BUCKETS];
+};
+
+//-----------------------------------------------------------------------------------
+//Same triangles, in the same order, as MeshBuilder::AddQuadIndicesClockwise.
+inline void ChunkMeshBuilder::AddQuadIndicesClockwise(unsigned int tlIndex, unsigned int trIndex, unsigned int blIndex, unsigned int brIndex)
+{
+    std::vector<unsigned int>& indices = m_indices[m_bucket];
+    indices.push_back(brIndex);
+    indices.push_back(blIndex);
+    indices.push_back(tlIndex);
+    indices.push_back(brIndex);
+    indices.push_back(tlIndex);
+    indices.push_back(trIndex);
+}
@@ -0,0 +1,226 @@
+#include "Game/ChunkMeshCache.hpp"
+#include "Game/ChunkMeshSnapshot.hpp"
+#include "Game/Chunk.hpp"
+#include "Game/TheGame.hpp"
+#include "Engine/Input/Console.hpp"
+#include "Engine/Time/Time.hpp"
+#include <string.h>
+
+//-----------------------------------------------------------------------------------
+ChunkMeshCache::ChunkMeshCache(size_t budgetBytes)
+    : m_budgetBytes(budgetBytes)
+    , m_numBytes(0)
+{
+    ResetStats();
+}
+
+//-----------------------------------------------------------------------------------
+//Gets one of the snapshot's sections into the builder, from the cache if it's been built before, or building it and
+//keeping a copy if not. Safe on any thread as long as each thread has its own builder.
+void ChunkMeshCache::BuildSection(ChunkMeshBuilder& builder, const ChunkMeshSnapshot& snapshot, int meshSection)
+{
+    if (m_budgetBytes == 0)
+    {
+        Chunk::BuildPackedMesh(builder, snapshot, meshSection);
+        return;
+    }
+    unsigned long long key = snapshot.CalculateSectionKey(meshSection);
+    if (Find(key, builder))
+    {
+        return;
+    }
+    double startSeconds = GetCurrentTimeSeconds();
+    Chunk::BuildPackedMesh(builder, snapshot, meshSection);
+    Add(key, builder, GetCurrentTimeSeconds() - startSeconds);
+}
+
+//-----------------------------------------------------------------------------------
+//Copies the entry for key into out_builder and returns true if there is one.
+bool ChunkMeshCache::Find(unsigned long long key, ChunkMeshBuilder& out_builder)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    ++m_stats.m_numLookups;
+    auto found = m_entriesByKey.find(key);
+    if (found == m_entriesByKey.end())
+    {
+        return false;
+    }
+    m_entries.splice(m_entries.begin(), m_entries, found->second);
+    out_builder = found->second->m_builder;
+    ++m_stats.m_numHits;
+    m_stats.m_savedBuildSeconds += found->second->m_buildSeconds;
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//Keeps a copy of what's in the builder under key. Two workers can build the same section at once; the second one
+//just marks the first one's entry as used.
+void ChunkMeshCache::Add(unsigned long long key, const ChunkMeshBuilder& builder, double buildSeconds)
+{
+    size_t numBytes = sizeof(Entry) + (builder.GetNumVerts() * sizeof(Vertex_PCTTD)) + (builder.GetNumIndices() * sizeof(unsigned int));
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (numBytes > m_budgetBytes)
+    {
+        return;
+    }
+    auto found = m_entriesByKey.find(key);
+    if (found != m_entriesByKey.end())
+    {
+        m_entries.splice(m_entries.begin(), m_entries, found->second);
+        return;
+    }
+    m_entries.push_front(Entry());
+    Entry& entry = m_entries.front();
+    entry.m_key = key;
+    entry.m_builder = builder;
+    entry.m_numBytes = numBytes;
+    entry.m_buildSeconds = buildSeconds;
+    m_entriesByKey[key] = m_entries.begin();
+    m_numBytes += numBytes;
+    EvictToBudget();
+}
+
+//-----------------------------------------------------------------------------------
+//0 turns the cache off and empties it.
+void ChunkMeshCache::SetBudget(size_t budgetBytes)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_budgetBytes = budgetBytes;
+    EvictToBudget();
+}
+
+//-----------------------------------------------------------------------------------
+void ChunkMeshCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_entries.clear();
+    m_entriesByKey.clear();
+    m_numBytes = 0;
+}
+
+//-----------------------------------------------------------------------------------
+void ChunkMeshCache::ResetStats()
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    memset(&m_stats, 0, sizeof(m_stats));
+}
+
+//-----------------------------------------------------------------------------------
+//Callers hold m_lock.
+void ChunkMeshCache::EvictToBudget()
+{
+    while (m_numBytes > m_budgetBytes)
+    {
+        const Entry& oldest = m_entries.back();
+        m_numBytes -= oldest.m_numBytes;
+        m_entriesByKey.erase(oldest.m_key);
+        m_entries.pop_back();
+        ++m_stats.m_numEvictions;
+    }
+}
+
+//-----------------------------------------------------------------------------------
+ChunkMeshCacheStats ChunkMeshCache::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_stats;
+}
+
+//-----------------------------------------------------------------------------------
+size_t ChunkMeshCache::GetNumBytes() const
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_numBytes;
+}
+
+//-----------------------------------------------------------------------------------
+int ChunkMeshCache::GetNumEntries() const
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    return static_cast<int>(m_entries.size());
+}
+
+//-----------------------------------------------------------------------------------
+static inline unsigned long long RotateLeft(unsigned long long value, int numBits)
+{
+    return (value << numBits) | (value >> (64 - numBits));
+}
+
+//-----------------------------------------------------------------------------------
+//One word into one lane, the same round xxHash64 uses: the rotate after the multiply brings the high bits, which the
+//multiply has mixed, back down to where the next multiply spreads them out again.
+static inline unsigned long long HashRound(unsigned long long lane, unsigned long long word)
+{
+    lane += word * 0xC2B2AE3D27D4EB4FULL;
+    return RotateLeft(lane, 31) * 0x9E3779B185EBCA87ULL;
+}
+
+//-----------------------------------------------------------------------------------
+static inline unsigned long long HashMerge(unsigned long long hash, unsigned long long lane)
+{
+    return (RotateLeft(hash ^ HashRound(0, lane), 27) * 0x9E3779B185EBCA87ULL) + 0x85EBCA77C2B2AE63ULL;
+}
+
+//-----------------------------------------------------------------------------------
+//Folds numBytes of data into hash, 8 bytes at a time, laid out like xxHash64. A section's key covers about 60 KB, so
+//the words are spread over four lanes that don't wait on each other's multiplies, then merged at the end.
+unsigned long long ChunkMeshCache::HashBytes(const void* data, size_t numBytes, unsigned long long hash)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    //Four locals rather than an array, which the compiler would keep in memory and wait on.
+    unsigned long long lane0 = hash + 0x60EA27EEADC0B5D6ULL;
+    unsigned long long lane1 = hash + 0xC2B2AE3D27D4EB4FULL;
+    unsigned long long lane2 = hash;
+    unsigned long long lane3 = hash - 0x9E3779B185EBCA87ULL;
+    size_t offset = 0;
+    for (; offset + (4 * sizeof(unsigned long long)) <= numBytes; offset += 4 * sizeof(unsigned long long))
+    {
+        unsigned long long words[4];
+        memcpy(words, bytes + offset, sizeof(words));
+        lane0 = HashRound(lane0, words[0]);
+        lane1 = HashRound(lane1, words[1]);
+        lane2 = HashRound(lane2, words[2]);
+        lane3 = HashRound(lane3, words[3]);
+    }
+    hash = RotateLeft(lane0, 1) + RotateLeft(lane1, 7) + RotateLeft(lane2, 12) + RotateLeft(lane3, 18);
+    hash = HashMerge(hash, lane0);
+    hash = HashMerge(hash, lane1);
+    hash = HashMerge(hash, lane2);
+    hash = HashMerge(hash, lane3);
+    for (; offset + sizeof(unsigned long long) <= numBytes; offset += sizeof(unsigned long long))
+    {
+        unsigned long long word;
+        memcpy(&word, bytes + offset, sizeof(word));
+        hash = HashMerge(hash, word);
+    }
+    unsigned long long tail = 0;
+    memcpy(&tail, bytes + offset, numBytes - offset);
+    hash = HashMerge(hash, tail ^ (static_cast<unsigned long long>(numBytes) << 56));
+
+    //So every input bit reaches every output bit, not just the ones above it.
+    hash ^= hash >> 33;
+    hash *= 0xC2B2AE3D27D4EB4FULL;
+    hash ^= hash >> 29;
+    hash *= 0x165667B19E3779F9ULL;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+//-----------------------------------------------------------------------------------
+CONSOLE_COMMAND(meshcache)
+{
+    ChunkMeshCache* meshCache = TheGame::instance->m_meshCache;
+    if (!args.HasArgs(1))
+    {
+        Console::instance->PrintLine(Stringf("meshcache <budget in MB, 0 to turn it off> (currently %i)", static_cast<int>(meshCache->GetBudget() / (1024 * 1024))), RGBA::GRAY);
+        ChunkMeshCacheStats stats = meshCache->GetStats();
+        Console::instance->PrintLine(Stringf("%-24s %i sections, %.02f MB", "Cached", meshCache->GetNumEntries(), meshCache->GetNumBytes() / (1024.0 * 1024.0)), RGBA::WHITE);
+        Console::instance->PrintLine(Stringf("%-24s %i of %i, %.01f%%", "Hits", stats.m_numHits, stats.m_numLookups, stats.m_numLookups > 0 ? stats.m_numHits * 100.0 / stats.m_numLookups : 0.0), RGBA::WHITE);
+        Console::instance->PrintLine(Stringf("%-24s %.02f ms", "Build time saved", stats.m_savedBuildSeconds * 1000.0), RGBA::WHITE);
+        Console::instance->PrintLine(Stringf("%-24s %i", "Evicted", stats.m_numEvictions), RGBA::WHITE);
+        return;
+    }
+    int budgetMegabytes = args.GetIntArgument(0);
+    meshCache->SetBudget(budgetMegabytes > 0 ? static_cast<size_t>(budgetMegabytes) * 1024 * 1024 : 0);
+    meshCache->ResetStats();
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "Game/GameCommon.hpp"
+#include "Game/ChunkMeshBuilder.hpp"
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+class ChunkMeshSnapshot;
+
+//-----------------------------------------------------------------------------------
+//What the mesh cache has done since its stats were last reset. Saved time is what the builds it skipped took the
+//first time around.
+struct ChunkMeshCacheStats
+{
+    int m_numLookups;
+    int m_numHits;
+    int m_numEvictions;
+    double m_savedBuildSeconds;
+};
+
+//-----------------------------------------------------------------------------------
+//Packed mesh sections that were built recently, so a chunk that's flushed and loaded again unchanged, say from the
+//player walking back and forth over the flush radius, gets its meshes back without building them.
+//Keyed by a hash of everything a section's build reads from the snapshot: the section's layers and the one on either
+//side, light included, the border borrowed from the neighbors, where the chunk sits, its portals and the mesh modes.
+//Nothing in the key names the chunk, so any section that would build the same vertices shares one entry. The keys
+//are 64 bits and never checked any further; a collision would show another section's mesh, but at the few thousand
+//entries a budget holds that's a lot less likely than anything else going wrong.
+//Least recently used entries go first once the buffers add up to more than the budget. Safe on any thread; the
+//mesh workers all share one.
+class ChunkMeshCache
+{
+public:
+    //CONSTRUCTORS//////////////////////////////////////////////////////////////////////////
+    ChunkMeshCache(size_t budgetBytes);
+    ~ChunkMeshCache() {};
+
+    //FUNCTIONS//////////////////////////////////////////////////////////////////////////
+    void BuildSection(ChunkMeshBuilder& builder, const ChunkMeshSnapshot& snapshot, int meshSection);
+    bool Find(unsigned long long key, ChunkMeshBuilder& out_builder);
+    void Add(unsigned long long key, const ChunkMeshBuilder& builder, double buildSeconds);
+    void SetBudget(size_t budgetBytes);
+    void Clear();
+    void ResetStats();
+
+    //QUERIES//////////////////////////////////////////////////////////////////////////
+    ChunkMeshCacheStats GetStats() const;
+    size_t GetNumBytes() const;
+    int GetNumEntries() const;
+    inline size_t GetBudget() const { return m_budgetBytes; };
+    static unsigned long long HashBytes(const void* data, size_t numBytes, unsigned long long hash);
+
+    //CONSTANTS//////////////////////////////////////////////////////////////////////////
+    static const size_t DEFAULT_BUDGET_BYTES = 32 * 1024 * 1024;
+
+private:
+    //-----------------------------------------------------------------------------------
+    struct Entry
+    {
+        unsigned long long m_key;
+        ChunkMeshBuilder m_builder;
+        size_t m_numBytes; //The buffers plus what the entry itself costs, so empty sections count for something.
+        double m_buildSeconds;
+    };
+
+    //FUNCTIONS//////////////////////////////////////////////////////////////////////////
+    void EvictToBudget();
+
+    //MEMBER VARIABLES//////////////////////////////////////////////////////////////////////////
+    mutable std::mutex m_lock; //Guards everything below.
+    std::list<Entry> m_entries; //Most recently used first.
+    std::unordered_map<unsigned long long, std::list<Entry>::iterator> m_entriesByKey;
+    std::atomic<size_t> m_budgetBytes; //Read without the lock to skip hashing when the cache is off.
+    size_t m_numBytes;
+    ChunkMeshCacheStats m_stats;
+};
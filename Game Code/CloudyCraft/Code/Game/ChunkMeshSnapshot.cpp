@@ -0,0 +1,144 @@
+#include "Game/ChunkMeshSnapshot.hpp"
+#include "Game/BlockInfo.hpp"
+#include "Game/ChunkMeshCache.hpp"
+#include <algorithm>
+
+//-----------------------------------------------------------------------------------
+ChunkMeshSnapshot::ChunkMeshSnapshot()
+    : m_chunkMins(WorldPosition(0.0f, 0.0f, 0.0f))
+    , m_version(0)
+    , m_meshSections(0)
+    , m_useSmoothLighting(false)
+    , m_useGreedyMeshing(false)
+    , m_useFaceMasks(false)
+{
+}
+
+//-----------------------------------------------------------------------------------
+//The block next to index in the same chunk, if there is one.
+static bool GetIndexInsideChunk(LocalIndex index, Direction direction, LocalIndex& out_neighborIndex)
+{
+    LocalCoords coords = Chunk::GetLocalCoordsFromBlockIndex(index);
+    switch (direction)
+    {
+    case ABOVE:
+        ++coords.z;
+        break;
+    case BELOW:
+        --coords.z;
+        break;
+    case NORTH:
+        ++coords.y;
+        break;
+    case SOUTH:
+        --coords.y;
+        break;
+    case EAST:
+        ++coords.x;
+        break;
+    case WEST:
+        --coords.x;
+        break;
+    default:
+        return false;
+    }
+    if (coords.x < 0 || coords.x >= Chunk::BLOCKS_WIDE_X || coords.y < 0 || coords.y >= Chunk::BLOCKS_WIDE_Y || coords.z < 0 || coords.z >= Chunk::BLOCKS_TALL_Z)
+    {
+        return false;
+    }
+    out_neighborIndex = static_cast<LocalIndex>((coords.z << Chunk::CHUNK_BITS_XY) + (coords.y << Chunk::CHUNK_BITS_X) + coords.x);
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//Main thread only; everything after this reads the copy. The layers from the bottom of the lowest section to the top
+//of the highest are copied, plus one more on either side for the faces and corners looking across.
+void ChunkMeshSnapshot::CopyFromChunk(Chunk* chunk, uchar meshSections)
+{
+    int lowestSection = 0;
+    int highestSection = Chunk::NUM_MESH_SECTIONS - 1;
+    while ((meshSections & BIT(lowestSection)) == 0 && lowestSection < highestSection)
+    {
+        ++lowestSection;
+    }
+    while ((meshSections & BIT(highestSection)) == 0 && highestSection > lowestSection)
+    {
+        --highestSection;
+    }
+    int firstZ = std::max((lowestSection << Chunk::CHUNK_BITS_MESH_SECTION_Z) - 1, 0);
+    int lastZ = std::min((highestSection + 1) << Chunk::CHUNK_BITS_MESH_SECTION_Z, Chunk::BLOCKS_TALL_Z - 1);
+    m_neighborhood.CopyFromChunk(chunk, firstZ, lastZ);
+    m_meshSections = meshSections;
+    m_chunkMins = chunk->m_bottomLeftCorner;
+    m_useSmoothLighting = Chunk::s_useSmoothLighting;
+    m_useGreedyMeshing = Chunk::s_useGreedyMeshing;
+    m_useFaceMasks = Chunk::s_useFaceMasks;
+
+    //A block with a portal on a face swaps itself out for whatever's on the other side when the block the face
+    //looks at asks for it. Portals are rare, so the answers are kept in a short list rather than a second copy.
+    m_portalNeighbors.clear();
+    for (int index = firstZ * Chunk::BLOCKS_PER_LAYER; index < (lastZ + 1) * Chunk::BLOCKS_PER_LAYER; ++index)
+    {
+        const Block* portalBlock = m_neighborhood.GetBlock(static_cast<LocalIndex>(index));
+        if (!portalBlock->IsPortal(NUM_DIRECTIONS))
+        {
+            continue;
+        }
+        for (int directionIndex = 0; directionIndex < NUM_DIRECTIONS; ++directionIndex)
+        {
+            Direction portalFace = static_cast<Direction>(directionIndex);
+            LocalIndex facingIndex = 0;
+            if (!portalBlock->IsPortal(portalFace) || !GetIndexInsideChunk(static_cast<LocalIndex>(index), portalFace, facingIndex))
+            {
+                continue;
+            }
+            Direction backDirection = static_cast<Direction>(portalFace ^ 1); //The enum pairs each direction with its opposite.
+            BlockInfo linkedInfo = BlockInfo(chunk, facingIndex).GetNeighbor(backDirection);
+            PortalNeighbor portalNeighbor;
+            portalNeighbor.m_index = facingIndex;
+            portalNeighbor.m_direction = backDirection;
+            portalNeighbor.m_isValid = linkedInfo.IsValid();
+            portalNeighbor.m_block = portalNeighbor.m_isValid ? *linkedInfo.GetBlock() : Block();
+            m_portalNeighbors.push_back(portalNeighbor);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//The neighbor the way BlockInfo finds it, following portals into the linked world.
+const Block* ChunkMeshSnapshot::GetNeighborThroughPortals(LocalIndex index, Direction direction) const
+{
+    for (const PortalNeighbor& portalNeighbor : m_portalNeighbors)
+    {
+        if (portalNeighbor.m_index == index && portalNeighbor.m_direction == direction)
+        {
+            return portalNeighbor.m_isValid ? &portalNeighbor.m_block : nullptr;
+        }
+    }
+    return m_neighborhood.GetNeighbor(index, direction);
+}
+
+//-----------------------------------------------------------------------------------
+//The mesh cache's key for one of the snapshot's sections: everything building it reads, and nothing it doesn't, so
+//an unchanged section hashes the same however many times it's snapshotted. Face masks are left out since they don't
+//change what gets built.
+unsigned long long ChunkMeshSnapshot::CalculateSectionKey(int meshSection) const
+{
+    int firstZ = meshSection << Chunk::CHUNK_BITS_MESH_SECTION_Z;
+    int endZ = firstZ + Chunk::BLOCKS_TALL_MESH_SECTION_Z;
+    float modesAndMins[4] = { m_chunkMins.x, m_chunkMins.y, m_useSmoothLighting ? 1.0f : 0.0f, m_useGreedyMeshing ? 1.0f : 0.0f };
+    unsigned long long hash = ChunkMeshCache::HashBytes(modesAndMins, sizeof(modesAndMins), static_cast<unsigned long long>(meshSection));
+    hash = m_neighborhood.HashLayers(firstZ - 1, endZ, hash);
+    for (const PortalNeighbor& portalNeighbor : m_portalNeighbors)
+    {
+        int z = portalNeighbor.m_index >> Chunk::CHUNK_BITS_XY;
+        if (z < firstZ || z >= endZ)
+        {
+            continue;
+        }
+        unsigned int portalFields[3] = { portalNeighbor.m_index, static_cast<unsigned int>(portalNeighbor.m_direction), portalNeighbor.m_isValid ? 1u : 0u };
+        hash = ChunkMeshCache::HashBytes(portalFields, sizeof(portalFields), hash);
+        hash = ChunkMeshCache::HashBytes(&portalNeighbor.m_block, sizeof(Block), hash);
+    }
+    return hash;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "Game/GameCommon.hpp"
+#include "Game/ChunkNeighborhood.hpp"
+#include <vector>
+
+//-----------------------------------------------------------------------------------
+//Everything the mesher reads to build some of one chunk's mesh sections, copied on the main thread so the build
+//itself can run anywhere: those layers of the chunk with a one block border from its neighbors and the layers on
+//either side, where the chunk sits, the mesh modes at the time, and the blocks the transparent pass sees through
+//portals, which can live in another world entirely.
+//Nothing in here points back at the chunk, so the chunk can be edited or even unloaded while a build reads it.
+//Each snapshot is stamped with the version of the chunk it copied; once it's handed to a worker the main thread
+//doesn't write to it again until the job comes back, so workers read it without taking any locks.
+class ChunkMeshSnapshot
+{
+public:
+    //CONSTRUCTORS//////////////////////////////////////////////////////////////////////////
+    ChunkMeshSnapshot();
+    ~ChunkMeshSnapshot() {};
+
+    //FUNCTIONS//////////////////////////////////////////////////////////////////////////
+    void CopyFromChunk(Chunk* chunk, uchar meshSections);
+
+    //QUERIES//////////////////////////////////////////////////////////////////////////
+    inline const Block* GetBlock(LocalIndex index) const { return m_neighborhood.GetBlock(index); };
+    inline const Block* GetNeighbor(LocalIndex index, Direction direction) const { return m_neighborhood.GetNeighbor(index, direction); };
+    const Block* GetNeighborThroughPortals(LocalIndex index, Direction direction) const;
+    inline WorldPosition GetWorldMinsForBlockIndex(LocalIndex index) const;
+    inline const ChunkNeighborhood* GetSmoothLightingNeighborhood() const { return m_useSmoothLighting ? &m_neighborhood : nullptr; };
+    inline void CalculateOpaqueFaces(int firstZ, int endZ, uchar* out_faceMasks) const { m_neighborhood.CalculateOpaqueFaces(firstZ, endZ, out_faceMasks); };
+    unsigned long long CalculateSectionKey(int meshSection) const;
+
+    //MEMBER VARIABLES//////////////////////////////////////////////////////////////////////////
+    WorldPosition m_chunkMins;
+    unsigned int m_version;
+    uchar m_meshSections; //Which of the chunk's mesh sections this has what it takes to build.
+    bool m_useSmoothLighting;
+    bool m_useGreedyMeshing;
+    bool m_useFaceMasks;
+
+private:
+    //-----------------------------------------------------------------------------------
+    //What BlockInfo hands back for the block next to m_index when the block it'd normally get has a portal facing
+    //it. Only happens inside the chunk, same as BlockInfo.
+    struct PortalNeighbor
+    {
+        LocalIndex m_index;
+        Direction m_direction;
+        bool m_isValid;
+        Block m_block;
+    };
+
+    //MEMBER VARIABLES//////////////////////////////////////////////////////////////////////////
+    ChunkNeighborhood m_neighborhood;
+    std::vector<PortalNeighbor> m_portalNeighbors;
+};
+
+//-----------------------------------------------------------------------------------
+inline WorldPosition ChunkMeshSnapshot::GetWorldMinsForBlockIndex(LocalIndex index) const
+{
+    LocalCoords coords = Chunk::GetLocalCoordsFromBlockIndex(index);
+    return WorldPosition((float)coords.x + m_chunkMins.x, (float)coords.y + m_chunkMins.y, (float)coords.z);
+}
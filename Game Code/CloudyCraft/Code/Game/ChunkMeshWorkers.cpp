@@ -0,0 +1,515 @@
+#include "Game/ChunkMeshWorkers.hpp"
+#include "Game/ChunkMeshCache.hpp"
+#include "Game/Chunk.hpp"
+#include "Game/TheGame.hpp"
+#include "Game/World.hpp"
+#include "Game/Generator.hpp"
+#include "Game/BlockDefinition.h"
+#include "Game/BlockInfo.hpp"
+#include "Game/LightingEngine.hpp"
+#include "Engine/Input/Console.hpp"
+#include "Engine/Time/Time.hpp"
+#include <algorithm>
+#include <map>
+#include <string.h>
+
+double ChunkMeshWorkers::s_frameBudgetSeconds = 0.001;
+bool ChunkMeshWorkers::s_useWorkers = true;
+
+//-----------------------------------------------------------------------------------
+ChunkMeshWorkers::ChunkMeshWorkers(int numThreads, ChunkMeshCache* meshCache)
+    : m_isShuttingDown(false)
+    , m_meshCache(meshCache)
+{
+    ResetStats();
+    for (int i = 0; i < numThreads * JOBS_PER_THREAD; ++i)
+    {
+        ChunkMeshJob* job = new ChunkMeshJob();
+        m_allJobs.push_back(job);
+        m_freeJobs.push_back(job);
+    }
+    for (int i = 0; i < numThreads; ++i)
+    {
+        m_threads.push_back(std::thread(&ChunkMeshWorkers::WorkerThreadMain, this));
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//Jobs still queued or finished are thrown away; the chunks they were for are going away too.
+ChunkMeshWorkers::~ChunkMeshWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_isShuttingDown = true;
+    }
+    m_jobQueued.notify_all();
+    for (std::thread& thread : m_threads)
+    {
+        thread.join();
+    }
+    for (ChunkMeshJob* job : m_allJobs)
+    {
+        delete job;
+    }
+}
+
+//-----------------------------------------------------------------------------------
+void ChunkMeshWorkers::WorkerThreadMain(ChunkMeshWorkers* workers)
+{
+    while (true)
+    {
+        ChunkMeshJob* job = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(workers->m_lock);
+            while (!workers->m_isShuttingDown && workers->m_queuedJobs.empty())
+            {
+                workers->m_jobQueued.wait(lock);
+            }
+            if (workers->m_isShuttingDown)
+            {
+                return;
+            }
+            job = workers->m_queuedJobs.front();
+            workers->m_queuedJobs.pop_front();
+        }
+
+        double startSeconds = GetCurrentTimeSeconds();
+        BuildSections(job->m_builders, job->m_snapshot, workers->m_meshCache);
+        job->m_buildSeconds = GetCurrentTimeSeconds() - startSeconds;
+
+        std::lock_guard<std::mutex> lock(workers->m_lock);
+        workers->m_finishedJobs.push_back(job);
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//Builds each of the snapshot's sections into the builder of the same index, or gets it from meshCache if there is one.
+//Safe on any thread.
+void ChunkMeshWorkers::BuildSections(ChunkMeshBuilder* builders, const ChunkMeshSnapshot& snapshot, ChunkMeshCache* meshCache)
+{
+    for (int meshSection = 0; meshSection < Chunk::NUM_MESH_SECTIONS; ++meshSection)
+    {
+        if ((snapshot.m_meshSections & BIT(meshSection)) == 0)
+        {
+            continue;
+        }
+        if (meshCache)
+        {
+            meshCache->BuildSection(builders[meshSection], snapshot, meshSection);
+        }
+        else
+        {
+            Chunk::BuildPackedMesh(builders[meshSection], snapshot, meshSection);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//A job to snapshot a chunk into, or null if they're all out.
+ChunkMeshJob* ChunkMeshWorkers::GetFreeJob()
+{
+    if (m_freeJobs.empty())
+    {
+        return nullptr;
+    }
+    ChunkMeshJob* job = m_freeJobs.back();
+    m_freeJobs.pop_back();
+    return job;
+}
+
+//-----------------------------------------------------------------------------------
+void ChunkMeshWorkers::Submit(ChunkMeshJob* job)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_queuedJobs.push_back(job);
+    }
+    m_jobQueued.notify_one();
+}
+
+//-----------------------------------------------------------------------------------
+//The oldest finished job submitted by this world, or null if none are done yet.
+ChunkMeshJob* ChunkMeshWorkers::TakeFinishedJob(World* world)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    for (auto iter = m_finishedJobs.begin(); iter != m_finishedJobs.end(); ++iter)
+    {
+        if ((*iter)->m_world == world)
+        {
+            ChunkMeshJob* job = *iter;
+            m_finishedJobs.erase(iter);
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+//-----------------------------------------------------------------------------------
+void ChunkMeshWorkers::ReturnJob(ChunkMeshJob* job)
+{
+    job->m_chunk = nullptr;
+    job->m_world = nullptr;
+    m_freeJobs.push_back(job);
+}
+
+//-----------------------------------------------------------------------------------
+//Called before a chunk is deleted. Its jobs still run, but whoever takes them back finds no chunk to upload to.
+void ChunkMeshWorkers::CancelJobsForChunk(Chunk* chunk)
+{
+    for (ChunkMeshJob* job : m_allJobs)
+    {
+        if (job->m_chunk == chunk)
+        {
+            job->m_chunk = nullptr;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------------
+void ChunkMeshWorkers::RecordMeshShown(double timeDirtied, double buildSeconds)
+{
+    double latencySeconds = GetCurrentTimeSeconds() - timeDirtied;
+    ++m_stats.m_numMeshesShown;
+    m_stats.m_totalLatencySeconds += latencySeconds;
+    m_stats.m_maxLatencySeconds = std::max(m_stats.m_maxLatencySeconds, latencySeconds);
+    m_stats.m_totalBuildSeconds += buildSeconds;
+}
+
+//-----------------------------------------------------------------------------------
+void ChunkMeshWorkers::RecordSectionUploaded(const ChunkMeshBuilder& builder)
+{
+    ++m_stats.m_numSectionsUploaded;
+    m_stats.m_numBytesUploaded += (builder.GetNumVerts() * sizeof(Vertex_PCTTD)) + (builder.GetNumIndices() * sizeof(unsigned int));
+}
+
+//-----------------------------------------------------------------------------------
+//A finished mesh that never got shown, because its chunk was flushed or a newer mesh beat it there.
+void ChunkMeshWorkers::RecordMeshDropped()
+{
+    ++m_stats.m_numMeshesDropped;
+}
+
+//-----------------------------------------------------------------------------------
+void ChunkMeshWorkers::RecordMainThreadTime(double seconds)
+{
+    ++m_stats.m_numMainThreadUpdates;
+    m_stats.m_totalMainThreadSeconds += seconds;
+    m_stats.m_maxMainThreadSeconds = std::max(m_stats.m_maxMainThreadSeconds, seconds);
+}
+
+//-----------------------------------------------------------------------------------
+void ChunkMeshWorkers::ResetStats()
+{
+    memset(&m_stats, 0, sizeof(m_stats));
+}
+
+//-----------------------------------------------------------------------------------
+CONSOLE_COMMAND(meshworkers)
+{
+    if (!args.HasArgs(1))
+    {
+        Console::instance->PrintLine(Stringf("meshworkers <0|1> (currently %i)", ChunkMeshWorkers::s_useWorkers ? 1 : 0), RGBA::GRAY);
+        return;
+    }
+    ChunkMeshWorkers::s_useWorkers = args.GetIntArgument(0) != 0;
+    TheGame::instance->m_meshWorkers->ResetStats();
+}
+
+//-----------------------------------------------------------------------------------
+CONSOLE_COMMAND(meshbudget)
+{
+    if (!args.HasArgs(1))
+    {
+        Console::instance->PrintLine(Stringf("meshbudget <microseconds per world per frame, 0 for unlimited> (currently %i)", static_cast<int>(ChunkMeshWorkers::s_frameBudgetSeconds * 1000000.0)), RGBA::GRAY);
+        return;
+    }
+    int budgetMicroseconds = args.GetIntArgument(0);
+    ChunkMeshWorkers::s_frameBudgetSeconds = (budgetMicroseconds > 0) ? budgetMicroseconds / 1000000.0 : 0.0;
+}
+
+//-----------------------------------------------------------------------------------
+//Prints the meshing stats gathered since the last reset, then resets them so the next call covers a fresh stretch.
+CONSOLE_COMMAND(meshstats)
+{
+    ChunkMeshWorkers* meshWorkers = TheGame::instance->m_meshWorkers;
+    const ChunkMeshStats& stats = meshWorkers->GetStats();
+    int numShown = std::max(stats.m_numMeshesShown, 1);
+    int numUpdates = std::max(stats.m_numMainThreadUpdates, 1);
+    if (ChunkMeshWorkers::s_useWorkers)
+    {
+        Console::instance->PrintLine(Stringf("%i worker threads, %i jobs out", meshWorkers->GetNumThreads(), meshWorkers->GetNumJobsOut()), RGBA::GRAY);
+    }
+    else
+    {
+        Console::instance->PrintLine("Workers off, building one mesh per world per frame on the main thread", RGBA::GRAY);
+    }
+    Console::instance->PrintLine(Stringf("%-24s %i shown, %i dropped", "Meshes", stats.m_numMeshesShown, stats.m_numMeshesDropped), RGBA::WHITE);
+    Console::instance->PrintLine(Stringf("%-24s %.02f ms avg, %.02f ms max", "Dirty to shown", stats.m_totalLatencySeconds * 1000.0 / numShown, stats.m_maxLatencySeconds * 1000.0), RGBA::WHITE);
+    Console::instance->PrintLine(Stringf("%-24s %.03f ms avg", "Build", stats.m_totalBuildSeconds * 1000.0 / numShown), RGBA::WHITE);
+    if (ChunkMeshWorkers::s_useWorkers)
+    {
+        Console::instance->PrintLine(Stringf("%-24s %.02f sections, %.01f KB avg", "Uploaded per mesh", (double)stats.m_numSectionsUploaded / numShown, stats.m_numBytesUploaded / 1024.0 / numShown), RGBA::WHITE);
+    }
+    Console::instance->PrintLine(Stringf("%-24s %.03f ms avg, %.03f ms max per world per frame", "Main thread", stats.m_totalMainThreadSeconds * 1000.0 / numUpdates, stats.m_maxMainThreadSeconds * 1000.0), RGBA::WHITE);
+    meshWorkers->ResetStats();
+}
+
+//-----------------------------------------------------------------------------------
+static unsigned int NextMeshStressRandom(unsigned int& seed)
+{
+    seed = seed * 1664525u + 1013904223u;
+    return seed >> 16;
+}
+
+//-----------------------------------------------------------------------------------
+//FNV-1a over the vertices of each section the snapshot covers, opaque then translucent; the indices follow from the
+//vertex counts.
+static unsigned int HashMesh(const ChunkMeshBuilder* builders, uchar meshSections)
+{
+    unsigned int hash = 2166136261u;
+    for (int meshSection = 0; meshSection < Chunk::NUM_MESH_SECTIONS; ++meshSection)
+    {
+        if ((meshSections & BIT(meshSection)) == 0)
+        {
+            continue;
+        }
+        for (int bucket = 0; bucket < ChunkMeshBuilder::NUM_BUCKETS; ++bucket)
+        {
+            const std::vector<Vertex_PCTTD>& vertices = builders[meshSection].GetVertices(static_cast<ChunkMeshBuilder::Bucket>(bucket));
+            const unsigned char* bytes = reinterpret_cast<const unsigned char*>(vertices.data());
+            size_t numBytes = vertices.size() * sizeof(Vertex_PCTTD);
+            for (size_t i = 0; i < numBytes; ++i)
+            {
+                hash = (hash ^ bytes[i]) * 16777619u;
+            }
+        }
+        hash = (hash ^ builders[meshSection].GetNumIndices()) * 16777619u;
+    }
+    return hash;
+}
+
+//-----------------------------------------------------------------------------------
+//Changes the type or the light of one block near the surface. Blocks in the outer chunks are only picked from the
+//columns touching the middle chunk, since those are the only ones its snapshot copies.
+static void EditBlockForMeshStress(const std::vector<Chunk*>& chunks, int gridSize, unsigned int& seed)
+{
+    const int NUM_STRESS_BLOCK_TYPES = 7;
+    const uchar STRESS_BLOCK_TYPES[NUM_STRESS_BLOCK_TYPES] = { BlockType::AIR, BlockType::STONE, BlockType::DIRT, BlockType::WATER, BlockType::GLOWSTONE, BlockType::RED_GLASS, BlockType::CYAN_GLASS };
+    int gridX = NextMeshStressRandom(seed) % gridSize;
+    int gridY = NextMeshStressRandom(seed) % gridSize;
+    int x = (gridX == 0) ? Chunk::BLOCKS_WIDE_X - 1 : ((gridX == gridSize - 1 && gridSize > 1) ? 0 : NextMeshStressRandom(seed) % Chunk::BLOCKS_WIDE_X);
+    int y = (gridY == 0) ? Chunk::BLOCKS_WIDE_Y - 1 : ((gridY == gridSize - 1 && gridSize > 1) ? 0 : NextMeshStressRandom(seed) % Chunk::BLOCKS_WIDE_Y);
+    Chunk* chunk = chunks[gridY * gridSize + gridX];
+    LocalIndex columnIndex = static_cast<LocalIndex>((y << Chunk::CHUNK_BITS_X) + x);
+    int z = chunk->GetHeight(columnIndex) - 4 + static_cast<int>(NextMeshStressRandom(seed) % 8);
+    z = (z < 0) ? 0 : ((z >= Chunk::BLOCKS_TALL_Z) ? Chunk::BLOCKS_TALL_Z - 1 : z);
+    Block* block = chunk->GetBlock(static_cast<LocalIndex>((z << Chunk::CHUNK_BITS_XY) + columnIndex));
+    if (NextMeshStressRandom(seed) % 2 == 0)
+    {
+        block->m_type = STRESS_BLOCK_TYPES[NextMeshStressRandom(seed) % NUM_STRESS_BLOCK_TYPES];
+    }
+    else
+    {
+        unsigned int light = NextMeshStressRandom(seed);
+        block->SetPackedLight(PackLight(static_cast<uchar>(light), static_cast<uchar>(light >> 4), static_cast<uchar>(light >> 8)));
+        block->SetPackedSkyLight(PackLight(static_cast<uchar>(light >> 2), static_cast<uchar>(light >> 6), static_cast<uchar>(light >> 10)));
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//Checks every job the stress test's workers have finished against the mesh the main thread built from the same
+//snapshot before handing it over.
+static void CheckFinishedMeshStressJobs(ChunkMeshWorkers& workers, std::map<ChunkMeshJob*, unsigned int>& expectedHashes, int& numMismatches, double& buildSeconds)
+{
+    //The stress test has workers of its own, so none of its jobs belong to a world.
+    ChunkMeshJob* job = workers.TakeFinishedJob(nullptr);
+    while (job)
+    {
+        unsigned int hash = HashMesh(job->m_builders, job->m_snapshot.m_meshSections);
+        if (hash != expectedHashes[job])
+        {
+            Console::instance->PrintLine(Stringf("Version %u: worker built a different mesh for sections 0x%02x", job->m_snapshot.m_version, job->m_snapshot.m_meshSections), RGBA::RED);
+            ++numMismatches;
+        }
+        buildSeconds += job->m_buildSeconds;
+        expectedHashes.erase(job);
+        workers.ReturnJob(job);
+        job = workers.TakeFinishedJob(nullptr);
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//Meshes a chunk on worker threads while the main thread keeps editing it and its neighbors, flipping the mesh modes
+//and which sections get rebuilt between snapshots, then unloads the chunks while the last builds are still running. Every worker mesh has to match
+//the one built on the main thread from the same snapshot before any of the edits after it.
+CONSOLE_COMMAND(meshstress)
+{
+    const int GRID_SIZE = 3;
+    bool hasSeed = args.HasArgs(2) || args.HasArgs(3);
+    int numSnapshots = (hasSeed || args.HasArgs(1)) ? args.GetIntArgument(0) : 200;
+    unsigned int seed = hasSeed ? static_cast<unsigned int>(args.GetIntArgument(1)) : 12345;
+    int editsPerSnapshot = args.HasArgs(3) ? args.GetIntArgument(2) : 20;
+    if (numSnapshots <= 0 || editsPerSnapshot < 0)
+    {
+        Console::instance->PrintLine("meshstress <# of snapshots> <seed> <edits between snapshots>", RGBA::GRAY);
+        return;
+    }
+    World* world = TheGame::instance->m_worlds[TheGame::instance->m_currentlyRenderedWorldID];
+    bool wasUsingSmoothLighting = Chunk::s_useSmoothLighting;
+    bool wasUsingGreedyMeshing = Chunk::s_useGreedyMeshing;
+
+    DetachedChunkFactory detachedChunks(world);
+    std::vector<Chunk*> chunks = detachedChunks.CreateGrid(GRID_SIZE);
+    Chunk* middleChunk = chunks[(GRID_SIZE / 2) * GRID_SIZE + (GRID_SIZE / 2)];
+
+    ChunkMeshWorkers workers(TheGame::instance->m_meshWorkers->GetNumThreads());
+    std::map<ChunkMeshJob*, unsigned int> expectedHashes;
+    ChunkMeshBuilder expectedBuilders[Chunk::NUM_MESH_SECTIONS];
+    std::map<uchar, unsigned int> lastExpectedHashes; //By which sections were built, to tell whether the edits showed.
+    int numChangedMeshes = 0;
+    int numMismatches = 0;
+    double snapshotSeconds = 0.0;
+    double buildSeconds = 0.0;
+    for (int snapshotNumber = 0; snapshotNumber < numSnapshots; ++snapshotNumber)
+    {
+        ChunkMeshJob* job = workers.GetFreeJob();
+        while (!job)
+        {
+            std::this_thread::yield();
+            CheckFinishedMeshStressJobs(workers, expectedHashes, numMismatches, buildSeconds);
+            job = workers.GetFreeJob();
+        }
+
+        //The modes change between snapshots too; a build has to use the ones its snapshot was taken in.
+        Chunk::s_useSmoothLighting = NextMeshStressRandom(seed) % 2 == 0;
+        Chunk::s_useGreedyMeshing = NextMeshStressRandom(seed) % 2 == 0;
+        uchar meshSections = static_cast<uchar>(NextMeshStressRandom(seed));
+        middleChunk->DirtyAndAddToDirtyList((meshSections != 0) ? meshSections : Chunk::ALL_MESH_SECTIONS);
+        double startSeconds = GetCurrentTimeSeconds();
+        middleChunk->TakeMeshSnapshot(job->m_snapshot);
+        snapshotSeconds += GetCurrentTimeSeconds() - startSeconds;
+        middleChunk->m_isDirty = true;
+        ChunkMeshWorkers::BuildSections(expectedBuilders, job->m_snapshot);
+        unsigned int expectedHash = HashMesh(expectedBuilders, job->m_snapshot.m_meshSections);
+        auto lastExpectedHash = lastExpectedHashes.find(job->m_snapshot.m_meshSections);
+        numChangedMeshes += (lastExpectedHash != lastExpectedHashes.end() && lastExpectedHash->second != expectedHash) ? 1 : 0;
+        lastExpectedHashes[job->m_snapshot.m_meshSections] = expectedHash;
+        expectedHashes[job] = expectedHash;
+        workers.Submit(job);
+
+        for (int editNumber = 0; editNumber < editsPerSnapshot; ++editNumber)
+        {
+            EditBlockForMeshStress(chunks, GRID_SIZE, seed);
+        }
+        CheckFinishedMeshStressJobs(workers, expectedHashes, numMismatches, buildSeconds);
+    }
+
+    //Nothing the workers are still reading points back into the chunks.
+    for (Chunk* chunk : chunks)
+    {
+        delete chunk;
+    }
+    while (!expectedHashes.empty())
+    {
+        std::this_thread::yield();
+        CheckFinishedMeshStressJobs(workers, expectedHashes, numMismatches, buildSeconds);
+    }
+    Chunk::s_useSmoothLighting = wasUsingSmoothLighting;
+    Chunk::s_useGreedyMeshing = wasUsingGreedyMeshing;
+
+    Console::instance->PrintLine(Stringf("%i snapshots, %i edits between each, %i worker threads, %i snapshots changed the mesh", numSnapshots, editsPerSnapshot, workers.GetNumThreads(), numChangedMeshes), RGBA::GRAY);
+    Console::instance->PrintLine(Stringf("%-24s %.03f ms avg", "Snapshot", snapshotSeconds * 1000.0 / numSnapshots), RGBA::WHITE);
+    Console::instance->PrintLine(Stringf("%-24s %.03f ms avg", "Worker build", buildSeconds * 1000.0 / numSnapshots), RGBA::WHITE);
+    Console::instance->PrintLine(Stringf("%s: %i mismatched meshes", numMismatches == 0 ? "PASS" : "FAIL", numMismatches), numMismatches == 0 ? RGBA::WHITE : RGBA::RED);
+}
+
+//-----------------------------------------------------------------------------------
+//What sectionbench measures for one way of dirtying, summed over all the edits.
+struct SectionBenchResult
+{
+    double m_seconds;
+    int m_numChunksRebuilt;
+    int m_numSectionsRebuilt;
+    double m_numBytes;
+};
+
+//-----------------------------------------------------------------------------------
+//Digs or places blocks near the surface of the middle chunk, edges included, dirtying what the lighting would for
+//each, then snapshots and rebuilds whatever got dirtied on the spot.
+static void RunSectionBench(World* world, int numEdits, unsigned int seed, SectionBenchResult& out_result)
+{
+    const int GRID_SIZE = 3;
+    DetachedChunkFactory detachedChunks(world);
+    std::vector<Chunk*> chunks = detachedChunks.CreateGrid(GRID_SIZE);
+    Chunk* middleChunk = chunks[(GRID_SIZE / 2) * GRID_SIZE + (GRID_SIZE / 2)];
+    ChunkMeshSnapshot* snapshot = new ChunkMeshSnapshot();
+    ChunkMeshBuilder builders[Chunk::NUM_MESH_SECTIONS];
+    memset(&out_result, 0, sizeof(out_result));
+    for (int editNumber = 0; editNumber < numEdits; ++editNumber)
+    {
+        LocalIndex columnIndex = static_cast<LocalIndex>(NextMeshStressRandom(seed) % Chunk::BLOCKS_PER_LAYER);
+        int z = middleChunk->GetHeight(columnIndex) - 1 + static_cast<int>(NextMeshStressRandom(seed) % 2);
+        z = (z < 0) ? 0 : ((z >= Chunk::BLOCKS_TALL_Z) ? Chunk::BLOCKS_TALL_Z - 1 : z);
+        BlockInfo info(middleChunk, static_cast<LocalIndex>((z << Chunk::CHUNK_BITS_XY) + columnIndex));
+        info.GetBlock()->m_type = info.GetBlock()->GetDefinition()->m_isOpaque ? static_cast<uchar>(BlockType::AIR) : static_cast<uchar>(BlockType::STONE);
+
+        double startSeconds = GetCurrentTimeSeconds();
+        LightingEngine::DirtyChunksShowingBlock(info);
+        for (Chunk* chunk : chunks)
+        {
+            if (!chunk->HasDirtyMeshSections())
+            {
+                continue;
+            }
+            chunk->TakeMeshSnapshot(*snapshot);
+            chunk->m_isDirty = true;
+            ChunkMeshWorkers::BuildSections(builders, *snapshot);
+            ++out_result.m_numChunksRebuilt;
+            for (int meshSection = 0; meshSection < Chunk::NUM_MESH_SECTIONS; ++meshSection)
+            {
+                if ((snapshot->m_meshSections & BIT(meshSection)) != 0)
+                {
+                    ++out_result.m_numSectionsRebuilt;
+                    out_result.m_numBytes += (builders[meshSection].GetNumVerts() * sizeof(Vertex_PCTTD)) + (builders[meshSection].GetNumIndices() * sizeof(unsigned int));
+                }
+            }
+        }
+        out_result.m_seconds += GetCurrentTimeSeconds() - startSeconds;
+    }
+    delete snapshot;
+    for (Chunk* chunk : chunks)
+    {
+        delete chunk;
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//Makes the same # edits to a fresh patch of chunks twice, once rebuilding whole chunks and once rebuilding only the
+//sections each edit touches, and compares the snapshot and build time and the bytes that would be uploaded per edit.
+//That's the part of an edit's time to show up that depends on how much gets rebuilt; meshstats measures the rest.
+CONSOLE_COMMAND(sectionbench)
+{
+    int numEdits = (args.HasArgs(1) || args.HasArgs(2)) ? args.GetIntArgument(0) : 200;
+    unsigned int seed = args.HasArgs(2) ? static_cast<unsigned int>(args.GetIntArgument(1)) : 12345;
+    if (numEdits <= 0)
+    {
+        Console::instance->PrintLine("sectionbench <# of edits> <seed>", RGBA::GRAY);
+        return;
+    }
+    World* world = TheGame::instance->m_worlds[TheGame::instance->m_currentlyRenderedWorldID];
+    bool wasUsingMeshSections = Chunk::s_useMeshSections;
+    SectionBenchResult results[2];
+    const char* MODE_NAMES[2] = { "Whole chunks", "Sections" };
+    for (int mode = 0; mode < 2; ++mode)
+    {
+        Chunk::s_useMeshSections = (mode == 1);
+        RunSectionBench(world, numEdits, seed, results[mode]);
+        const SectionBenchResult& result = results[mode];
+        Console::instance->PrintLine(Stringf("%-24s %.03f ms, %.02f chunks, %.02f sections, %.01f KB per edit", MODE_NAMES[mode], result.m_seconds * 1000.0 / numEdits,
+            (double)result.m_numChunksRebuilt / numEdits, (double)result.m_numSectionsRebuilt / numEdits, result.m_numBytes / 1024.0 / numEdits), RGBA::WHITE);
+    }
+    Chunk::s_useMeshSections = wasUsingMeshSections;
+    double timeRatio = results[1].m_seconds / (results[0].m_seconds > 0.0 ? results[0].m_seconds : 1.0);
+    double byteRatio = results[1].m_numBytes / (results[0].m_numBytes > 0.0 ? results[0].m_numBytes : 1.0);
+    Console::instance->PrintLine(Stringf("Sections take %.02fx as long and upload %.01f%% of the bytes", timeRatio, byteRatio * 100.0), RGBA::WHITE);
+}
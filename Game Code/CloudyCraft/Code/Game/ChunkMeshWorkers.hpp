@@ -0,0 +1,100 @@
+#pragma once
+#include "Game/GameCommon.hpp"
+#include "Game/ChunkMeshSnapshot.hpp"
+#include "Game/ChunkMeshBuilder.hpp"
+#include "Game/Chunk.hpp"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class World;
+class ChunkMeshCache;
+
+//-----------------------------------------------------------------------------------
+//One chunk's trip through the mesh workers: the snapshot the main thread took of it, then the meshes a worker built
+//for the sections the snapshot covers. Builders for the other sections are left as they were.
+struct ChunkMeshJob
+{
+    ChunkMeshJob() : m_chunk(nullptr), m_world(nullptr), m_timeDirtied(0.0), m_buildSeconds(0.0) {};
+
+    Chunk* m_chunk; //Main thread only. Cleared if the chunk gets flushed while the job is out.
+    World* m_world;
+    double m_timeDirtied;
+    double m_buildSeconds;
+    ChunkMeshSnapshot m_snapshot;
+    ChunkMeshBuilder m_builders[Chunk::NUM_MESH_SECTIONS];
+};
+
+//-----------------------------------------------------------------------------------
+//What meshing has cost since the stats were last reset. Latency runs from a chunk getting dirty to its new mesh
+//showing; main thread time is everything UpdateVertexArrays spends, per world per frame. Bytes are vertices plus
+//indices handed to the GPU.
+struct ChunkMeshStats
+{
+    int m_numMeshesShown;
+    int m_numMeshesDropped;
+    int m_numSectionsUploaded;
+    double m_numBytesUploaded;
+    double m_totalLatencySeconds;
+    double m_maxLatencySeconds;
+    double m_totalBuildSeconds;
+    int m_numMainThreadUpdates;
+    double m_totalMainThreadSeconds;
+    double m_maxMainThreadSeconds;
+};
+
+//-----------------------------------------------------------------------------------
+//Builds chunk meshes on worker threads. The main thread snapshots a dirty chunk into a free job and submits it; a
+//worker builds the snapshot into the job's own ChunkMeshBuilder; the main thread takes the finished job back,
+//uploads it and hands the job back for reuse. Only the upload touches GL, so only it stays on the main thread.
+//There are a fixed number of jobs, so snapshots are only taken when a worker will get to them soon, and the job
+//buffers are reused instead of reallocated every build.
+class ChunkMeshWorkers
+{
+public:
+    //CONSTRUCTORS//////////////////////////////////////////////////////////////////////////
+    ChunkMeshWorkers(int numThreads, ChunkMeshCache* meshCache = nullptr);
+    ~ChunkMeshWorkers();
+
+    //FUNCTIONS//////////////////////////////////////////////////////////////////////////
+    ChunkMeshJob* GetFreeJob();
+    void Submit(ChunkMeshJob* job);
+    ChunkMeshJob* TakeFinishedJob(World* world);
+    void ReturnJob(ChunkMeshJob* job);
+    void CancelJobsForChunk(Chunk* chunk);
+    void RecordMeshShown(double timeDirtied, double buildSeconds);
+    void RecordSectionUploaded(const ChunkMeshBuilder& builder);
+    void RecordMeshDropped();
+    void RecordMainThreadTime(double seconds);
+    void ResetStats();
+
+    //QUERIES//////////////////////////////////////////////////////////////////////////
+    inline int GetNumThreads() const { return m_threads.size(); };
+    inline int GetNumJobsOut() const { return m_allJobs.size() - m_freeJobs.size(); };
+    inline const ChunkMeshStats& GetStats() const { return m_stats; };
+
+    static void BuildSections(ChunkMeshBuilder* builders, const ChunkMeshSnapshot& snapshot, ChunkMeshCache* meshCache = nullptr);
+
+    //CONSTANTS//////////////////////////////////////////////////////////////////////////
+    static const int JOBS_PER_THREAD = 2;
+    static double s_frameBudgetSeconds;
+    static bool s_useWorkers;
+
+private:
+    //FUNCTIONS//////////////////////////////////////////////////////////////////////////
+    static void WorkerThreadMain(ChunkMeshWorkers* workers);
+
+    //MEMBER VARIABLES//////////////////////////////////////////////////////////////////////////
+    std::mutex m_lock; //Guards the two queues and m_isShuttingDown.
+    std::condition_variable m_jobQueued;
+    std::deque<ChunkMeshJob*> m_queuedJobs;
+    std::deque<ChunkMeshJob*> m_finishedJobs;
+    bool m_isShuttingDown;
+    std::vector<ChunkMeshJob*> m_allJobs;
+    std::vector<ChunkMeshJob*> m_freeJobs; //Main thread only, like everything below.
+    std::vector<std::thread> m_threads;
+    ChunkMeshCache* m_meshCache; //Shared with the main thread; null to build every section.
+    ChunkMeshStats m_stats;
+};
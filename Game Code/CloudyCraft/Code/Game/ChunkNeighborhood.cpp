@@ -0,0 +1,342 @@
+#include "Game/ChunkNeighborhood.hpp"
+#include "Game/ChunkMeshCache.hpp"
+#include "Game/BlockDefinition.h"
+#include "Game/LightingEngine.hpp"
+#include <string.h>
+
+//How much darker a corner gets with 0 through 3 opaque blocks crowding it. Applied like the per-face damping,
+//as a subtraction from both glow and sky light, so it works the same whatever the sky is.
+static const uchar AMBIENT_OCCLUSION_DAMPING[4] = { 0x00, 0x1C, 0x38, 0x54 };
+
+//Where the flags sit in each byte of m_flags, for pulling one of them out of a whole row at once.
+static const int OPAQUE_FLAG_SHIFT = 0;
+static const int MISSING_FLAG_SHIFT = 1;
+static const int PORTAL_FLAG_SHIFT = 2;
+
+//-----------------------------------------------------------------------------------
+static Block GetEmptyAirBlock()
+{
+    Block airBlock(BlockType::AIR);
+    airBlock.m_portalFlags = 0x00;
+    return airBlock;
+}
+
+//-----------------------------------------------------------------------------------
+//Whichever chunk is dx, dy chunks over, either way around the corner for the diagonals.
+static Chunk* GetNearbyChunk(Chunk* chunk, int dx, int dy)
+{
+    Chunk* eastOrWest = (dx > 0) ? chunk->m_eastChunk : ((dx < 0) ? chunk->m_westChunk : chunk);
+    Chunk* northOrSouth = (dy > 0) ? chunk->m_northChunk : ((dy < 0) ? chunk->m_southChunk : chunk);
+    if (dx == 0)
+    {
+        return northOrSouth;
+    }
+    if (dy == 0)
+    {
+        return eastOrWest;
+    }
+    if (eastOrWest)
+    {
+        Chunk* diagonal = (dy > 0) ? eastOrWest->m_northChunk : eastOrWest->m_southChunk;
+        if (diagonal)
+        {
+            return diagonal;
+        }
+    }
+    if (northOrSouth)
+    {
+        return (dx > 0) ? northOrSouth->m_eastChunk : northOrSouth->m_westChunk;
+    }
+    return nullptr;
+}
+
+//-----------------------------------------------------------------------------------
+//Only layers firstZ through lastZ of the chunk and its border are copied; the rest is left as it was.
+void ChunkNeighborhood::CopyFromChunk(Chunk* chunk, int firstZ, int lastZ)
+{
+    //The chunk itself, a row of 16 blocks at a time.
+    for (int z = firstZ; z <= lastZ; ++z)
+    {
+        for (int y = 0; y < Chunk::BLOCKS_WIDE_Y; ++y)
+        {
+            LocalIndex rowIndex = (z << Chunk::CHUNK_BITS_XY) + (y << Chunk::CHUNK_BITS_X);
+            memcpy(&m_blocks[GetPaddedIndex(rowIndex)], chunk->GetBlock(rowIndex), Chunk::BLOCKS_WIDE_X * sizeof(Block));
+            memset(&m_flags[GetPaddedIndex(rowIndex)], 0x00, Chunk::BLOCKS_WIDE_X);
+        }
+    }
+
+    //The ring of columns around it.
+    for (int paddedY = 0; paddedY < PADDED_WIDE_Y; ++paddedY)
+    {
+        for (int paddedX = 0; paddedX < PADDED_WIDE_X; ++paddedX)
+        {
+            int x = paddedX - 1;
+            int y = paddedY - 1;
+            bool isInsideX = x >= 0 && x < Chunk::BLOCKS_WIDE_X;
+            bool isInsideY = y >= 0 && y < Chunk::BLOCKS_WIDE_Y;
+            if (isInsideX && isInsideY)
+            {
+                continue;
+            }
+            int dx = isInsideX ? 0 : ((x < 0) ? -1 : 1);
+            int dy = isInsideY ? 0 : ((y < 0) ? -1 : 1);
+            CopyBorderColumn(GetNearbyChunk(chunk, dx, dy), x & Chunk::LOCAL_X_MASK, y & (Chunk::BLOCKS_WIDE_Y - 1), paddedX, paddedY, firstZ, lastZ);
+        }
+    }
+
+    //Opacity and portals for every copied block; missing blocks were flagged as they were copied.
+    for (int paddedIndex = (firstZ + 1) * PADDED_BLOCKS_PER_LAYER; paddedIndex < (lastZ + 2) * PADDED_BLOCKS_PER_LAYER; ++paddedIndex)
+    {
+        if (m_flags[paddedIndex] != MISSING_FLAG)
+        {
+            const Block& block = m_blocks[paddedIndex];
+            m_flags[paddedIndex] = (block.GetDefinition()->m_isOpaque ? OPAQUE_FLAG : 0x00) | (block.m_portalFlags != 0x00 ? PORTAL_FLAG : 0x00);
+        }
+    }
+
+    //Nothing under the world, and open sky over it.
+    Block emptyBlock = GetEmptyAirBlock();
+    Block skyBlock = GetEmptyAirBlock();
+    skyBlock.SetPackedSkyLight(PackLight(LightingEngine::FULL_SKY_LIGHT, LightingEngine::FULL_SKY_LIGHT, LightingEngine::FULL_SKY_LIGHT));
+    const int TOP_LAYER_START = PADDED_BLOCKS - PADDED_BLOCKS_PER_LAYER;
+    for (int i = 0; i < PADDED_BLOCKS_PER_LAYER; ++i)
+    {
+        m_blocks[i] = emptyBlock;
+        m_flags[i] = MISSING_FLAG;
+        m_blocks[TOP_LAYER_START + i] = skyBlock;
+        m_flags[TOP_LAYER_START + i] = 0x00;
+    }
+}
+
+//-----------------------------------------------------------------------------------
+void ChunkNeighborhood::CopyBorderColumn(Chunk* sourceChunk, int sourceX, int sourceY, int paddedX, int paddedY, int firstZ, int lastZ)
+{
+    Block emptyBlock = GetEmptyAirBlock();
+    int paddedIndex = ((firstZ + 1) * PADDED_BLOCKS_PER_LAYER) + (paddedY * PADDED_WIDE_X) + paddedX;
+    LocalIndex sourceIndex = static_cast<LocalIndex>((firstZ << Chunk::CHUNK_BITS_XY) + (sourceY << Chunk::CHUNK_BITS_X) + sourceX);
+    for (int z = firstZ; z <= lastZ; ++z)
+    {
+        if (sourceChunk)
+        {
+            m_blocks[paddedIndex] = *sourceChunk->GetBlock(sourceIndex);
+            m_flags[paddedIndex] = 0x00;
+        }
+        else
+        {
+            m_blocks[paddedIndex] = emptyBlock;
+            m_flags[paddedIndex] = MISSING_FLAG;
+        }
+        paddedIndex += PADDED_BLOCKS_PER_LAYER;
+        sourceIndex += Chunk::BLOCKS_PER_LAYER;
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//The light at one corner of a face: the block in front of the face averaged with the three other blocks in front
+//of it that share the corner, skipping opaque and missing ones, then damped for the face and for how many of
+//those blocks are opaque. cornerOffset is the corner's position within the block, 0 or 1 on each axis.
+//Returns false if the block in front has a portal on it, since what the face actually sees might be in another
+//world; the caller lights those faces flat like before.
+bool ChunkNeighborhood::GetSmoothVertexLight(LocalIndex index, Direction faceDirection, const Vector3Int& cornerOffset, uchar dampAmount, PackedLight& out_light, PackedLight& out_skyLight) const
+{
+    const int STEP_X = 1;
+    const int STEP_Y = PADDED_WIDE_X;
+    const int STEP_Z = PADDED_BLOCKS_PER_LAYER;
+    int stepX = cornerOffset.x ? STEP_X : -STEP_X;
+    int stepY = cornerOffset.y ? STEP_Y : -STEP_Y;
+    int stepZ = cornerOffset.z ? STEP_Z : -STEP_Z;
+    int frontIndex = GetPaddedIndex(index);
+    int firstSideStep = 0;
+    int secondSideStep = 0;
+    switch (faceDirection)
+    {
+    case ABOVE:
+    case BELOW:
+        frontIndex += (faceDirection == ABOVE) ? STEP_Z : -STEP_Z;
+        firstSideStep = stepX;
+        secondSideStep = stepY;
+        break;
+    case NORTH:
+    case SOUTH:
+        frontIndex += (faceDirection == NORTH) ? STEP_Y : -STEP_Y;
+        firstSideStep = stepX;
+        secondSideStep = stepZ;
+        break;
+    default:
+        frontIndex += (faceDirection == EAST) ? STEP_X : -STEP_X;
+        firstSideStep = stepY;
+        secondSideStep = stepZ;
+        break;
+    }
+    if (m_blocks[frontIndex].m_portalFlags != 0x00)
+    {
+        return false;
+    }
+
+    const int cornerIndices[4] = { frontIndex, frontIndex + firstSideStep, frontIndex + secondSideStep, frontIndex + firstSideStep + secondSideStep };
+    int sums[6] = { 0, 0, 0, 0, 0, 0 };
+    int numLitBlocks = 0;
+    for (int cornerIndex : cornerIndices)
+    {
+        if (m_flags[cornerIndex] != 0x00)
+        {
+            continue;
+        }
+        const Block& block = m_blocks[cornerIndex];
+        sums[0] += block.m_redLight;
+        sums[1] += block.m_greenLight;
+        sums[2] += block.m_blueLight;
+        sums[3] += block.m_skyRedLight;
+        sums[4] += block.m_skyGreenLight;
+        sums[5] += block.m_skyBlueLight;
+        ++numLitBlocks;
+    }
+
+    //Portal faces can be up against an opaque block, which only ever shows its own light.
+    if (numLitBlocks == 0)
+    {
+        const Block& frontBlock = m_blocks[frontIndex];
+        out_light = SubtractPackedLight(frontBlock.GetPackedLight(), PackLight(dampAmount, dampAmount, dampAmount));
+        out_skyLight = SubtractPackedLight(frontBlock.GetPackedSkyLight(), PackLight(dampAmount, dampAmount, dampAmount));
+        return true;
+    }
+
+    bool isFirstSideOpaque = (m_flags[cornerIndices[1]] & OPAQUE_FLAG) != 0;
+    bool isSecondSideOpaque = (m_flags[cornerIndices[2]] & OPAQUE_FLAG) != 0;
+    bool isCornerOpaque = (m_flags[cornerIndices[3]] & OPAQUE_FLAG) != 0;
+    int occlusion = (isFirstSideOpaque && isSecondSideOpaque) ? 3 : (isFirstSideOpaque ? 1 : 0) + (isSecondSideOpaque ? 1 : 0) + (isCornerOpaque ? 1 : 0);
+    uchar totalDamping = static_cast<uchar>(dampAmount + AMBIENT_OCCLUSION_DAMPING[occlusion]);
+    PackedLight damping = PackLight(totalDamping, totalDamping, totalDamping);
+    PackedLight light = PackLight(static_cast<uchar>(sums[0] / numLitBlocks), static_cast<uchar>(sums[1] / numLitBlocks), static_cast<uchar>(sums[2] / numLitBlocks));
+    PackedLight skyLight = PackLight(static_cast<uchar>(sums[3] / numLitBlocks), static_cast<uchar>(sums[4] / numLitBlocks), static_cast<uchar>(sums[5] / numLitBlocks));
+    out_light = SubtractPackedLight(light, damping);
+    out_skyLight = SubtractPackedLight(skyLight, damping);
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//One flag from eight bytes of m_flags packed into the low eight bits, first byte lowest. Each byte's flag lands on
+//its own bit of the product's top byte, and none of the partial products collide there.
+static inline unsigned int GatherFlagBits(unsigned long long eightFlags, int flagShift)
+{
+    return static_cast<unsigned int>((((eightFlags >> flagShift) & 0x0101010101010101ULL) * 0x0102040810204080ULL) >> 56);
+}
+
+//-----------------------------------------------------------------------------------
+//One flag for all 18 blocks of a padded row, padded x 0 in bit 0.
+static inline unsigned int GatherRowBits(const uchar* rowFlags, int flagShift)
+{
+    unsigned long long firstEight = 0;
+    unsigned long long secondEight = 0;
+    memcpy(&firstEight, rowFlags, sizeof(firstEight));
+    memcpy(&secondEight, rowFlags + 8, sizeof(secondEight));
+    return GatherFlagBits(firstEight, flagShift) | (GatherFlagBits(secondEight, flagShift) << 8)
+        | (((rowFlags[16] >> flagShift) & 1) << 16) | (((rowFlags[17] >> flagShift) & 1) << 17);
+}
+
+//-----------------------------------------------------------------------------------
+//The other way around: bit i of the low eight bits to the low bit of byte i. Masking the copies leaves byte i with
+//just bit i, and adding 0x7F to it carries into the byte's top bit exactly when that bit was set.
+static inline unsigned long long SpreadBitsToBytes(unsigned int eightBits)
+{
+    unsigned long long isolatedBits = ((eightBits & 0xFF) * 0x0101010101010101ULL) & 0x8040201008040201ULL;
+    return ((isolatedBits + 0x7F7F7F7F7F7F7F7FULL) >> 7) & 0x0101010101010101ULL;
+}
+
+//-----------------------------------------------------------------------------------
+//Which faces of the opaque blocks in layers firstZ up to endZ the mesher draws, as BIT(direction) per block in
+//out_faceMasks[index]: the ones looking at a loaded block that isn't opaque, or with a portal on either side, the
+//same as asking GetNeighbor block by block. The layer on either side has to have been copied too.
+//Works 16 blocks at a time: each padded row's flags are packed into bitfields once, then a row's faces in every
+//direction are its own opaque bits ANDed with the open bits of the row next to it that way, shifted into line.
+void ChunkNeighborhood::CalculateOpaqueFaces(int firstZ, int endZ, uchar* out_faceMasks) const
+{
+    //Bit x of each is padded block x of one padded row, rows numbered y first, for padded layers firstZ through endZ + 1.
+    //One set per thread, since mesh workers build side by side.
+    static thread_local unsigned int s_opaqueRows[PADDED_TALL_Z * PADDED_WIDE_Y];
+    static thread_local unsigned int s_openRows[PADDED_TALL_Z * PADDED_WIDE_Y];
+    static thread_local unsigned int s_portalRows[PADDED_TALL_Z * PADDED_WIDE_Y];
+    const unsigned int PADDED_ROW_MASK = BIT(PADDED_WIDE_X) - 1;
+    for (int paddedRow = firstZ * PADDED_WIDE_Y; paddedRow < (endZ + 2) * PADDED_WIDE_Y; ++paddedRow)
+    {
+        const uchar* rowFlags = &m_flags[paddedRow * PADDED_WIDE_X];
+        unsigned int opaqueBits = GatherRowBits(rowFlags, OPAQUE_FLAG_SHIFT);
+        unsigned int missingBits = GatherRowBits(rowFlags, MISSING_FLAG_SHIFT);
+        s_opaqueRows[paddedRow] = opaqueBits;
+        s_portalRows[paddedRow] = GatherRowBits(rowFlags, PORTAL_FLAG_SHIFT);
+        //GetNeighbor treats the sky over the world as missing too, so nothing faces up into it.
+        bool isSkyLayer = paddedRow >= (PADDED_TALL_Z - 1) * PADDED_WIDE_Y;
+        s_openRows[paddedRow] = isSkyLayer ? 0 : (~(opaqueBits | missingBits) & PADDED_ROW_MASK);
+    }
+
+    const unsigned int ROW_MASK = BIT(Chunk::BLOCKS_WIDE_X) - 1;
+    for (int z = firstZ; z < endZ; ++z)
+    {
+        for (int y = 0; y < Chunk::BLOCKS_WIDE_Y; ++y)
+        {
+            int paddedRow = ((z + 1) * PADDED_WIDE_Y) + (y + 1);
+            unsigned int opaqueBlocks = (s_opaqueRows[paddedRow] >> 1) & ROW_MASK;
+            unsigned int faceRows[NUM_DIRECTIONS];
+            faceRows[ABOVE] = opaqueBlocks & (s_openRows[paddedRow + PADDED_WIDE_Y] >> 1);
+            faceRows[BELOW] = opaqueBlocks & (s_openRows[paddedRow - PADDED_WIDE_Y] >> 1);
+            faceRows[NORTH] = opaqueBlocks & (s_openRows[paddedRow + 1] >> 1);
+            faceRows[SOUTH] = opaqueBlocks & (s_openRows[paddedRow - 1] >> 1);
+            faceRows[EAST] = opaqueBlocks & (s_openRows[paddedRow] >> 2);
+            faceRows[WEST] = opaqueBlocks & s_openRows[paddedRow];
+            LocalIndex rowIndex = static_cast<LocalIndex>((z << Chunk::CHUNK_BITS_XY) + (y << Chunk::CHUNK_BITS_X));
+            unsigned int nearbyPortals = s_portalRows[paddedRow] | s_portalRows[paddedRow + PADDED_WIDE_Y] | s_portalRows[paddedRow - PADDED_WIDE_Y] | s_portalRows[paddedRow + 1] | s_portalRows[paddedRow - 1];
+            if (opaqueBlocks != 0 && nearbyPortals != 0)
+            {
+                AddPortalFaces(rowIndex, opaqueBlocks, faceRows);
+            }
+
+            //Little endian, so byte i of each half is block i of it. Rows of all air or all buried skip the spreading.
+            unsigned long long firstEight = 0;
+            unsigned long long secondEight = 0;
+            unsigned int anyFaces = faceRows[ABOVE] | faceRows[BELOW] | faceRows[NORTH] | faceRows[SOUTH] | faceRows[EAST] | faceRows[WEST];
+            for (int directionIndex = 0; anyFaces != 0 && directionIndex < NUM_DIRECTIONS; ++directionIndex)
+            {
+                firstEight |= SpreadBitsToBytes(faceRows[directionIndex]) << directionIndex;
+                secondEight |= SpreadBitsToBytes(faceRows[directionIndex] >> 8) << directionIndex;
+            }
+            memcpy(&out_faceMasks[rowIndex], &firstEight, sizeof(firstEight));
+            memcpy(&out_faceMasks[rowIndex + 8], &secondEight, sizeof(secondEight));
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//A portal on either side shows a face even between two opaque blocks. Rare enough to check block by block.
+void ChunkNeighborhood::AddPortalFaces(LocalIndex rowIndex, unsigned int opaqueBlocks, unsigned int* faceRows) const
+{
+    for (int x = 0; x < Chunk::BLOCKS_WIDE_X; ++x)
+    {
+        if ((opaqueBlocks & BIT(x)) == 0)
+        {
+            continue;
+        }
+        LocalIndex index = static_cast<LocalIndex>(rowIndex + x);
+        const Block* block = GetBlock(index);
+        for (int directionIndex = 0; directionIndex < NUM_DIRECTIONS; ++directionIndex)
+        {
+            Direction direction = static_cast<Direction>(directionIndex);
+            Direction oppositeDirection = static_cast<Direction>(direction ^ 1); //The enum pairs each direction with its opposite.
+            const Block* neighborBlock = GetNeighbor(index, direction);
+            if (neighborBlock && (block->IsPortal(direction) || neighborBlock->IsPortal(oppositeDirection)))
+            {
+                faceRows[directionIndex] |= BIT(x);
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//Folds the blocks and flags of layers firstZ through lastZ, border included, into hash. The layers under and over the
+//world count as -1 and BLOCKS_TALL_Z.
+unsigned long long ChunkNeighborhood::HashLayers(int firstZ, int lastZ, unsigned long long hash) const
+{
+    int firstPaddedIndex = (firstZ + 1) * PADDED_BLOCKS_PER_LAYER;
+    int numPaddedBlocks = (lastZ - firstZ + 1) * PADDED_BLOCKS_PER_LAYER;
+    hash = ChunkMeshCache::HashBytes(&m_blocks[firstPaddedIndex], numPaddedBlocks * sizeof(Block), hash);
+    return ChunkMeshCache::HashBytes(&m_flags[firstPaddedIndex], numPaddedBlocks, hash);
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "Game/GameCommon.hpp"
+#include "Game/Chunk.hpp"
+
+//-----------------------------------------------------------------------------------
+//A chunk's blocks plus a one block border borrowed from the chunks around it, 18x18x130 in all, so the mesher
+//can look at any of the 26 blocks around a block without boundary checks or chasing neighbor pointers.
+//Copied once per mesh build, or just the layers a build needs. Blocks in neighbors that aren't loaded, and the layer
+//under the world, are marked missing; the layer over the top of the world is open sky.
+//The same flags, packed into a bitfield per row, tell the mesher which opaque faces show without it looking at blocks.
+class ChunkNeighborhood
+{
+public:
+    //CONSTRUCTORS//////////////////////////////////////////////////////////////////////////
+    ChunkNeighborhood() {};
+    ~ChunkNeighborhood() {};
+
+    //FUNCTIONS//////////////////////////////////////////////////////////////////////////
+    void CopyFromChunk(Chunk* chunk, int firstZ = 0, int lastZ = Chunk::BLOCKS_TALL_Z - 1);
+    bool GetSmoothVertexLight(LocalIndex index, Direction faceDirection, const Vector3Int& cornerOffset, uchar dampAmount, PackedLight& out_light, PackedLight& out_skyLight) const;
+    void CalculateOpaqueFaces(int firstZ, int endZ, uchar* out_faceMasks) const;
+    unsigned long long HashLayers(int firstZ, int lastZ, unsigned long long hash) const;
+
+    //QUERIES//////////////////////////////////////////////////////////////////////////
+    static inline int GetPaddedIndex(LocalIndex index);
+    inline const Block* GetBlock(LocalIndex index) const { return &m_blocks[GetPaddedIndex(index)]; };
+    inline const Block* GetNeighbor(LocalIndex index, Direction direction) const;
+
+    //CONSTANTS//////////////////////////////////////////////////////////////////////////
+    static const int PADDED_WIDE_X = Chunk::BLOCKS_WIDE_X + 2;
+    static const int PADDED_WIDE_Y = Chunk::BLOCKS_WIDE_Y + 2;
+    static const int PADDED_TALL_Z = Chunk::BLOCKS_TALL_Z + 2;
+    static const int PADDED_BLOCKS_PER_LAYER = PADDED_WIDE_X * PADDED_WIDE_Y;
+    static const int PADDED_BLOCKS = PADDED_BLOCKS_PER_LAYER * PADDED_TALL_Z;
+    static const uchar OPAQUE_FLAG = BIT(0);
+    static const uchar MISSING_FLAG = BIT(1);
+    static const uchar PORTAL_FLAG = BIT(2);
+
+private:
+    //FUNCTIONS//////////////////////////////////////////////////////////////////////////
+    void CopyBorderColumn(Chunk* sourceChunk, int sourceX, int sourceY, int paddedX, int paddedY, int firstZ, int lastZ);
+    void AddPortalFaces(LocalIndex rowIndex, unsigned int opaqueBlocks, unsigned int* faceRows) const;
+
+    //MEMBER VARIABLES//////////////////////////////////////////////////////////////////////////
+    Block m_blocks[PADDED_BLOCKS];
+    uchar m_flags[PADDED_BLOCKS];
+};
+
+//-----------------------------------------------------------------------------------
+inline int ChunkNeighborhood::GetPaddedIndex(LocalIndex index)
+{
+    int x = index & Chunk::LOCAL_X_MASK;
+    int y = (index & Chunk::LOCAL_Y_MASK) >> Chunk::CHUNK_BITS_X;
+    int z = index >> Chunk::CHUNK_BITS_XY;
+    return ((z + 1) * PADDED_BLOCKS_PER_LAYER) + ((y + 1) * PADDED_WIDE_X) + (x + 1);
+}
+
+//-----------------------------------------------------------------------------------
+//The block next to one of the chunk's blocks, or null wherever Chunk::GetAbove and the rest would give null: under
+//or over the world, or in a neighbor that isn't loaded.
+inline const Block* ChunkNeighborhood::GetNeighbor(LocalIndex index, Direction direction) const
+{
+    static const int PADDED_STEPS[NUM_DIRECTIONS] = { PADDED_BLOCKS_PER_LAYER, -PADDED_BLOCKS_PER_LAYER, PADDED_WIDE_X, -PADDED_WIDE_X, 1, -1 };
+    int neighborIndex = GetPaddedIndex(index) + PADDED_STEPS[direction];
+    if ((m_flags[neighborIndex] & MISSING_FLAG) != 0 || neighborIndex >= PADDED_BLOCKS - PADDED_BLOCKS_PER_LAYER)
+    {
+        return nullptr;
+    }
+    return &m_blocks[neighborIndex];
+}
@@ -0,0 +1,127 @@
+#include "Game/CompactChunkVertex.hpp"
+#include "Engine/Renderer/Vertex.hpp"
+#include "Engine/Math/Vector3.hpp"
+#include <math.h>
+
+//How the tiles run across a face for each direction, as the per-face and greedy meshers lay them out: which local
+//axis (0 x, 1 y, 2 z) each texture coordinate follows, and whether it runs against that axis.
+static const int TILE_U_AXES[NUM_DIRECTIONS] = { 0, 1, 0, 0, 1, 1 };
+static const int TILE_V_AXES[NUM_DIRECTIONS] = { 1, 0, 2, 2, 2, 2 };
+static const bool IS_TILE_U_FLIPPED[NUM_DIRECTIONS] = { false, false, true, false, false, true };
+
+//-----------------------------------------------------------------------------------
+static uchar ToByte(float value)
+{
+    return static_cast<uchar>(floor(value + 0.5f));
+}
+
+//-----------------------------------------------------------------------------------
+static uchar ToColorByte(float normalizedValue)
+{
+    return ToByte(normalizedValue * 255.0f);
+}
+
+//-----------------------------------------------------------------------------------
+//The quad's outward normal, from the winding every chunk face is built with.
+static Direction GetQuadDirection(const Vertex_PCTTD* quad)
+{
+    Vector3 firstEdge = quad[1].pos - quad[0].pos;
+    Vector3 secondEdge = quad[3].pos - quad[0].pos;
+    Vector3 normal((firstEdge.y * secondEdge.z) - (firstEdge.z * secondEdge.y), (firstEdge.z * secondEdge.x) - (firstEdge.x * secondEdge.z), (firstEdge.x * secondEdge.y) - (firstEdge.y * secondEdge.x));
+    if (normal.z != 0.0f)
+    {
+        return (normal.z > 0.0f) ? ABOVE : BELOW;
+    }
+    if (normal.y != 0.0f)
+    {
+        return (normal.y > 0.0f) ? NORTH : SOUTH;
+    }
+    return (normal.x > 0.0f) ? EAST : WEST;
+}
+
+//-----------------------------------------------------------------------------------
+//Every quad's first corner has the tile's mins as its first UV set, whichever mesher built it. The atlas is flipped,
+//so the mins are at the bottom of the tile.
+void CompactChunkVertex::PackQuad(const Vertex_PCTTD* quad, const WorldPosition& chunkMins, CompactChunkVertex* out_quad)
+{
+    Direction direction = GetQuadDirection(quad);
+    int tileX = ToByte(quad[0].texCoords.x * ATLAS_TILES_WIDE);
+    int tileY = ToByte(quad[0].texCoords.y * ATLAS_TILES_TALL) - 1;
+    uchar tileIndex = static_cast<uchar>((tileY * ATLAS_TILES_WIDE) + tileX);
+    for (int corner = 0; corner < 4; ++corner)
+    {
+        const Vertex_PCTTD& vertex = quad[corner];
+        CompactChunkVertex& packed = out_quad[corner];
+        packed.m_x = ToByte(vertex.pos.x - chunkMins.x);
+        packed.m_y = ToByte(vertex.pos.y - chunkMins.y);
+        packed.m_z = ToByte(vertex.pos.z - chunkMins.z);
+        packed.m_faceAndFlags = static_cast<uchar>(direction) | ((vertex.floatData0.x > 0.5f) ? PORTAL_BIT : 0x00);
+        packed.m_red = vertex.color.red;
+        packed.m_green = vertex.color.green;
+        packed.m_blue = vertex.color.blue;
+        packed.m_tileIndex = tileIndex;
+        packed.m_skyRed = ToColorByte(vertex.floatData0.y);
+        packed.m_skyGreen = ToColorByte(vertex.floatData0.z);
+        packed.m_skyBlue = ToColorByte(vertex.floatData0.w);
+        packed.m_unused = 0x00;
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//The reference decoder, written for clarity rather than speed; it says what a shader reading the compact format
+//has to reproduce. The tile coordinates come back as whole tiles counted from the chunk's edge rather than from the
+//face's corner, which samples the same texels once the shader wraps them.
+void CompactChunkVertex::Decode(const CompactChunkVertex& vertex, const WorldPosition& chunkMins, Vertex_PCTTD& out_vertex)
+{
+    Direction direction = vertex.GetFaceDirection();
+    int tileX = vertex.m_tileIndex % ATLAS_TILES_WIDE;
+    int tileY = vertex.m_tileIndex / ATLAS_TILES_WIDE;
+    const float localCoords[3] = { (float)vertex.m_x, (float)vertex.m_y, (float)vertex.m_z };
+    float tileU = localCoords[TILE_U_AXES[direction]];
+    float tileV = localCoords[TILE_V_AXES[direction]];
+
+    out_vertex.pos = Vector3(chunkMins.x + localCoords[0], chunkMins.y + localCoords[1], chunkMins.z + localCoords[2]);
+    out_vertex.color = RGBA::CreateFromUChars(vertex.m_red, vertex.m_green, vertex.m_blue, 0xFF);
+    out_vertex.texCoords = Vector2((float)tileX / (float)ATLAS_TILES_WIDE, (float)(tileY + 1) / (float)ATLAS_TILES_TALL);
+    out_vertex.texCoords1 = Vector2(IS_TILE_U_FLIPPED[direction] ? -tileU : tileU, tileV);
+    out_vertex.floatData0 = Vector4(vertex.IsPortal() ? 1.0f : 0.0f, (float)vertex.m_skyRed / 255.0f, (float)vertex.m_skyGreen / 255.0f, (float)vertex.m_skyBlue / 255.0f);
+}
+
+//-----------------------------------------------------------------------------------
+//Packs and decodes a quad and checks it would draw the same. Everything but the texture coordinates has to come
+//back exactly. For those, the tile has to match, and each corner has to be the same distance across the atlas from
+//the first corner, counting the tiles in the second UV set.
+bool CompactChunkVertex::DoesQuadSurviveRoundTrip(const Vertex_PCTTD* quad, const WorldPosition& chunkMins)
+{
+    const float UV_TOLERANCE = 0.0001f;
+    const Vector2 tileSpan(1.0f / (float)ATLAS_TILES_WIDE, -1.0f / (float)ATLAS_TILES_TALL);
+    CompactChunkVertex packedQuad[4];
+    PackQuad(quad, chunkMins, packedQuad);
+    Vertex_PCTTD decodedQuad[4];
+    for (int corner = 0; corner < 4; ++corner)
+    {
+        Decode(packedQuad[corner], chunkMins, decodedQuad[corner]);
+    }
+    if (!(decodedQuad[0].texCoords == quad[0].texCoords))
+    {
+        return false;
+    }
+    for (int corner = 0; corner < 4; ++corner)
+    {
+        const Vertex_PCTTD& original = quad[corner];
+        const Vertex_PCTTD& decoded = decodedQuad[corner];
+        if (!(decoded.pos == original.pos) || decoded.color != original.color || !(decoded.floatData0 == original.floatData0))
+        {
+            return false;
+        }
+        Vector2 originalTiles = original.texCoords1 - quad[0].texCoords1;
+        Vector2 decodedTiles = decoded.texCoords1 - decodedQuad[0].texCoords1;
+        Vector2 originalOffset = (original.texCoords - quad[0].texCoords) + Vector2(originalTiles.x * tileSpan.x, originalTiles.y * tileSpan.y);
+        Vector2 decodedOffset = Vector2(decodedTiles.x * tileSpan.x, decodedTiles.y * tileSpan.y);
+        if (fabs(originalOffset.x - decodedOffset.x) > UV_TOLERANCE || fabs(originalOffset.y - decodedOffset.y) > UV_TOLERANCE)
+        {
+            return false;
+        }
+    }
+    return true;
+}
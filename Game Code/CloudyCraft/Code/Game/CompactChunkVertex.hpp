@@ -0,0 +1,44 @@
+#pragma once
+#include "Game/GameCommon.hpp"
+
+struct Vertex_PCTTD;
+
+//-----------------------------------------------------------------------------------
+//A chunk vertex in 12 bytes instead of the 48 of a Vertex_PCTTD, with nothing lost:
+//Position relative to the chunk's bottom left corner, 0 through 16 across and 0 through 128 up, a byte each.
+//Which way the face points and whether it's a portal, sharing a byte.
+//Block light and sky light, 8 bits a channel, the same precision the blocks store them at.
+//The atlas tile index. The texture coordinates inside the tile come back from the position and the face direction,
+//  the same way the meshers lay tiles out, so neither UV set is stored.
+//Vertices are packed a quad at a time, since the face direction comes from the quad's winding.
+struct CompactChunkVertex
+{
+    //FUNCTIONS//////////////////////////////////////////////////////////////////////////
+    static void PackQuad(const Vertex_PCTTD* quad, const WorldPosition& chunkMins, CompactChunkVertex* out_quad);
+    static void Decode(const CompactChunkVertex& vertex, const WorldPosition& chunkMins, Vertex_PCTTD& out_vertex);
+    static bool DoesQuadSurviveRoundTrip(const Vertex_PCTTD* quad, const WorldPosition& chunkMins);
+
+    //QUERIES//////////////////////////////////////////////////////////////////////////
+    inline Direction GetFaceDirection() const { return static_cast<Direction>(m_faceAndFlags & FACE_DIRECTION_MASK); };
+    inline bool IsPortal() const { return (m_faceAndFlags & PORTAL_BIT) != 0; };
+
+    //CONSTANTS//////////////////////////////////////////////////////////////////////////
+    static const uchar FACE_DIRECTION_MASK = 0x07;
+    static const uchar PORTAL_BIT = BIT(3);
+    static const int ATLAS_TILES_WIDE = 16;
+    static const int ATLAS_TILES_TALL = 16;
+
+    //MEMBER VARIABLES//////////////////////////////////////////////////////////////////////////
+    uchar m_x;
+    uchar m_y;
+    uchar m_z;
+    uchar m_faceAndFlags;
+    uchar m_red;
+    uchar m_green;
+    uchar m_blue;
+    uchar m_tileIndex;
+    uchar m_skyRed;
+    uchar m_skyGreen;
+    uchar m_skyBlue;
+    uchar m_unused;
+};
@@ -0,0 +1,87 @@
+#include "Game/DeferredBlockWriteQueue.hpp"
+#include "Game/Block.hpp"
+
+//-----------------------------------------------------------------------------------
+DeferredBlockWriteQueue::DeferredBlockWriteQueue()
+    : m_numPendingWrites(0)
+    , m_numWritesPosted(0)
+{
+}
+
+//-----------------------------------------------------------------------------------
+void DeferredBlockWriteQueue::Post(const ChunkCoords& targetCoords, const DeferredBlockWriteList& writes)
+{
+    if (writes.empty())
+    {
+        return;
+    }
+    Shard& shard = m_shards[GetShardIndex(targetCoords)];
+    {
+        std::lock_guard<std::mutex> lock(shard.m_lock);
+        DeferredBlockWriteList& pendingWrites = shard.m_pendingWrites[targetCoords];
+        pendingWrites.insert(pendingWrites.end(), writes.begin(), writes.end());
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_recentlyPostedLock);
+        m_recentlyPostedCoords.push_back(targetCoords);
+    }
+    m_numPendingWrites += static_cast<int>(writes.size());
+    m_numWritesPosted += static_cast<int>(writes.size());
+}
+
+//-----------------------------------------------------------------------------------
+bool DeferredBlockWriteQueue::Take(const ChunkCoords& targetCoords, DeferredBlockWriteList& out_writes)
+{
+    out_writes.clear();
+    Shard& shard = m_shards[GetShardIndex(targetCoords)];
+    {
+        std::lock_guard<std::mutex> lock(shard.m_lock);
+        auto pendingIter = shard.m_pendingWrites.find(targetCoords);
+        if (pendingIter == shard.m_pendingWrites.end())
+        {
+            return false;
+        }
+        out_writes.swap(pendingIter->second);
+        shard.m_pendingWrites.erase(pendingIter);
+    }
+    m_numPendingWrites -= static_cast<int>(out_writes.size());
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//Chunks that have had edits posted since the last call, possibly with duplicates.
+void DeferredBlockWriteQueue::TakeRecentlyPostedCoords(std::vector<ChunkCoords>& out_coords)
+{
+    out_coords.clear();
+    std::lock_guard<std::mutex> lock(m_recentlyPostedLock);
+    out_coords.assign(m_recentlyPostedCoords.begin(), m_recentlyPostedCoords.end());
+    m_recentlyPostedCoords.clear();
+}
+
+//-----------------------------------------------------------------------------------
+int DeferredBlockWriteQueue::ApplyWrites(Block* blocks, const DeferredBlockWriteList& writes, std::vector<LocalIndex>* out_changedIndices)
+{
+    int numChangedBlocks = 0;
+    for (const DeferredBlockWrite& write : writes)
+    {
+        Block& block = blocks[write.m_index];
+        if (block.m_type == write.m_type || (write.m_replaceType != DeferredBlockWrite::REPLACE_ANY && block.m_type != write.m_replaceType))
+        {
+            continue;
+        }
+        block.m_type = write.m_type;
+        ++numChangedBlocks;
+        if (out_changedIndices)
+        {
+            out_changedIndices->push_back(write.m_index);
+        }
+    }
+    return numChangedBlocks;
+}
+
+//-----------------------------------------------------------------------------------
+int DeferredBlockWriteQueue::GetShardIndex(const ChunkCoords& coords)
+{
+    unsigned int hash = (static_cast<unsigned int>(coords.x) * 73856093u) ^ (static_cast<unsigned int>(coords.y) * 19349663u);
+    return static_cast<int>(hash % NUM_SHARDS);
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "Game/GameCommon.hpp"
+#include "Engine/Core/Memory/UntrackedAllocator.hpp"
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <vector>
+
+class Block;
+
+//-----------------------------------------------------------------------------------
+//A block edit aimed at a chunk that may not exist yet. It only lands if the block already there
+//is m_replaceType (or anything, for REPLACE_ANY), so two features touching the same chunk come
+//out the same regardless of which chunk was generated first.
+struct DeferredBlockWrite
+{
+    static const uchar REPLACE_ANY = 0xFF;
+
+    DeferredBlockWrite() {};
+    DeferredBlockWrite(LocalIndex index, uchar type, uchar replaceType) : m_index(index), m_type(type), m_replaceType(replaceType) {};
+
+    LocalIndex m_index;
+    uchar m_type;
+    uchar m_replaceType;
+};
+typedef std::vector<DeferredBlockWrite, UntrackedAllocator<DeferredBlockWrite>> DeferredBlockWriteList;
+
+//-----------------------------------------------------------------------------------
+//Cross-chunk feature edits (tree canopies, ore veins), keyed by the chunk they land in.
+//Generation threads post a chunk's worth of edits at once and the target chunk takes them when
+//it's generated, loaded or activated. The map is split into shards with their own locks so
+//threads generating different chunks rarely wait on each other.
+//Edits for chunks that never get visited again this session are dropped at shutdown.
+class DeferredBlockWriteQueue
+{
+public:
+    //CONSTRUCTORS//////////////////////////////////////////////////////////////////////////
+    DeferredBlockWriteQueue();
+    ~DeferredBlockWriteQueue() {};
+
+    //FUNCTIONS//////////////////////////////////////////////////////////////////////////
+    void Post(const ChunkCoords& targetCoords, const DeferredBlockWriteList& writes);
+    bool Take(const ChunkCoords& targetCoords, DeferredBlockWriteList& out_writes);
+    void TakeRecentlyPostedCoords(std::vector<ChunkCoords>& out_coords);
+    inline int GetNumPendingWrites() const { return m_numPendingWrites; };
+    inline int GetNumWritesPosted() const { return m_numWritesPosted; };
+    static int ApplyWrites(Block* blocks, const DeferredBlockWriteList& writes, std::vector<LocalIndex>* out_changedIndices = nullptr);
+
+private:
+    typedef std::map<ChunkCoords, DeferredBlockWriteList, std::less<ChunkCoords>, UntrackedAllocator<std::pair<const ChunkCoords, DeferredBlockWriteList>>> PendingWriteMap;
+    struct Shard
+    {
+        std::mutex m_lock;
+        PendingWriteMap m_pendingWrites;
+    };
+    static const int NUM_SHARDS = 16;
+
+    static int GetShardIndex(const ChunkCoords& coords);
+
+    //MEMBER VARIABLES//////////////////////////////////////////////////////////////////////////
+    Shard m_shards[NUM_SHARDS];
+    std::mutex m_recentlyPostedLock;
+    std::vector<ChunkCoords, UntrackedAllocator<ChunkCoords>> m_recentlyPostedCoords;
+    std::atomic<int> m_numPendingWrites;
+    std::atomic<int> m_numWritesPosted;
+};
@@ -0,0 +1,441 @@
+#include "Game/DirtyChunkQueue.hpp"
+#include "Engine/Input/Console.hpp"
+#include "Engine/Time/Time.hpp"
+#include <set>
+
+//-----------------------------------------------------------------------------------
+static int CalcDistSquaredInChunks(const ChunkCoords& chunkCoords, const ChunkCoords& centerChunkCoords)
+{
+    ChunkCoords offset = chunkCoords - centerChunkCoords;
+    return (offset.x * offset.x) + (offset.y * offset.y);
+}
+
+//-----------------------------------------------------------------------------------
+DirtyChunkQueue::DirtyChunkQueue()
+    : m_center(0, 0)
+    , m_needsReprioritizing(false)
+    , m_numReprioritizations(0)
+{
+}
+
+//-----------------------------------------------------------------------------------
+//Adds the chunk if it isn't waiting already. If it is, it only ever moves up: a high priority push takes it to the
+//front, and a normal push leaves it where it is.
+void DirtyChunkQueue::Push(Chunk* chunk, const ChunkCoords& chunkCoords, bool isHighPriority)
+{
+    auto found = m_heapIndices.find(chunk);
+    if (found != m_heapIndices.end())
+    {
+        Entry& entry = m_heap[found->second];
+        if (isHighPriority && !entry.m_isHighPriority)
+        {
+            entry.m_isHighPriority = true;
+            entry.m_priority = HIGH_PRIORITY;
+            if (!m_needsReprioritizing)
+            {
+                SiftUp(found->second);
+            }
+        }
+        return;
+    }
+
+    Entry entry;
+    entry.m_chunk = chunk;
+    entry.m_chunkCoords = chunkCoords;
+    entry.m_isHighPriority = isHighPriority;
+    entry.m_priority = CalculatePriority(entry);
+    int heapIndex = static_cast<int>(m_heap.size());
+    m_heap.push_back(entry);
+    m_heapIndices[chunk] = heapIndex;
+    //A stale heap gets rebuilt before anyone looks at it, so there's no point placing this properly yet.
+    if (!m_needsReprioritizing)
+    {
+        SiftUp(heapIndex);
+    }
+}
+
+//-----------------------------------------------------------------------------------
+Chunk* DirtyChunkQueue::Top()
+{
+    if (m_heap.empty())
+    {
+        return nullptr;
+    }
+    if (m_needsReprioritizing)
+    {
+        Reprioritize();
+    }
+    return m_heap[0].m_chunk;
+}
+
+//-----------------------------------------------------------------------------------
+Chunk* DirtyChunkQueue::Pop()
+{
+    Chunk* chunk = Top();
+    if (chunk)
+    {
+        RemoveAt(0);
+    }
+    return chunk;
+}
+
+//-----------------------------------------------------------------------------------
+bool DirtyChunkQueue::Remove(Chunk* chunk)
+{
+    auto found = m_heapIndices.find(chunk);
+    if (found == m_heapIndices.end())
+    {
+        return false;
+    }
+    RemoveAt(found->second);
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+void DirtyChunkQueue::SetCenter(const ChunkCoords& centerChunkCoords)
+{
+    if (centerChunkCoords == m_center)
+    {
+        return;
+    }
+    m_center = centerChunkCoords;
+    m_needsReprioritizing = !m_heap.empty();
+}
+
+//-----------------------------------------------------------------------------------
+void DirtyChunkQueue::Clear()
+{
+    m_heap.clear();
+    m_heapIndices.clear();
+    m_needsReprioritizing = false;
+}
+
+//-----------------------------------------------------------------------------------
+int DirtyChunkQueue::CalculatePriority(const Entry& entry) const
+{
+    if (entry.m_isHighPriority)
+    {
+        return HIGH_PRIORITY;
+    }
+    return CalcDistSquaredInChunks(entry.m_chunkCoords, m_center);
+}
+
+//-----------------------------------------------------------------------------------
+//Rekeys every chunk for the current center and heapifies bottom up, which is O(n) where reinserting them all would be
+//O(n log n).
+void DirtyChunkQueue::Reprioritize()
+{
+    for (Entry& entry : m_heap)
+    {
+        entry.m_priority = CalculatePriority(entry);
+    }
+    for (int heapIndex = (static_cast<int>(m_heap.size()) / 2) - 1; heapIndex >= 0; --heapIndex)
+    {
+        SiftDown(heapIndex);
+    }
+    m_needsReprioritizing = false;
+    ++m_numReprioritizations;
+}
+
+//-----------------------------------------------------------------------------------
+void DirtyChunkQueue::SiftUp(int heapIndex)
+{
+    Entry entry = m_heap[heapIndex];
+    while (heapIndex > 0)
+    {
+        int parentIndex = (heapIndex - 1) / 2;
+        if (m_heap[parentIndex].m_priority <= entry.m_priority)
+        {
+            break;
+        }
+        m_heap[heapIndex] = m_heap[parentIndex];
+        m_heapIndices[m_heap[heapIndex].m_chunk] = heapIndex;
+        heapIndex = parentIndex;
+    }
+    m_heap[heapIndex] = entry;
+    m_heapIndices[entry.m_chunk] = heapIndex;
+}
+
+//-----------------------------------------------------------------------------------
+void DirtyChunkQueue::SiftDown(int heapIndex)
+{
+    int heapSize = static_cast<int>(m_heap.size());
+    Entry entry = m_heap[heapIndex];
+    while (true)
+    {
+        int childIndex = (heapIndex * 2) + 1;
+        if (childIndex >= heapSize)
+        {
+            break;
+        }
+        if (childIndex + 1 < heapSize && m_heap[childIndex + 1].m_priority < m_heap[childIndex].m_priority)
+        {
+            ++childIndex;
+        }
+        if (entry.m_priority <= m_heap[childIndex].m_priority)
+        {
+            break;
+        }
+        m_heap[heapIndex] = m_heap[childIndex];
+        m_heapIndices[m_heap[heapIndex].m_chunk] = heapIndex;
+        heapIndex = childIndex;
+    }
+    m_heap[heapIndex] = entry;
+    m_heapIndices[entry.m_chunk] = heapIndex;
+}
+
+//-----------------------------------------------------------------------------------
+//Fills the hole with the last entry, then moves that whichever way it needs to go.
+void DirtyChunkQueue::RemoveAt(int heapIndex)
+{
+    m_heapIndices.erase(m_heap[heapIndex].m_chunk);
+    int lastIndex = static_cast<int>(m_heap.size()) - 1;
+    if (heapIndex != lastIndex)
+    {
+        m_heap[heapIndex] = m_heap[lastIndex];
+        m_heapIndices[m_heap[heapIndex].m_chunk] = heapIndex;
+    }
+    m_heap.pop_back();
+    if (heapIndex == lastIndex || m_needsReprioritizing)
+    {
+        return;
+    }
+    if (heapIndex > 0 && m_heap[heapIndex].m_priority < m_heap[(heapIndex - 1) / 2].m_priority)
+    {
+        SiftUp(heapIndex);
+    }
+    else
+    {
+        SiftDown(heapIndex);
+    }
+}
+
+//-----------------------------------------------------------------------------------
+static unsigned int NextDirtyQueueBenchRandom(unsigned int& seed)
+{
+    seed = (seed * 1664525u) + 1013904223u;
+    return seed >> 8;
+}
+
+//-----------------------------------------------------------------------------------
+//How World kept its dirty chunks before: ordered by distance alone, high priority chunks added again at 0 rather
+//than moved, and every entry pulled out and put back every half second to pick up the player's movement.
+struct OldDirtyChunkEntry
+{
+    OldDirtyChunkEntry(float priority, int chunkIndex) : m_priority(priority), m_chunkIndex(chunkIndex) {};
+    inline bool operator<(const OldDirtyChunkEntry& rhs) const { return m_priority < rhs.m_priority; }
+
+    float m_priority;
+    int m_chunkIndex;
+};
+
+//-----------------------------------------------------------------------------------
+//Times the dirty chunk queue against the multiset World used to keep, running both through the same frames with
+//about # chunks waiting: chunks dirtied (some high priority), flushed and popped every frame, and the player
+//walking into a new chunk every 20 frames. The chunks are stand-ins; only their addresses get used.
+CONSOLE_COMMAND(dirtyqueuebench)
+{
+    int numChunks = (args.HasArgs(1) || args.HasArgs(2)) ? args.GetIntArgument(0) : 1000;
+    unsigned int seed = args.HasArgs(2) ? static_cast<unsigned int>(args.GetIntArgument(1)) : 12345;
+    if (numChunks <= 0)
+    {
+        Console::instance->PrintLine("dirtyqueuebench <# of chunks> <seed>", RGBA::GRAY);
+        return;
+    }
+    const int NUM_FRAMES = 600;
+    const int FRAMES_PER_PLAYER_MOVE = 20;
+    const int FRAMES_PER_OLD_RESHUFFLE = 30; //Half a second at 60 fps.
+    const int DIRTIES_PER_FRAME = 20; //Half of them land on chunks already waiting, which holds it around # chunks.
+    const int FLUSHES_PER_FRAME = 2;
+    const int POPS_PER_FRAME = 8;
+    const int NUM_CANDIDATES = numChunks * 2;
+
+    //The same script for both, decided up front so neither run pays for the random numbers.
+    std::vector<char> chunkStandIns(NUM_CANDIDATES);
+    std::vector<ChunkCoords> chunkCoords(NUM_CANDIDATES);
+    for (ChunkCoords& coords : chunkCoords)
+    {
+        coords = ChunkCoords(static_cast<int>(NextDirtyQueueBenchRandom(seed) % 33) - 16, static_cast<int>(NextDirtyQueueBenchRandom(seed) % 33) - 16);
+    }
+    std::vector<int> dirtiedChunks(NUM_FRAMES * DIRTIES_PER_FRAME);
+    std::vector<bool> isHighPriorityDirty(NUM_FRAMES * DIRTIES_PER_FRAME);
+    std::vector<int> flushedChunks(NUM_FRAMES * FLUSHES_PER_FRAME);
+    std::vector<ChunkCoords> playerChunkCoords(NUM_FRAMES);
+    ChunkCoords playerCoords(0, 0);
+    for (int frame = 0; frame < NUM_FRAMES; ++frame)
+    {
+        if (frame > 0 && frame % FRAMES_PER_PLAYER_MOVE == 0)
+        {
+            playerCoords += (NextDirtyQueueBenchRandom(seed) % 2 == 0) ? ChunkCoords(1, 0) : ChunkCoords(0, 1);
+        }
+        playerChunkCoords[frame] = playerCoords;
+        for (int i = 0; i < DIRTIES_PER_FRAME; ++i)
+        {
+            dirtiedChunks[frame * DIRTIES_PER_FRAME + i] = static_cast<int>(NextDirtyQueueBenchRandom(seed) % NUM_CANDIDATES);
+            isHighPriorityDirty[frame * DIRTIES_PER_FRAME + i] = (NextDirtyQueueBenchRandom(seed) % 4 == 0);
+        }
+        for (int i = 0; i < FLUSHES_PER_FRAME; ++i)
+        {
+            flushedChunks[frame * FLUSHES_PER_FRAME + i] = static_cast<int>(NextDirtyQueueBenchRandom(seed) % NUM_CANDIDATES);
+        }
+    }
+
+    //Before: the multiset.
+    double oldSeconds[3] = { 0.0, 0.0, 0.0 };
+    {
+        std::multiset<OldDirtyChunkEntry> oldQueue;
+        std::vector<bool> isDirty(NUM_CANDIDATES, false);
+        ChunkCoords center(0, 0);
+        for (int chunkIndex = 0; chunkIndex < numChunks; ++chunkIndex)
+        {
+            isDirty[chunkIndex] = true;
+            oldQueue.emplace(static_cast<float>(CalcDistSquaredInChunks(chunkCoords[chunkIndex], center)), chunkIndex);
+        }
+        for (int frame = 0; frame < NUM_FRAMES; ++frame)
+        {
+            center = playerChunkCoords[frame];
+            double startSeconds = GetCurrentTimeSeconds();
+            for (int i = frame * DIRTIES_PER_FRAME; i < (frame + 1) * DIRTIES_PER_FRAME; ++i)
+            {
+                int chunkIndex = dirtiedChunks[i];
+                if (isHighPriorityDirty[i])
+                {
+                    isDirty[chunkIndex] = true;
+                    oldQueue.emplace(0.0f, chunkIndex);
+                }
+                else if (!isDirty[chunkIndex])
+                {
+                    isDirty[chunkIndex] = true;
+                    oldQueue.emplace(static_cast<float>(CalcDistSquaredInChunks(chunkCoords[chunkIndex], center)), chunkIndex);
+                }
+            }
+            double dirtiedSeconds = GetCurrentTimeSeconds();
+            for (int i = frame * FLUSHES_PER_FRAME; i < (frame + 1) * FLUSHES_PER_FRAME; ++i)
+            {
+                for (auto iter = oldQueue.begin(); iter != oldQueue.end();)
+                {
+                    iter = (iter->m_chunkIndex == flushedChunks[i]) ? oldQueue.erase(iter) : ++iter;
+                }
+                isDirty[flushedChunks[i]] = false;
+            }
+            double flushedSeconds = GetCurrentTimeSeconds();
+            if (frame % FRAMES_PER_OLD_RESHUFFLE == 0 && oldQueue.size() > 40)
+            {
+                std::vector<int> waitingChunks;
+                for (const OldDirtyChunkEntry& entry : oldQueue)
+                {
+                    waitingChunks.push_back(entry.m_chunkIndex);
+                }
+                oldQueue.clear();
+                for (int chunkIndex : waitingChunks)
+                {
+                    oldQueue.emplace(static_cast<float>(CalcDistSquaredInChunks(chunkCoords[chunkIndex], center)), chunkIndex);
+                }
+            }
+            for (int numPopped = 0; numPopped < POPS_PER_FRAME && !oldQueue.empty();)
+            {
+                int chunkIndex = oldQueue.begin()->m_chunkIndex;
+                oldQueue.erase(oldQueue.begin());
+                if (isDirty[chunkIndex])
+                {
+                    isDirty[chunkIndex] = false;
+                    ++numPopped;
+                }
+            }
+            double poppedSeconds = GetCurrentTimeSeconds();
+            oldSeconds[0] += dirtiedSeconds - startSeconds;
+            oldSeconds[1] += flushedSeconds - dirtiedSeconds;
+            oldSeconds[2] += poppedSeconds - flushedSeconds;
+        }
+    }
+
+    //After: the indexed heap.
+    double newSeconds[3] = { 0.0, 0.0, 0.0 };
+    DirtyChunkQueue queue;
+    std::vector<bool> isWaiting(NUM_CANDIDATES, false);
+    std::vector<bool> isHighPriority(NUM_CANDIDATES, false);
+    std::vector<Chunk*> poppedChunks(POPS_PER_FRAME, nullptr);
+    int totalWaiting = 0;
+    for (int chunkIndex = 0; chunkIndex < numChunks; ++chunkIndex)
+    {
+        queue.Push(reinterpret_cast<Chunk*>(&chunkStandIns[chunkIndex]), chunkCoords[chunkIndex]);
+        isWaiting[chunkIndex] = true;
+    }
+    for (int frame = 0; frame < NUM_FRAMES; ++frame)
+    {
+        double startSeconds = GetCurrentTimeSeconds();
+        queue.SetCenter(playerChunkCoords[frame]);
+        for (int i = frame * DIRTIES_PER_FRAME; i < (frame + 1) * DIRTIES_PER_FRAME; ++i)
+        {
+            queue.Push(reinterpret_cast<Chunk*>(&chunkStandIns[dirtiedChunks[i]]), chunkCoords[dirtiedChunks[i]], isHighPriorityDirty[i]);
+        }
+        double dirtiedSeconds = GetCurrentTimeSeconds();
+        for (int i = frame * FLUSHES_PER_FRAME; i < (frame + 1) * FLUSHES_PER_FRAME; ++i)
+        {
+            queue.Remove(reinterpret_cast<Chunk*>(&chunkStandIns[flushedChunks[i]]));
+        }
+        double flushedSeconds = GetCurrentTimeSeconds();
+        for (int numPopped = 0; numPopped < POPS_PER_FRAME; ++numPopped)
+        {
+            poppedChunks[numPopped] = queue.Pop();
+        }
+        double poppedSeconds = GetCurrentTimeSeconds();
+        newSeconds[0] += dirtiedSeconds - startSeconds;
+        newSeconds[1] += flushedSeconds - dirtiedSeconds;
+        newSeconds[2] += poppedSeconds - flushedSeconds;
+        totalWaiting += queue.GetSize();
+
+        //Replays the frame to know which chunks should still be high priority for the order check below, outside the
+        //timing. A chunk stays high priority from the first high priority push after it starts waiting until it leaves.
+        for (int i = frame * DIRTIES_PER_FRAME; i < (frame + 1) * DIRTIES_PER_FRAME; ++i)
+        {
+            int chunkIndex = dirtiedChunks[i];
+            isHighPriority[chunkIndex] = isWaiting[chunkIndex] ? (isHighPriority[chunkIndex] || isHighPriorityDirty[i]) : isHighPriorityDirty[i];
+            isWaiting[chunkIndex] = true;
+        }
+        for (int i = frame * FLUSHES_PER_FRAME; i < (frame + 1) * FLUSHES_PER_FRAME; ++i)
+        {
+            isWaiting[flushedChunks[i]] = false;
+            isHighPriority[flushedChunks[i]] = false;
+        }
+        for (Chunk* chunk : poppedChunks)
+        {
+            if (chunk)
+            {
+                int chunkIndex = static_cast<int>(reinterpret_cast<char*>(chunk) - &chunkStandIns[0]);
+                isWaiting[chunkIndex] = false;
+                isHighPriority[chunkIndex] = false;
+            }
+        }
+    }
+
+    //Whatever's left should come out high priority first, then nearest first, each chunk once.
+    bool isInOrder = true;
+    int lastPriority = DirtyChunkQueue::HIGH_PRIORITY;
+    int numLeft = queue.GetSize();
+    int numDrained = 0;
+    std::vector<bool> wasDrained(NUM_CANDIDATES, false);
+    for (Chunk* chunk = queue.Pop(); chunk; chunk = queue.Pop())
+    {
+        int chunkIndex = static_cast<int>(reinterpret_cast<char*>(chunk) - &chunkStandIns[0]);
+        int priority = isHighPriority[chunkIndex] ? DirtyChunkQueue::HIGH_PRIORITY : CalcDistSquaredInChunks(chunkCoords[chunkIndex], playerChunkCoords[NUM_FRAMES - 1]);
+        isInOrder = isInOrder && priority >= lastPriority && !wasDrained[chunkIndex];
+        wasDrained[chunkIndex] = true;
+        lastPriority = priority;
+        ++numDrained;
+    }
+    isInOrder = isInOrder && numDrained == numLeft;
+
+    const char* COLUMN_FORMAT = "%-24s %8.01f ns/dirty %8.01f ns/flush %8.01f ns/pop %8.03f ms total";
+    double oldTotal = oldSeconds[0] + oldSeconds[1] + oldSeconds[2];
+    double newTotal = newSeconds[0] + newSeconds[1] + newSeconds[2];
+    double numDirties = NUM_FRAMES * DIRTIES_PER_FRAME;
+    double numFlushes = NUM_FRAMES * FLUSHES_PER_FRAME;
+    double numPops = NUM_FRAMES * POPS_PER_FRAME;
+    Console::instance->PrintLine(Stringf("%i frames, %.0f chunks waiting on average, player moved %i times", NUM_FRAMES, (double)totalWaiting / NUM_FRAMES, (NUM_FRAMES - 1) / FRAMES_PER_PLAYER_MOVE), RGBA::WHITE);
+    Console::instance->PrintLine(Stringf(COLUMN_FORMAT, "Multiset", oldSeconds[0] * 1.0e9 / numDirties, oldSeconds[1] * 1.0e9 / numFlushes, oldSeconds[2] * 1.0e9 / numPops, oldTotal * 1000.0), RGBA::WHITE);
+    Console::instance->PrintLine(Stringf(COLUMN_FORMAT, "Indexed heap", newSeconds[0] * 1.0e9 / numDirties, newSeconds[1] * 1.0e9 / numFlushes, newSeconds[2] * 1.0e9 / numPops, newTotal * 1000.0), RGBA::WHITE);
+    Console::instance->PrintLine(Stringf("%-24s %i (pops include them)", "Reprioritizations", queue.GetNumReprioritizations()), RGBA::WHITE);
+    Console::instance->PrintLine(Stringf("%-24s %.02fx", "Speedup", oldTotal / (newTotal > 0.0 ? newTotal : 1.0)), RGBA::WHITE);
+    Console::instance->PrintLine(isInOrder ? "PASS: drained in priority order" : "FAIL: drained out of priority order", isInOrder ? RGBA::GREEN : RGBA::RED);
+}
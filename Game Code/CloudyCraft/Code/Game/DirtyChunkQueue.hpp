@@ -0,0 +1,63 @@
+#pragma once
+#include "Game/GameCommon.hpp"
+#include <unordered_map>
+#include <vector>
+
+class Chunk;
+
+//-----------------------------------------------------------------------------------
+//The chunks waiting on a mesh rebuild, closest to the player first. A binary heap with each chunk's slot kept in a
+//side table, so a chunk is only ever in here once: dirtying it again does nothing, or moves it up if it's become
+//high priority, and pulling out a chunk that's being flushed is O(log n) instead of a scan.
+//Priorities are squared distances in chunks from the player's chunk, so they only change when the player crosses
+//into another chunk. SetCenter just notes that; the heap gets rekeyed and rebuilt in O(n) the next time something
+//asks for the front of it, however many chunks the player crossed in between.
+//The chunk pointers are only ever compared, never followed.
+class DirtyChunkQueue
+{
+public:
+    //CONSTRUCTORS//////////////////////////////////////////////////////////////////////////
+    DirtyChunkQueue();
+    ~DirtyChunkQueue() {};
+
+    //FUNCTIONS//////////////////////////////////////////////////////////////////////////
+    void Push(Chunk* chunk, const ChunkCoords& chunkCoords, bool isHighPriority = false);
+    Chunk* Top();
+    Chunk* Pop();
+    bool Remove(Chunk* chunk);
+    void SetCenter(const ChunkCoords& centerChunkCoords);
+    void Clear();
+
+    //QUERIES//////////////////////////////////////////////////////////////////////////
+    inline bool IsEmpty() const { return m_heap.empty(); };
+    inline int GetSize() const { return static_cast<int>(m_heap.size()); };
+    inline bool Contains(Chunk* chunk) const { return m_heapIndices.find(chunk) != m_heapIndices.end(); };
+    inline int GetNumReprioritizations() const { return m_numReprioritizations; };
+
+    //CONSTANTS//////////////////////////////////////////////////////////////////////////
+    static const int HIGH_PRIORITY = -1; //Ahead of every distance, so the player's own edits show up first.
+
+private:
+    //-----------------------------------------------------------------------------------
+    struct Entry
+    {
+        Chunk* m_chunk;
+        ChunkCoords m_chunkCoords;
+        int m_priority;
+        bool m_isHighPriority;
+    };
+
+    //FUNCTIONS//////////////////////////////////////////////////////////////////////////
+    int CalculatePriority(const Entry& entry) const;
+    void Reprioritize();
+    void SiftUp(int heapIndex);
+    void SiftDown(int heapIndex);
+    void RemoveAt(int heapIndex);
+
+    //MEMBER VARIABLES//////////////////////////////////////////////////////////////////////////
+    std::vector<Entry> m_heap;
+    std::unordered_map<Chunk*, int> m_heapIndices;
+    ChunkCoords m_center;
+    bool m_needsReprioritizing; //The center moved since the heap was last keyed, so its order is stale.
+    int m_numReprioritizations;
+};
@@ -2,113 +2,500 @@
 #include "Game/Chunk.hpp"
 #include "Game/World.hpp"
 #include "Engine/Math/Noise.hpp"
+#include "Engine/Math/NoiseSIMD.hpp"
+#include "Engine/Math/Dice.hpp"
+#include "Engine/Math/DensityField.hpp"
+#include "Engine/Input/Console.hpp"
+#include <algorithm>
+#include <string.h>
+#include <thread>
 
-void EarthGenerator::GenerateChunk(Block* blockArray, Chunk* chunk)
+//-----------------------------------------------------------------------------------
+GenerationContext::GenerationContext(Block* blockArray, const ChunkCoords& chunkCoords)
+	: m_blocks(blockArray)
+	, m_chunkCoords(chunkCoords)
+	, m_chunkMins(static_cast<float>(chunkCoords.x * Chunk::BLOCKS_WIDE_X), static_cast<float>(chunkCoords.y * Chunk::BLOCKS_WIDE_Y))
+{
+}
+
+//-----------------------------------------------------------------------------------
+void GenerationContext::SetBlockType(int localX, int localY, int localZ, uchar type, uchar replaceType)
+{
+	if (localZ < 0 || localZ >= Chunk::BLOCKS_TALL_Z)
+	{
+		return;
+	}
+	//Arithmetic shifts floor, so -1 lands in the neighbor to the west/south at its far edge.
+	const int chunkOffsetX = localX >> Chunk::CHUNK_BITS_X;
+	const int chunkOffsetY = localY >> Chunk::CHUNK_BITS_Y;
+	const LocalIndex index = (localZ << Chunk::CHUNK_BITS_XY) + ((localY & (Chunk::BLOCKS_WIDE_Y - 1)) << Chunk::CHUNK_BITS_X) + (localX & Chunk::LOCAL_X_MASK);
+	if (chunkOffsetX == 0 && chunkOffsetY == 0)
+	{
+		Block& block = m_blocks[index];
+		if (replaceType == DeferredBlockWrite::REPLACE_ANY || block.m_type == replaceType)
+		{
+			block.m_type = type;
+		}
+		return;
+	}
+	m_deferredWrites[m_chunkCoords + ChunkCoords(chunkOffsetX, chunkOffsetY)].push_back(DeferredBlockWrite(index, type, replaceType));
+}
+
+//-----------------------------------------------------------------------------------
+Generator::Generator()
+	: m_isProfiled(false)
+	, m_isColumnThreadStopping(false)
+{
+}
+
+//-----------------------------------------------------------------------------------
+Generator::~Generator()
+{
+	StopColumnThread();
+}
+
+//-----------------------------------------------------------------------------------
+void Generator::StartColumnThread()
+{
+	if (!m_columnThread.joinable())
+	{
+		m_isColumnThreadStopping = false;
+		m_columnThread = std::thread(&Generator::ColumnThreadMain, this);
+	}
+}
+
+//-----------------------------------------------------------------------------------
+//Columns still queued are thrown away; the generation thread works them out itself if it ever needs them.
+void Generator::StopColumnThread()
+{
+	if (!m_columnThread.joinable())
+	{
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_columnQueueLock);
+		m_isColumnThreadStopping = true;
+		m_queuedColumns.clear();
+	}
+	m_columnsQueued.notify_all();
+	m_columnThread.join();
+}
+
+//-----------------------------------------------------------------------------------
+//Asks the column thread to get the chunk's columns ready before the generation thread reaches it. Does nothing
+//without a column thread.
+void Generator::QueueColumns(const ChunkCoords& chunkCoords)
+{
+	if (!m_columnThread.joinable())
+	{
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_columnQueueLock);
+		m_queuedColumns.push_back(chunkCoords);
+	}
+	m_columnsQueued.notify_one();
+}
+
+//-----------------------------------------------------------------------------------
+//Chunks the generation thread already got to are skipped, since their columns are cached by then.
+void Generator::ColumnThreadMain(Generator* generator)
+{
+	while (true)
+	{
+		ChunkCoords chunkCoords;
+		{
+			std::unique_lock<std::mutex> lock(generator->m_columnQueueLock);
+			while (!generator->m_isColumnThreadStopping && generator->m_queuedColumns.empty())
+			{
+				generator->m_columnsQueued.wait(lock);
+			}
+			if (generator->m_isColumnThreadStopping)
+			{
+				return;
+			}
+			chunkCoords = generator->m_queuedColumns.front();
+			generator->m_queuedColumns.pop_front();
+		}
+		if (generator->IsColumnCached(chunkCoords))
+		{
+			continue;
+		}
+		GenerationContext context(nullptr, chunkCoords);
+		generator->GenerateColumns(context);
+		generator->CacheColumns(context);
+	}
+}
+
+//-----------------------------------------------------------------------------------
+bool Generator::IsColumnCached(const ChunkCoords& chunkCoords)
+{
+	std::lock_guard<std::mutex> lock(m_columnCacheLock);
+	return m_cachedColumns.find(chunkCoords) != m_cachedColumns.end();
+}
+
+//-----------------------------------------------------------------------------------
+//Fills in the context's column channels from the cache, or returns false if the chunk isn't in it.
+bool Generator::CopyCachedColumns(GenerationContext& context)
+{
+	std::lock_guard<std::mutex> lock(m_columnCacheLock);
+	auto cachedIter = m_cachedColumns.find(context.m_chunkCoords);
+	if (cachedIter == m_cachedColumns.end())
+	{
+		return false;
+	}
+	const ColumnValues& cachedValues = cachedIter->second;
+	for (int channel = 0; channel < GetNumColumnChannels(); ++channel)
+	{
+		memcpy(context.m_columns[channel], &cachedValues[channel * Chunk::BLOCKS_PER_LAYER], sizeof(context.m_columns[channel]));
+	}
+	return true;
+}
+
+//-----------------------------------------------------------------------------------
+//Both threads can work out the same chunk's columns at once; they come out identical, so the first one in is kept.
+void Generator::CacheColumns(const GenerationContext& context)
+{
+	const int numChannels = GetNumColumnChannels();
+	ColumnValues values(numChannels * Chunk::BLOCKS_PER_LAYER);
+	for (int channel = 0; channel < numChannels; ++channel)
+	{
+		memcpy(&values[channel * Chunk::BLOCKS_PER_LAYER], context.m_columns[channel], sizeof(context.m_columns[channel]));
+	}
+	std::lock_guard<std::mutex> lock(m_columnCacheLock);
+	if (m_cachedColumns.find(context.m_chunkCoords) != m_cachedColumns.end())
+	{
+		return;
+	}
+	if (static_cast<int>(m_cachedColumnsOrder.size()) >= MAX_CACHED_COLUMN_CHUNKS)
+	{
+		m_cachedColumns.erase(m_cachedColumnsOrder.front());
+		m_cachedColumnsOrder.pop_front();
+	}
+	m_cachedColumns[context.m_chunkCoords].swap(values);
+	m_cachedColumnsOrder.push_back(context.m_chunkCoords);
+}
+
+//-----------------------------------------------------------------------------------
+void Generator::GenerateChunk(Block* blockArray, Chunk* chunk)
+{
+	GenerateChunk(blockArray, chunk->m_chunkPosition);
+}
+
+//-----------------------------------------------------------------------------------
+static inline void StartStageTiming(bool isProfiled, ProfilingID id)
+{
+	if (isProfiled)
+	{
+		StartTiming(id);
+	}
+}
+
+//-----------------------------------------------------------------------------------
+static inline void EndStageTiming(bool isProfiled, ProfilingID id)
+{
+	if (isProfiled)
+	{
+		EndTiming(id);
+	}
+}
+
+//-----------------------------------------------------------------------------------
+void Generator::GenerateChunk(Block* blockArray, const ChunkCoords& chunkCoords)
+{
+	//REMINDER: THREAD-SAFE CODE ONLY! This runs on the generation thread.
+	GenerationContext context(blockArray, chunkCoords);
+
+	//Only what this thread spends on the stage is timed, so columns the column thread got ready count as a lookup.
+	StartStageTiming(m_isProfiled, g_generationColumnsProfiling);
+	if (!CopyCachedColumns(context))
+	{
+		GenerateColumns(context);
+		CacheColumns(context);
+	}
+	EndStageTiming(m_isProfiled, g_generationColumnsProfiling);
+
+	StartStageTiming(m_isProfiled, g_generationDensityProfiling);
+	GenerateDensity(context);
+	EndStageTiming(m_isProfiled, g_generationDensityProfiling);
+
+	StartStageTiming(m_isProfiled, g_generationSurfaceProfiling);
+	DecorateSurface(context);
+	EndStageTiming(m_isProfiled, g_generationSurfaceProfiling);
+
+	StartStageTiming(m_isProfiled, g_generationFeaturesProfiling);
+	PlaceFeatures(context);
+	//Hand off the edits that spilled into neighbors, then pick up whatever earlier neighbors left for us.
+	for (const auto& deferredPair : context.m_deferredWrites)
+	{
+		m_deferredBlockWrites.Post(deferredPair.first, deferredPair.second);
+	}
+	DeferredBlockWriteList pendingWrites;
+	if (m_deferredBlockWrites.Take(chunkCoords, pendingWrites))
+	{
+		DeferredBlockWriteQueue::ApplyWrites(blockArray, pendingWrites);
+	}
+	EndStageTiming(m_isProfiled, g_generationFeaturesProfiling);
+}
+
+//EARTH//////////////////////////////////////////////////////////////////////////
+static const int EARTH_MIN_HEIGHT = Chunk::BLOCKS_TALL_Z / 3;
+static const int EARTH_MAX_HEIGHT = (Chunk::BLOCKS_TALL_Z * 3) / 4;
+static const int EARTH_SEA_LEVEL = Chunk::BLOCKS_TALL_Z / 2;
+static const unsigned int EARTH_TREE_SEED = 0x7EE5;
+static const unsigned int EARTH_ORE_SEED = 0x04E5;
+static const float EARTH_TREE_CHANCE_PER_COLUMN = 0.004f;
+static const int EARTH_ORE_VEINS_PER_CHUNK = 4;
+
+//-----------------------------------------------------------------------------------
+EarthGenerator::EarthGenerator()
+	: m_treeChancePerColumn(EARTH_TREE_CHANCE_PER_COLUMN)
+	, m_oreVeinsPerChunk(EARTH_ORE_VEINS_PER_CHUNK)
+{
+}
+
+//-----------------------------------------------------------------------------------
+EarthGenerator::EarthGenerator(float treeChancePerColumn, int oreVeinsPerChunk)
+	: m_treeChancePerColumn(treeChancePerColumn)
+	, m_oreVeinsPerChunk(oreVeinsPerChunk)
+{
+}
+
+//-----------------------------------------------------------------------------------
+void EarthGenerator::GenerateColumns(GenerationContext& context)
 {
-	const int MIN_HEIGHT = Chunk::BLOCKS_TALL_Z / 3;
-	const int MAX_HEIGHT = (Chunk::BLOCKS_TALL_Z * 3) / 4;
-	const int SEA_LEVEL = Chunk::BLOCKS_TALL_Z / 2;
 	const float GRID_SIZE = 100.0f;
-	const int NUM_OCTAVES = 5;
+	const unsigned int NUM_OCTAVES = 5;
 	const float PERSISTENCE = 0.30f;
-	std::map<Vector2Int, float> heights;
 
-	Vector2Int chunkPosInWorld = Vector2Int(chunk->m_chunkPosition.x * Chunk::BLOCKS_WIDE_X, chunk->m_chunkPosition.y * Chunk::BLOCKS_WIDE_X);
-	for (int x = chunkPosInWorld.x; x < (chunkPosInWorld.x + Chunk::BLOCKS_WIDE_X); x++)
+	float* heights = context.m_columns[HEIGHT_CHANNEL];
+	for (int columnIndex = 0; columnIndex < Chunk::BLOCKS_PER_LAYER; ++columnIndex)
 	{
-		for (int y = chunkPosInWorld.y; y < (chunkPosInWorld.y + Chunk::BLOCKS_WIDE_Y); y++)
+		float x = context.m_chunkMins.x + static_cast<float>(columnIndex & Chunk::LOCAL_X_MASK);
+		float y = context.m_chunkMins.y + static_cast<float>(columnIndex >> Chunk::CHUNK_BITS_X);
+		float delta = Compute2dPerlinNoise<NUM_OCTAVES, true>(x, y, GRID_SIZE, PERSISTENCE);
+		heights[columnIndex] = round(MathUtils::RangeMap(delta, -1.0f, 1.0f, static_cast<float>(EARTH_MIN_HEIGHT), static_cast<float>(EARTH_MAX_HEIGHT)));
+	}
+}
+
+//-----------------------------------------------------------------------------------
+void EarthGenerator::GenerateDensity(GenerationContext& context)
+{
+	const float* heights = context.m_columns[HEIGHT_CHANNEL];
+	Block* blocks = context.m_blocks;
+	for (int z = 0; z < Chunk::BLOCKS_TALL_Z; ++z)
+	{
+		const float layerZ = static_cast<float>(z);
+		const uchar emptyType = (z <= EARTH_SEA_LEVEL) ? BlockType::WATER : BlockType::AIR;
+		Block* layer = &blocks[z << Chunk::CHUNK_BITS_XY];
+		for (int columnIndex = 0; columnIndex < Chunk::BLOCKS_PER_LAYER; ++columnIndex)
 		{
-			Vector2 currentColumn = Vector2(static_cast<float>(x), static_cast<float>(y));
-			float delta = Compute2dPerlinNoise(currentColumn.x, currentColumn.y, GRID_SIZE, NUM_OCTAVES, PERSISTENCE);
-			heights[Vector2Int(x, y)] = round(MathUtils::RangeMap(delta, -1.0f, 1.0f, static_cast<float>(MIN_HEIGHT), static_cast<float>(MAX_HEIGHT)));
+			layer[columnIndex].m_type = (layerZ > heights[columnIndex]) ? emptyType : static_cast<uchar>(BlockType::STONE);
 		}
 	}
+}
 
-	for (int i = 0; i < Chunk::BLOCKS_PER_CHUNK; i++)
+//-----------------------------------------------------------------------------------
+void EarthGenerator::DecorateSurface(GenerationContext& context)
+{
+	//Everything below sea level stays stone; only the top of each column above it is touched.
+	const float* heights = context.m_columns[HEIGHT_CHANNEL];
+	Block* blocks = context.m_blocks;
+	for (int columnIndex = 0; columnIndex < Chunk::BLOCKS_PER_LAYER; ++columnIndex)
 	{
-		WorldCoords globalCoords = chunk->GetWorldCoordsForBlockIndex(i);
-		Vector2Int currentColumn = Vector2Int(globalCoords.x, globalCoords.y);
-		float height = heights[currentColumn];
-		float z = static_cast<float>(globalCoords.z);
-		if (z > height)
+		int height = static_cast<int>(heights[columnIndex]);
+		for (int z = EARTH_SEA_LEVEL; z <= height; ++z)
 		{
-			if (z <= SEA_LEVEL)
-				blockArray[i].m_type = BlockType::WATER;
+			Block& block = blocks[(z << Chunk::CHUNK_BITS_XY) + columnIndex];
+			if (z == EARTH_SEA_LEVEL)
+			{
+				block.m_type = BlockType::SAND;
+			}
+			else if (z < height)
+			{
+				block.m_type = BlockType::DIRT;
+			}
 			else
-				blockArray[i].m_type = BlockType::AIR;
-		}
-		else if (z < SEA_LEVEL)
-		{
-			blockArray[i].m_type = BlockType::STONE;
+			{
+				block.m_type = BlockType::GRASS;
+			}
 		}
-		else if (z == SEA_LEVEL)
+	}
+}
+
+//-----------------------------------------------------------------------------------
+void EarthGenerator::PlaceFeatures(GenerationContext& context)
+{
+	const float* heights = context.m_columns[HEIGHT_CHANNEL];
+	const unsigned int treeThreshold = static_cast<unsigned int>(m_treeChancePerColumn * 65536.0f);
+	const int chunkMinX = context.m_chunkCoords.x * Chunk::BLOCKS_WIDE_X;
+	const int chunkMinY = context.m_chunkCoords.y * Chunk::BLOCKS_WIDE_Y;
+
+	//Every column's tree roll in one batch, 4 or 8 lanes at a time; the bits are the same as rolling them one by one.
+	int columnXs[Chunk::BLOCKS_PER_LAYER];
+	int columnYs[Chunk::BLOCKS_PER_LAYER];
+	unsigned int treeNoises[Chunk::BLOCKS_PER_LAYER];
+	for (int columnIndex = 0; columnIndex < Chunk::BLOCKS_PER_LAYER; ++columnIndex)
+	{
+		columnXs[columnIndex] = chunkMinX + (columnIndex & Chunk::LOCAL_X_MASK);
+		columnYs[columnIndex] = chunkMinY + (columnIndex >> Chunk::CHUNK_BITS_X);
+	}
+	Get2dNoiseUints(columnXs, columnYs, treeNoises, Chunk::BLOCKS_PER_LAYER, EARTH_TREE_SEED);
+
+	for (int columnIndex = 0; columnIndex < Chunk::BLOCKS_PER_LAYER; ++columnIndex)
+	{
+		//Only columns that poke above the sea have grass to grow on.
+		int height = static_cast<int>(heights[columnIndex]);
+		if (height <= EARTH_SEA_LEVEL)
 		{
-			blockArray[i].m_type = BlockType::SAND;
+			continue;
 		}
-		else if (z < height)
+		int localX = columnIndex & Chunk::LOCAL_X_MASK;
+		int localY = columnIndex >> Chunk::CHUNK_BITS_X;
+		unsigned int treeNoise = treeNoises[columnIndex];
+		if ((treeNoise & 0xFFFF) < treeThreshold)
 		{
-			blockArray[i].m_type = BlockType::DIRT;
+			PlaceTree(context, localX, localY, height, treeNoise);
 		}
-		else if (z == height)
+	}
+	for (int veinIndex = 0; veinIndex < m_oreVeinsPerChunk; ++veinIndex)
+	{
+		PlaceOreVein(context, Get3dNoiseUint(context.m_chunkCoords.x, context.m_chunkCoords.y, veinIndex, EARTH_ORE_SEED));
+	}
+}
+
+//-----------------------------------------------------------------------------------
+//Trunks overwrite anything and leaves only fill air, so overlapping trees settle the same way
+//whichever one is placed first.
+void EarthGenerator::PlaceTree(GenerationContext& context, int localX, int localY, int groundZ, unsigned int treeNoise)
+{
+	const int trunkHeight = 4 + ((treeNoise >> 16) & 0x3);
+	const int topZ = groundZ + trunkHeight;
+	for (int z = groundZ + 1; z <= topZ; ++z)
+	{
+		context.SetBlockType(localX, localY, z, BlockType::WOOD, DeferredBlockWrite::REPLACE_ANY);
+	}
+	//Two wide layers of leaves around the top of the trunk, then two narrow ones capping it.
+	for (int z = topZ - 1; z <= topZ + 2; ++z)
+	{
+		const int radius = (z <= topZ) ? 2 : 1;
+		const bool skipCorners = (radius == 2) || (z == topZ + 2);
+		for (int offsetY = -radius; offsetY <= radius; ++offsetY)
 		{
-			blockArray[i].m_type = BlockType::GRASS;
+			for (int offsetX = -radius; offsetX <= radius; ++offsetX)
+			{
+				if (skipCorners && abs(offsetX) == radius && abs(offsetY) == radius)
+				{
+					continue;
+				}
+				context.SetBlockType(localX + offsetX, localY + offsetY, z, BlockType::LEAVES, BlockType::AIR);
+			}
 		}
 	}
 }
 
 //-----------------------------------------------------------------------------------
-void SkylandsGenerator::GenerateChunk(Block* blockArray, Chunk* chunk)
+//A short random walk through the stone, free to wander into the neighboring chunks.
+//Every step's x, y and z moves are rolled up front in one seeded batch, so the walk is the same whichever thread
+//generates the chunk.
+void EarthGenerator::PlaceOreVein(GenerationContext& context, unsigned int veinNoise)
+{
+	const int VEIN_LENGTH = 8;
+	static const Dice STEP_DICE(1, 3, -2);
+	int stepRolls[VEIN_LENGTH * 3];
+	STEP_DICE.RollSeeded(stepRolls, VEIN_LENGTH * 3, veinNoise);
+
+	int x = veinNoise & Chunk::LOCAL_X_MASK;
+	int y = (veinNoise >> Chunk::CHUNK_BITS_X) & Chunk::LOCAL_X_MASK;
+	int z = 2 + static_cast<int>((veinNoise >> 8) % (EARTH_MIN_HEIGHT - 4));
+	for (int step = 0; step < VEIN_LENGTH; ++step)
+	{
+		context.SetBlockType(x, y, z, BlockType::IRON, BlockType::STONE);
+		x += stepRolls[(step * 3) + 0];
+		y += stepRolls[(step * 3) + 1];
+		z += stepRolls[(step * 3) + 2];
+	}
+}
+
+//SKYLANDS//////////////////////////////////////////////////////////////////////////
+const float SkylandsGenerator::ISLAND_SUBLEVELS[NUM_ISLAND_TIERS] = { 25.0f, 50.0f, 75.0f, 100.0f };
+const float SkylandsGenerator::MIN_DENSITY = 40.0f;
+
+static const float SKYLANDS_MAX_DENSITY = 70.0f;
+static const float SKYLANDS_DENSITY_GRID_SIZE = 60.0f;
+
+//-----------------------------------------------------------------------------------
+struct SkylandsNoiseParameters
+{
+	DensityField::SampleFunction m_sampleFunction;
+	float m_gridSize;
+	unsigned int m_seed;
+	int m_latticeStep;
+};
+
+//-----------------------------------------------------------------------------------
+template <unsigned int NUM_OCTAVES>
+static float SampleSkylandsNoise(const Vector3& position, void* userData)
+{
+	const SkylandsNoiseParameters* parameters = static_cast<const SkylandsNoiseParameters*>(userData);
+	return Compute2dPerlinNoise<NUM_OCTAVES, true>(position.x, position.y, parameters->m_gridSize, 0.5f, 2.0f, parameters->m_seed);
+}
+
+//Density and the terrain above are broad features and survive a 4 block lattice. The underbelly noise
+//has a much smaller grid, so it gets a finer lattice to keep its upper octaves.
+static const SkylandsNoiseParameters SKYLANDS_DENSITY_NOISE = { &SampleSkylandsNoise<1>, SKYLANDS_DENSITY_GRID_SIZE, 0, 4 };
+static const SkylandsNoiseParameters SKYLANDS_ABOVE_NOISE = { &SampleSkylandsNoise<6>, 70.0f, 0, 4 };
+static const SkylandsNoiseParameters SKYLANDS_BELOW_NOISE = { &SampleSkylandsNoise<4>, 20.0f, 0, 2 };
+
+//-----------------------------------------------------------------------------------
+void SkylandsGenerator::GenerateColumns(GenerationContext& context)
 {
-	const float MIN_DENSITY = 40.0f;
-	const float MAX_DENSITY = 70.0f;
 	const float MIN_THICKNESS_BELOW = 10.0f;
 	const float MAX_THICKNESS_BELOW = 30.0f;
-	const float MIN_THICKNESS_ABOVE = 0.0f;
-	const float MAX_THICKNESS_ABOVE = 8.0f;
 	const float VARIABLE_THICKNESS_BELOW = MAX_THICKNESS_BELOW - MIN_THICKNESS_BELOW;
-	const float DENSITY_GRID_SIZE = 60.0f;
-	const float DENSITY_NUM_OCTAVES = 2;
-	const float DENSITY_PERSISTENCE = 0.30f;
-
-	const float ISLAND_SUBLEVELS[] = { 25.0f, 50.0f, 75.0f, 100.0f };
-	const int NUM_ISLAND_TIERS = sizeof(ISLAND_SUBLEVELS) / sizeof(ISLAND_SUBLEVELS[0]);
-
-	float islandDensityPerColumnPerTier[Chunk::BLOCKS_PER_LAYER][NUM_ISLAND_TIERS];
-	float islandThicknessAbovePerColumnPerTier[Chunk::BLOCKS_PER_LAYER][NUM_ISLAND_TIERS];
-	float islandThicknessBelowPerColumnPerTier[Chunk::BLOCKS_PER_LAYER][NUM_ISLAND_TIERS];
 
 	for (int tierIndex = 0; tierIndex < NUM_ISLAND_TIERS; ++tierIndex)
 	{
 		//Use different seeds for the noise functions for each tier
 #pragma todo("Make these functions work off of an actual rng seed")
-		unsigned int seed1 = tierIndex;
-		unsigned int seed2 = seed1 + NUM_ISLAND_TIERS;
-		unsigned int seed3 = seed2 + NUM_ISLAND_TIERS;
+		unsigned int seeds[NUM_CHANNELS_PER_TIER];
+		seeds[DENSITY_CHANNEL] = tierIndex;
+		seeds[THICKNESS_ABOVE_CHANNEL] = seeds[DENSITY_CHANNEL] + NUM_ISLAND_TIERS;
+		seeds[THICKNESS_BELOW_CHANNEL] = seeds[THICKNESS_ABOVE_CHANNEL] + NUM_ISLAND_TIERS;
+
+		float* densities = context.m_columns[GetChannel(tierIndex, DENSITY_CHANNEL)];
+		float* thicknessesAbove = context.m_columns[GetChannel(tierIndex, THICKNESS_ABOVE_CHANNEL)];
+		float* thicknessesBelow = context.m_columns[GetChannel(tierIndex, THICKNESS_BELOW_CHANNEL)];
+
+		//Stagger the grid by 50% each tier.
+		float tierNoiseGridOffset = 0.5f * SKYLANDS_DENSITY_GRID_SIZE * (float)tierIndex;
+		Vector2 noiseOrigin = context.m_chunkMins + Vector2(tierNoiseGridOffset, tierNoiseGridOffset);
+
+		//Fill the channels with island "density" and the raw above & below noise, then shape them into thicknesses in place.
+		if (m_useDensityLattice)
+		{
+			SampleTierNoiseOnLattice(noiseOrigin, seeds, densities, thicknessesAbove, thicknessesBelow);
+		}
+		else
+		{
+			SampleTierNoiseExact(noiseOrigin, seeds, densities, thicknessesAbove, thicknessesBelow);
+		}
 
-		//Determine density and the above & below thicknesses for each column in this chunk
 		for (int columnIndex = 0; columnIndex < Chunk::BLOCKS_PER_LAYER; ++columnIndex)
 		{
 			float thicknessAbove = 0.0f;
 			float thicknessBelow = 0.0f;
-
-			//Compute 2D position to be used in various perlin noise functions; Stagger the grid by 50% each tier.
-			float tierNoiseGridOffset = 0.5f * DENSITY_GRID_SIZE * (float)tierIndex;
-			Vector3 blockPosition = chunk->GetWorldMinsForBlockIndex(columnIndex);
-			Vector2 noisePosition = Vector2(blockPosition.x, blockPosition.y) + Vector2(tierNoiseGridOffset, tierNoiseGridOffset);
-
-			//Compute island "density", used as a threshold to decide if an island exists on this tier, and how far inside the island each column is.
-			float density = Compute2dPerlinNoise(noisePosition.x, noisePosition.y, DENSITY_GRID_SIZE, 1, 0.5, 2.0f, true, seed1);
-			density = MathUtils::RangeMap(density, -1.0f, 1.0f, -MAX_DENSITY, MAX_DENSITY);
+			float density = densities[columnIndex];
 			if (density > 0.0f)
 			{
 				//This column is inside of an island on this tier!
 				//Compute density "fraction", 0 at island edges, increasingly positive in island interiors
-				float densityFraction = (density - MIN_DENSITY) / (MAX_DENSITY - MIN_DENSITY);
+				float densityFraction = (density - MIN_DENSITY) / (SKYLANDS_MAX_DENSITY - MIN_DENSITY);
 				densityFraction = SmoothStop(densityFraction); //Quickly (and non-linearly) ramp up "density" as we come in from the edge
 
 				//Compute thicknessAbove (terrain variation) and deltaThicknessBelow (underbelly variation)
-				thicknessAbove = fabs(Compute2dPerlinNoise(noisePosition.x, noisePosition.y, 70.0f, 6, 0.5f, 2.0f, true, seed2) * 8.0f);
-				float deltaThicknessBelow = fabs(Compute2dPerlinNoise(noisePosition.x, noisePosition.y, 20.0f, 4, 0.5f, 2.0f, true, seed3) * VARIABLE_THICKNESS_BELOW);
+				thicknessAbove = fabs(thicknessesAbove[columnIndex] * 8.0f);
+				float deltaThicknessBelow = fabs(thicknessesBelow[columnIndex] * VARIABLE_THICKNESS_BELOW);
 
 				//Rapidly feather the terrain above down to base island level as we approach island edge
 				float edgeDensityThresholdAbove = 0.05f;
@@ -127,41 +514,358 @@ void SkylandsGenerator::GenerateChunk(Block* blockArray, Chunk* chunk)
 					thicknessBelow = 1.0f - thicknessAbove;
 				}
 			}
-			islandDensityPerColumnPerTier[columnIndex][tierIndex] = density;
-			islandThicknessAbovePerColumnPerTier[columnIndex][tierIndex] = thicknessAbove;
-			islandThicknessBelowPerColumnPerTier[columnIndex][tierIndex] = thicknessBelow;
+			thicknessesAbove[columnIndex] = thicknessAbove;
+			thicknessesBelow[columnIndex] = thicknessBelow;
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------------
+//Evaluates every column. The above & below noise is only needed inside islands, so it's skipped elsewhere.
+void SkylandsGenerator::SampleTierNoiseExact(const Vector2& noiseOrigin, const unsigned int seeds[NUM_CHANNELS_PER_TIER], float* out_densities, float* out_above, float* out_below)
+{
+	SkylandsNoiseParameters densityNoise = SKYLANDS_DENSITY_NOISE;
+	SkylandsNoiseParameters aboveNoise = SKYLANDS_ABOVE_NOISE;
+	SkylandsNoiseParameters belowNoise = SKYLANDS_BELOW_NOISE;
+	densityNoise.m_seed = seeds[DENSITY_CHANNEL];
+	aboveNoise.m_seed = seeds[THICKNESS_ABOVE_CHANNEL];
+	belowNoise.m_seed = seeds[THICKNESS_BELOW_CHANNEL];
+
+	for (int columnIndex = 0; columnIndex < Chunk::BLOCKS_PER_LAYER; ++columnIndex)
+	{
+		Vector3 noisePosition(noiseOrigin.x + static_cast<float>(columnIndex & Chunk::LOCAL_X_MASK), noiseOrigin.y + static_cast<float>(columnIndex >> Chunk::CHUNK_BITS_X), 0.0f);
+		float density = densityNoise.m_sampleFunction(noisePosition, &densityNoise);
+		out_densities[columnIndex] = MathUtils::RangeMap(density, -1.0f, 1.0f, -SKYLANDS_MAX_DENSITY, SKYLANDS_MAX_DENSITY);
+		out_above[columnIndex] = 0.0f;
+		out_below[columnIndex] = 0.0f;
+		if (out_densities[columnIndex] > 0.0f)
+		{
+			out_above[columnIndex] = aboveNoise.m_sampleFunction(noisePosition, &aboveNoise);
+			out_below[columnIndex] = belowNoise.m_sampleFunction(noisePosition, &belowNoise);
 		}
 	}
-	
-	//Populate the actual blocks based on the above data.
+}
+
+//-----------------------------------------------------------------------------------
+//Samples each noise channel on a coarse lattice and interpolates it back up to every column.
+//The lattice is one layer deep, so the trilinear interpolation reduces to bilinear.
+void SkylandsGenerator::SampleTierNoiseOnLattice(const Vector2& noiseOrigin, const unsigned int seeds[NUM_CHANNELS_PER_TIER], float* out_densities, float* out_above, float* out_below)
+{
+	const SkylandsNoiseParameters* channelNoise[NUM_CHANNELS_PER_TIER] = { &SKYLANDS_DENSITY_NOISE, &SKYLANDS_ABOVE_NOISE, &SKYLANDS_BELOW_NOISE };
+	float* channelOutputs[NUM_CHANNELS_PER_TIER] = { out_densities, out_above, out_below };
+	const Vector3 origin(noiseOrigin.x, noiseOrigin.y, 0.0f);
+
+	for (int channel = 0; channel < NUM_CHANNELS_PER_TIER; ++channel)
+	{
+		SkylandsNoiseParameters parameters = *channelNoise[channel];
+		parameters.m_seed = seeds[channel];
+		DensityField field(Vector3Int(Chunk::BLOCKS_WIDE_X, Chunk::BLOCKS_WIDE_Y, 1), Vector3Int(parameters.m_latticeStep, parameters.m_latticeStep, 1));
+		field.SampleLattice(origin, parameters.m_sampleFunction, &parameters);
+		field.Interpolate(channelOutputs[channel]);
+	}
+
+	for (int columnIndex = 0; columnIndex < Chunk::BLOCKS_PER_LAYER; ++columnIndex)
+	{
+		out_densities[columnIndex] = MathUtils::RangeMap(out_densities[columnIndex], -1.0f, 1.0f, -SKYLANDS_MAX_DENSITY, SKYLANDS_MAX_DENSITY);
+	}
+}
+
+//-----------------------------------------------------------------------------------
+void SkylandsGenerator::GenerateDensity(GenerationContext& context)
+{
+	Block* blocks = context.m_blocks;
 	for (int blockIndex = 0; blockIndex < Chunk::BLOCKS_PER_CHUNK; ++blockIndex)
 	{
-		WorldPosition blockMins = chunk->GetWorldMinsForBlockIndex(blockIndex);
-		BlockType blockType = BlockType::AIR;
+		blocks[blockIndex].m_type = BlockType::AIR;
+	}
+
+	//Fill each island's vertical span directly rather than testing every block against every tier.
+	for (int columnIndex = 0; columnIndex < Chunk::BLOCKS_PER_LAYER; ++columnIndex)
+	{
+		for (int tierIndex = 0; tierIndex < NUM_ISLAND_TIERS; ++tierIndex)
+		{
+			int minZ = 0;
+			int maxZ = 0;
+			if (!GetIslandExtentsForColumn(context, columnIndex, tierIndex, minZ, maxZ))
+			{
+				continue;
+			}
+			for (int z = minZ; z <= maxZ; ++z)
+			{
+				blocks[(z << Chunk::CHUNK_BITS_XY) + columnIndex].m_type = BlockType::DIRT;
+			}
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------------
+void SkylandsGenerator::DecorateSurface(GenerationContext& context)
+{
+	Block* blocks = context.m_blocks;
+	for (int columnIndex = 0; columnIndex < Chunk::BLOCKS_PER_LAYER; ++columnIndex)
+	{
 		for (int tierIndex = 0; tierIndex < NUM_ISLAND_TIERS; ++tierIndex)
 		{
-			int columnIndex = blockIndex & 0b11111111;
-			float density = islandDensityPerColumnPerTier[columnIndex][tierIndex];
-			if (density > MIN_DENSITY)
+			int minZ = 0;
+			int maxZ = 0;
+			if (!GetIslandExtentsForColumn(context, columnIndex, tierIndex, minZ, maxZ))
 			{
-				float thicknessBelow = islandThicknessBelowPerColumnPerTier[columnIndex][tierIndex];
-				float thicknessAbove = islandThicknessAbovePerColumnPerTier[columnIndex][tierIndex];
-				float islandBaseZ = ISLAND_SUBLEVELS[tierIndex];
-				float islandMinZ = islandBaseZ - thicknessBelow;
-				float islandMaxZ = islandBaseZ + thicknessAbove;
-				if (blockMins.z >= islandMinZ && blockMins.z <= islandMaxZ)
+				continue;
+			}
+
+			//Higher tiers win where islands overlap, so a top buried inside one of them stays dirt.
+			bool isBuried = false;
+			for (int higherTierIndex = tierIndex + 1; higherTierIndex < NUM_ISLAND_TIERS; ++higherTierIndex)
+			{
+				int higherMinZ = 0;
+				int higherMaxZ = 0;
+				if (GetIslandExtentsForColumn(context, columnIndex, higherTierIndex, higherMinZ, higherMaxZ) && maxZ >= higherMinZ && maxZ <= higherMaxZ)
 				{
-					if (blockMins.z + 1.0f > islandMaxZ)
-					{
-						blockType = BlockType::GRASS;
-					}
-					else
-					{
-						blockType = BlockType::DIRT;
-					}
+					isBuried = true;
+					break;
 				}
 			}
-			blockArray[blockIndex].m_type = static_cast<uchar>(blockType);
+			if (!isBuried)
+			{
+				blocks[(maxZ << Chunk::CHUNK_BITS_XY) + columnIndex].m_type = BlockType::GRASS;
+			}
 		}
 	}
 }
+
+//-----------------------------------------------------------------------------------
+bool SkylandsGenerator::GetIslandExtentsForColumn(const GenerationContext& context, int columnIndex, int tierIndex, int& out_minZ, int& out_maxZ)
+{
+	if (context.m_columns[GetChannel(tierIndex, DENSITY_CHANNEL)][columnIndex] <= MIN_DENSITY)
+	{
+		return false;
+	}
+	float islandBaseZ = ISLAND_SUBLEVELS[tierIndex];
+	float islandMinZ = islandBaseZ - context.m_columns[GetChannel(tierIndex, THICKNESS_BELOW_CHANNEL)][columnIndex];
+	float islandMaxZ = islandBaseZ + context.m_columns[GetChannel(tierIndex, THICKNESS_ABOVE_CHANNEL)][columnIndex];
+	out_minZ = MathUtils::Clamp(static_cast<int>(ceil(islandMinZ)), 0, Chunk::BLOCKS_TALL_Z - 1);
+	out_maxZ = MathUtils::Clamp(static_cast<int>(floor(islandMaxZ)), 0, Chunk::BLOCKS_TALL_Z - 1);
+	return out_minZ <= out_maxZ;
+}
+
+//DETACHED CHUNKS//////////////////////////////////////////////////////////////////////////
+//-----------------------------------------------------------------------------------
+DetachedChunkFactory::DetachedChunkFactory(World* world)
+	: m_world(world)
+	, m_generator(world->m_generator->CreateCopy())
+	, m_firstChunkCoords(world->GetPlayerChunkCoords() + ChunkCoords(1000, 1000))
+{
+}
+
+//-----------------------------------------------------------------------------------
+//Whatever features left for chunks that were never made is dropped with the generator.
+DetachedChunkFactory::~DetachedChunkFactory()
+{
+	delete m_generator;
+}
+
+//-----------------------------------------------------------------------------------
+//The chunk at an offset in chunks from the factory's corner, hooked up to nothing.
+Chunk* DetachedChunkFactory::CreateChunk(int offsetX, int offsetY)
+{
+	Chunk* chunk = new Chunk(m_firstChunkCoords + ChunkCoords(offsetX, offsetY), m_world, *m_generator);
+	chunk->m_isDirty = true;
+	return chunk;
+}
+
+//-----------------------------------------------------------------------------------
+//A gridSize x gridSize block of chunks hooked up to each other, row by row from the south-west corner.
+std::vector<Chunk*> DetachedChunkFactory::CreateGrid(int gridSize)
+{
+	std::vector<Chunk*> chunks(gridSize * gridSize, nullptr);
+	for (int y = 0; y < gridSize; ++y)
+	{
+		for (int x = 0; x < gridSize; ++x)
+		{
+			Chunk* chunk = CreateChunk(x, y);
+			chunks[y * gridSize + x] = chunk;
+			if (x > 0)
+			{
+				chunk->m_westChunk = chunks[y * gridSize + x - 1];
+				chunk->m_westChunk->m_eastChunk = chunk;
+			}
+			if (y > 0)
+			{
+				chunk->m_southChunk = chunks[(y - 1) * gridSize + x];
+				chunk->m_southChunk->m_northChunk = chunk;
+			}
+		}
+	}
+	return chunks;
+}
+
+//-----------------------------------------------------------------------------------
+CONSOLE_COMMAND(skylandsbench)
+{
+	if (!args.HasArgs(1))
+	{
+		Console::instance->PrintLine("skylandsbench <# of chunks>", RGBA::GRAY);
+		return;
+	}
+	int numChunks = args.GetIntArgument(0);
+	if (numChunks <= 0)
+	{
+		return;
+	}
+	const int CHUNKS_PER_ROW = 16;
+	//Generators of their own, so the world's generation thread never sees the mode flip under it.
+	SkylandsGenerator exactGenerator(false);
+	SkylandsGenerator latticeGenerator(true);
+	Block* exactBlocks = new Block[Chunk::BLOCKS_PER_CHUNK];
+	Block* latticeBlocks = new Block[Chunk::BLOCKS_PER_CHUNK];
+	double exactSeconds = 0.0;
+	double latticeSeconds = 0.0;
+	int numDifferentTypes = 0;
+	int numDifferentSolidity = 0;
+	int numSolidBlocks = 0;
+
+	for (int i = 0; i < numChunks; ++i)
+	{
+		ChunkCoords chunkCoords(i % CHUNKS_PER_ROW, i / CHUNKS_PER_ROW);
+
+		StartTiming();
+		exactGenerator.GenerateChunk(exactBlocks, chunkCoords);
+		exactSeconds += EndTiming();
+
+		StartTiming();
+		latticeGenerator.GenerateChunk(latticeBlocks, chunkCoords);
+		latticeSeconds += EndTiming();
+
+		for (int blockIndex = 0; blockIndex < Chunk::BLOCKS_PER_CHUNK; ++blockIndex)
+		{
+			bool isExactSolid = exactBlocks[blockIndex].m_type != BlockType::AIR;
+			bool isLatticeSolid = latticeBlocks[blockIndex].m_type != BlockType::AIR;
+			numSolidBlocks += isExactSolid ? 1 : 0;
+			numDifferentTypes += (exactBlocks[blockIndex].m_type != latticeBlocks[blockIndex].m_type) ? 1 : 0;
+			numDifferentSolidity += (isExactSolid != isLatticeSolid) ? 1 : 0;
+		}
+	}
+	delete[] exactBlocks;
+	delete[] latticeBlocks;
+
+	double totalBlocks = (double)numChunks * (double)Chunk::BLOCKS_PER_CHUNK;
+	Console::instance->PrintLine(Stringf("Exact:   %.01f chunks/sec (%.03f ms/chunk)", numChunks / exactSeconds, (exactSeconds * 1000.0) / numChunks), RGBA::WHITE);
+	Console::instance->PrintLine(Stringf("Lattice: %.01f chunks/sec (%.03f ms/chunk), %.02fx", numChunks / latticeSeconds, (latticeSeconds * 1000.0) / numChunks, exactSeconds / latticeSeconds), RGBA::WHITE);
+	Console::instance->PrintLine(Stringf("Blocks differing: %.03f%% by type, %.03f%% solid/air (%.03f%% of solid blocks)", (100.0 * numDifferentTypes) / totalBlocks, (100.0 * numDifferentSolidity) / totalBlocks, numSolidBlocks > 0 ? (100.0 * numDifferentSolidity) / numSolidBlocks : 0.0), RGBA::GOLD);
+}
+
+//-----------------------------------------------------------------------------------
+struct FeatureBenchJob
+{
+	Generator* m_generator;
+	Block* m_blocks;
+	int m_firstChunk;
+	int m_numChunks;
+	int m_chunksPerRow;
+};
+
+//-----------------------------------------------------------------------------------
+static void GenerateFeatureBenchChunks(FeatureBenchJob job)
+{
+	for (int i = job.m_firstChunk; i < job.m_firstChunk + job.m_numChunks; ++i)
+	{
+		job.m_generator->GenerateChunk(&job.m_blocks[i * Chunk::BLOCKS_PER_CHUNK], ChunkCoords(i % job.m_chunksPerRow, i / job.m_chunksPerRow));
+	}
+}
+
+//-----------------------------------------------------------------------------------
+//Edits aimed at chunks generated earlier in the pass are still waiting; in game these land on activation.
+static void ApplyLeftoverFeatureBenchWrites(Generator& generator, Block* blocks, int numChunks, int chunksPerRow)
+{
+	DeferredBlockWriteList pendingWrites;
+	for (int i = 0; i < numChunks; ++i)
+	{
+		if (generator.GetDeferredBlockWrites().Take(ChunkCoords(i % chunksPerRow, i / chunksPerRow), pendingWrites))
+		{
+			DeferredBlockWriteQueue::ApplyWrites(&blocks[i * Chunk::BLOCKS_PER_CHUNK], pendingWrites);
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------------
+CONSOLE_COMMAND(featurebench)
+{
+	if (!args.HasArgs(1))
+	{
+		Console::instance->PrintLine("featurebench <# of chunks>", RGBA::GRAY);
+		return;
+	}
+	int numChunks = args.GetIntArgument(0);
+	if (numChunks <= 0)
+	{
+		return;
+	}
+	const int CHUNKS_PER_ROW = 16;
+	const float DENSE_TREE_CHANCE = 0.05f;
+	const int DENSE_ORE_VEINS = 24;
+	Block* sequentialBlocks = new Block[numChunks * Chunk::BLOCKS_PER_CHUNK];
+	Block* parallelBlocks = new Block[numChunks * Chunk::BLOCKS_PER_CHUNK];
+
+	//Baseline: no features at all. Every pass gets a generator of its own, so the world's generation thread never
+	//sees the feature density change under it.
+	double plainSeconds = 0.0;
+	{
+		EarthGenerator generator(0.0f, 0);
+		FeatureBenchJob job = { &generator, sequentialBlocks, 0, numChunks, CHUNKS_PER_ROW };
+		StartTiming();
+		GenerateFeatureBenchChunks(job);
+		plainSeconds = EndTiming();
+	}
+
+	double sequentialSeconds = 0.0;
+	int numWritesPosted = 0;
+	int numWritesOutsideGrid = 0;
+	{
+		EarthGenerator generator(DENSE_TREE_CHANCE, DENSE_ORE_VEINS);
+		FeatureBenchJob job = { &generator, sequentialBlocks, 0, numChunks, CHUNKS_PER_ROW };
+		StartTiming();
+		GenerateFeatureBenchChunks(job);
+		sequentialSeconds = EndTiming();
+		ApplyLeftoverFeatureBenchWrites(generator, sequentialBlocks, numChunks, CHUNKS_PER_ROW);
+		numWritesPosted = generator.GetDeferredBlockWrites().GetNumWritesPosted();
+		numWritesOutsideGrid = generator.GetDeferredBlockWrites().GetNumPendingWrites();
+	}
+
+	//Same chunks spread across every hardware thread, all sharing one queue.
+	int numThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	double parallelSeconds = 0.0;
+	{
+		EarthGenerator generator(DENSE_TREE_CHANCE, DENSE_ORE_VEINS);
+		std::vector<std::thread> threads;
+		int chunksPerThread = (numChunks + numThreads - 1) / numThreads;
+		StartTiming();
+		for (int firstChunk = 0; firstChunk < numChunks; firstChunk += chunksPerThread)
+		{
+			FeatureBenchJob job = { &generator, parallelBlocks, firstChunk, std::min(chunksPerThread, numChunks - firstChunk), CHUNKS_PER_ROW };
+			threads.push_back(std::thread(&GenerateFeatureBenchChunks, job));
+		}
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+		parallelSeconds = EndTiming();
+		ApplyLeftoverFeatureBenchWrites(generator, parallelBlocks, numChunks, CHUNKS_PER_ROW);
+	}
+
+	int numMismatches = 0;
+	int numFeatureBlocks = 0;
+	for (int blockIndex = 0; blockIndex < numChunks * Chunk::BLOCKS_PER_CHUNK; ++blockIndex)
+	{
+		uchar type = sequentialBlocks[blockIndex].m_type;
+		numMismatches += (type != parallelBlocks[blockIndex].m_type) ? 1 : 0;
+		numFeatureBlocks += (type == BlockType::WOOD || type == BlockType::LEAVES || type == BlockType::IRON) ? 1 : 0;
+	}
+	delete[] sequentialBlocks;
+	delete[] parallelBlocks;
+
+	Console::instance->PrintLine(Stringf("No features:      %.01f chunks/sec (%.03f ms/chunk)", numChunks / plainSeconds, (plainSeconds * 1000.0) / numChunks), RGBA::WHITE);
+	Console::instance->PrintLine(Stringf("Dense features:   %.01f chunks/sec (%.03f ms/chunk)", numChunks / sequentialSeconds, (sequentialSeconds * 1000.0) / numChunks), RGBA::WHITE);
+	Console::instance->PrintLine(Stringf("%2i threads:       %.01f chunks/sec (%.03f ms/chunk), %.02fx", numThreads, numChunks / parallelSeconds, (parallelSeconds * 1000.0) / numChunks, sequentialSeconds / parallelSeconds), RGBA::WHITE);
+	Console::instance->PrintLine(Stringf("%i feature blocks, %i cross-chunk writes posted, %i left for chunks outside the grid", numFeatureBlocks, numWritesPosted, numWritesOutsideGrid), RGBA::WHITE);
+	Console::instance->PrintLine(Stringf("Blocks differing between sequential and threaded: %i", numMismatches), numMismatches == 0 ? RGBA::GOLD : RGBA::RED);
+}
@@ -1,32 +1,183 @@
 #pragma once
 #include "Game/GameCommon.hpp"
+#include "Game/Chunk.hpp"
+#include "Game/DeferredBlockWriteQueue.hpp"
+#include "Engine/Core/Memory/UntrackedAllocator.hpp"
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 class Block;
-class Chunk;
+class World;
 
 //-----------------------------------------------------------------------------------
+//Scratch data handed from stage to stage while a single chunk is generated.
+//Only the thread generating the chunk ever touches it, so stages need no locking.
+struct GenerationContext
+{
+	static const int MAX_COLUMN_CHANNELS = 16;
+
+	GenerationContext(Block* blockArray, const ChunkCoords& chunkCoords);
+	//Local coordinates may run past the chunk's x/y edges; those edits are deferred to the neighbor.
+	void SetBlockType(int localX, int localY, int localZ, uchar type, uchar replaceType);
+
+	Block* m_blocks;
+	ChunkCoords m_chunkCoords;
+	Vector2 m_chunkMins;
+	//Per-column values (heights, island thicknesses, biome data...), indexed [channel][columnIndex].
+	float m_columns[MAX_COLUMN_CHANNELS][Chunk::BLOCKS_PER_LAYER];
+	//Feature edits that landed outside this chunk, posted all at once when the chunk is finished.
+	std::map<ChunkCoords, DeferredBlockWriteList> m_deferredWrites;
+};
+
+//-----------------------------------------------------------------------------------
+//Generators are a fixed pipeline of whole-array stages:
+//	Columns: 2D per-column data, a pure function of the chunk's coordinates.
+//	Density: fills the solid volume (stone, water, air).
+//	Surface: decorates the top of the volume (grass, sand).
+//	Features: structures like trees and ore veins, which are free to spill into neighboring chunks.
+//Since the column stage only depends on where the chunk is, its results are cached by chunk, and the column thread
+//can work them out for queued chunks while the generation thread is still busy with earlier ones.
 class Generator
 {
 public:
-	Generator() {};
-	~Generator() {};
-	virtual void GenerateChunk(Block* blockArray, Chunk* chunk) = 0;
+	Generator();
+	virtual ~Generator();
+	void GenerateChunk(Block* blockArray, Chunk* chunk);
+	void GenerateChunk(Block* blockArray, const ChunkCoords& chunkCoords);
+	inline DeferredBlockWriteQueue& GetDeferredBlockWrites() { return m_deferredBlockWrites; };
+	//Same settings, but an empty deferred write queue and column cache of its own, not profiled and no column thread.
+	virtual Generator* CreateCopy() const = 0;
+	//Only the world's own generator, which runs on the generation thread, fills in the generation profiling channels.
+	inline void SetProfiled(bool isProfiled) { m_isProfiled = isProfiled; };
+	//The column thread calls into the derived generator, so it has to be stopped before the generator is deleted.
+	void StartColumnThread();
+	void StopColumnThread();
+	void QueueColumns(const ChunkCoords& chunkCoords);
+
+	//CONSTANTS//////////////////////////////////////////////////////////////////////////
+	static const int MAX_CACHED_COLUMN_CHUNKS = 512;
+
+protected:
+	//STAGES//////////////////////////////////////////////////////////////////////////
+	//How many of the context's column channels GenerateColumns fills in, and so how many get cached.
+	virtual int GetNumColumnChannels() const = 0;
+	virtual void GenerateColumns(GenerationContext& context) = 0;
+	virtual void GenerateDensity(GenerationContext& context) = 0;
+	virtual void DecorateSurface(GenerationContext& context) = 0;
+	virtual void PlaceFeatures(GenerationContext& context) { UNUSED(context); };
+
+private:
+	typedef std::vector<float, UntrackedAllocator<float>> ColumnValues;
+	typedef std::map<ChunkCoords, ColumnValues, std::less<ChunkCoords>, UntrackedAllocator<std::pair<const ChunkCoords, ColumnValues>>> ColumnCacheMap;
+	typedef std::deque<ChunkCoords, UntrackedAllocator<ChunkCoords>> ChunkCoordsDeque;
+
+	//FUNCTIONS//////////////////////////////////////////////////////////////////////////
+	bool CopyCachedColumns(GenerationContext& context);
+	void CacheColumns(const GenerationContext& context);
+	bool IsColumnCached(const ChunkCoords& chunkCoords);
+	static void ColumnThreadMain(Generator* generator);
+
+	//MEMBER VARIABLES//////////////////////////////////////////////////////////////////////////
+	DeferredBlockWriteQueue m_deferredBlockWrites;
+	bool m_isProfiled;
+	std::mutex m_columnCacheLock; //Guards the cache and its eviction order.
+	ColumnCacheMap m_cachedColumns;
+	ChunkCoordsDeque m_cachedColumnsOrder; //Oldest first; the oldest is dropped once the cache is full.
+	std::mutex m_columnQueueLock; //Guards the queue and m_isColumnThreadStopping.
+	std::condition_variable m_columnsQueued;
+	ChunkCoordsDeque m_queuedColumns;
+	bool m_isColumnThreadStopping;
+	std::thread m_columnThread;
 };
 
 //-----------------------------------------------------------------------------------
 class EarthGenerator : public Generator
 {
 public:
-	EarthGenerator() {};
-	~EarthGenerator() {};
-	virtual void GenerateChunk(Block* blockArray, Chunk* chunk);
+	EarthGenerator();
+	EarthGenerator(float treeChancePerColumn, int oreVeinsPerChunk);
+	virtual ~EarthGenerator() {};
+	virtual Generator* CreateCopy() const { return new EarthGenerator(m_treeChancePerColumn, m_oreVeinsPerChunk); };
+
+protected:
+	virtual int GetNumColumnChannels() const { return NUM_COLUMN_CHANNELS; };
+	virtual void GenerateColumns(GenerationContext& context);
+	virtual void GenerateDensity(GenerationContext& context);
+	virtual void DecorateSurface(GenerationContext& context);
+	virtual void PlaceFeatures(GenerationContext& context);
+
+private:
+	enum ColumnChannel
+	{
+		HEIGHT_CHANNEL = 0,
+		NUM_COLUMN_CHANNELS
+	};
+
+	static void PlaceTree(GenerationContext& context, int localX, int localY, int groundZ, unsigned int treeNoise);
+	static void PlaceOreVein(GenerationContext& context, unsigned int veinNoise);
+
+	//Chance for a grass column to grow a tree, and ore veins started per chunk.
+	//Fixed for the generator's lifetime, since the generation thread reads them mid-chunk.
+	const float m_treeChancePerColumn;
+	const int m_oreVeinsPerChunk;
 };
 
 //-----------------------------------------------------------------------------------
 class SkylandsGenerator : public Generator
 {
 public:
-	SkylandsGenerator() {};
-	~SkylandsGenerator() {};
-	virtual void GenerateChunk(Block* blockArray, Chunk* chunk);
+	SkylandsGenerator(bool useDensityLattice = true) : m_useDensityLattice(useDensityLattice) {};
+	virtual ~SkylandsGenerator() {};
+	virtual Generator* CreateCopy() const { return new SkylandsGenerator(m_useDensityLattice); };
+
+protected:
+	virtual int GetNumColumnChannels() const { return NUM_ISLAND_TIERS * NUM_CHANNELS_PER_TIER; };
+	virtual void GenerateColumns(GenerationContext& context);
+	virtual void GenerateDensity(GenerationContext& context);
+	virtual void DecorateSurface(GenerationContext& context);
+
+private:
+	//Each tier gets three consecutive column channels.
+	enum ColumnChannel
+	{
+		DENSITY_CHANNEL = 0,
+		THICKNESS_ABOVE_CHANNEL,
+		THICKNESS_BELOW_CHANNEL,
+		NUM_CHANNELS_PER_TIER
+	};
+	static const int NUM_ISLAND_TIERS = 4;
+	static const float ISLAND_SUBLEVELS[NUM_ISLAND_TIERS];
+	static const float MIN_DENSITY;
+
+	inline static int GetChannel(int tierIndex, ColumnChannel channel) { return (tierIndex * NUM_CHANNELS_PER_TIER) + channel; };
+	static void SampleTierNoiseExact(const Vector2& noiseOrigin, const unsigned int seeds[NUM_CHANNELS_PER_TIER], float* out_densities, float* out_above, float* out_below);
+	static void SampleTierNoiseOnLattice(const Vector2& noiseOrigin, const unsigned int seeds[NUM_CHANNELS_PER_TIER], float* out_densities, float* out_above, float* out_below);
+	static bool GetIslandExtentsForColumn(const GenerationContext& context, int columnIndex, int tierIndex, int& out_minZ, int& out_maxZ);
+
+	//Column noise is sampled on a coarse lattice and interpolated; false evaluates every column exactly.
+	//Fixed for the generator's lifetime, since the generation thread reads it mid-chunk.
+	const bool m_useDensityLattice;
+};
+
+//-----------------------------------------------------------------------------------
+//Chunks for benches and test fixtures, generated like the world's but never part of it. They sit far from anything
+//loaded and come from a copy of the world's generator, so features spilling over their edges stay in the copy's
+//queue instead of landing in the world later, and nothing stamps the generation thread's profiling channels.
+//They're marked dirty so nothing adds them to the world's lists. Main thread only.
+class DetachedChunkFactory
+{
+public:
+	DetachedChunkFactory(World* world);
+	~DetachedChunkFactory();
+	Chunk* CreateChunk(int offsetX, int offsetY);
+	std::vector<Chunk*> CreateGrid(int gridSize);
+
+private:
+	World* m_world;
+	Generator* m_generator;
+	ChunkCoords m_firstChunkCoords;
 };
@@ -0,0 +1,566 @@
+#include "Game/LightingEngine.hpp"
+#include "Game/World.hpp"
+#include "Game/Generator.hpp"
+#include "Game/Block.hpp"
+#include "Game/BlockDefinition.h"
+#include "Engine/Input/Console.hpp"
+#include "Engine/Time/Time.hpp"
+
+uchar Block::* const LightingEngine::s_channelLights[NUM_LIGHT_CHANNELS] = { &Block::m_redLight, &Block::m_greenLight, &Block::m_blueLight, &Block::m_skyRedLight, &Block::m_skyGreenLight, &Block::m_skyBlueLight };
+const int LightingEngine::s_channelShifts[NUM_LIGHT_CHANNELS] = { RGBA::SHIFT_RED, RGBA::SHIFT_GREEN, RGBA::SHIFT_BLUE, RGBA::SHIFT_RED, RGBA::SHIFT_GREEN, RGBA::SHIFT_BLUE };
+double LightingEngine::s_frameBudgetSeconds = 0.002;
+
+//-----------------------------------------------------------------------------------
+LightingEngine::LightingEngine(World* world)
+    : m_world(world)
+    , m_playerChunkCoords(0, 0)
+    , m_budgetDeadline(0.0)
+    , m_numBlocksVisitedThisUpdate(0)
+    , m_numBlocksVisitedLastUpdate(0)
+{
+}
+
+//-----------------------------------------------------------------------------------
+//The block's type, sky bit or surroundings changed, so whatever light it had (and passed on) is suspect.
+void LightingEngine::QueueRelight(const BlockInfo& info)
+{
+    Block* block = info.GetBlock();
+    if (!block)
+    {
+        return;
+    }
+    bool hasSourceLight = false;
+    for (int channelIndex = 0; channelIndex < NUM_LIGHT_CHANNELS; ++channelIndex)
+    {
+        LightChannel channel = static_cast<LightChannel>(channelIndex);
+        uchar& light = block->*s_channelLights[channel];
+        uchar sourceLight = GetSourceLight(info, channel);
+        PushRemoval(info, light, channel);
+        if (light != sourceLight)
+        {
+            light = sourceLight;
+            DirtyChunksShowingBlock(info);
+        }
+        hasSourceLight = hasSourceLight || sourceLight > 0;
+    }
+    if (hasSourceLight)
+    {
+        PushAddition(info);
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//The block's own light is already right, but its neighbors may not have received it yet.
+void LightingEngine::QueueSpread(const BlockInfo& info)
+{
+    PushAddition(info);
+}
+
+//-----------------------------------------------------------------------------------
+//Works through the queued light changes, nearest the player first, and returns the number of blocks visited.
+//A budget of 0 runs every queue dry; otherwise whatever is left once the budget runs out waits for the next call.
+int LightingEngine::Update(double budgetSeconds)
+{
+    m_playerChunkCoords = m_world->GetPlayerChunkCoords();
+    m_budgetDeadline = (budgetSeconds > 0.0) ? GetCurrentTimeSeconds() + budgetSeconds : 0.0;
+    m_numBlocksVisitedThisUpdate = 0;
+    bool hasBudgetLeft = true;
+    //Far-away blocks can spread light back into the near queues, so keep going until everything is empty.
+    while (hasBudgetLeft && !IsIdle())
+    {
+        for (int priorityIndex = 0; priorityIndex < NUM_LIGHT_PRIORITIES && hasBudgetLeft; ++priorityIndex)
+        {
+            LightPriority priority = static_cast<LightPriority>(priorityIndex);
+            for (int channelIndex = 0; channelIndex < NUM_LIGHT_CHANNELS && hasBudgetLeft; ++channelIndex)
+            {
+                hasBudgetLeft = PropagateRemovals(priority, static_cast<LightChannel>(channelIndex));
+            }
+            hasBudgetLeft = hasBudgetLeft && PropagateAdditions(priority);
+        }
+    }
+    //Nothing left can carry a retired id, so there's no need to remember them.
+    if (!m_purgedQueueIDs.empty() && IsIdle())
+    {
+        m_purgedQueueIDs.clear();
+    }
+    m_numBlocksVisitedLastUpdate = m_numBlocksVisitedThisUpdate;
+    return m_numBlocksVisitedThisUpdate;
+}
+
+//-----------------------------------------------------------------------------------
+//The chunk is about to be saved and deleted, so nothing may still point into it. Whatever it still has queued
+//is left where it is and dropped when it comes up; anything queued for it from now on gets the new id.
+void LightingEngine::PurgeChunk(Chunk* chunk)
+{
+    m_purgedQueueIDs.insert(chunk->m_lightingQueueID);
+    chunk->m_lightingQueueID = Chunk::GetNewLightingQueueID();
+}
+
+//-----------------------------------------------------------------------------------
+bool LightingEngine::IsIdle() const
+{
+    return GetNumQueuedBlocks() == 0;
+}
+
+//-----------------------------------------------------------------------------------
+int LightingEngine::GetNumQueuedBlocks() const
+{
+    int numQueuedBlocks = 0;
+    for (int priorityIndex = 0; priorityIndex < NUM_LIGHT_PRIORITIES; ++priorityIndex)
+    {
+        for (int channelIndex = 0; channelIndex < NUM_LIGHT_CHANNELS; ++channelIndex)
+        {
+            numQueuedBlocks += static_cast<int>(m_removalQueues[priorityIndex][channelIndex].size());
+        }
+        numQueuedBlocks += static_cast<int>(m_additionQueues[priorityIndex].size());
+    }
+    return numQueuedBlocks;
+}
+
+//-----------------------------------------------------------------------------------
+//The light a block has on its own, before anything spreads into it: its glow, or full sky if it can see it.
+uchar LightingEngine::GetSourceLight(const BlockInfo& info, LightChannel channel)
+{
+    Block* block = info.GetBlock();
+    BlockDefinition* definition = block->GetDefinition();
+    if (channel < SKY_RED_CHANNEL)
+    {
+        return static_cast<uchar>((definition->m_illumination >> s_channelShifts[channel]) & 0xFF);
+    }
+    return (!definition->m_isOpaque && block->IsSky()) ? FULL_SKY_LIGHT : 0x00;
+}
+
+//-----------------------------------------------------------------------------------
+bool LightingEngine::CanSpreadLight(const Block* block)
+{
+    return block->m_redLight > LIGHT_FALLOFF || block->m_greenLight > LIGHT_FALLOFF || block->m_blueLight > LIGHT_FALLOFF
+        || block->m_skyRedLight > LIGHT_FALLOFF || block->m_skyGreenLight > LIGHT_FALLOFF || block->m_skyBlueLight > LIGHT_FALLOFF;
+}
+
+//-----------------------------------------------------------------------------------
+//Darken every neighbor dimmer than the light we lost, since it may have come from us. Anything at
+//least as bright is lit from somewhere else, so it gets to flood back in during the addition pass.
+//Returns false if the budget ran out before the queue did.
+bool LightingEngine::PropagateRemovals(LightPriority priority, LightChannel channel)
+{
+    uchar Block::* const channelLight = s_channelLights[channel];
+    std::deque<LightRemovalNode>& removalQueue = m_removalQueues[priority][channel];
+    while (!removalQueue.empty())
+    {
+        if (!HasBudgetLeft())
+        {
+            return false;
+        }
+        LightRemovalNode node = removalQueue.front();
+        removalQueue.pop_front();
+        if (IsPurged(node.m_queueID))
+        {
+            continue;
+        }
+        ++m_numBlocksVisitedThisUpdate;
+        for (Direction direction : BlockInfo::directions)
+        {
+            BlockInfo neighbor = node.m_info.GetNeighbor(direction);
+            if (!neighbor.IsValid())
+            {
+                continue;
+            }
+            Block* neighborBlock = neighbor.GetBlock();
+            uchar neighborLight = neighborBlock->*channelLight;
+            if (neighborLight == 0)
+            {
+                continue;
+            }
+            //A neighbor already down at its own source light (including every opaque block) has nothing to lose.
+            LightingEngine* neighborEngine = GetOwningEngine(neighbor);
+            uchar sourceLight = GetSourceLight(neighbor, channel);
+            if (neighborLight < node.m_oldLight && neighborLight > sourceLight)
+            {
+                neighborEngine->PushRemoval(neighbor, neighborLight, channel);
+                neighborBlock->*channelLight = sourceLight;
+                DirtyChunksShowingBlock(neighbor);
+                if (sourceLight > 0)
+                {
+                    neighborEngine->PushAddition(neighbor);
+                }
+            }
+            else
+            {
+                neighborEngine->PushAddition(neighbor);
+            }
+        }
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//Same falloff and filtering the old per-block evaluation used: one step of falloff, then the
+//neighbor's opacity, neither going below zero. Opaque blocks only ever show their own glow.
+//Glow and sky spread side by side, and a neighbor brightened by either is passed on.
+bool LightingEngine::PropagateAdditions(LightPriority priority)
+{
+    std::deque<LightAdditionNode>& additionQueue = m_additionQueues[priority];
+    while (!additionQueue.empty())
+    {
+        if (!HasBudgetLeft())
+        {
+            return false;
+        }
+        LightAdditionNode node = additionQueue.front();
+        additionQueue.pop_front();
+        if (IsPurged(node.m_queueID))
+        {
+            continue;
+        }
+        ++m_numBlocksVisitedThisUpdate;
+        const BlockInfo& info = node.m_info;
+        Block* block = info.GetBlock();
+        if (!CanSpreadLight(block))
+        {
+            continue;
+        }
+        PackedLight light = block->GetPackedLight();
+        PackedLight skyLight = block->GetPackedSkyLight();
+        for (Direction direction : BlockInfo::directions)
+        {
+            BlockInfo neighbor = info.GetNeighbor(direction);
+            if (!neighbor.IsValid())
+            {
+                continue;
+            }
+            Block* neighborBlock = neighbor.GetBlock();
+            BlockDefinition* neighborDefinition = neighborBlock->GetDefinition();
+            if (neighborDefinition->m_isOpaque)
+            {
+                continue;
+            }
+            PackedLight spreadLight = SubtractPackedLight(light, neighborDefinition->m_packedAttenuation);
+            PackedLight spreadSkyLight = SubtractPackedLight(skyLight, neighborDefinition->m_packedAttenuation);
+            PackedLight neighborLight = neighborBlock->GetPackedLight();
+            PackedLight neighborSkyLight = neighborBlock->GetPackedSkyLight();
+            bool isBrighter = IsPackedLightBrighter(spreadLight, neighborLight);
+            bool isSkyBrighter = IsPackedLightBrighter(spreadSkyLight, neighborSkyLight);
+            if (isBrighter || isSkyBrighter)
+            {
+                if (isBrighter)
+                {
+                    neighborBlock->SetPackedLight(MaxPackedLight(spreadLight, neighborLight));
+                }
+                if (isSkyBrighter)
+                {
+                    neighborBlock->SetPackedSkyLight(MaxPackedLight(spreadSkyLight, neighborSkyLight));
+                }
+                DirtyChunksShowingBlock(neighbor);
+                GetOwningEngine(neighbor)->PushAddition(neighbor);
+            }
+        }
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+void LightingEngine::PushRemoval(const BlockInfo& info, uchar oldLight, LightChannel channel)
+{
+    m_removalQueues[GetPriority(info)][channel].emplace_back(info, oldLight, info.m_chunk->m_lightingQueueID);
+}
+
+//-----------------------------------------------------------------------------------
+void LightingEngine::PushAddition(const BlockInfo& info)
+{
+    m_additionQueues[GetPriority(info)].emplace_back(info, info.m_chunk->m_lightingQueueID);
+}
+
+//-----------------------------------------------------------------------------------
+//Uses the player's chunk as of the last Update, which is close enough for sorting.
+LightingEngine::LightPriority LightingEngine::GetPriority(const BlockInfo& info) const
+{
+    ChunkCoords offset = info.m_chunk->m_chunkPosition - m_playerChunkCoords;
+    if (abs(offset.x) <= NEAR_PLAYER_CHUNK_RADIUS && abs(offset.y) <= NEAR_PLAYER_CHUNK_RADIUS)
+    {
+        return NEAR_PLAYER;
+    }
+    return FAR_FROM_PLAYER;
+}
+
+//-----------------------------------------------------------------------------------
+//Reading the clock for every block would cost more than the blocks, so only check it every so often.
+//Every Update gets through at least one batch, so the queues always drain eventually.
+bool LightingEngine::HasBudgetLeft() const
+{
+    if (m_budgetDeadline == 0.0 || m_numBlocksVisitedThisUpdate == 0 || (m_numBlocksVisitedThisUpdate % BLOCKS_PER_BUDGET_CHECK) != 0)
+    {
+        return true;
+    }
+    return GetCurrentTimeSeconds() < m_budgetDeadline;
+}
+
+//-----------------------------------------------------------------------------------
+//Almost always nothing has been purged, so skip the lookup unless something has.
+bool LightingEngine::IsPurged(unsigned int queueID) const
+{
+    return !m_purgedQueueIDs.empty() && m_purgedQueueIDs.count(queueID) != 0;
+}
+
+//-----------------------------------------------------------------------------------
+LightingEngine* LightingEngine::GetOwningEngine(const BlockInfo& info)
+{
+    return &info.m_chunk->m_world->m_lightingEngine;
+}
+
+//-----------------------------------------------------------------------------------
+//Faces are colored by the light of the block in front of them, so blocks on an edge show up in
+//the neighboring chunk's mesh too. Only the sections around the block need rebuilding.
+void LightingEngine::DirtyChunksShowingBlock(const BlockInfo& info)
+{
+    uchar meshSections = Chunk::GetMeshSectionsShowingBlock(info.m_index);
+    info.m_chunk->DirtyAndAddToDirtyList(meshSections);
+    if (!info.GetBlock()->IsEdgeBlock())
+    {
+        return;
+    }
+    Chunk* chunk = info.m_chunk;
+    if (info.IsOnEast() && chunk->m_eastChunk)
+    {
+        chunk->m_eastChunk->DirtyAndAddToDirtyList(meshSections);
+    }
+    else if (info.IsOnWest() && chunk->m_westChunk)
+    {
+        chunk->m_westChunk->DirtyAndAddToDirtyList(meshSections);
+    }
+    if (info.IsOnNorth() && chunk->m_northChunk)
+    {
+        chunk->m_northChunk->DirtyAndAddToDirtyList(meshSections);
+    }
+    else if (info.IsOnSouth() && chunk->m_southChunk)
+    {
+        chunk->m_southChunk->DirtyAndAddToDirtyList(meshSections);
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//Does what placing or digging does to the sky bits of the column below, then relights everything it touched.
+static void SetBlockTypeForLightBench(LightingEngine& lightingEngine, const BlockInfo& info, uchar type)
+{
+    info.GetBlock()->m_type = type;
+    info.m_chunk->DirtyAndAddToDirtyList();
+    info.m_chunk->UpdateHeightMap(info.m_index);
+    int height = info.m_chunk->GetHeight(info.m_index & (Chunk::LOCAL_X_MASK | Chunk::LOCAL_Y_MASK));
+    bool isSky = (info.m_index >> Chunk::CHUNK_BITS_XY) >= height;
+    info.GetBlock()->SetSky(isSky);
+    lightingEngine.QueueRelight(info);
+    for (BlockInfo belowInfo = info.GetBelow(); belowInfo.IsValid(); belowInfo = belowInfo.GetBelow())
+    {
+        Block* belowBlock = belowInfo.GetBlock();
+        if (belowBlock->GetDefinition()->m_blocksSky || belowBlock->IsSky() == isSky)
+        {
+            break;
+        }
+        belowBlock->SetSky(isSky);
+        lightingEngine.QueueRelight(belowInfo);
+    }
+}
+
+//-----------------------------------------------------------------------------------
+static void TimeLightBenchEdit(LightingEngine& lightingEngine, const char* name, const BlockInfo& info, uchar type)
+{
+    StartTiming();
+    SetBlockTypeForLightBench(lightingEngine, info, type);
+    int numBlocksVisited = lightingEngine.Update();
+    double seconds = EndTiming();
+    Console::instance->PrintLine(Stringf("%-24s %7i blocks visited, %.03f ms", name, numBlocksVisited, seconds * 1000.0), RGBA::WHITE);
+}
+
+//-----------------------------------------------------------------------------------
+//Edits the world around the player and puts everything back afterwards.
+CONSOLE_COMMAND(lightbench)
+{
+    UNUSED(args);
+    World* world = TheGame::instance->m_worlds[TheGame::instance->m_currentlyRenderedWorldID];
+    LightingEngine& lightingEngine = world->m_lightingEngine;
+    world->UpdateLighting();
+    lightingEngine.Update();
+    WorldPosition playerPosition = world->GetPlayerPosition();
+    WorldCoords playerCoords(static_cast<int>(floor(playerPosition.x)), static_cast<int>(floor(playerPosition.y)), static_cast<int>(floor(playerPosition.z)));
+
+    //A glowstone in the first open block over the player's head.
+    BlockInfo lampInfo = BlockInfo::INVALID_BLOCKINFO;
+    for (int height = 1; height <= 4 && !lampInfo.IsValid(); ++height)
+    {
+        BlockInfo candidateInfo = world->GetBlockInfoFromWorldCoords(playerCoords + WorldCoords(0, 0, height));
+        if (candidateInfo.IsValid() && candidateInfo.GetBlock()->m_type == BlockType::AIR)
+        {
+            lampInfo = candidateInfo;
+        }
+    }
+    if (lampInfo.IsValid())
+    {
+        TimeLightBenchEdit(lightingEngine, "Place glowstone", lampInfo, BlockType::GLOWSTONE);
+        TimeLightBenchEdit(lightingEngine, "Remove glowstone", lampInfo, BlockType::AIR);
+    }
+    else
+    {
+        Console::instance->PrintLine("No open block over the player's head for the glowstone test.", RGBA::RED);
+    }
+
+    //Tunnel up to the surface a few blocks away from the player, break through, then fill it back in.
+    const int SHAFT_DEPTH = 8;
+    BlockInfo surfaceInfo = world->GetBlockInfoFromWorldCoords(WorldCoords(playerCoords.x + 3, playerCoords.y, Chunk::BLOCKS_TALL_Z - 1));
+    while (surfaceInfo.IsValid() && !surfaceInfo.GetBlock()->GetDefinition()->m_isOpaque)
+    {
+        surfaceInfo = surfaceInfo.GetBelow();
+    }
+    BlockInfo shaftInfos[SHAFT_DEPTH];
+    uchar shaftTypes[SHAFT_DEPTH];
+    BlockInfo shaftInfo = surfaceInfo;
+    int shaftDepth = 0;
+    while (shaftDepth < SHAFT_DEPTH && shaftInfo.IsValid())
+    {
+        shaftInfos[shaftDepth] = shaftInfo;
+        shaftTypes[shaftDepth] = shaftInfo.GetBlock()->m_type;
+        ++shaftDepth;
+        shaftInfo = shaftInfo.GetBelow();
+    }
+    if (shaftDepth == SHAFT_DEPTH)
+    {
+        for (int i = SHAFT_DEPTH - 1; i > 0; --i)
+        {
+            SetBlockTypeForLightBench(lightingEngine, shaftInfos[i], BlockType::AIR);
+        }
+        lightingEngine.Update();
+        TimeLightBenchEdit(lightingEngine, "Dig through to the sky", shaftInfos[0], BlockType::AIR);
+        TimeLightBenchEdit(lightingEngine, "Seal the shaft", shaftInfos[0], shaftTypes[0]);
+        for (int i = 1; i < SHAFT_DEPTH; ++i)
+        {
+            SetBlockTypeForLightBench(lightingEngine, shaftInfos[i], shaftTypes[i]);
+        }
+        lightingEngine.Update();
+    }
+    else
+    {
+        Console::instance->PrintLine("No surface next to the player for the shaft test.", RGBA::RED);
+    }
+
+    //A freshly generated chunk far from anything loaded, lit on its own the way the worker threads do it.
+    DetachedChunkFactory detachedChunks(world);
+    Chunk* freshChunk = detachedChunks.CreateChunk(0, 0);
+    StartTiming();
+    freshChunk->CalculateLocalLighting();
+    double seconds = EndTiming();
+    delete freshChunk;
+    Console::instance->PrintLine(Stringf("%-24s %.03f ms (worker thread)", "Light fresh chunk", seconds * 1000.0), RGBA::WHITE);
+}
+
+//-----------------------------------------------------------------------------------
+//The per-channel spread the engine used before PackedLight, kept as the baseline for lightkernelbench.
+static inline bool SpreadLightChannel(uchar light, uchar& neighborLight, uchar neighborOpacity)
+{
+    uchar spreadLight = light > LightingEngine::LIGHT_FALLOFF ? light - LightingEngine::LIGHT_FALLOFF : 0x00;
+    uchar filteredLight = spreadLight > neighborOpacity ? spreadLight - neighborOpacity : 0x00;
+    if (filteredLight > neighborLight)
+    {
+        neighborLight = filteredLight;
+        return true;
+    }
+    return false;
+}
+
+//-----------------------------------------------------------------------------------
+//Spreads light across pairs of blocks with the old byte-per-channel code and with PackedLight, and checks they agree.
+//Each receiving block starts out near what it would get, like most spreads during a flood, so some brighten and most don't.
+CONSOLE_COMMAND(lightkernelbench)
+{
+    const int NUM_PAIRS = 4096;
+    int numPasses = args.HasArgs(1) ? args.GetIntArgument(0) : 1000;
+    if (numPasses <= 0)
+    {
+        Console::instance->PrintLine("lightkernelbench <# of passes over 4096 block pairs>", RGBA::GRAY);
+        return;
+    }
+    std::vector<Block> fromBlocks(NUM_PAIRS);
+    std::vector<Block> startingBlocks(NUM_PAIRS);
+    std::vector<BlockDefinition*> toDefinitions(NUM_PAIRS);
+    unsigned int seed = 12345;
+    for (int i = 0; i < NUM_PAIRS; ++i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        uchar light = static_cast<uchar>(seed >> 24);
+        fromBlocks[i].SetPackedLight(PackLight(light, light / 2, light / 3));
+        seed = seed * 1664525u + 1013904223u;
+        int offset = static_cast<int>((seed >> 16) % 21) - 10 - LightingEngine::LIGHT_FALLOFF;
+        uchar channels[3] = { light, static_cast<uchar>(light / 2), static_cast<uchar>(light / 3) };
+        for (int channelIndex = 0; channelIndex < 3; ++channelIndex)
+        {
+            int startingLight = channels[channelIndex] + offset;
+            channels[channelIndex] = static_cast<uchar>(startingLight < 0 ? 0 : startingLight);
+        }
+        startingBlocks[i].SetPackedLight(PackLight(channels[0], channels[1], channels[2]));
+        toDefinitions[i] = BlockDefinition::GetDefinition(static_cast<uchar>(seed % BlockType::NUM_BLOCKS));
+    }
+
+    std::vector<Block> byteResults(startingBlocks);
+    int numByteChanges = 0;
+    StartTiming();
+    for (int pass = 0; pass < numPasses; ++pass)
+    {
+        if (pass % 2 == 0)
+        {
+            byteResults = startingBlocks;
+        }
+        for (int i = 0; i < NUM_PAIRS; ++i)
+        {
+            const RGBA& opacity = toDefinitions[i]->m_opacity;
+            bool wasBrightened = SpreadLightChannel(fromBlocks[i].m_redLight, byteResults[i].m_redLight, opacity.red)
+                | SpreadLightChannel(fromBlocks[i].m_greenLight, byteResults[i].m_greenLight, opacity.green)
+                | SpreadLightChannel(fromBlocks[i].m_blueLight, byteResults[i].m_blueLight, opacity.blue);
+            numByteChanges += wasBrightened ? 1 : 0;
+        }
+    }
+    double byteSeconds = EndTiming();
+
+    std::vector<Block> packedResults(startingBlocks);
+    int numPackedChanges = 0;
+    StartTiming();
+    for (int pass = 0; pass < numPasses; ++pass)
+    {
+        if (pass % 2 == 0)
+        {
+            packedResults = startingBlocks;
+        }
+        for (int i = 0; i < NUM_PAIRS; ++i)
+        {
+            PackedLight spreadLight = SubtractPackedLight(fromBlocks[i].GetPackedLight(), toDefinitions[i]->m_packedAttenuation);
+            PackedLight light = packedResults[i].GetPackedLight();
+            if (IsPackedLightBrighter(spreadLight, light))
+            {
+                packedResults[i].SetPackedLight(MaxPackedLight(spreadLight, light));
+                ++numPackedChanges;
+            }
+        }
+    }
+    double packedSeconds = EndTiming();
+
+    int numMismatches = (numByteChanges == numPackedChanges) ? 0 : 1;
+    for (int i = 0; i < NUM_PAIRS; ++i)
+    {
+        if (byteResults[i].GetPackedLight() != packedResults[i].GetPackedLight())
+        {
+            ++numMismatches;
+        }
+    }
+    double numSpreads = static_cast<double>(numPasses) * NUM_PAIRS;
+    Console::instance->PrintLine(Stringf("%-24s %.03f ns/spread", "Byte per channel", byteSeconds * 1000000000.0 / numSpreads), RGBA::WHITE);
+    Console::instance->PrintLine(Stringf("%-24s %.03f ns/spread", "PackedLight", packedSeconds * 1000000000.0 / numSpreads), RGBA::WHITE);
+    Console::instance->PrintLine(Stringf("%i of %i spreads brightened, %i mismatches", numPackedChanges, static_cast<int>(numSpreads), numMismatches), numMismatches == 0 ? RGBA::WHITE : RGBA::RED);
+}
+
+//-----------------------------------------------------------------------------------
+CONSOLE_COMMAND(lightbudget)
+{
+    if (!args.HasArgs(1))
+    {
+        Console::instance->PrintLine(Stringf("lightbudget <microseconds per world per frame, 0 for unlimited> (currently %i)", static_cast<int>(LightingEngine::s_frameBudgetSeconds * 1000000.0)), RGBA::GRAY);
+        return;
+    }
+    int budgetMicroseconds = args.GetIntArgument(0);
+    LightingEngine::s_frameBudgetSeconds = (budgetMicroseconds > 0) ? budgetMicroseconds / 1000000.0 : 0.0;
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include "Game/GameCommon.hpp"
+#include "Game/BlockInfo.hpp"
+#include <deque>
+#include <unordered_set>
+
+class World;
+class Block;
+class Chunk;
+
+//-----------------------------------------------------------------------------------
+//Flood-fill light propagation. Removals run first, one channel at a time since each channel loses
+//light independently, darkening everything a changed block could have been lighting and queueing
+//any brighter blocks they run into as additions. Additions then flood back outward from those
+//blocks and from the changed block's new light, glow and sky each as one PackedLight.
+//Sky light has its own three channels, lit as if the sky were full white; the world's actual sky light is
+//only applied when rendering, so changing the sky never queues anything here.
+//Each world owns one engine; light that crosses a portal is handed to the other world's engine.
+//Work can be capped per frame: whatever doesn't fit is carried over to the next Update, and blocks
+//in chunks around the player are always handled before the rest.
+//Everything queued is stamped with its chunk's lighting queue id. Purging a chunk just retires that id, and
+//entries carrying a retired id are thrown away as they come off the queues instead of being searched for.
+class LightingEngine
+{
+public:
+    //ENUMS//////////////////////////////////////////////////////////////////////////
+    enum LightChannel
+    {
+        RED_CHANNEL = 0,
+        GREEN_CHANNEL,
+        BLUE_CHANNEL,
+        SKY_RED_CHANNEL,
+        SKY_GREEN_CHANNEL,
+        SKY_BLUE_CHANNEL,
+        NUM_LIGHT_CHANNELS
+    };
+
+    enum LightPriority
+    {
+        NEAR_PLAYER = 0,
+        FAR_FROM_PLAYER,
+        NUM_LIGHT_PRIORITIES
+    };
+
+    //CONSTRUCTORS//////////////////////////////////////////////////////////////////////////
+    LightingEngine(World* world);
+    ~LightingEngine() {};
+
+    //FUNCTIONS//////////////////////////////////////////////////////////////////////////
+    void QueueRelight(const BlockInfo& info);
+    void QueueSpread(const BlockInfo& info);
+    int Update(double budgetSeconds = 0.0);
+    void PurgeChunk(Chunk* chunk);
+    bool IsIdle() const;
+    int GetNumQueuedBlocks() const;
+    inline int GetNumBlocksVisitedLastUpdate() const { return m_numBlocksVisitedLastUpdate; };
+    static void DirtyChunksShowingBlock(const BlockInfo& info);
+
+    //QUERIES//////////////////////////////////////////////////////////////////////////
+    static uchar GetSourceLight(const BlockInfo& info, LightChannel channel);
+    static bool CanSpreadLight(const Block* block);
+
+    //CONSTANTS//////////////////////////////////////////////////////////////////////////
+    static const uchar LIGHT_FALLOFF = 0x0F;
+    static const uchar FULL_SKY_LIGHT = 0xFF;
+    static const int NEAR_PLAYER_CHUNK_RADIUS = 2;
+    static const int BLOCKS_PER_BUDGET_CHECK = 64;
+    static double s_frameBudgetSeconds;
+
+private:
+    //-----------------------------------------------------------------------------------
+    struct LightRemovalNode
+    {
+        LightRemovalNode() {};
+        LightRemovalNode(const BlockInfo& info, uchar oldLight, unsigned int queueID) : m_info(info), m_oldLight(oldLight), m_queueID(queueID) {};
+
+        BlockInfo m_info;
+        uchar m_oldLight;
+        unsigned int m_queueID;
+    };
+
+    //-----------------------------------------------------------------------------------
+    struct LightAdditionNode
+    {
+        LightAdditionNode() {};
+        LightAdditionNode(const BlockInfo& info, unsigned int queueID) : m_info(info), m_queueID(queueID) {};
+
+        BlockInfo m_info;
+        unsigned int m_queueID;
+    };
+
+    //FUNCTIONS//////////////////////////////////////////////////////////////////////////
+    bool PropagateRemovals(LightPriority priority, LightChannel channel);
+    bool PropagateAdditions(LightPriority priority);
+    void PushRemoval(const BlockInfo& info, uchar oldLight, LightChannel channel);
+    void PushAddition(const BlockInfo& info);
+    LightPriority GetPriority(const BlockInfo& info) const;
+    bool HasBudgetLeft() const;
+    bool IsPurged(unsigned int queueID) const;
+    static LightingEngine* GetOwningEngine(const BlockInfo& info);
+
+    //MEMBER VARIABLES//////////////////////////////////////////////////////////////////////////
+    static uchar Block::* const s_channelLights[NUM_LIGHT_CHANNELS];
+    static const int s_channelShifts[NUM_LIGHT_CHANNELS];
+
+    World* m_world;
+    std::deque<LightRemovalNode> m_removalQueues[NUM_LIGHT_PRIORITIES][NUM_LIGHT_CHANNELS];
+    std::deque<LightAdditionNode> m_additionQueues[NUM_LIGHT_PRIORITIES];
+    std::unordered_set<unsigned int> m_purgedQueueIDs; //Retired since the queues were last empty.
+    ChunkCoords m_playerChunkCoords;
+    double m_budgetDeadline;
+    int m_numBlocksVisitedThisUpdate;
+    int m_numBlocksVisitedLastUpdate;
+};
@@ -0,0 +1,290 @@
+#include "Game/LightingOracle.hpp"
+#include "Game/World.hpp"
+#include "Game/Generator.hpp"
+#include "Game/Block.hpp"
+#include "Game/BlockDefinition.h"
+#include "Game/LightingEngine.hpp"
+#include "Engine/Input/Console.hpp"
+
+//-----------------------------------------------------------------------------------
+LightingOracle::LightingOracle(const std::vector<Chunk*>& chunks)
+    : m_chunks(chunks)
+    , m_expected(chunks.size() * Chunk::BLOCKS_PER_CHUNK)
+    , m_numSweepsLastRelight(0)
+{
+    for (unsigned int chunkNumber = 0; chunkNumber < m_chunks.size(); ++chunkNumber)
+    {
+        m_firstSlots[m_chunks[chunkNumber]] = chunkNumber * Chunk::BLOCKS_PER_CHUNK;
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//Works out the light every block should have from the chunks' current block types. Sweeps alternate between
+//forwards and backwards so light doesn't crawl one block per sweep against the order. Returns the number of blocks
+//evaluated, for comparing against the blocks the engine visited to get to the same place.
+int LightingOracle::Relight()
+{
+    ResetToSourceLight();
+    int numSlots = static_cast<int>(m_expected.size());
+    int numBlocksEvaluated = 0;
+    bool wasAnythingBrightened = true;
+    m_numSweepsLastRelight = 0;
+    while (wasAnythingBrightened)
+    {
+        wasAnythingBrightened = false;
+        bool isForwardSweep = (m_numSweepsLastRelight % 2) == 0;
+        for (int step = 0; step < numSlots; ++step)
+        {
+            int slot = isForwardSweep ? step : numSlots - 1 - step;
+            wasAnythingBrightened = RelaxBlock(slot) || wasAnythingBrightened;
+        }
+        numBlocksEvaluated += numSlots;
+        ++m_numSweepsLastRelight;
+    }
+    return numBlocksEvaluated;
+}
+
+//-----------------------------------------------------------------------------------
+//Compares what the chunks hold against the last Relight. Returns the number of blocks whose glow, sky light or
+//sky bit differs, and points out_firstMismatch at the first of them.
+int LightingOracle::CountMismatches(BlockInfo& out_firstMismatch) const
+{
+    int numMismatches = 0;
+    out_firstMismatch = BlockInfo::INVALID_BLOCKINFO;
+    for (unsigned int chunkNumber = 0; chunkNumber < m_chunks.size(); ++chunkNumber)
+    {
+        Chunk* chunk = m_chunks[chunkNumber];
+        for (LocalIndex index = 0; index < Chunk::BLOCKS_PER_CHUNK; ++index)
+        {
+            const ExpectedLight& expected = m_expected[chunkNumber * Chunk::BLOCKS_PER_CHUNK + index];
+            Block* block = chunk->GetBlock(index);
+            if (block->GetPackedLight() != expected.m_light || block->GetPackedSkyLight() != expected.m_skyLight || block->IsSky() != expected.m_isSky)
+            {
+                if (numMismatches == 0)
+                {
+                    out_firstMismatch = BlockInfo(chunk, index);
+                }
+                ++numMismatches;
+            }
+        }
+    }
+    return numMismatches;
+}
+
+//-----------------------------------------------------------------------------------
+//Every block gets its own glow, and full sky if nothing over it in its column blocks the sky and it isn't opaque.
+void LightingOracle::ResetToSourceLight()
+{
+    for (unsigned int chunkNumber = 0; chunkNumber < m_chunks.size(); ++chunkNumber)
+    {
+        Chunk* chunk = m_chunks[chunkNumber];
+        for (LocalIndex columnIndex = 0; columnIndex < Chunk::BLOCKS_PER_LAYER; ++columnIndex)
+        {
+            bool isSky = true;
+            for (int z = Chunk::BLOCKS_TALL_Z - 1; z >= 0; --z)
+            {
+                LocalIndex index = (z << Chunk::CHUNK_BITS_XY) + columnIndex;
+                BlockDefinition* definition = chunk->GetBlock(index)->GetDefinition();
+                isSky = isSky && !definition->m_blocksSky;
+                uchar red = static_cast<uchar>((definition->m_illumination >> RGBA::SHIFT_RED) & 0xFF);
+                uchar green = static_cast<uchar>((definition->m_illumination >> RGBA::SHIFT_GREEN) & 0xFF);
+                uchar blue = static_cast<uchar>((definition->m_illumination >> RGBA::SHIFT_BLUE) & 0xFF);
+                uchar skyLight = (isSky && !definition->m_isOpaque) ? LightingEngine::FULL_SKY_LIGHT : 0x00;
+                ExpectedLight& expected = m_expected[chunkNumber * Chunk::BLOCKS_PER_CHUNK + index];
+                expected.m_light = PackLight(red, green, blue);
+                expected.m_skyLight = PackLight(skyLight, skyLight, skyLight);
+                expected.m_isSky = isSky;
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//Brightens one block to the best light any neighbor can give it. Opaque blocks only ever have their own glow,
+//though they still light the blocks around them. Returns true if the block got brighter.
+bool LightingOracle::RelaxBlock(int slot)
+{
+    Chunk* chunk = m_chunks[slot / Chunk::BLOCKS_PER_CHUNK];
+    LocalIndex index = slot % Chunk::BLOCKS_PER_CHUNK;
+    BlockDefinition* definition = chunk->GetBlock(index)->GetDefinition();
+    if (definition->m_isOpaque)
+    {
+        return false;
+    }
+    ExpectedLight& expected = m_expected[slot];
+    int firstSlot = slot - index;
+    bool wasBrightened = false;
+    BlockInfo info(chunk, index);
+    for (Direction direction : BlockInfo::directions)
+    {
+        BlockInfo neighbor = info.GetNeighbor(direction);
+        if (!neighbor.IsValid())
+        {
+            continue;
+        }
+        int neighborFirstSlot = firstSlot;
+        if (neighbor.m_chunk != chunk)
+        {
+            auto slotIter = m_firstSlots.find(neighbor.m_chunk);
+            if (slotIter == m_firstSlots.end())
+            {
+                continue;
+            }
+            neighborFirstSlot = slotIter->second;
+        }
+        const ExpectedLight& neighborExpected = m_expected[neighborFirstSlot + neighbor.m_index];
+        PackedLight spreadLight = SubtractPackedLight(neighborExpected.m_light, definition->m_packedAttenuation);
+        PackedLight spreadSkyLight = SubtractPackedLight(neighborExpected.m_skyLight, definition->m_packedAttenuation);
+        if (IsPackedLightBrighter(spreadLight, expected.m_light))
+        {
+            expected.m_light = MaxPackedLight(spreadLight, expected.m_light);
+            wasBrightened = true;
+        }
+        if (IsPackedLightBrighter(spreadSkyLight, expected.m_skyLight))
+        {
+            expected.m_skyLight = MaxPackedLight(spreadSkyLight, expected.m_skyLight);
+            wasBrightened = true;
+        }
+    }
+    return wasBrightened;
+}
+
+//-----------------------------------------------------------------------------------
+//What DestroyBlock and RelightChangedBlock do to a block and the sky bits under it, except that the changed blocks
+//go straight into the chunk's dirty bits; the fuzz chunks aren't active, so the world's dirty chunk list would skip them.
+static void SetBlockTypeForLightFuzz(const BlockInfo& info, uchar type)
+{
+    Chunk* chunk = info.m_chunk;
+    info.GetBlock()->m_type = type;
+    chunk->UpdateHeightMap(info.m_index);
+    int height = chunk->GetHeight(info.m_index & (Chunk::LOCAL_X_MASK | Chunk::LOCAL_Y_MASK));
+    bool isSky = (info.m_index >> Chunk::CHUNK_BITS_XY) >= height;
+    info.GetBlock()->SetSky(isSky);
+    chunk->SetLightingDirty(info.m_index);
+    for (BlockInfo belowInfo = info.GetBelow(); belowInfo.IsValid(); belowInfo = belowInfo.GetBelow())
+    {
+        Block* belowBlock = belowInfo.GetBlock();
+        if (belowBlock->GetDefinition()->m_blocksSky || belowBlock->IsSky() == isSky)
+        {
+            break;
+        }
+        belowBlock->SetSky(isSky);
+        belowInfo.m_chunk->SetLightingDirty(belowInfo.m_index);
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//Relights the fuzz chunks with the oracle and reports the first block the engine got wrong, if any.
+static int CheckLightFuzz(LightingOracle& oracle, const char* stepName, int& inout_numBlocksEvaluated, double& inout_oracleSeconds)
+{
+    StartTiming();
+    inout_numBlocksEvaluated += oracle.Relight();
+    inout_oracleSeconds += EndTiming();
+    BlockInfo firstMismatch;
+    int numMismatches = oracle.CountMismatches(firstMismatch);
+    if (numMismatches > 0)
+    {
+        WorldCoords coords = firstMismatch.m_chunk->GetWorldCoordsForBlockIndex(firstMismatch.m_index);
+        Console::instance->PrintLine(Stringf("%s: %i blocks lit wrong, first at %i,%i,%i", stepName, numMismatches, coords.x, coords.y, coords.z), RGBA::RED);
+    }
+    return numMismatches;
+}
+
+//-----------------------------------------------------------------------------------
+//Generates a 3x3 group of chunks far from anything loaded and lights it the way the world does, one chunk at a time
+//with the seams seeded as they're hooked up. Then it places and destroys random blocks near the surface, relighting
+//each edit through the dirty bits and the world's LightingEngine, and every few edits checks every block against
+//the oracle's relight from scratch. Prints the work both sides did; any mismatch is printed in red.
+//The chunks are held dirty the whole time so they never go on the world's mesh rebuild list.
+CONSOLE_COMMAND(lightfuzz)
+{
+    const int GRID_SIZE = 3;
+    const int NUM_FUZZ_BLOCK_TYPES = 9;
+    const uchar FUZZ_BLOCK_TYPES[NUM_FUZZ_BLOCK_TYPES] = { BlockType::STONE, BlockType::DIRT, BlockType::WATER, BlockType::GLOWSTONE, BlockType::RED_LIGHT, BlockType::BLUE_LIGHT, BlockType::GREEN_LIGHT, BlockType::RED_GLASS, BlockType::CYAN_GLASS };
+    bool hasSeed = args.HasArgs(2) || args.HasArgs(3);
+    int numEdits = (hasSeed || args.HasArgs(1)) ? args.GetIntArgument(0) : 200;
+    unsigned int seed = hasSeed ? static_cast<unsigned int>(args.GetIntArgument(1)) : 12345;
+    int editsPerCheck = args.HasArgs(3) ? args.GetIntArgument(2) : 10;
+    if (numEdits <= 0 || editsPerCheck <= 0)
+    {
+        Console::instance->PrintLine("lightfuzz <# of edits> <seed> <edits between checks>", RGBA::GRAY);
+        return;
+    }
+    World* world = TheGame::instance->m_worlds[TheGame::instance->m_currentlyRenderedWorldID];
+    LightingEngine& lightingEngine = world->m_lightingEngine;
+    world->UpdateLighting();
+    lightingEngine.Update();
+
+    std::vector<Chunk*> chunks(GRID_SIZE * GRID_SIZE, nullptr);
+    DetachedChunkFactory detachedChunks(world);
+    int numBlocksVisited = 0;
+    double engineSeconds = 0.0;
+    for (int y = 0; y < GRID_SIZE; ++y)
+    {
+        for (int x = 0; x < GRID_SIZE; ++x)
+        {
+            Chunk* chunk = detachedChunks.CreateChunk(x, y);
+            chunk->CalculateLocalLighting();
+            chunks[y * GRID_SIZE + x] = chunk;
+            if (x > 0)
+            {
+                Chunk* westChunk = chunks[y * GRID_SIZE + x - 1];
+                chunk->m_westChunk = westChunk;
+                westChunk->m_eastChunk = chunk;
+                chunk->QueueSeamLightSpread(WEST, lightingEngine);
+            }
+            if (y > 0)
+            {
+                Chunk* southChunk = chunks[(y - 1) * GRID_SIZE + x];
+                chunk->m_southChunk = southChunk;
+                southChunk->m_northChunk = chunk;
+                chunk->QueueSeamLightSpread(SOUTH, lightingEngine);
+            }
+            StartTiming();
+            numBlocksVisited += lightingEngine.Update();
+            engineSeconds += EndTiming();
+        }
+    }
+
+    LightingOracle oracle(chunks);
+    int numBlocksEvaluated = 0;
+    double oracleSeconds = 0.0;
+    int numChecks = 1;
+    int numMismatches = CheckLightFuzz(oracle, "Loading", numBlocksEvaluated, oracleSeconds);
+    for (int editNumber = 1; editNumber <= numEdits; ++editNumber)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        Chunk* chunk = chunks[(seed >> 16) % chunks.size()];
+        seed = seed * 1664525u + 1013904223u;
+        LocalIndex columnIndex = static_cast<LocalIndex>((seed >> 16) % Chunk::BLOCKS_PER_LAYER);
+        seed = seed * 1664525u + 1013904223u;
+        int z = chunk->GetHeight(columnIndex) - 8 + static_cast<int>((seed >> 16) % 12);
+        z = (z < 0) ? 0 : ((z >= Chunk::BLOCKS_TALL_Z) ? Chunk::BLOCKS_TALL_Z - 1 : z);
+        seed = seed * 1664525u + 1013904223u;
+        uchar type = ((seed >> 16) % 2 == 0) ? static_cast<uchar>(BlockType::AIR) : FUZZ_BLOCK_TYPES[(seed >> 20) % NUM_FUZZ_BLOCK_TYPES];
+        SetBlockTypeForLightFuzz(BlockInfo(chunk, (z << Chunk::CHUNK_BITS_XY) + columnIndex), type);
+
+        StartTiming();
+        for (Chunk* dirtyChunk : chunks)
+        {
+            dirtyChunk->QueueLightingDirtyBlocks(lightingEngine);
+        }
+        numBlocksVisited += lightingEngine.Update();
+        engineSeconds += EndTiming();
+        if (editNumber % editsPerCheck == 0 || editNumber == numEdits)
+        {
+            numMismatches += CheckLightFuzz(oracle, Stringf("Edit %i", editNumber).c_str(), numBlocksEvaluated, oracleSeconds);
+            ++numChecks;
+        }
+    }
+
+    for (Chunk* chunk : chunks)
+    {
+        lightingEngine.PurgeChunk(chunk);
+        delete chunk;
+    }
+    Console::instance->PrintLine(Stringf("%i chunks, %i edits, %i checks", static_cast<int>(chunks.size()), numEdits, numChecks), RGBA::GRAY);
+    Console::instance->PrintLine(Stringf("%-24s %9i blocks visited, %.03f ms", "LightingEngine", numBlocksVisited, engineSeconds * 1000.0), RGBA::WHITE);
+    Console::instance->PrintLine(Stringf("%-24s %9i blocks evaluated in %i sweeps last time, %.03f ms", "Oracle relights", numBlocksEvaluated, oracle.GetNumSweepsLastRelight(), oracleSeconds * 1000.0), RGBA::WHITE);
+    Console::instance->PrintLine(Stringf("%s: %i mismatched blocks", numMismatches == 0 ? "PASS" : "FAIL", numMismatches), numMismatches == 0 ? RGBA::WHITE : RGBA::RED);
+}
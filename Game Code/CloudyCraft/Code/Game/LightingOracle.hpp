@@ -0,0 +1,48 @@
+#pragma once
+#include "Game/GameCommon.hpp"
+#include "Game/BlockInfo.hpp"
+#include "Game/PackedLight.hpp"
+#include <vector>
+#include <map>
+
+class Chunk;
+
+//-----------------------------------------------------------------------------------
+//Lights a small group of chunks from scratch the slowest, most obvious way, as the reference the LightingEngine
+//gets checked against. Which blocks see the sky comes straight from the block types, then every block is relaxed
+//against its six neighbors, sweep after sweep, until a whole sweep changes nothing. There are no queues, dirty bits
+//or seams to get wrong. The chunks themselves are never touched; the answer is kept on the side.
+//The chunks should only be hooked up to each other, with no portals, since anything outside the group is ignored.
+class LightingOracle
+{
+public:
+    //CONSTRUCTORS//////////////////////////////////////////////////////////////////////////
+    LightingOracle(const std::vector<Chunk*>& chunks);
+    ~LightingOracle() {};
+
+    //FUNCTIONS//////////////////////////////////////////////////////////////////////////
+    int Relight();
+    int CountMismatches(BlockInfo& out_firstMismatch) const;
+
+    //QUERIES//////////////////////////////////////////////////////////////////////////
+    inline int GetNumSweepsLastRelight() const { return m_numSweepsLastRelight; };
+
+private:
+    //-----------------------------------------------------------------------------------
+    struct ExpectedLight
+    {
+        PackedLight m_light;
+        PackedLight m_skyLight;
+        bool m_isSky;
+    };
+
+    //FUNCTIONS//////////////////////////////////////////////////////////////////////////
+    void ResetToSourceLight();
+    bool RelaxBlock(int slot);
+
+    //MEMBER VARIABLES//////////////////////////////////////////////////////////////////////////
+    std::vector<Chunk*> m_chunks;
+    std::map<const Chunk*, int> m_firstSlots; //Where each chunk's blocks start in m_expected.
+    std::vector<ExpectedLight> m_expected; //Chunk::BLOCKS_PER_CHUNK per chunk, in the same order as m_chunks.
+    int m_numSweepsLastRelight;
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+//-----------------------------------------------------------------------------------
+//Red, green and blue light side by side in one integer, so falloff, filtering and max can be done
+//for all three channels with a handful of plain integer ops instead of three clamped byte ops each.
+//Each channel gets a 10-bit lane: 8 bits of light, then a spare bit, then a guard bit. Subtracting
+//at most 511 from a lane with its guard bit set can never borrow out of that lane, and whether the
+//guard bit survived says whether the result went negative.
+typedef unsigned int PackedLight;
+
+static const int PACKED_LIGHT_LANE_BITS = 10;
+static const int PACKED_LIGHT_RED_SHIFT = 0;
+static const int PACKED_LIGHT_GREEN_SHIFT = PACKED_LIGHT_LANE_BITS;
+static const int PACKED_LIGHT_BLUE_SHIFT = PACKED_LIGHT_LANE_BITS * 2;
+static const int PACKED_LIGHT_GUARD_SHIFT = PACKED_LIGHT_LANE_BITS - 1;
+static const PackedLight PACKED_LIGHT_LOW_BITS = (1u << PACKED_LIGHT_RED_SHIFT) | (1u << PACKED_LIGHT_GREEN_SHIFT) | (1u << PACKED_LIGHT_BLUE_SHIFT);
+static const PackedLight PACKED_LIGHT_GUARD_BITS = PACKED_LIGHT_LOW_BITS << PACKED_LIGHT_GUARD_SHIFT;
+static const PackedLight PACKED_LIGHT_CHANNEL_MASK = PACKED_LIGHT_LOW_BITS * 0xFF;
+
+//-----------------------------------------------------------------------------------
+inline PackedLight PackLight(unsigned char red, unsigned char green, unsigned char blue)
+{
+    return (red << PACKED_LIGHT_RED_SHIFT) | (green << PACKED_LIGHT_GREEN_SHIFT) | (blue << PACKED_LIGHT_BLUE_SHIFT);
+}
+
+//-----------------------------------------------------------------------------------
+//Like PackLight, but each amount can be up to 511 so a falloff step and a full opacity fit in one lane.
+inline PackedLight PackLightAttenuation(unsigned int red, unsigned int green, unsigned int blue)
+{
+    return (red << PACKED_LIGHT_RED_SHIFT) | (green << PACKED_LIGHT_GREEN_SHIFT) | (blue << PACKED_LIGHT_BLUE_SHIFT);
+}
+
+//-----------------------------------------------------------------------------------
+inline unsigned char GetPackedRed(PackedLight light)
+{
+    return static_cast<unsigned char>(light >> PACKED_LIGHT_RED_SHIFT);
+}
+
+//-----------------------------------------------------------------------------------
+inline unsigned char GetPackedGreen(PackedLight light)
+{
+    return static_cast<unsigned char>(light >> PACKED_LIGHT_GREEN_SHIFT);
+}
+
+//-----------------------------------------------------------------------------------
+inline unsigned char GetPackedBlue(PackedLight light)
+{
+    return static_cast<unsigned char>(light >> PACKED_LIGHT_BLUE_SHIFT);
+}
+
+//-----------------------------------------------------------------------------------
+//Per channel max(light - attenuation, 0).
+inline PackedLight SubtractPackedLight(PackedLight light, PackedLight attenuation)
+{
+    PackedLight difference = (light | PACKED_LIGHT_GUARD_BITS) - attenuation;
+    PackedLight nonNegativeLanes = (difference & PACKED_LIGHT_GUARD_BITS) >> PACKED_LIGHT_GUARD_SHIFT;
+    return difference & (nonNegativeLanes * 0xFF);
+}
+
+//-----------------------------------------------------------------------------------
+//Per channel max(first, second).
+inline PackedLight MaxPackedLight(PackedLight first, PackedLight second)
+{
+    PackedLight difference = (first | PACKED_LIGHT_GUARD_BITS) - second;
+    PackedLight firstIsBrighter = ((difference & PACKED_LIGHT_GUARD_BITS) >> PACKED_LIGHT_GUARD_SHIFT) * 0xFF;
+    return (first & firstIsBrighter) | (second & ~firstIsBrighter & PACKED_LIGHT_CHANNEL_MASK);
+}
+
+//-----------------------------------------------------------------------------------
+//True if any channel of first is brighter than the same channel of second. Most light spreading into a
+//block doesn't brighten it, so this lets the caller skip MaxPackedLight and the write-back.
+inline bool IsPackedLightBrighter(PackedLight first, PackedLight second)
+{
+    return (((first | PACKED_LIGHT_GUARD_BITS) - second - PACKED_LIGHT_LOW_BITS) & PACKED_LIGHT_GUARD_BITS) != 0;
+}
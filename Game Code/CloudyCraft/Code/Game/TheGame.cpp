@@ -5,6 +5,8 @@
 #include "Game/BlockDefinition.h"
 #include "Game/Player.hpp"
 #include "Game/Generator.hpp"
+#include "Game/ChunkMeshWorkers.hpp"
+#include "Game/ChunkMeshCache.hpp"
 #include "Engine/Renderer/Renderer.hpp"
 #include "Engine/Renderer/AABB2.hpp"
 #include "Engine/Renderer/SpriteSheet.hpp"
@@ -25,12 +27,21 @@
 #include "Engine/Renderer/Framebuffer.hpp"
 #include <thread>
 #include <regex>
+#include <algorithm>
 
 TheGame* TheGame::instance = nullptr;
 ProfilingID g_generationProfiling;
+ProfilingID g_generationColumnsProfiling;
+ProfilingID g_generationDensityProfiling;
+ProfilingID g_generationSurfaceProfiling;
+ProfilingID g_generationFeaturesProfiling;
 ProfilingID g_loadingProfiling;
 ProfilingID g_savingProfiling;
 ProfilingID g_vaBuildingProfiling;
+ProfilingID g_translucentSortProfiling;
+ProfilingID g_lightingProfiling;
+ProfilingID g_localLightingProfiling;
+ProfilingID g_chunkActivationProfiling;
 ProfilingID g_temporaryProfiling;
 
 //-----------------------------------------------------------------------------------
@@ -57,12 +68,23 @@ TheGame::TheGame()
     , m_secondaryWorldFramebuffer(nullptr)
    {
     g_generationProfiling = RegisterProfilingChannel();
+    g_generationColumnsProfiling = RegisterProfilingChannel();
+    g_generationDensityProfiling = RegisterProfilingChannel();
+    g_generationSurfaceProfiling = RegisterProfilingChannel();
+    g_generationFeaturesProfiling = RegisterProfilingChannel();
     g_loadingProfiling = RegisterProfilingChannel();
     g_savingProfiling = RegisterProfilingChannel();
     g_vaBuildingProfiling = RegisterProfilingChannel();
+    g_translucentSortProfiling = RegisterProfilingChannel();
+    g_lightingProfiling = RegisterProfilingChannel();
+    g_localLightingProfiling = RegisterProfilingChannel();
+    g_chunkActivationProfiling = RegisterProfilingChannel();
     g_temporaryProfiling = RegisterProfilingChannel();
 
     BlockDefinition::Initialize();
+    //Leave the rest of the cores for the main, generation and disk threads.
+    m_meshCache = new ChunkMeshCache(ChunkMeshCache::DEFAULT_BUDGET_BYTES);
+    m_meshWorkers = new ChunkMeshWorkers(std::max(1, static_cast<int>(std::thread::hardware_concurrency()) / 2), m_meshCache);
     m_worlds.push_back(new World(0, RGBA(0xDDEEFFFF), RGBA(0x4DC9FFFF), new EarthGenerator()));			//BlueSky 0x4DC9FFFF     Vaporwave 0xFF819CFF
     m_worlds.push_back(new World(1, RGBA(0xFDDA0EFF), RGBA(0xC55409FF), new SkylandsGenerator()));
     //Why does this have to be here? I had it in initializer list, but caused race condition. Reminder to ask someone.
@@ -91,12 +113,17 @@ TheGame::TheGame()
 
     m_blockMaterial->SetDiffuseTexture(m_blockSheet->GetTexture());
     m_blockMaterial->SetNormalTexture(Texture::CreateOrGetTexture("Data/Images/PortalMap.png"));
+    AABB2 firstTile = m_blockSheet->GetTexCoordsForSpriteIndex(0);
+    m_blockMaterial->SetVec4Uniform("gAtlasTileSpan", Vector4(firstTile.maxs - firstTile.mins, 0.0f, 0.0f));
     m_blockMaterialWithoutPortals->SetDiffuseTexture(m_blockSheet->GetTexture());
 }
 
 //-----------------------------------------------------------------------------------
 TheGame::~TheGame()
 {
+    //The workers read block definitions and the mesh cache, so they stop first.
+    delete m_meshWorkers;
+    delete m_meshCache;
     BlockDefinition::Uninitialize();
     for (World* world : m_worlds)
     {
@@ -170,6 +197,7 @@ void TheGame::Render() const
     m_blockMaterial->SetIntUniform("gPassNumber", 0);
     m_blockMaterial->SetEmissiveTexture(Texture::CreateOrGetTexture("Data/Images/initialPortalTexture.png"));
     m_blockMaterial->SetVec4Uniform("gColor", m_worlds[m_alternateRenderedWorldID]->m_skyColor.ToVec4());
+    m_blockMaterial->SetVec4Uniform("gSkyLight", m_worlds[m_currentlyRenderedWorldID]->m_skyLight.ToVec4());
     m_worlds[m_currentlyRenderedWorldID]->Render();
 
     //Second Pass
@@ -180,6 +208,7 @@ void TheGame::Render() const
     m_blockMaterial->SetEmissiveTexture(m_primaryWorldFramebuffer->m_colorTargets[1]);
     m_blockMaterial->SetNoiseTexture(m_primaryWorldFramebuffer->m_depthStencilTarget);
     m_blockMaterial->SetVec4Uniform("gColor", m_worlds[m_currentlyRenderedWorldID]->m_skyColor.ToVec4());
+    m_blockMaterial->SetVec4Uniform("gSkyLight", m_worlds[m_alternateRenderedWorldID]->m_skyLight.ToVec4());
     m_worlds[m_alternateRenderedWorldID]->Render();
     Renderer::instance->EnableFaceCulling(false);
     Renderer::instance->BindFramebuffer(nullptr);
@@ -294,9 +323,34 @@ void TheGame::RenderDebugText() const
     //Multiply by 1000 to put into milliseconds.
     std::string genProfiling = Stringf("Generation Times =  Avg: %.02f ms, Max: %.02f ms, Last: %.02f ms", genProfilingInfo.m_averageSample * 1000.0, genProfilingInfo.m_maxSample * 1000.0, genProfilingInfo.m_lastSample * 1000.0);
 
+    //Per-stage breakdown of the generation pipeline
+    TimingInfo genColumnsProfilingInfo = g_profilingResults[g_generationColumnsProfiling];
+    std::string genColumnsProfiling = Stringf("  Columns Stage =  Avg: %.02f ms, Max: %.02f ms, Last: %.02f ms", genColumnsProfilingInfo.m_averageSample * 1000.0, genColumnsProfilingInfo.m_maxSample * 1000.0, genColumnsProfilingInfo.m_lastSample * 1000.0);
+    TimingInfo genDensityProfilingInfo = g_profilingResults[g_generationDensityProfiling];
+    std::string genDensityProfiling = Stringf("  Density Stage =  Avg: %.02f ms, Max: %.02f ms, Last: %.02f ms", genDensityProfilingInfo.m_averageSample * 1000.0, genDensityProfilingInfo.m_maxSample * 1000.0, genDensityProfilingInfo.m_lastSample * 1000.0);
+    TimingInfo genSurfaceProfilingInfo = g_profilingResults[g_generationSurfaceProfiling];
+    std::string genSurfaceProfiling = Stringf("  Surface Stage =  Avg: %.02f ms, Max: %.02f ms, Last: %.02f ms", genSurfaceProfilingInfo.m_averageSample * 1000.0, genSurfaceProfilingInfo.m_maxSample * 1000.0, genSurfaceProfilingInfo.m_lastSample * 1000.0);
+    TimingInfo genFeaturesProfilingInfo = g_profilingResults[g_generationFeaturesProfiling];
+    std::string genFeaturesProfiling = Stringf("  Features Stage = Avg: %.02f ms, Max: %.02f ms, Last: %.02f ms", genFeaturesProfilingInfo.m_averageSample * 1000.0, genFeaturesProfilingInfo.m_maxSample * 1000.0, genFeaturesProfilingInfo.m_lastSample * 1000.0);
+
     TimingInfo vaProfilingInfo = g_profilingResults[g_vaBuildingProfiling];
     //Multiply by 1000 to put into milliseconds.
     std::string vaProfiling = Stringf("VA Times =  Avg: %.02f ms, Max: %.02f ms, Last: %.02f ms", vaProfilingInfo.m_averageSample * 1000.0, vaProfilingInfo.m_maxSample * 1000.0, vaProfilingInfo.m_lastSample * 1000.0);
+    const ChunkMeshStats& meshStats = m_meshWorkers->GetStats();
+    std::string meshWorkerProfiling = Stringf("  Mesh Workers = Dirty to Shown Avg: %.02f ms, Max: %.02f ms, Jobs Out: %i", meshStats.m_numMeshesShown > 0 ? meshStats.m_totalLatencySeconds * 1000.0 / meshStats.m_numMeshesShown : 0.0, meshStats.m_maxLatencySeconds * 1000.0, m_meshWorkers->GetNumJobsOut());
+    TimingInfo translucentSortProfilingInfo = g_profilingResults[g_translucentSortProfiling];
+    std::string translucentSortProfiling = Stringf("  Translucent Sort (per chunk) = Avg: %.03f ms, Max: %.03f ms, Last: %.03f ms", translucentSortProfilingInfo.m_averageSample * 1000.0, translucentSortProfilingInfo.m_maxSample * 1000.0, translucentSortProfilingInfo.m_lastSample * 1000.0);
+    ChunkMeshCacheStats meshCacheStats = m_meshCache->GetStats();
+    std::string meshCacheProfiling = Stringf("  Mesh Cache = Hit Rate: %.01f%% of %i, Build Time Saved: %.02f ms, Size: %.02f MB", meshCacheStats.m_numLookups > 0 ? meshCacheStats.m_numHits * 100.0 / meshCacheStats.m_numLookups : 0.0, meshCacheStats.m_numLookups, meshCacheStats.m_savedBuildSeconds * 1000.0, m_meshCache->GetNumBytes() / (1024.0 * 1024.0));
+
+    TimingInfo lightingProfilingInfo = g_profilingResults[g_lightingProfiling];
+    LightingEngine& lightingEngine = m_worlds[m_currentlyRenderedWorldID]->m_lightingEngine;
+    //Multiply by 1000 to put into milliseconds.
+    std::string lightingProfiling = Stringf("Lighting Times =  Avg: %.02f ms, Max: %.02f ms, Last: %.02f ms, Visited: %i, Queued: %i", lightingProfilingInfo.m_averageSample * 1000.0, lightingProfilingInfo.m_maxSample * 1000.0, lightingProfilingInfo.m_lastSample * 1000.0, lightingEngine.GetNumBlocksVisitedLastUpdate(), lightingEngine.GetNumQueuedBlocks());
+    TimingInfo localLightingProfilingInfo = g_profilingResults[g_localLightingProfiling];
+    std::string localLightingProfiling = Stringf("  Chunk Local (worker) = Avg: %.02f ms, Max: %.02f ms, Last: %.02f ms", localLightingProfilingInfo.m_averageSample * 1000.0, localLightingProfilingInfo.m_maxSample * 1000.0, localLightingProfilingInfo.m_lastSample * 1000.0);
+    TimingInfo activationProfilingInfo = g_profilingResults[g_chunkActivationProfiling];
+    std::string activationProfiling = Stringf("  Chunk Activation =  Avg: %.02f ms, Max: %.02f ms, Last: %.02f ms", activationProfilingInfo.m_averageSample * 1000.0, activationProfilingInfo.m_maxSample * 1000.0, activationProfilingInfo.m_lastSample * 1000.0);
 
     TimingInfo tempProfilingInfo = g_profilingResults[g_temporaryProfiling];
     //Multiply by 1000 to put into milliseconds.
@@ -321,9 +375,19 @@ void TheGame::RenderDebugText() const
     Renderer::instance->DrawText2D(Vector2(0.0f, TopLineY - (FontSize * lineNumber++)), activeChunks, FontWidth, FontSize, RGBA::GREEN, true);
     lineNumber++;
     Renderer::instance->DrawText2D(Vector2(0.0f, TopLineY - (FontSize * lineNumber++)), genProfiling, FontWidth, FontSize, RGBA::ORANGE, true);
+    Renderer::instance->DrawText2D(Vector2(0.0f, TopLineY - (FontSize * lineNumber++)), genColumnsProfiling, FontWidth, FontSize, RGBA::ORANGE, true);
+    Renderer::instance->DrawText2D(Vector2(0.0f, TopLineY - (FontSize * lineNumber++)), genDensityProfiling, FontWidth, FontSize, RGBA::ORANGE, true);
+    Renderer::instance->DrawText2D(Vector2(0.0f, TopLineY - (FontSize * lineNumber++)), genSurfaceProfiling, FontWidth, FontSize, RGBA::ORANGE, true);
+    Renderer::instance->DrawText2D(Vector2(0.0f, TopLineY - (FontSize * lineNumber++)), genFeaturesProfiling, FontWidth, FontSize, RGBA::ORANGE, true);
     Renderer::instance->DrawText2D(Vector2(0.0f, TopLineY - (FontSize * lineNumber++)), loadProfiling, FontWidth, FontSize, RGBA::RED, true);
     Renderer::instance->DrawText2D(Vector2(0.0f, TopLineY - (FontSize * lineNumber++)), saveProfiling, FontWidth, FontSize, RGBA::BLUE, true);
     Renderer::instance->DrawText2D(Vector2(0.0f, TopLineY - (FontSize * lineNumber++)), vaProfiling, FontWidth, FontSize, RGBA::GREEN, true);
+    Renderer::instance->DrawText2D(Vector2(0.0f, TopLineY - (FontSize * lineNumber++)), meshWorkerProfiling, FontWidth, FontSize, RGBA::GREEN, true);
+    Renderer::instance->DrawText2D(Vector2(0.0f, TopLineY - (FontSize * lineNumber++)), meshCacheProfiling, FontWidth, FontSize, RGBA::GREEN, true);
+    Renderer::instance->DrawText2D(Vector2(0.0f, TopLineY - (FontSize * lineNumber++)), translucentSortProfiling, FontWidth, FontSize, RGBA::GREEN, true);
+    Renderer::instance->DrawText2D(Vector2(0.0f, TopLineY - (FontSize * lineNumber++)), lightingProfiling, FontWidth, FontSize, RGBA::GOLD, true);
+    Renderer::instance->DrawText2D(Vector2(0.0f, TopLineY - (FontSize * lineNumber++)), localLightingProfiling, FontWidth, FontSize, RGBA::GOLD, true);
+    Renderer::instance->DrawText2D(Vector2(0.0f, TopLineY - (FontSize * lineNumber++)), activationProfiling, FontWidth, FontSize, RGBA::GOLD, true);
     Renderer::instance->DrawText2D(Vector2(0.0f, TopLineY - (FontSize * lineNumber++)), tempProfiling, FontWidth, FontSize, RGBA::MAGENTA, true);
     lineNumber++;
     Renderer::instance->DrawText2D(Vector2(0.0f, TopLineY - (FontSize * lineNumber++)), updateProfiling, FontWidth, FontSize, RGBA::CHOCOLATE, true);
@@ -11,12 +11,22 @@ class World;
 class Player;
 class Material;
 class Framebuffer;
+class ChunkMeshWorkers;
+class ChunkMeshCache;
 
 //GLOBALS//////////////////////////////////////////////////////////////////////////
 extern ProfilingID g_generationProfiling;
+extern ProfilingID g_generationColumnsProfiling;
+extern ProfilingID g_generationDensityProfiling;
+extern ProfilingID g_generationSurfaceProfiling;
+extern ProfilingID g_generationFeaturesProfiling;
 extern ProfilingID g_loadingProfiling;
 extern ProfilingID g_savingProfiling;
 extern ProfilingID g_vaBuildingProfiling;
+extern ProfilingID g_translucentSortProfiling;
+extern ProfilingID g_lightingProfiling;
+extern ProfilingID g_localLightingProfiling;
+extern ProfilingID g_chunkActivationProfiling;
 extern ProfilingID g_temporaryProfiling;
 
 class TheGame
@@ -43,6 +53,8 @@ public:
     Camera3D* m_playerCamera;
     Player* m_player;
     std::vector<World*> m_worlds;
+    ChunkMeshWorkers* m_meshWorkers;
+    ChunkMeshCache* m_meshCache;
     Framebuffer* m_primaryWorldFramebuffer;
     Framebuffer* m_secondaryWorldFramebuffer;
     Material* m_blockMaterial;
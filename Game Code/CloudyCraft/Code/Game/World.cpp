@@ -6,6 +6,8 @@
 #include "Game/Generator.hpp"
 #include "Game/Portal.hpp"
 #include "Game/Skybox.hpp"
+#include "Game/ChunkMeshWorkers.hpp"
+#include "Engine/Input/Console.hpp"
 #include "Engine/Input/InputOutputUtils.hpp"
 #include "Engine/Renderer/Face.hpp"
 #include "Engine/Renderer/Vertex.hpp"
@@ -36,8 +38,13 @@ World::World(int id, const RGBA& skyLight, const RGBA& skyColor, Generator* gene
     , m_skyLight(skyLight) //Daylight 0xDDEEFF00  Sunset 0xFF990000  Vaporwave 0xFF819C00
     , m_skyColor(skyColor)
     , m_generator(generator)
+    , m_lightingEngine(this)
+    , m_numSeamHookups(0)
+    , m_numSeamBlocksSeeded(0)
     , m_skybox(new Skybox(Texture::CreateOrGetTexture("Data/Images/skybox_top.png"), Texture::CreateOrGetTexture("Data/Images/skybox_bottom.png"), Texture::CreateOrGetTexture("Data/Images/skybox_sideClouds.png"), skyColor))
 {
+    m_generator->SetProfiled(true);
+    m_generator->StartColumnThread();
     FindAllChunksOnDisk();
 }
 
@@ -45,7 +52,7 @@ World::World(int id, const RGBA& skyLight, const RGBA& skyColor, Generator* gene
 World::~World()
 {
     delete m_skybox;
-    delete m_generator;
+    m_generator->StopColumnThread();
     //Wait for the other thread to finish shutting down, then continue.
     if (m_chunkGenerationThread.joinable())
     {
@@ -55,6 +62,8 @@ World::~World()
     {
         m_diskIOThread.join();
     }
+    //Only once the generation thread is done with it.
+    delete m_generator;
     for (auto chunkToFlushPair : m_activeChunks)
     {
         Chunk* flushedChunk = chunkToFlushPair.second;
@@ -83,6 +92,7 @@ void World::Update(float deltaTime)
 {
     RequestNeededChunks();
     PickUpCompletedChunks();
+    ApplyDeferredBlockWrites();
     FlushUnnecessaryChunks();
     for (auto currentChunkPair : m_activeChunks)
     {
@@ -96,32 +106,94 @@ void World::Update(float deltaTime)
 //-----------------------------------------------------------------------------------
 void World::UpdateVertexArrays()
 {
-    static double timeLastShuffled;
-    int numberOfChunksWaitingForVAUpdate = m_dirtyChunks.size();
+    int numberOfChunksWaitingForVAUpdate = m_dirtyChunks.GetSize();
     double timeInSeconds = GetCurrentTimeSeconds();
     DebuggerPrintf("[%i] World [%i]: Number of chunks awaiting VA Updates: %i\n", g_frameNumber, m_worldID, numberOfChunksWaitingForVAUpdate);
-    if (numberOfChunksWaitingForVAUpdate > 40 && (timeInSeconds - timeLastShuffled) > 0.5)
+    //Only marks the queue stale when the player's crossed into another chunk; it reorders itself when next popped.
+    m_dirtyChunks.SetCenter(GetPlayerChunkCoords());
+
+    //Finished meshes get picked up either way, so none are stranded if the workers get switched off.
+    ChunkMeshWorkers* meshWorkers = TheGame::instance->m_meshWorkers;
+    double budgetDeadline = (ChunkMeshWorkers::s_frameBudgetSeconds > 0.0) ? timeInSeconds + ChunkMeshWorkers::s_frameBudgetSeconds : 0.0;
+    UploadFinishedMeshes(budgetDeadline);
+    if (ChunkMeshWorkers::s_useWorkers && Chunk::s_usePackedMesher)
+    {
+        QueueDirtyChunksForMeshing(budgetDeadline);
+    }
+    else if (!m_dirtyChunks.IsEmpty())
+    {
+        Chunk* chunkToUpdate = m_dirtyChunks.Pop();
+        double timeDirtied = chunkToUpdate->GetTimeDirtied();
+        double buildStartSeconds = GetCurrentTimeSeconds();
+        chunkToUpdate->GenerateVertexArray();
+        meshWorkers->RecordMeshShown(timeDirtied, GetCurrentTimeSeconds() - buildStartSeconds);
+    }
+    meshWorkers->RecordMainThreadTime(GetCurrentTimeSeconds() - timeInSeconds);
+}
+
+//-----------------------------------------------------------------------------------
+//Uploads the meshes the workers have finished for this world, at least one a frame, then as many as fit before the
+//deadline (0 for no deadline).
+void World::UploadFinishedMeshes(double budgetDeadline)
+{
+    ChunkMeshWorkers* meshWorkers = TheGame::instance->m_meshWorkers;
+    bool isFirstUpload = true;
+    while (isFirstUpload || budgetDeadline == 0.0 || GetCurrentTimeSeconds() < budgetDeadline)
     {
-        timeLastShuffled = timeInSeconds;
-        DebuggerPrintf("[%i] World [%i]: Recalculating chunk queue...\n", g_frameNumber, m_worldID);
-        Chunk** chunkPointerHolder = new Chunk*[numberOfChunksWaitingForVAUpdate];
-        int currentIndex = 0;
-        for (PrioritizedChunk chunkPair : m_dirtyChunks)
+        ChunkMeshJob* job = meshWorkers->TakeFinishedJob(this);
+        if (!job)
         {
-            chunkPointerHolder[currentIndex++] = chunkPair.chunk;
+            break;
         }
-        m_dirtyChunks.clear();
-        for (int i = 0; i < numberOfChunksWaitingForVAUpdate; i++)
+        isFirstUpload = false;
+        StartTiming(g_vaBuildingProfiling);
+        bool wasShown = false;
+        for (int meshSection = 0; job->m_chunk && meshSection < Chunk::NUM_MESH_SECTIONS; ++meshSection)
         {
-            m_dirtyChunks.emplace(chunkPointerHolder[i], chunkPointerHolder[i]->m_world->DistanceSquaredFromPlayerToChunk(chunkPointerHolder[i]->m_chunkPosition));
+            const ChunkMeshBuilder& builder = job->m_builders[meshSection];
+            if ((job->m_snapshot.m_meshSections & BIT(meshSection)) != 0 && job->m_chunk->UploadMesh(builder, meshSection, job->m_snapshot.m_version))
+            {
+                meshWorkers->RecordSectionUploaded(builder);
+                wasShown = true;
+            }
         }
-        delete [] chunkPointerHolder;
+        if (wasShown)
+        {
+            meshWorkers->RecordMeshShown(job->m_timeDirtied, job->m_buildSeconds);
+        }
+        else
+        {
+            meshWorkers->RecordMeshDropped();
+        }
+        EndTiming(g_vaBuildingProfiling);
+        meshWorkers->ReturnJob(job);
     }
-    if (!m_dirtyChunks.empty())
+}
+
+//-----------------------------------------------------------------------------------
+//Snapshots the closest dirty chunks into free jobs for the workers, at least one a frame if a job is free, then as
+//many as fit before the deadline. Chunks wait in m_dirtyChunks until a job frees up, so a chunk that keeps changing
+//is only copied when a worker will get to it soon.
+void World::QueueDirtyChunksForMeshing(double budgetDeadline)
+{
+    ChunkMeshWorkers* meshWorkers = TheGame::instance->m_meshWorkers;
+    bool isFirstSnapshot = true;
+    while (!m_dirtyChunks.IsEmpty() && (isFirstSnapshot || budgetDeadline == 0.0 || GetCurrentTimeSeconds() < budgetDeadline))
     {
-        Chunk* chunkToUpdate = m_dirtyChunks.begin()->chunk;
-        chunkToUpdate->GenerateVertexArray();
-        m_dirtyChunks.erase(m_dirtyChunks.begin());
+        ChunkMeshJob* job = meshWorkers->GetFreeJob();
+        if (!job)
+        {
+            break;
+        }
+        isFirstSnapshot = false;
+        Chunk* chunkToUpdate = m_dirtyChunks.Pop();
+        StartTiming(g_vaBuildingProfiling);
+        job->m_chunk = chunkToUpdate;
+        job->m_world = this;
+        job->m_timeDirtied = chunkToUpdate->GetTimeDirtied();
+        chunkToUpdate->TakeMeshSnapshot(job->m_snapshot);
+        EndTiming(g_vaBuildingProfiling);
+        meshWorkers->Submit(job);
     }
 }
 
@@ -208,6 +280,7 @@ void World::RequestChunk(PrioritizedChunkCoords &prioritizedChunkCoordsToGenerat
             g_requestedChunkGenerationSet.insert(prioritizedChunkCoordsToGenerate);
         }
         LeaveCriticalSection(&g_chunkListsCriticalSection);
+        m_generator->QueueColumns(prioritizedChunkCoordsToGenerate.chunkCoords);
     }
     m_pendingRequests[prioritizedChunkCoordsToGenerate.chunkCoords] = prioritizedChunkCoordsToGenerate;
 }
@@ -229,8 +302,13 @@ Chunk* World::LoadChunk(unsigned int worldID, ChunkCoords &chunkToGenerate)
 }
 
 //-----------------------------------------------------------------------------------
+//Opaque faces first, then translucent ones over the top of them. The rendering offsets run from the outermost ring of
+//chunks in, so the second pass also goes roughly farthest chunk first.
 void World::Render() const
 {
+    //Main thread only, so every world's render reuses the same list.
+    static std::vector<Chunk*> s_visibleChunks;
+    s_visibleChunks.clear();
     ChunkCoords playerPos = GetPlayerChunkCoords();
     if (m_worldID == TheGame::instance->m_currentlyRenderedWorldID)
     {
@@ -247,9 +325,16 @@ void World::Render() const
             if (currentChunk->IsInFrustum(TheGame::instance->m_playerCamera->GetForwardXYZ(), TheGame::instance->m_playerCamera->m_position))
             {
                 currentChunk->Render();
+                s_visibleChunks.push_back(currentChunk);
             }
         }
     }
+    const WorldPosition& cameraPosition = TheGame::instance->m_playerCamera->m_position;
+    for (Chunk* visibleChunk : s_visibleChunks)
+    {
+        visibleChunk->SortTranslucentFaces(cameraPosition);
+        visibleChunk->RenderTranslucent(cameraPosition);
+    }
 }
 
 //-----------------------------------------------------------------------------------
@@ -287,10 +372,11 @@ void World::PlaceBlock()
     BlockDefinition* definition = BlockDefinition::GetDefinition(player->m_heldBlock);
     Block* block = highlightedBlockInfo.GetBlock();
 
-    //Place the block down
+    //Place the block down. It can be across the border from the block we clicked on, so it's its chunk that rebuilds.
     block->m_type = player->m_heldBlock;
     AudioSystem::instance->PlaySound(definition->m_placeSound);
-    currentChunk->SetHighPriorityChunkDirtyAndAddToDirtyList();
+    uchar meshSections = Chunk::GetMeshSectionsShowingBlock(highlightedBlockInfo.m_index);
+    highlightedBlockInfo.m_chunk->SetHighPriorityChunkDirtyAndAddToDirtyList(meshSections);
     BlockInfo::SetDirtyFlagAndAddToDirtyList(highlightedBlockInfo);
     if (block->IsEdgeBlock())
     {
@@ -300,42 +386,23 @@ void World::PlaceBlock()
         BlockInfo south = highlightedBlockInfo.GetSouth();
         if (highlightedBlockInfo.IsOnEast() && east.m_chunk)
         {
-            east.m_chunk->DirtyAndAddToDirtyList();
+            east.m_chunk->DirtyAndAddToDirtyList(meshSections);
         }
         else if (highlightedBlockInfo.IsOnWest() && west.m_chunk)
         {
-            west.m_chunk->DirtyAndAddToDirtyList();
+            west.m_chunk->DirtyAndAddToDirtyList(meshSections);
         }
 
         if (highlightedBlockInfo.IsOnNorth() && north.m_chunk)
         {
-            north.m_chunk->DirtyAndAddToDirtyList();
+            north.m_chunk->DirtyAndAddToDirtyList(meshSections);
         }
         else if (highlightedBlockInfo.IsOnSouth() && south.m_chunk)
         {
-            south.m_chunk->DirtyAndAddToDirtyList();
-        }
-    }
-    if (highlightedBlockInfo.GetBlock()->IsSky())
-    {
-        block->SetSky(false);
-        highlightedBlockInfo = highlightedBlockInfo.GetBelow();
-        while (highlightedBlockInfo.m_index != BlockInfo::INVALID_INDEX)
-        {
-            Block* currentBlock = highlightedBlockInfo.GetBlock();
-            uchar blockType = currentBlock->m_type;
-            if (BlockDefinition::GetDefinition(blockType)->m_isOpaque)
-            {
-                highlightedBlockInfo = BlockInfo::INVALID_BLOCKINFO;
-            }
-            else
-            {
-                currentBlock->SetSky(false);
-                BlockInfo::SetDirtyFlagAndAddToDirtyList(highlightedBlockInfo);
-                highlightedBlockInfo = highlightedBlockInfo.GetBelow();
-            }
+            south.m_chunk->DirtyAndAddToDirtyList(meshSections);
         }
     }
+    RelightChangedBlock(highlightedBlockInfo);
 }
 
 //-----------------------------------------------------------------------------------
@@ -353,7 +420,8 @@ void World::DestroyBlock()
     block->m_type = BlockType::AIR;
     //This chunk is NOT high priority because we want the edge chunk to get updated first.
     //If we don't, we'll see a gap in the world before the other chunk's VA gets updated. This chunk is next in line regardless.
-    info.m_chunk->DirtyAndAddToDirtyList();
+    uchar meshSections = Chunk::GetMeshSectionsShowingBlock(info.m_index);
+    info.m_chunk->DirtyAndAddToDirtyList(meshSections);
     BlockInfo::SetDirtyFlagAndAddToDirtyList(info);
     //Update VA's if we were on a boundary
     if (block->IsEdgeBlock())
@@ -364,45 +432,23 @@ void World::DestroyBlock()
         BlockInfo south = info.GetSouth();
         if (info.IsOnEast() && east.m_chunk)
         {
-            east.m_chunk->SetHighPriorityChunkDirtyAndAddToDirtyList();
+            east.m_chunk->SetHighPriorityChunkDirtyAndAddToDirtyList(meshSections);
         }
         else if (info.IsOnWest() && west.m_chunk)
         {
-            west.m_chunk->SetHighPriorityChunkDirtyAndAddToDirtyList();
+            west.m_chunk->SetHighPriorityChunkDirtyAndAddToDirtyList(meshSections);
         }
 
         if (info.IsOnNorth() && north.m_chunk)
         {
-            north.m_chunk->SetHighPriorityChunkDirtyAndAddToDirtyList();
+            north.m_chunk->SetHighPriorityChunkDirtyAndAddToDirtyList(meshSections);
         }
         else if (info.IsOnSouth() && south.m_chunk)
         {
-            south.m_chunk->SetHighPriorityChunkDirtyAndAddToDirtyList();
+            south.m_chunk->SetHighPriorityChunkDirtyAndAddToDirtyList(meshSections);
         }
     }
-    if (info.GetAbove().GetBlock()->IsSky())
-    {
-        while (info.m_index != BlockInfo::INVALID_INDEX)
-        {
-            Block* currentBlock = info.GetBlock();
-            uchar blockType = currentBlock->m_type;
-            BlockDefinition* blockDef = BlockDefinition::GetDefinition(blockType);
-            if (blockDef->m_isOpaque)
-            {
-                info = BlockInfo::INVALID_BLOCKINFO;
-            }
-            else
-            {
-                if (block->m_type != BlockType::WATER)
-                {
-                    currentBlock->SetSky(true);
-                }
-                BlockInfo::SetDirtyFlagAndAddToDirtyList(info);
-                info = info.GetBelow();
-            }
-        }
-    }
-
+    RelightChangedBlock(info);
 }
 
 //-----------------------------------------------------------------------------------
@@ -497,6 +543,7 @@ void World::SaveChunk(Chunk* chunkToUnload)
 }
 
 //-----------------------------------------------------------------------------------
+//Links the chunk to whichever neighbors are loaded and reconciles the lighting across each new seam.
 void World::HookUpChunkPointers(Chunk* chunkToHookUp)
 {
     ChunkCoords position = chunkToHookUp->m_chunkPosition;
@@ -510,7 +557,8 @@ void World::HookUpChunkPointers(Chunk* chunkToHookUp)
         Chunk* existingNeighborChunk = eastChunk->second;
         chunkToHookUp->m_eastChunk = existingNeighborChunk;
         existingNeighborChunk->m_westChunk = chunkToHookUp;
-        existingNeighborChunk->FlagEdgesAsDirtyLighting(WEST);
+        m_numSeamBlocksSeeded += chunkToHookUp->QueueSeamLightSpread(EAST, m_lightingEngine);
+        ++m_numSeamHookups;
         existingNeighborChunk->DirtyAndAddToDirtyList();
     }
     auto westChunk = m_activeChunks.find(westChunkPos);
@@ -519,7 +567,8 @@ void World::HookUpChunkPointers(Chunk* chunkToHookUp)
         chunkToHookUp->m_westChunk = westChunk->second;
         Chunk* existingNeighborChunk = westChunk->second;
         existingNeighborChunk->m_eastChunk = chunkToHookUp;
-        existingNeighborChunk->FlagEdgesAsDirtyLighting(EAST);
+        m_numSeamBlocksSeeded += chunkToHookUp->QueueSeamLightSpread(WEST, m_lightingEngine);
+        ++m_numSeamHookups;
         existingNeighborChunk->DirtyAndAddToDirtyList();
     }
     auto northChunk = m_activeChunks.find(northChunkPos);
@@ -528,7 +577,8 @@ void World::HookUpChunkPointers(Chunk* chunkToHookUp)
         chunkToHookUp->m_northChunk = northChunk->second;
         Chunk* existingNeighborChunk = northChunk->second;
         existingNeighborChunk->m_southChunk = chunkToHookUp;
-        existingNeighborChunk->FlagEdgesAsDirtyLighting(SOUTH);
+        m_numSeamBlocksSeeded += chunkToHookUp->QueueSeamLightSpread(NORTH, m_lightingEngine);
+        ++m_numSeamHookups;
         existingNeighborChunk->DirtyAndAddToDirtyList();
     }
     auto southChunk = m_activeChunks.find(southChunkPos);
@@ -537,7 +587,8 @@ void World::HookUpChunkPointers(Chunk* chunkToHookUp)
         chunkToHookUp->m_southChunk = southChunk->second;
         Chunk* existingNeighborChunk = southChunk->second;
         existingNeighborChunk->m_northChunk = chunkToHookUp;
-        existingNeighborChunk->FlagEdgesAsDirtyLighting(NORTH);
+        m_numSeamBlocksSeeded += chunkToHookUp->QueueSeamLightSpread(SOUTH, m_lightingEngine);
+        ++m_numSeamHookups;
         existingNeighborChunk->DirtyAndAddToDirtyList();
     }
 }
@@ -840,29 +891,11 @@ void World::CreateRenderingOffsetList(Player* player)
 void World::AddToSaveQueue(Chunk* flushedChunk)
 {
     //Before we add it to the save queue, we need to pull the chunk out of any processing stages it's in.
-    for (auto iter = m_dirtyChunks.begin(); iter != m_dirtyChunks.end();)
-    {
-        if (iter->chunk == flushedChunk)
-        {
-            iter = m_dirtyChunks.erase(iter);
-        }
-        else
-        {
-            iter++;
-        }
-    }
-    //Remove any blocks that were marked as dirty lighting by the chunk's creation.
-    for (auto iter = m_dirtyBlocks.begin(); iter != m_dirtyBlocks.end();)
-    {
-        if (iter->m_chunk == flushedChunk)
-        {
-            iter = m_dirtyBlocks.erase(iter);
-        }
-        else
-        {
-            iter++;
-        }
-    }
+    m_dirtyChunks.Remove(flushedChunk);
+    //Its coords can stay in m_lightingDirtyChunks; they're skipped once the chunk is no longer active.
+    flushedChunk->ClearLightingDirty();
+    m_lightingEngine.PurgeChunk(flushedChunk);
+    TheGame::instance->m_meshWorkers->CancelJobsForChunk(flushedChunk);
     EnterCriticalSection(&g_diskIOCriticalSection);
     {
         g_requestedChunkSaveDeque.push_back(flushedChunk);
@@ -893,46 +926,91 @@ void World::PickUpCompletedChunks()
     LeaveCriticalSection(&g_chunkListsCriticalSection);
     if (newChunk)
     {
+        //The worker already lit the chunk on its own, so all that's left here is the seams with its neighbors.
+        g_profilingResults[g_localLightingProfiling].AddSample(newChunk->GetLocalLightingSeconds());
+        StartTiming(g_chunkActivationProfiling);
         ChunkCoords chunkPosition = newChunk->m_chunkPosition;
         m_activeChunks[chunkPosition] = newChunk;
+        std::vector<LocalIndex> changedIndices;
+        newChunk->ApplyDeferredBlockWrites(&changedIndices);
+        for (LocalIndex index : changedIndices)
+        {
+            BlockInfo changedBlockInfo(newChunk, index);
+            RelightChangedBlock(changedBlockInfo);
+        }
         newChunk->DirtyAndAddToDirtyList();
-        newChunk->CalculateSkyLighting();
         HookUpChunkPointers(m_activeChunks[chunkPosition]);
+        EndTiming(g_chunkActivationProfiling);
         m_chunkAddRemoveBalance++;
         DebuggerPrintf("[%i] World [%i]: Claiming Chunk %i,%i\n", g_frameNumber, m_worldID, chunkPosition.x, chunkPosition.y);
     }
 }
 
-//--------------------------------------------------------------------------------
-void World::UpdateLighting()
+//-----------------------------------------------------------------------------------
+//Features generated after a neighbor went active still need to land in it.
+void World::ApplyDeferredBlockWrites()
 {
-    DebuggerPrintf("[%i] World [%i]: Updating %i blocks for lighting intially.\n", g_frameNumber, m_worldID, m_dirtyBlocks.size());
-    unsigned int numberOfDirtyBlocks = 0;
-    while (!m_dirtyBlocks.empty())
+    std::vector<ChunkCoords> postedCoords;
+    m_generator->GetDeferredBlockWrites().TakeRecentlyPostedCoords(postedCoords);
+    std::vector<LocalIndex> changedIndices;
+    for (const ChunkCoords& coords : postedCoords)
     {
-        BlockInfo bi = m_dirtyBlocks.front();
-        m_dirtyBlocks.pop_front();
-        bi.GetBlock()->SetDirty(false);
-        UpdateLightingForBlock(bi);
-        numberOfDirtyBlocks++;
+        auto chunkIter = m_activeChunks.find(coords);
+        if (chunkIter == m_activeChunks.end())
+        {
+            continue;
+        }
+        Chunk* chunk = chunkIter->second;
+        changedIndices.clear();
+        if (chunk->ApplyDeferredBlockWrites(&changedIndices) == 0)
+        {
+            continue;
+        }
+        for (LocalIndex index : changedIndices)
+        {
+            BlockInfo changedBlockInfo(chunk, index);
+            RelightChangedBlock(changedBlockInfo);
+        }
+        chunk->DirtyAndAddToDirtyList();
+        //New leaves on our edge can hide faces the neighbors were drawing.
+        Chunk* neighbors[] = { chunk->m_eastChunk, chunk->m_westChunk, chunk->m_northChunk, chunk->m_southChunk };
+        for (Chunk* neighbor : neighbors)
+        {
+            if (neighbor)
+            {
+                neighbor->DirtyAndAddToDirtyList();
+            }
+        }
     }
-    DebuggerPrintf("[%i] World [%i]: Actually updated %i blocks during lighting.\n", g_frameNumber, m_worldID, numberOfDirtyBlocks);
 }
 
 //--------------------------------------------------------------------------------
-void World::UpdateLightingForBlock(const BlockInfo& bi)
+void World::UpdateLighting()
 {
-    RGBA ideal = GetIdealLightForBlock(bi);
-    RGBA current = bi.GetBlock()->GetRGBALightValue();
-    if (ideal == current)
-        return;
-    Block* block = bi.GetBlock();
-    if (block)
+    StartTiming(g_lightingProfiling);
+    //Handing dirty blocks to the engine is cheap; the budget applies to the propagation itself.
+    int numberOfDirtyBlocks = QueueLightingDirtyBlocks(m_lightingEngine);
+    DebuggerPrintf("[%i] World [%i]: Updating %i blocks for lighting intially.\n", g_frameNumber, m_worldID, numberOfDirtyBlocks);
+    int numberOfVisitedBlocks = m_lightingEngine.Update(LightingEngine::s_frameBudgetSeconds);
+    EndTiming(g_lightingProfiling);
+    DebuggerPrintf("[%i] World [%i]: Visited %i blocks during lighting, %i still queued.\n", g_frameNumber, m_worldID, numberOfVisitedBlocks, m_lightingEngine.GetNumQueuedBlocks());
+}
+
+//-----------------------------------------------------------------------------------
+//Empties the dirty chunk queue into the given engine, skipping chunks that were flushed since they were queued.
+int World::QueueLightingDirtyBlocks(LightingEngine& lightingEngine)
+{
+    int numQueuedBlocks = 0;
+    while (!m_lightingDirtyChunks.empty())
     {
-        block->SetLightValue(ideal);
+        auto chunkIter = m_activeChunks.find(m_lightingDirtyChunks.front());
+        m_lightingDirtyChunks.pop_front();
+        if (chunkIter != m_activeChunks.end())
+        {
+            numQueuedBlocks += chunkIter->second->QueueLightingDirtyBlocks(lightingEngine);
+        }
     }
-    SetBlockNeighborsDirty(bi);
-    bi.m_chunk->DirtyAndAddToDirtyList();
+    return numQueuedBlocks;
 }
 
 //-----------------------------------------------------------------------------------
@@ -941,131 +1019,39 @@ void World::MarkAsLightingDirty(BlockInfo& bi)
     Block* block = bi.GetBlock();
     if (!block)
         return;
-    if (block->IsDirty())
-        return;
     BlockInfo::SetDirtyFlagAndAddToDirtyList(bi);
 
 }
 
 //-----------------------------------------------------------------------------------
-void World::SetBlockNeighborsDirty(const BlockInfo& info)
+//A block changed type without going through PlaceBlock or DestroyBlock (feature writes), so the sky
+//bits of the column under it may be stale too. Fixes those up and hands everything that changed to the lighting.
+void World::RelightChangedBlock(BlockInfo& changedBlockInfo)
 {
-    if (info.m_index == BlockInfo::INVALID_INDEX)
-    {
-        return;
-    }
-    BlockInfo eastBlock = info.GetEast();
-    if (eastBlock.m_index != BlockInfo::INVALID_INDEX && !BlockDefinition::GetDefinition(eastBlock.GetBlock()->m_type)->m_isOpaque)
-    {
-        BlockInfo::SetDirtyFlagAndAddToDirtyList(eastBlock);
-    }
-    BlockInfo westBlock = info.GetWest();
-    if (westBlock.m_index != BlockInfo::INVALID_INDEX && !BlockDefinition::GetDefinition(westBlock.GetBlock()->m_type)->m_isOpaque)
+    Chunk* chunk = changedBlockInfo.m_chunk;
+    chunk->UpdateHeightMap(changedBlockInfo.m_index);
+    int height = chunk->GetHeight(changedBlockInfo.m_index & (Chunk::LOCAL_X_MASK | Chunk::LOCAL_Y_MASK));
+    bool isSky = (changedBlockInfo.m_index >> Chunk::CHUNK_BITS_XY) >= height;
+    changedBlockInfo.GetBlock()->SetSky(isSky);
+    MarkAsLightingDirty(changedBlockInfo);
+    for (BlockInfo belowInfo = changedBlockInfo.GetBelow(); belowInfo.IsValid(); belowInfo = belowInfo.GetBelow())
     {
-        BlockInfo::SetDirtyFlagAndAddToDirtyList(westBlock);
-    }
-    BlockInfo northBlock = info.GetNorth();
-    if (northBlock.m_index != BlockInfo::INVALID_INDEX && !BlockDefinition::GetDefinition(northBlock.GetBlock()->m_type)->m_isOpaque)
-    {
-        BlockInfo::SetDirtyFlagAndAddToDirtyList(northBlock);
-    }
-    BlockInfo southBlock = info.GetSouth();
-    if (southBlock.m_index != BlockInfo::INVALID_INDEX && !BlockDefinition::GetDefinition(southBlock.GetBlock()->m_type)->m_isOpaque)
-    {
-        BlockInfo::SetDirtyFlagAndAddToDirtyList(southBlock);
-    }
-    BlockInfo belowBlock = info.GetBelow();
-    if (belowBlock.m_index != BlockInfo::INVALID_INDEX && !BlockDefinition::GetDefinition(belowBlock.GetBlock()->m_type)->m_isOpaque)
-    {
-        BlockInfo::SetDirtyFlagAndAddToDirtyList(belowBlock);
-    }
-    BlockInfo aboveBlock = info.GetAbove();
-    if (aboveBlock.m_index != BlockInfo::INVALID_INDEX && !BlockDefinition::GetDefinition(aboveBlock.GetBlock()->m_type)->m_isOpaque)
-    {
-        BlockInfo::SetDirtyFlagAndAddToDirtyList(aboveBlock);
-    }
-    //If we're an edge block, we need to inform the other chunk that its VA's are out of date
-    if (info.GetBlock()->IsEdgeBlock())
-    {
-        BlockInfo east = info.GetEast();
-        BlockInfo west = info.GetWest();
-        BlockInfo north = info.GetNorth();
-        BlockInfo south = info.GetSouth();
-        if (info.IsOnEast() && east.m_chunk)
-        {
-            east.m_chunk->DirtyAndAddToDirtyList();
-        }
-        else if (info.IsOnWest() && west.m_chunk)
+        Block* belowBlock = belowInfo.GetBlock();
+        if (belowBlock->GetDefinition()->m_blocksSky || belowBlock->IsSky() == isSky)
         {
-            west.m_chunk->DirtyAndAddToDirtyList();
-        }
-
-        if (info.IsOnNorth() && north.m_chunk)
-        {
-            north.m_chunk->DirtyAndAddToDirtyList();
-        }
-        else if (info.IsOnSouth() && south.m_chunk)
-        {
-            south.m_chunk->DirtyAndAddToDirtyList();
+            break;
         }
+        belowBlock->SetSky(isSky);
+        MarkAsLightingDirty(belowInfo);
     }
 }
 
 //-----------------------------------------------------------------------------------
-RGBA World::GetIdealLightForBlock(const BlockInfo& bi)
+//Blocks only store how much of the sky reaches them, and the shader multiplies that by m_skyLight every frame,
+//so nothing needs relighting or rebuilding here.
+void World::SetSkyLight(const RGBA& skyLight)
 {
-    BlockDefinition* definition = BlockDefinition::GetDefinition(bi.GetBlock()->m_type);
-    RGBA myLight = RGBA(definition->m_illumination);
-    if (definition->m_isOpaque)
-    {
-        return myLight;
-    }
-    RGBA brightestNeighbor = GetBrightestNeighbor(bi);
-
-    RGBA highestNeighborMinusOneStep = brightestNeighbor - 0x0F;
-    uchar highestNeighborMinusOneStepRed = highestNeighborMinusOneStep.red > brightestNeighbor.red ? 0x00 : highestNeighborMinusOneStep.red;
-    uchar highestNeighborMinusOneStepGreen = highestNeighborMinusOneStep.green > brightestNeighbor.green ? 0x00 : highestNeighborMinusOneStep.green;
-    uchar highestNeighborMinusOneStepBlue = highestNeighborMinusOneStep.blue > brightestNeighbor.blue ? 0x00 : highestNeighborMinusOneStep.blue;
-    uchar highestFilteredForOpacityRed = highestNeighborMinusOneStepRed - definition->m_opacity.red;
-    uchar highestFilteredForOpacityGreen = highestNeighborMinusOneStepGreen - definition->m_opacity.green;
-    uchar highestFilteredForOpacityBlue = highestNeighborMinusOneStepBlue - definition->m_opacity.blue;
-    highestFilteredForOpacityRed = highestFilteredForOpacityRed > highestNeighborMinusOneStepRed ? 0x00 : highestFilteredForOpacityRed;
-    highestFilteredForOpacityGreen = highestFilteredForOpacityGreen > highestNeighborMinusOneStepGreen ? 0x00 : highestFilteredForOpacityGreen;
-    highestFilteredForOpacityBlue = highestFilteredForOpacityBlue > highestNeighborMinusOneStepBlue ? 0x00 : highestFilteredForOpacityBlue;
-
-    RGBA skylight = bi.GetBlock()->IsSky() ? m_skyLight : RGBA::BLACK;
-    uchar idealRed = myLight.red > skylight.red ? myLight.red : skylight.red;
-    uchar idealGreen = myLight.green > skylight.green ? myLight.green : skylight.green;
-    uchar idealBlue = myLight.blue > skylight.blue ? myLight.blue : skylight.blue;
-
-    idealRed = highestFilteredForOpacityRed > idealRed ? highestFilteredForOpacityRed : idealRed;
-    idealGreen = highestFilteredForOpacityGreen > idealGreen ? highestFilteredForOpacityGreen : idealGreen;
-    idealBlue = highestFilteredForOpacityBlue > idealBlue ? highestFilteredForOpacityBlue : idealBlue;
-
-    return RGBA::CreateFromUChars(idealRed, idealGreen, idealBlue, 0xFF);
-}
-
-//-----------------------------------------------------------------------------------
-RGBA World::GetBrightestNeighbor(const BlockInfo& info)
-{
-    RGBA brightestLightValue = RGBA::BLACK;
-    if (info.m_index == BlockInfo::INVALID_INDEX)
-    {
-        return brightestLightValue;
-    }
-    for (Direction neighborDirection : BlockInfo::directions)
-    {
-        BlockInfo neighborBlock = info.GetNeighbor(neighborDirection);
-        if (neighborBlock.m_index != BlockInfo::INVALID_INDEX)
-        {
-            RGBA neighborLight = neighborBlock.GetBlock()->GetRGBALightValue();
-            uchar brightestRedValue = neighborLight.red > brightestLightValue.red ? neighborLight.red : brightestLightValue.red;
-            uchar brightestGreenValue = neighborLight.green > brightestLightValue.green ? neighborLight.green : brightestLightValue.green;
-            uchar brightestBlueValue = neighborLight.blue > brightestLightValue.blue ? neighborLight.blue : brightestLightValue.blue;
-            brightestLightValue = RGBA::CreateFromUChars(brightestRedValue, brightestGreenValue, brightestBlueValue, 0x00);
-        }
-    }
-    return brightestLightValue;
+    m_skyLight = skyLight;
 }
 
 //-----------------------------------------------------------------------------------
@@ -1090,6 +1076,7 @@ void ChunkGenerationThreadMain()
             continue;
         }
         Chunk* newChunk = new Chunk(coords.chunkCoords, coords.world);
+        newChunk->CalculateLocalLighting();
         EnterCriticalSection(&g_chunkListsCriticalSection);
         {
             g_readyToActivateChunksDeque.push_back(newChunk);
@@ -1139,6 +1126,7 @@ void ChunkIOThreadMain()
             Chunk* loadedChunk = World::LoadChunk(chunkToLoadCoords.world->m_worldID,chunkToLoadCoords.chunkCoords);
             if (loadedChunk)
             {
+                loadedChunk->CalculateLocalLighting();
                 EnterCriticalSection(&g_chunkListsCriticalSection);
                 {
                     g_readyToActivateChunksDeque.push_back(loadedChunk);
@@ -1153,3 +1141,230 @@ void ChunkIOThreadMain()
         }
     }
 }
+
+//-----------------------------------------------------------------------------------
+//Marks a pile of blocks around the player dirty, then times purging one chunk's share and handing the rest to the engine.
+//The purge is also timed against a deque of BlockInfos scanned the way AddToSaveQueue used to, and then the same chunk
+//is purged from the engine with every handed-off entry still pending. Nothing changes type, and the purged chunk had
+//nothing of its own queued, so the relight afterwards leaves the world lit exactly as it was.
+CONSOLE_COMMAND(dirtybench)
+{
+    int numDirtyBlocks = args.HasArgs(1) ? args.GetIntArgument(0) : 100000;
+    World* world = TheGame::instance->m_worlds[TheGame::instance->m_currentlyRenderedWorldID];
+    LightingEngine& lightingEngine = world->m_lightingEngine;
+    world->UpdateLighting();
+    lightingEngine.Update();
+
+    std::vector<Chunk*> chunks;
+    ChunkCoords playerChunkCoords = world->GetPlayerChunkCoords();
+    for (int radius = 0; static_cast<int>(chunks.size()) * Chunk::BLOCKS_PER_CHUNK < numDirtyBlocks && radius < 8; ++radius)
+    {
+        for (int x = -radius; x <= radius; ++x)
+        {
+            for (int y = -radius; y <= radius; ++y)
+            {
+                if (abs(x) != radius && abs(y) != radius)
+                {
+                    continue;
+                }
+                WorldCoords chunkMins((playerChunkCoords.x + x) * Chunk::BLOCKS_WIDE_X, (playerChunkCoords.y + y) * Chunk::BLOCKS_WIDE_Y, 0);
+                BlockInfo info = world->GetBlockInfoFromWorldCoords(chunkMins);
+                if (info.IsValid())
+                {
+                    chunks.push_back(info.m_chunk);
+                }
+            }
+        }
+    }
+    if (chunks.empty() || numDirtyBlocks <= 0)
+    {
+        Console::instance->PrintLine("dirtybench <# of dirty blocks> needs loaded chunks around the player.", RGBA::RED);
+        return;
+    }
+    int maxDirtyBlocks = static_cast<int>(chunks.size()) * Chunk::BLOCKS_PER_CHUNK;
+    numDirtyBlocks = (numDirtyBlocks < maxDirtyBlocks) ? numDirtyBlocks : maxDirtyBlocks;
+
+    //Spread the blocks over the chunks with a stride, so the bits aren't all packed into whole words.
+    std::deque<BlockInfo> oldStyleQueue;
+    StartTiming();
+    for (int blockNumber = 0; blockNumber < numDirtyBlocks; ++blockNumber)
+    {
+        Chunk* chunk = chunks[blockNumber % chunks.size()];
+        LocalIndex index = static_cast<LocalIndex>((blockNumber / chunks.size()) * 7919 % Chunk::BLOCKS_PER_CHUNK);
+        BlockInfo::SetDirtyFlagAndAddToDirtyList(BlockInfo(chunk, index));
+    }
+    double markSeconds = EndTiming();
+    for (int blockNumber = 0; blockNumber < numDirtyBlocks; ++blockNumber)
+    {
+        Chunk* chunk = chunks[blockNumber % chunks.size()];
+        oldStyleQueue.push_back(BlockInfo(chunk, static_cast<LocalIndex>((blockNumber / chunks.size()) * 7919 % Chunk::BLOCKS_PER_CHUNK)));
+    }
+
+    Chunk* purgedChunk = chunks.back();
+    StartTiming();
+    for (auto iter = oldStyleQueue.begin(); iter != oldStyleQueue.end();)
+    {
+        if (iter->m_chunk == purgedChunk)
+        {
+            iter = oldStyleQueue.erase(iter);
+        }
+        else
+        {
+            iter++;
+        }
+    }
+    double oldPurgeSeconds = EndTiming();
+    int numPurgedBlocks = purgedChunk->GetNumLightingDirtyBlocks();
+    StartTiming();
+    purgedChunk->ClearLightingDirty();
+    double purgeSeconds = EndTiming();
+
+    StartTiming();
+    int numQueuedBlocks = world->QueueLightingDirtyBlocks(lightingEngine);
+    double queueSeconds = EndTiming();
+    //Same chunk again, this time out of the engine's queues while everything just handed off is still waiting.
+    int numPendingEntries = lightingEngine.GetNumQueuedBlocks();
+    StartTiming();
+    lightingEngine.PurgeChunk(purgedChunk);
+    double enginePurgeSeconds = EndTiming();
+    StartTiming();
+    int numBlocksVisited = lightingEngine.Update();
+    double relightSeconds = EndTiming();
+
+    Console::instance->PrintLine(Stringf("%i dirty blocks over %i chunks", numDirtyBlocks, static_cast<int>(chunks.size())), RGBA::GRAY);
+    Console::instance->PrintLine(Stringf("%-24s %.03f ms", "Mark dirty", markSeconds * 1000.0), RGBA::WHITE);
+    Console::instance->PrintLine(Stringf("%-24s %.03f ms (%i blocks, deque scan: %.03f ms)", "Purge one chunk", purgeSeconds * 1000.0, numPurgedBlocks, oldPurgeSeconds * 1000.0), RGBA::WHITE);
+    Console::instance->PrintLine(Stringf("%-24s %.03f ms (%i blocks)", "Hand off to engine", queueSeconds * 1000.0, numQueuedBlocks), RGBA::WHITE);
+    Console::instance->PrintLine(Stringf("%-24s %.03f ms (%i entries pending)", "Purge from engine", enginePurgeSeconds * 1000.0, numPendingEntries), RGBA::WHITE);
+    Console::instance->PrintLine(Stringf("%-24s %.03f ms (%i blocks visited)", "Relight", relightSeconds * 1000.0, numBlocksVisited), RGBA::WHITE);
+}
+
+//-----------------------------------------------------------------------------------
+//Loads a full active radius of fresh chunks far from the player row by row, hooking each one up to the chunks
+//west and south of it like the world does, and counts the blocks queued for the seams by the old edge seeding
+//and by the seam comparison. Only two rows are kept alive at a time. Neither queue is run, so nothing is lit.
+CONSOLE_COMMAND(seambench)
+{
+    int radius = args.HasArgs(1) ? args.GetIntArgument(0) : 13;
+    if (radius <= 0)
+    {
+        Console::instance->PrintLine("seambench <radius in chunks>", RGBA::GRAY);
+        return;
+    }
+    World* world = TheGame::instance->m_worlds[TheGame::instance->m_currentlyRenderedWorldID];
+    DetachedChunkFactory detachedChunks(world);
+    int diameter = radius * 2 + 1;
+    std::vector<Chunk*> previousRow(diameter, nullptr);
+    std::vector<Chunk*> currentRow(diameter, nullptr);
+    int numSeams = 0;
+    int numEdgeBlocksQueued = 0;
+    int numSeamBlocksQueued = 0;
+    int mostSeamBlocksQueued = 0;
+    double edgeSeconds = 0.0;
+    double seamSeconds = 0.0;
+    for (int y = 0; y < diameter; ++y)
+    {
+        for (int x = 0; x < diameter; ++x)
+        {
+            Chunk* chunk = detachedChunks.CreateChunk(x, y);
+            chunk->CalculateLocalLighting();
+            currentRow[x] = chunk;
+            Direction neighborDirections[2] = { WEST, SOUTH };
+            Chunk* neighbors[2] = { x > 0 ? currentRow[x - 1] : nullptr, previousRow[x] };
+            for (int neighborIndex = 0; neighborIndex < 2; ++neighborIndex)
+            {
+                Chunk* neighbor = neighbors[neighborIndex];
+                if (!neighbor)
+                {
+                    continue;
+                }
+                if (neighborDirections[neighborIndex] == WEST)
+                {
+                    chunk->m_westChunk = neighbor;
+                    neighbor->m_eastChunk = chunk;
+                }
+                else
+                {
+                    chunk->m_southChunk = neighbor;
+                    neighbor->m_northChunk = chunk;
+                }
+                Direction neighborSide = neighborDirections[neighborIndex] == WEST ? EAST : NORTH;
+                LightingEngine edgeEngine(world);
+                StartTiming();
+                numEdgeBlocksQueued += chunk->QueueEdgeLightSpread(neighborDirections[neighborIndex], edgeEngine);
+                numEdgeBlocksQueued += neighbor->QueueEdgeLightSpread(neighborSide, edgeEngine);
+                edgeSeconds += EndTiming();
+                LightingEngine seamEngine(world);
+                StartTiming();
+                int numQueued = chunk->QueueSeamLightSpread(neighborDirections[neighborIndex], seamEngine);
+                seamSeconds += EndTiming();
+                numSeamBlocksQueued += numQueued;
+                mostSeamBlocksQueued = numQueued > mostSeamBlocksQueued ? numQueued : mostSeamBlocksQueued;
+                ++numSeams;
+            }
+        }
+        for (int x = 0; x < diameter; ++x)
+        {
+            delete previousRow[x];
+            currentRow[x]->m_southChunk = nullptr;
+        }
+        previousRow.swap(currentRow);
+    }
+    for (int x = 0; x < diameter; ++x)
+    {
+        delete previousRow[x];
+    }
+
+    int seamsForAverage = numSeams > 0 ? numSeams : 1;
+    Console::instance->PrintLine(Stringf("%i chunks, %i seams", diameter * diameter, numSeams), RGBA::GRAY);
+    Console::instance->PrintLine(Stringf("%-24s %9i blocks (%.01f/seam), %.03f ms", "Old edge seeding", numEdgeBlocksQueued, static_cast<double>(numEdgeBlocksQueued) / seamsForAverage, edgeSeconds * 1000.0), RGBA::WHITE);
+    Console::instance->PrintLine(Stringf("%-24s %9i blocks (%.01f/seam, at most %i), %.03f ms", "Seam comparison", numSeamBlocksQueued, static_cast<double>(numSeamBlocksQueued) / seamsForAverage, mostSeamBlocksQueued, seamSeconds * 1000.0), RGBA::WHITE);
+    Console::instance->PrintLine(Stringf("This world so far: %i seams hooked up, %i blocks seeded", world->m_numSeamHookups, world->m_numSeamBlocksSeeded), RGBA::GRAY);
+}
+
+//-----------------------------------------------------------------------------------
+//Changes the sky light of the world being rendered and times it over every active chunk. For comparison it also
+//times rebuilding every active mesh once, which is what baking the sky into the vertex colors would cost on top
+//of relighting. Nothing about the meshes actually changes, so the rebuild leaves the world looking as it did.
+CONSOLE_COMMAND(skylight)
+{
+    World* world = TheGame::instance->m_worlds[TheGame::instance->m_currentlyRenderedWorldID];
+    if (!args.HasArgs(1))
+    {
+        Console::instance->PrintLine(Stringf("skylight <daylight | sunset | vaporwave | RRGGBB> (currently %02X%02X%02X)", world->m_skyLight.red, world->m_skyLight.green, world->m_skyLight.blue), RGBA::GRAY);
+        return;
+    }
+    std::string skyName = args.GetStringArgument(0);
+    unsigned int skyLightHex = 0;
+    if (skyName == "daylight")
+    {
+        skyLightHex = 0xDDEEFF00;
+    }
+    else if (skyName == "sunset")
+    {
+        skyLightHex = 0xFF990000;
+    }
+    else if (skyName == "vaporwave")
+    {
+        skyLightHex = 0xFF819C00;
+    }
+    else
+    {
+        skyLightHex = static_cast<unsigned int>(strtoul(skyName.c_str(), nullptr, 16)) << 8;
+    }
+
+    const std::map<ChunkCoords, Chunk*>& activeChunks = world->GetActiveChunks();
+    StartTiming();
+    world->SetSkyLight(RGBA(skyLightHex));
+    double skyChangeSeconds = EndTiming();
+    StartTiming();
+    for (auto chunkIter = activeChunks.begin(); chunkIter != activeChunks.end(); ++chunkIter)
+    {
+        chunkIter->second->GenerateVertexArray();
+    }
+    double rebuildSeconds = EndTiming();
+
+    int numActiveChunks = static_cast<int>(activeChunks.size());
+    Console::instance->PrintLine(Stringf("%-24s %.03f ms over %i active chunks", "Sky change", skyChangeSeconds * 1000.0, numActiveChunks), RGBA::WHITE);
+    Console::instance->PrintLine(Stringf("%-24s %.03f ms (%.03f ms/chunk)", "Rebuild every mesh", rebuildSeconds * 1000.0, numActiveChunks > 0 ? rebuildSeconds * 1000.0 / numActiveChunks : 0.0), RGBA::WHITE);
+}
@@ -3,6 +3,8 @@
 #include "Game/Chunk.hpp"
 #include "Game/BlockInfo.hpp"
 #include "Game/Generator.hpp"
+#include "Game/LightingEngine.hpp"
+#include "Game/DirtyChunkQueue.hpp"
 #include <map>
 #include <set>
 #include <deque>
@@ -21,9 +23,16 @@ extern std::set<WorldChunkCoordsPair, std::less<WorldChunkCoordsPair>, Untracked
 extern std::deque<Chunk*, UntrackedAllocator<Chunk*>> g_requestedChunkSaveDeque;
 extern std::deque<Chunk*, UntrackedAllocator<Chunk*>> g_readyToActivateChunksDeque;
 extern ProfilingID g_generationProfiling;
+extern ProfilingID g_generationColumnsProfiling;
+extern ProfilingID g_generationDensityProfiling;
+extern ProfilingID g_generationSurfaceProfiling;
+extern ProfilingID g_generationFeaturesProfiling;
 extern ProfilingID g_loadingProfiling;
 extern ProfilingID g_savingProfiling;
 extern ProfilingID g_vaBuildingProfiling;
+extern ProfilingID g_lightingProfiling;
+extern ProfilingID g_localLightingProfiling;
+extern ProfilingID g_chunkActivationProfiling;
 extern ProfilingID g_temporaryProfiling;
 
 //STRUCTS//////////////////////////////////////////////////////////////////////////
@@ -62,20 +71,6 @@ struct PrioritizedChunkCoords
     float prioritizedDistanceValue;
 };
 
-//-----------------------------------------------------------------------------------
-struct PrioritizedChunk
-{
-    PrioritizedChunk() {};
-    PrioritizedChunk(Chunk* chunkPointer, float priorityValue) : chunk(chunkPointer), prioritizedDistanceValue(priorityValue) {};
-    inline bool operator<(const PrioritizedChunk& rhs) const
-    {
-        return (this->prioritizedDistanceValue < rhs.prioritizedDistanceValue ? true : false);
-    }
-
-    Chunk* chunk;
-    float prioritizedDistanceValue;
-};
-
 //-----------------------------------------------------------------------------------
 struct RaycastResult3D
 {
@@ -114,6 +109,8 @@ public:
     void PlaceBlock();
     void DestroyBlock();
     void UpdateVertexArrays();
+    void UploadFinishedMeshes(double budgetDeadline);
+    void QueueDirtyChunksForMeshing(double budgetDeadline);
     void CreateRenderingOffsetList(Player* player);
     RaycastResult3D Raycast(const Vector3& start, const Vector3& end) const;
 
@@ -146,24 +143,28 @@ public:
     void FlushUnnecessaryChunks();
     void RequestChunk(PrioritizedChunkCoords &chunkToGenerate);
     void PickUpCompletedChunks();
+    void ApplyDeferredBlockWrites();
     int GetNumActiveChunks();
+    inline const std::map<ChunkCoords, Chunk*>& GetActiveChunks() const { return m_activeChunks; };
     float DistanceSquaredFromPlayerToChunk(ChunkCoords candidateChunkCoords);
 
     //LIGHTING//////////////////////////////////////////////////////////////////////////
     void UpdateLighting();
-    void UpdateLightingForBlock(const BlockInfo& bi);
+    int QueueLightingDirtyBlocks(LightingEngine& lightingEngine);
     void MarkAsLightingDirty(BlockInfo& bi);
-    void SetBlockNeighborsDirty(const BlockInfo& info);
-    RGBA GetIdealLightForBlock(const BlockInfo& bi);
-    RGBA GetBrightestNeighbor(const BlockInfo& info);
+    void RelightChangedBlock(BlockInfo& changedBlockInfo);
+    void SetSkyLight(const RGBA& skyLight);
 
     //MEMBER VARIABLES//////////////////////////////////////////////////////////////////////////
     unsigned int m_worldID;
     RGBA m_skyLight;
     RGBA m_skyColor;
     Generator* m_generator;
-    std::deque<BlockInfo> m_dirtyBlocks;
-    std::multiset<PrioritizedChunk> m_dirtyChunks;
+    std::deque<ChunkCoords> m_lightingDirtyChunks; //Chunks with dirty bits set, in the order they first got one.
+    LightingEngine m_lightingEngine;
+    int m_numSeamHookups; //Every chunk pair hooked up since the world started,
+    int m_numSeamBlocksSeeded; //and the blocks their seams queued for lighting.
+    DirtyChunkQueue m_dirtyChunks;
     Skybox* m_skybox;
 
 private:
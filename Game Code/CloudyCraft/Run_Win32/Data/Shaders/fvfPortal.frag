@@ -4,10 +4,13 @@ uniform vec4 gColor;
 uniform sampler2D gDiffuseTexture;
 uniform sampler2D gEmissiveTexture; //The portal depth texture from last pass.
 uniform int gPassNumber; //Render pass number
+uniform vec4 gAtlasTileSpan; //Size of one atlas tile in texture space. Zero (unset) means no tiling.
+uniform vec4 gSkyLight; //The world's sky light. Vertices only store how much of the sky reaches them.
 
 in vec4 passColor;
 in vec2 passUV0;
-flat in vec4 passFloatData0;
+in vec2 passUV1;
+in vec4 passFloatData0;
 noperspective in vec2 passScreenCoord;
 noperspective in float logZResult;
 
@@ -16,7 +19,11 @@ out float outPortalDepth;
 
 void main()
 {
-    vec4 diffuse = texture(gDiffuseTexture, passUV0); //The diffuse texture for the blocks
+    //Faces merged by the greedy mesher repeat their tile once per block: passUV0 is the tile's corner and passUV1 counts tiles.
+    //Gradients come from the unwrapped coordinates so the mip level doesn't jump where the tile wraps.
+    vec2 unwrappedUV = passUV0 + (passUV1 * gAtlasTileSpan.xy);
+    vec2 tiledUV = passUV0 + (fract(passUV1) * gAtlasTileSpan.xy);
+    vec4 diffuse = textureGrad(gDiffuseTexture, tiledUV, dFdx(unwrappedUV), dFdy(unwrappedUV)); //The diffuse texture for the blocks
     float isPortalValue = passFloatData0.x; //A custom float parameter that denotes whether or not the vertex is a portal. 1.0f means portal, 0.0f means no portal.
     float portalDepth = texture(gEmissiveTexture, passScreenCoord).r; //Max depth (white) if not portal, otherwise holds the depth value of the portal
     
@@ -31,7 +38,7 @@ void main()
     {
         //If this is a portal fragment, write out the portal's depth for our next pass.
         //Only things behind this depth get written out.
-        if(isPortalValue == 1.0f) 
+        if(isPortalValue > 0.5f) 
         {
             outPortalDepth = gl_FragDepth;
         }
@@ -41,9 +48,12 @@ void main()
             outPortalDepth = 1.0f;
         }
     }
-    outColor = mix(diffuse * passColor, gColor * passColor, isPortalValue);
+    //Sky light reaching the face is the world's sky minus whatever full white sky would have lost getting here.
+    vec3 skyLight = max(gSkyLight.rgb - (vec3(1.0f) - passFloatData0.yzw), vec3(0.0f));
+    vec4 light = vec4(max(passColor.rgb, skyLight), passColor.a);
+    outColor = mix(diffuse * light, gColor * light, isPortalValue);
     if(gPassNumber == 1)
     {
-        outColor = diffuse * passColor;
+        outColor = diffuse * light;
     }
 }
@@ -8,11 +8,13 @@ uniform int gPassNumber; //Render pass number
 in vec3 inPosition;
 in vec4 inColor;
 in vec2 inUV0;
+in vec2 inUV1; //Greedy meshed faces: how many tiles across the face this vertex is.
 in vec4 inFloatData0;
 
 out vec4 passColor;
 out vec2 passUV0;
-flat out vec4 passFloatData0;
+out vec2 passUV1;
+out vec4 passFloatData0; //Not flat: smooth lighting gives each corner its own sky transmission.
 noperspective out vec2 passScreenCoord;
 noperspective out float logZResult;
 
@@ -20,6 +22,7 @@ void main(void)
 {
   passColor = inColor;
   passUV0 = inUV0;
+  passUV1 = inUV1;
   passFloatData0 = inFloatData0;
 
   vec4 pos = vec4(inPosition, 1.0f);